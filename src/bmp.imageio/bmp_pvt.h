@@ -37,10 +37,10 @@ const int16_t MAGIC_PT = 0x5450;
 class BmpFileHeader {
 public:
     // reads informations about BMP file
-    bool read_header(FILE* fd);
+    bool read_header(Filesystem::IOProxy* fd);
 
     // writes information about bmp file to given file
-    bool write_header(FILE* fd);
+    bool write_header(Filesystem::IOProxy* fd);
 
     // return true if given file is BMP file
     bool isBmp() const;
@@ -58,10 +58,10 @@ private:
 class DibInformationHeader {
 public:
     // reads informations about bitmap
-    bool read_header(FILE* fd);
+    bool read_header(Filesystem::IOProxy* fd);
 
     // writes informations about bitmap
-    bool write_header(FILE* fd);
+    bool write_header(Filesystem::IOProxy* fd);
 
     int32_t size;         // size of the header
     int32_t width;        // bitmap width in pixels
@@ -122,8 +122,14 @@ public:
     BmpInput() { init(); }
     virtual ~BmpInput() { close(); }
     virtual const char* format_name(void) const override { return "bmp"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool close(void) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
@@ -131,7 +137,6 @@ public:
 private:
     int64_t m_padded_scanline_size;
     int m_pad_size;
-    FILE* m_fd;
     bmp_pvt::BmpFileHeader m_bmp_header;
     bmp_pvt::DibInformationHeader m_dib_header;
     std::string m_filename;
@@ -141,7 +146,6 @@ private:
     {
         m_padded_scanline_size = 0;
         m_pad_size             = 0;
-        m_fd                   = NULL;
         m_filename.clear();
         m_colortable.clear();
     }
@@ -168,7 +172,6 @@ public:
 
 private:
     int64_t m_padded_scanline_size;
-    FILE* m_fd;
     std::string m_filename;
     bmp_pvt::BmpFileHeader m_bmp_header;
     bmp_pvt::DibInformationHeader m_dib_header;
@@ -179,13 +182,12 @@ private:
     void init(void)
     {
         m_padded_scanline_size = 0;
-        m_fd                   = NULL;
         m_filename.clear();
     }
 
-    void create_and_write_file_header(void);
+    bool create_and_write_file_header(void);
 
-    void create_and_write_bitmap_header(void);
+    bool create_and_write_bitmap_header(void);
 };
 
 
@@ -32,13 +32,21 @@ OIIO_PLUGIN_EXPORTS_END
 bool
 BmpInput::valid_file(const std::string& filename) const
 {
-    FILE* fd = Filesystem::fopen(filename, "rb");
-    if (!fd)
+    Filesystem::IOFile file(filename, Filesystem::IOProxy::Read);
+    if (!file.opened())
         return false;
     bmp_pvt::BmpFileHeader bmp_header;
-    bool ok = bmp_header.read_header(fd) && bmp_header.isBmp();
-    fclose(fd);
-    return ok;
+    return bmp_header.read_header(&file) && bmp_header.isBmp();
+}
+
+
+
+bool
+BmpInput::open(const std::string& name, ImageSpec& spec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
 }
 
 
@@ -49,14 +57,11 @@ BmpInput::open(const std::string& name, ImageSpec& spec)
     // saving 'name' for later use
     m_filename = name;
 
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // we read header of the file that we think is BMP file
-    if (!m_bmp_header.read_header(m_fd)) {
+    if (!m_bmp_header.read_header(ioproxy())) {
         errorf("\"%s\": wrong bmp header size", m_filename);
         close();
         return false;
@@ -67,7 +72,7 @@ BmpInput::open(const std::string& name, ImageSpec& spec)
         close();
         return false;
     }
-    if (!m_dib_header.read_header(m_fd)) {
+    if (!m_dib_header.read_header(ioproxy())) {
         errorf("\"%s\": wrong bitmap header size", m_filename);
         close();
         return false;
@@ -114,7 +119,7 @@ BmpInput::open(const std::string& name, ImageSpec& spec)
 
     // file pointer is set to the beginning of image data
     // we save this position - it will be helpfull in read_native_scanline
-    m_image_start = Filesystem::ftell(m_fd);
+    m_image_start = iotell();
 
     spec = m_spec;
     return true;
@@ -138,26 +143,30 @@ BmpInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
         y = m_spec.height - y - 1;
     const int64_t scanline_off = y * m_padded_scanline_size;
 
-    std::unique_ptr<unsigned char[]> fscanline(
-        new unsigned char[m_padded_scanline_size]);
-    Filesystem::fseek(m_fd, m_image_start + scanline_off, SEEK_SET);
-    size_t n = fread(fscanline.get(), 1, m_padded_scanline_size, m_fd);
-    if (n != (size_t)m_padded_scanline_size) {
-        if (feof(m_fd))
-            errorf("Hit end of file unexpectedly");
-        else
-            errorf("read error");
-        return false;  // Read failed
+    // Decode straight from the proxy's memory if it has it, else read the
+    // scanline into a buffer of our own.
+    const unsigned char* fscanline = iomapped(m_image_start + scanline_off,
+                                              m_padded_scanline_size);
+    std::unique_ptr<unsigned char[]> fscanbuf;
+    if (!fscanline) {
+        fscanbuf.reset(new unsigned char[m_padded_scanline_size]);
+        if (!ioseek(m_image_start + scanline_off)
+            || !ioread(fscanbuf.get(), m_padded_scanline_size))
+            return false;  // Read failed
+        fscanline = fscanbuf.get();
     }
 
     // in each case we process only first m_spec.scanline_bytes () bytes
     // as only they contain information about pixels. The rest are just
     // because scanline size have to be 32-bit boundary
     if (m_dib_header.bpp == 24 || m_dib_header.bpp == 32) {
+        // BGR(A) -> RGB(A), swapping in the caller's buffer so that we
+        // never modify the (possibly read-only) source
+        unsigned char* cdata = (unsigned char*)data;
+        memcpy(cdata, fscanline, m_spec.scanline_bytes());
         for (unsigned int i = 0; i < m_spec.scanline_bytes();
              i += m_spec.nchannels)
-            std::swap(fscanline[i], fscanline[i + 2]);
-        memcpy(data, fscanline.get(), m_spec.scanline_bytes());
+            std::swap(cdata[i], cdata[i + 2]);
         return true;
     }
 
@@ -216,10 +225,7 @@ BmpInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
 bool inline BmpInput::close(void)
 {
-    if (m_fd) {
-        fclose(m_fd);
-        m_fd = NULL;
-    }
+    ioproxy_clear();
     init();
     return true;
 }
@@ -241,15 +247,8 @@ BmpInput::read_color_table(void)
         entry_size = 3;
     m_colortable.resize(colors);
     for (int i = 0; i < colors; i++) {
-        size_t n = fread(&m_colortable[i], 1, entry_size, m_fd);
-        if (n != entry_size) {
-            if (feof(m_fd))
-                errorf(
-                    "Hit end of file unexpectedly while reading color table");
-            else
-                errorf("read error while reading color table");
+        if (!ioread(&m_colortable[i], entry_size))
             return false;  // Read failed
-        }
     }
     return true;  // ok
 }
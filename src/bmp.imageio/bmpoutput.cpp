@@ -29,7 +29,7 @@ OIIO_PLUGIN_EXPORTS_END
 int
 BmpOutput::supports(string_view feature) const
 {
-    return (feature == "alpha");
+    return (feature == "alpha" || feature == "ioproxy");
 }
 
 
@@ -62,18 +62,18 @@ BmpOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
         return false;
     }
 
-    m_fd = Filesystem::fopen(m_filename, "wb");
-    if (!m_fd) {
-        errorf("Could not open \"%s\"", m_filename);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
-    create_and_write_file_header();
-    create_and_write_bitmap_header();
+    if (!create_and_write_file_header() || !create_and_write_bitmap_header()) {
+        close();
+        return false;
+    }
 
     // Scanline size is rounded up to align to 4-byte boundary
     m_padded_scanline_size = ((m_spec.width * m_spec.nchannels) + 3) & ~3;
-    m_image_start          = Filesystem::ftell(m_fd);
+    m_image_start          = iotell();
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
@@ -98,7 +98,8 @@ BmpOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
     if (m_spec.width >= 0)
         y = (m_spec.height - y - 1);
     int64_t scanline_off = y * m_padded_scanline_size;
-    Filesystem::fseek(m_fd, m_image_start + scanline_off, SEEK_SET);
+    if (!ioseek(m_image_start + scanline_off))
+        return false;
 
     std::vector<unsigned char> scratch;
     data = to_native_scanline(format, data, xstride, scratch, m_dither, y, z);
@@ -113,8 +114,7 @@ BmpOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
         for (int i = 0, iend = buf.size() - 2; i < iend; i += m_spec.nchannels)
             std::swap(buf[i], buf[i + 2]);
 
-    size_t byte_count = fwrite(&buf[0], 1, buf.size(), m_fd);
-    return byte_count == buf.size();  // true if wrote all bytes (no error)
+    return iowrite(buf.data(), buf.size());
 }
 
 
@@ -133,7 +133,7 @@ BmpOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 BmpOutput::close(void)
 {
-    if (!m_fd) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -147,13 +147,12 @@ BmpOutput::close(void)
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    fclose(m_fd);
-    m_fd = NULL;
+    ioproxy_clear();
     return ok;
 }
 
 
-void
+bool
 BmpOutput::create_and_write_file_header(void)
 {
     m_bmp_header.magic = MAGIC_BM;
@@ -165,12 +164,16 @@ BmpOutput::create_and_write_file_header(void)
     m_bmp_header.res2   = 0;
     m_bmp_header.offset = BMP_HEADER_SIZE + WINDOWS_V3;
 
-    m_bmp_header.write_header(m_fd);
+    if (!m_bmp_header.write_header(ioproxy())) {
+        errorf("Could not write the BMP file header");
+        return false;
+    }
+    return true;
 }
 
 
 
-void
+bool
 BmpOutput::create_and_write_bitmap_header(void)
 {
     m_dib_header.size        = WINDOWS_V3;
@@ -203,7 +206,11 @@ BmpOutput::create_and_write_bitmap_header(void)
         }
     }
 
-    m_dib_header.write_header(m_fd);
+    if (!m_dib_header.write_header(ioproxy())) {
+        errorf("Could not write the BMP bitmap header");
+        return false;
+    }
+    return true;
 }
 
 OIIO_PLUGIN_NAMESPACE_END
@@ -20,7 +20,13 @@ public:
     CineonInput() { init(); }
     virtual ~CineonInput() { close(); }
     virtual const char* format_name(void) const override { return "cineon"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
@@ -75,10 +81,13 @@ OIIO_PLUGIN_EXPORTS_END
 bool
 CineonInput::open(const std::string& name, ImageSpec& newspec)
 {
-    // open the image
+    // open the image, reading through the app's proxy if there is one
+    if (!ioproxy_use_or_open(name))
+        return false;
     m_stream = new InStream();
-    if (!m_stream->Open(name.c_str())) {
+    if (!m_stream->Open(ioproxy())) {
         errorf("Could not open file \"%s\"", name);
+        close();
         return false;
     }
 
@@ -355,10 +364,21 @@ CineonInput::open(const std::string& name, ImageSpec& newspec)
 
 
 
+bool
+CineonInput::open(const std::string& name, ImageSpec& newspec,
+                  const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
 bool
 CineonInput::close()
 {
     init();  // Reset to initial state
+    ioproxy_clear();
     return true;
 }
 
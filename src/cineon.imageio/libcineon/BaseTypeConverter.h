@@ -37,6 +37,12 @@
 #define _CINEON_BASETYPECONVERTER_H 1
 
 
+#include <algorithm>
+#include <cstring>
+
+#include <OpenImageIO/simd.h>
+
+
 namespace cineon
 {
 	// convert between all of the DPX base types in a controllable way
@@ -231,6 +237,184 @@ namespace cineon
 		dst = (src << 4) | (src >> 8);
 	}
 
+
+	// Bulk 10/12-bit conversions
+	//
+	// The reader converts whole runs of 10-bit and 12-bit data to U16 with
+	// these rather than datum by datum, promoting them the same way as
+	// BaseTypeConvertU10ToU16/BaseTypeConvertU12ToU16. With SSSE3 and up,
+	// each 10/12-bit field is gathered into a 16-bit lane with a byte
+	// shuffle, 8 values per 128 bits (16 per 256 bits with AVX2); remainders
+	// and other architectures use the scalar code. As for DPX, that's
+	// decided when compiling: only builds with USE_SIMD=ssse3 or higher get
+	// the shuffle kernels.
+
+#if OIIO_SIMD_SSE >= 3
+	// periods of the layouts unpacked per loop iteration, so that AVX2
+	// always has a pair of 8 value groups to fill a register
+	const int kUnpackPeriods = (OIIO_SIMD_AVX >= 2) ? 2 : 1;
+
+	// where the values of one period of a layout live in the source, in
+	// groups of 8, for the shuffle based unpacking
+	struct UnpackLayout
+	{
+		int groups;							// groups of 8 values per period
+		int periodBytes;					// source bytes per period
+		int readBytes;						// source bytes read per period
+		int offset[6];						// source byte offset of each group
+		unsigned char shuffle[6][16];		// gathers the 16 bits holding each value
+		U16 multiply[6][8];					// shifts each value to the top bits
+	};
+
+	// value j of the period is the bitDepth bits starting at bit pos[j]
+	// of the little-endian source
+	inline void UnpackLayoutBuild(UnpackLayout &layout, const int *pos, const int bitDepth)
+	{
+		layout.readBytes = 0;
+		for (int g = 0; g < layout.groups; g++)
+		{
+			const int *gpos = pos + 8 * g;
+			layout.offset[g] = gpos[0] / 8;
+			for (int k = 1; k < 8; k++)
+				layout.offset[g] = std::min(layout.offset[g], gpos[k] / 8);
+			layout.readBytes = std::max(layout.readBytes, layout.offset[g] + 16);
+			for (int k = 0; k < 8; k++)
+			{
+				const int byte = gpos[k] / 8 - layout.offset[g];
+				layout.shuffle[g][2 * k] = (unsigned char)byte;
+				layout.shuffle[g][2 * k + 1] = (unsigned char)(byte + 1);
+				layout.multiply[g][k] = U16(1 << (16 - bitDepth - gpos[k] % 8));
+			}
+		}
+	}
+
+	// 10-bit filled: a period is 8 words, 24 datums
+	inline void UnpackLayoutFilled(UnpackLayout &layout, const int padbits, const bool lsbFirst)
+	{
+		int pos[48];
+		layout.groups = 3 * kUnpackPeriods;
+		layout.periodBytes = 32 * kUnpackPeriods;
+		for (int j = 0; j < 8 * layout.groups; j++)
+		{
+			const int r = j % 3;
+			pos[j] = 32 * (j / 3) + (lsbFirst ? 10 * r : 20 - 10 * r) + padbits;
+		}
+		UnpackLayoutBuild(layout, pos, 10);
+	}
+
+	// 10/12-bit packed: a period is 8 datums, bitDepth bytes
+	inline void UnpackLayoutPacked(UnpackLayout &layout, const int bitDepth)
+	{
+		int pos[16];
+		layout.groups = kUnpackPeriods;
+		layout.periodBytes = bitDepth * kUnpackPeriods;
+		for (int j = 0; j < 8 * layout.groups; j++)
+			pos[j] = bitDepth * j;
+		UnpackLayoutBuild(layout, pos, bitDepth);
+	}
+
+	// unpack whole periods of the layout from src, which has srcBytes
+	// bytes, into at most count values of dst; returns the number of values
+	// unpacked
+	inline int UnpackWithLayout(const UnpackLayout &layout, const unsigned char *src, const size_t srcBytes, U16 *dst, const int count, const int bitDepth)
+	{
+		const int perPeriod = 8 * layout.groups;
+		const __m128i expand = _mm_cvtsi32_si128(bitDepth);
+		int done = 0;
+		size_t pos = 0;
+#if OIIO_SIMD_AVX >= 2
+		__m256i shuffle[3], multiply[3];
+		for (int g = 0; g < layout.groups; g += 2)
+		{
+			shuffle[g / 2] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)layout.shuffle[g])),
+						_mm_loadu_si128((const __m128i *)layout.shuffle[g + 1]), 1);
+			multiply[g / 2] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)layout.multiply[g])),
+						_mm_loadu_si128((const __m128i *)layout.multiply[g + 1]), 1);
+		}
+		const __m256i top = _mm256_set1_epi16(short(0xffff << (16 - bitDepth)));
+		for ( ; done + perPeriod <= count && pos + layout.readBytes <= srcBytes; done += perPeriod, pos += layout.periodBytes)
+		{
+			for (int g = 0; g < layout.groups; g += 2)
+			{
+				__m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g]))),
+							_mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g + 1])), 1);
+				x = _mm256_shuffle_epi8(x, shuffle[g / 2]);
+				x = _mm256_and_si256(_mm256_mullo_epi16(x, multiply[g / 2]), top);
+				x = _mm256_or_si256(x, _mm256_srl_epi16(x, expand));
+				_mm256_storeu_si256((__m256i *)(dst + done + 8 * g), x);
+			}
+		}
+#else
+		__m128i shuffle[6], multiply[6];
+		for (int g = 0; g < layout.groups; g++)
+		{
+			shuffle[g] = _mm_loadu_si128((const __m128i *)layout.shuffle[g]);
+			multiply[g] = _mm_loadu_si128((const __m128i *)layout.multiply[g]);
+		}
+		const __m128i top = _mm_set1_epi16(short(0xffff << (16 - bitDepth)));
+		for ( ; done + perPeriod <= count && pos + layout.readBytes <= srcBytes; done += perPeriod, pos += layout.periodBytes)
+		{
+			for (int g = 0; g < layout.groups; g++)
+			{
+				__m128i x = _mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g]));
+				x = _mm_shuffle_epi8(x, shuffle[g]);
+				x = _mm_and_si128(_mm_mullo_epi16(x, multiply[g]), top);
+				x = _mm_or_si128(x, _mm_srl_epi16(x, expand));
+				_mm_storeu_si128((__m128i *)(dst + done + 8 * g), x);
+			}
+		}
+#endif
+		return done;
+	}
+#endif
+
+	// unpack nwords words of 10-bit filled data (padbits is 2 for method A,
+	// 0 for method B) into 3 * nwords values; the first datum of each word
+	// is in its most significant bits unless lsbFirst
+	inline void UnpackU10Filled(const U32 *src, U16 *dst, const int nwords, const bool lsbFirst, const int padbits)
+	{
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		UnpackLayout layout;
+		UnpackLayoutFilled(layout, padbits, lsbFirst);
+		done = UnpackWithLayout(layout, reinterpret_cast<const unsigned char *>(src), nwords * sizeof(U32), dst, 3 * nwords, 10);
+#endif
+		for (int w = done / 3; w < nwords; w++)
+		{
+			const U32 word = src[w];
+			for (int r = 0; r < 3; r++)
+			{
+				U16 d1 = U16(word >> ((lsbFirst ? 10 * r : 20 - 10 * r) + padbits) & 0x3ff);
+				BaseTypeConvertU10ToU16(d1, dst[3 * w + r]);
+			}
+		}
+	}
+
+	// unpack count datums of bitDepth (10 or 12) bits, packed one after
+	// another starting at the least significant bit of the first word
+	inline void UnpackPackedU16(const U32 *src, U16 *dst, const int count, const int bitDepth)
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src);
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		UnpackLayout layout;
+		UnpackLayoutPacked(layout, bitDepth);
+		done = UnpackWithLayout(layout, bytes, size_t((count * bitDepth + 31) / 32) * sizeof(U32), dst, count, bitDepth);
+#endif
+		const int reverse = 16 - bitDepth;
+		const int mask = (0xffff << reverse) & 0xffff;
+		for (int i = done; i < count; i++)
+		{
+			U16 d1;
+			memcpy(&d1, bytes + (i * bitDepth) / 8, sizeof(d1));
+			U16 d2 = U16(((d1 << (reverse - (i * bitDepth) % 8)) & mask) >> reverse);
+			if (bitDepth == 10)
+				BaseTypeConvertU10ToU16(d2, dst[i]);
+			else
+				BaseTypeConvertU12ToU16(d2, dst[i]);
+		}
+	}
+
 }
 
 #endif
@@ -92,6 +92,18 @@ bool cineon::ElementReadStream::ReadDirect(const cineon::Header &dpxHeader, cons
 
 
 
+const void * cineon::ElementReadStream::ReadMapped(const cineon::Header &dpxHeader, const long offset, const size_t size)
+{
+	// data in the other byte order has to be swapped, which we must not do
+	// to the stream's memory
+	if (dpxHeader.RequiresByteSwap() && dpxHeader.BitDepth(0) != 8)
+		return 0;
+
+	return this->fd->Mapped(dpxHeader.ImageOffset() + offset, size);
+}
+
+
+
 void cineon::ElementReadStream::EndianDataCheck(const cineon::Header &dpxHeader, void *buf, const size_t size)
 {
 	if (dpxHeader.RequiresByteSwap())
@@ -54,6 +54,10 @@ namespace cineon
 		virtual bool Read(const cineon::Header &, const long offset, void * buf, const size_t size);
 		virtual bool ReadDirect(const cineon::Header &, const long offset, void * buf, const size_t size);
 
+		// pointer to the data in place if the stream holds the file in memory
+		// and the data need no byte swapping, else NULL (use Read instead)
+		virtual const void * ReadMapped(const cineon::Header &, const long offset, const size_t size);
+
 	protected:
 		void EndianDataCheck(const cineon::Header &, void *, const size_t size);
 
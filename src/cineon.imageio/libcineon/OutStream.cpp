@@ -41,13 +41,14 @@
 
 namespace cineon {
 
-OutStream::OutStream() : fp(0)
+OutStream::OutStream() : fp(0), owned(false)
 {
 }
 
 
 OutStream::~OutStream()
 {
+	this->Close();
 }
 
 
@@ -55,20 +56,36 @@ bool OutStream::Open(const char *f)
 {
 	if (this->fp)
 		this->Close();
-	if ((this->fp = OIIO::Filesystem::fopen(f, "wb")) == 0)
+	OIIO::Filesystem::IOFile *io = new OIIO::Filesystem::IOFile(f, OIIO::Filesystem::IOProxy::Write);
+	if (!io->opened())
+	{
+		delete io;
 		return false;
+	}
+	this->fp = io;
+	this->owned = true;
+	return true;
+}
 
+
+bool OutStream::Open(OIIO::Filesystem::IOProxy *io)
+{
+	if (this->fp)
+		this->Close();
+	if (io == 0 || io->mode() != OIIO::Filesystem::IOProxy::Write)
+		return false;
+	this->fp = io;
+	this->owned = false;
 	return true;
 }
 
 
 void OutStream::Close()
 {
-	if (this->fp)
-	{
-		::fclose(this->fp);
-		this->fp = 0;
-	}
+	if (this->fp && this->owned)
+		delete this->fp;
+	this->fp = 0;
+	this->owned = false;
 }
 
 
@@ -76,7 +93,7 @@ size_t OutStream::Write(void *buf, const size_t size)
 {
 	if (this->fp == 0)
 		return false;
-	return ::fwrite(buf, 1, size, this->fp);
+    return this->fp->write(buf, size);
 }
 
 
@@ -98,20 +115,17 @@ bool OutStream::Seek(long offset, Origin origin)
 
 	if (this->fp == 0)
 		return false;
-	return (::fseek(this->fp, offset, o) == 0);
+	return this->fp->seek(offset, o);
 }
 
 
 void OutStream::Flush()
 {
 	if (this->fp)
-		::fflush(this->fp);
+		this->fp->flush();
 }
 
 }
 
 
 
-
-
-
@@ -239,7 +239,9 @@ endif ()
 # The USE_SIMD optinon may be set to a comma-separated list of machine /
 # instruction set optinos, such as "avx3,f16c". The list will be parsed and
 # the proper compiler directives added to generate code for those ISA
-# capabilities.
+# capabilities. There is no runtime dispatch: code that needs more than SSE2
+# (such as the DPX and Cineon 10/12-bit unpacking, which needs ssse3) falls
+# back to scalar code unless the build asks for it here.
 #
 set (USE_SIMD "" CACHE STRING "Use SIMD directives (0, sse2, sse3, ssse3, sse4.1, sse4.2, avx, avx2, avx512f, f16c, aes)")
 set (SIMD_COMPILE_FLAGS "")
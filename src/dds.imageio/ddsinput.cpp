@@ -27,7 +27,13 @@ public:
     DDSInput() { init(); }
     virtual ~DDSInput() { close(); }
     virtual const char* format_name(void) const override { return "dds"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual int current_subimage(void) const override
     {
@@ -47,7 +53,6 @@ public:
 
 private:
     std::string m_filename;            ///< Stash the filename
-    FILE* m_file;                      ///< Open image handle
     std::vector<unsigned char> m_buf;  ///< Buffer the image pixels
     int m_subimage;
     int m_miplevel;
@@ -65,7 +70,6 @@ private:
     ///
     void init()
     {
-        m_file     = NULL;
         m_subimage = -1;
         m_miplevel = -1;
         m_buf.clear();
@@ -95,10 +99,7 @@ private:
     ///
     bool fread(void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Read error");
-        return n == nitems;
+        return ioread(buf, itemsize, nitems);
     }
 };
 
@@ -132,11 +133,8 @@ DDSInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
 
-    m_file = Filesystem::fopen(name, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
 // due to struct packing, we may get a corrupt header if we just load the
 // struct from file; to adress that, read every member individually
@@ -155,7 +153,7 @@ DDSInput::open(const std::string& name, ImageSpec& newspec)
     RH(mipmaps);
 
     // advance the file pointer by 44 bytes (reserved fields)
-    fseek(m_file, 44, SEEK_CUR);
+    ioseek(44, SEEK_CUR);
 
     // pixel format struct
     RH(fmt.size);
@@ -172,7 +170,7 @@ DDSInput::open(const std::string& name, ImageSpec& newspec)
     RH(caps.flags2);
 
     // advance the file pointer by 8 bytes (reserved fields)
-    fseek(m_file, 8, SEEK_CUR);
+    ioseek(8, SEEK_CUR);
 #undef RH
     if (bigendian()) {
         // DDS files are little-endian
@@ -384,7 +382,7 @@ DDSInput::internal_seek_subimage(int cubeface, int miplevel, unsigned int& w,
         }
     }
     // seek to the offset we've found
-    fseek(m_file, ofs, SEEK_SET);
+    ioseek(ofs);
 }
 
 
@@ -582,7 +580,7 @@ DDSInput::internal_readimg(unsigned char* dst, int w, int h, int d)
 bool
 DDSInput::readimg_scanlines()
 {
-    //std::cerr << "[dds] readimg: " << ftell (m_file) << "\n";
+    //std::cerr << "[dds] readimg: " << iotell() << "\n";
     // resize destination buffer
     m_buf.resize(m_spec.scanline_bytes() * m_spec.height * m_spec.depth
                  /*/ (1 << m_miplevel)*/);
@@ -606,13 +604,19 @@ DDSInput::readimg_tiles()
 
 
 bool
-DDSInput::close()
+DDSInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
 
+
+
+bool
+DDSInput::close()
+{
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
@@ -24,6 +24,10 @@ public:
     DPXInput() { init(); }
     virtual ~DPXInput() { close(); }
     virtual const char* format_name(void) const override { return "dpx"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
     virtual bool open(const std::string& name, ImageSpec& newspec,
@@ -122,10 +126,13 @@ DPXInput::valid_file(const std::string& filename) const
 bool
 DPXInput::open(const std::string& name, ImageSpec& newspec)
 {
-    // open the image
+    // open the image, reading through the app's proxy if there is one
+    if (!ioproxy_use_or_open(name))
+        return false;
     m_stream = new InStream();
-    if (!m_stream->Open(name.c_str())) {
+    if (!m_stream->Open(ioproxy())) {
         errorf("Could not open file \"%s\"", name);
+        close();
         return false;
     }
 
@@ -154,6 +161,7 @@ DPXInput::open(const std::string& name, ImageSpec& newspec,
     m_rawcolor = config.get_int_attribute("dpx:RawColor")
                  || config.get_int_attribute("dpx:RawData")  // deprecated
                  || config.get_int_attribute("oiio:RawColor");
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
@@ -549,6 +557,7 @@ bool
 DPXInput::close()
 {
     init();  // Reset to initial state
+    ioproxy_clear();
     return true;
 }
 
@@ -34,7 +34,7 @@ public:
         if (feature == "multiimage" || feature == "alpha"
             || feature == "nchannels" || feature == "random_access"
             || feature == "rewrite" || feature == "displaywindow"
-            || feature == "origin")
+            || feature == "origin" || feature == "ioproxy")
             return true;
         return false;
     }
@@ -190,11 +190,15 @@ DPXOutput::open(const std::string& name, const ImageSpec& userspec,
 
     if (is_opened())
         close();  // Close any already-opened file
+    ioproxy_retrieve_from_config(m_subimage_specs[0]);
+    if (!ioproxy_use_or_open(name))
+        return false;
     m_stream = new OutStream();
-    if (!m_stream->Open(name.c_str())) {
+    if (!m_stream->Open(ioproxy())) {
         errorf("Could not open \"%s\"", name);
         delete m_stream;
         m_stream = nullptr;
+        ioproxy_clear();
         return false;
     }
     m_dpx.SetOutStream(m_stream);
@@ -605,6 +609,7 @@ DPXOutput::close()
     ok &= write_buffer();
     m_dpx.Finish();
     init();  // Reset to initial state
+    ioproxy_clear();
     return ok;
 }
 
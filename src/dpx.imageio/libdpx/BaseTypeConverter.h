@@ -37,6 +37,12 @@
 #define _DPX_BASETYPECONVERTER_H 1
 
 
+#include <algorithm>
+#include <cstring>
+
+#include <OpenImageIO/simd.h>
+
+
 namespace dpx
 {
 	// convert between all of the DPX base types in a controllable way
@@ -192,6 +198,321 @@ namespace dpx
 		dst = (src << 4) | (src >> 8);
 	}
 	
+	
+	// Bulk 10/12-bit conversions
+	//
+	// The reader and writer convert whole runs of 10-bit and 12-bit data to
+	// and from U16 with these rather than datum by datum. Promotion is the
+	// same as BaseTypeConvertU10ToU16/BaseTypeConvertU12ToU16, demotion is
+	// truncation. With SSSE3 and up, each 10/12-bit field is gathered into a
+	// 16-bit lane with a byte shuffle, 8 values per 128 bits (16 per 256 bits
+	// with AVX2); remainders and other architectures use the scalar code.
+	//
+	// N.B. like the rest of OIIO's SIMD code, the choice is made when
+	// compiling, not at runtime: the default x86-64 build is only SSE2 and
+	// gets the scalar code. Build with USE_SIMD=ssse3 (or higher, e.g.
+	// sse4.2 or avx2) to get the shuffle kernels, on machines that have it.
+	
+#if OIIO_SIMD_SSE >= 3
+	// periods of the layouts unpacked per loop iteration, so that AVX2
+	// always has a pair of 8 value groups to fill a register
+	const int kUnpackPeriods = (OIIO_SIMD_AVX >= 2) ? 2 : 1;
+	
+	// where the values of one period of a layout live in the source, in
+	// groups of 8, for the shuffle based unpacking
+	struct UnpackLayout
+	{
+		int groups;							// groups of 8 values per period
+		int periodBytes;					// source bytes per period
+		int readBytes;						// source bytes read per period
+		int offset[6];						// source byte offset of each group
+		unsigned char shuffle[6][16];		// gathers the 16 bits holding each value
+		U16 multiply[6][8];					// shifts each value to the top bits
+	};
+	
+	// value j of the period is the bitDepth bits starting at bit pos[j]
+	// of the little-endian source
+	inline void UnpackLayoutBuild(UnpackLayout &layout, const int *pos, const int bitDepth)
+	{
+		layout.readBytes = 0;
+		for (int g = 0; g < layout.groups; g++)
+		{
+			const int *gpos = pos + 8 * g;
+			layout.offset[g] = gpos[0] / 8;
+			for (int k = 1; k < 8; k++)
+				layout.offset[g] = std::min(layout.offset[g], gpos[k] / 8);
+			layout.readBytes = std::max(layout.readBytes, layout.offset[g] + 16);
+			for (int k = 0; k < 8; k++)
+			{
+				const int byte = gpos[k] / 8 - layout.offset[g];
+				layout.shuffle[g][2 * k] = (unsigned char)byte;
+				layout.shuffle[g][2 * k + 1] = (unsigned char)(byte + 1);
+				layout.multiply[g][k] = U16(1 << (16 - bitDepth - gpos[k] % 8));
+			}
+		}
+	}
+	
+	// 10-bit filled: a period is 8 words, 24 datums
+	inline void UnpackLayoutFilled(UnpackLayout &layout, const int padbits, const bool lsbFirst)
+	{
+		int pos[48];
+		layout.groups = 3 * kUnpackPeriods;
+		layout.periodBytes = 32 * kUnpackPeriods;
+		for (int j = 0; j < 8 * layout.groups; j++)
+		{
+			const int r = j % 3;
+			pos[j] = 32 * (j / 3) + (lsbFirst ? 10 * r : 20 - 10 * r) + padbits;
+		}
+		UnpackLayoutBuild(layout, pos, 10);
+	}
+	
+	// 10/12-bit packed: a period is 8 datums, bitDepth bytes
+	inline void UnpackLayoutPacked(UnpackLayout &layout, const int bitDepth)
+	{
+		int pos[16];
+		layout.groups = kUnpackPeriods;
+		layout.periodBytes = bitDepth * kUnpackPeriods;
+		for (int j = 0; j < 8 * layout.groups; j++)
+			pos[j] = bitDepth * j;
+		UnpackLayoutBuild(layout, pos, bitDepth);
+	}
+	
+	// unpack whole periods of the layout from src, which has srcBytes
+	// bytes, into at most count values of dst; returns the number of values
+	// unpacked
+	inline int UnpackWithLayout(const UnpackLayout &layout, const unsigned char *src, const size_t srcBytes, U16 *dst, const int count, const int bitDepth)
+	{
+		const int perPeriod = 8 * layout.groups;
+		const __m128i expand = _mm_cvtsi32_si128(bitDepth);
+		int done = 0;
+		size_t pos = 0;
+#if OIIO_SIMD_AVX >= 2
+		__m256i shuffle[3], multiply[3];
+		for (int g = 0; g < layout.groups; g += 2)
+		{
+			shuffle[g / 2] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)layout.shuffle[g])),
+						_mm_loadu_si128((const __m128i *)layout.shuffle[g + 1]), 1);
+			multiply[g / 2] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)layout.multiply[g])),
+						_mm_loadu_si128((const __m128i *)layout.multiply[g + 1]), 1);
+		}
+		const __m256i top = _mm256_set1_epi16(short(0xffff << (16 - bitDepth)));
+		for ( ; done + perPeriod <= count && pos + layout.readBytes <= srcBytes; done += perPeriod, pos += layout.periodBytes)
+		{
+			for (int g = 0; g < layout.groups; g += 2)
+			{
+				__m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g]))),
+							_mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g + 1])), 1);
+				x = _mm256_shuffle_epi8(x, shuffle[g / 2]);
+				x = _mm256_and_si256(_mm256_mullo_epi16(x, multiply[g / 2]), top);
+				x = _mm256_or_si256(x, _mm256_srl_epi16(x, expand));
+				_mm256_storeu_si256((__m256i *)(dst + done + 8 * g), x);
+			}
+		}
+#else
+		__m128i shuffle[6], multiply[6];
+		for (int g = 0; g < layout.groups; g++)
+		{
+			shuffle[g] = _mm_loadu_si128((const __m128i *)layout.shuffle[g]);
+			multiply[g] = _mm_loadu_si128((const __m128i *)layout.multiply[g]);
+		}
+		const __m128i top = _mm_set1_epi16(short(0xffff << (16 - bitDepth)));
+		for ( ; done + perPeriod <= count && pos + layout.readBytes <= srcBytes; done += perPeriod, pos += layout.periodBytes)
+		{
+			for (int g = 0; g < layout.groups; g++)
+			{
+				__m128i x = _mm_loadu_si128((const __m128i *)(src + pos + layout.offset[g]));
+				x = _mm_shuffle_epi8(x, shuffle[g]);
+				x = _mm_and_si128(_mm_mullo_epi16(x, multiply[g]), top);
+				x = _mm_or_si128(x, _mm_srl_epi16(x, expand));
+				_mm_storeu_si128((__m128i *)(dst + done + 8 * g), x);
+			}
+		}
+#endif
+		return done;
+	}
+#endif
+	
+	// unpack nwords words of 10-bit filled data (padbits is 2 for method A,
+	// 0 for method B) into 3 * nwords values; the first datum of each word
+	// is in its most significant bits unless lsbFirst
+	inline void UnpackU10Filled(const U32 *src, U16 *dst, const int nwords, const bool lsbFirst, const int padbits)
+	{
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		UnpackLayout layout;
+		UnpackLayoutFilled(layout, padbits, lsbFirst);
+		done = UnpackWithLayout(layout, reinterpret_cast<const unsigned char *>(src), nwords * sizeof(U32), dst, 3 * nwords, 10);
+#endif
+		for (int w = done / 3; w < nwords; w++)
+		{
+			const U32 word = src[w];
+			for (int r = 0; r < 3; r++)
+			{
+				U16 d1 = U16(word >> ((lsbFirst ? 10 * r : 20 - 10 * r) + padbits) & 0x3ff);
+				BaseTypeConvertU10ToU16(d1, dst[3 * w + r]);
+			}
+		}
+	}
+	
+	// unpack count datums of bitDepth (10 or 12) bits, packed one after
+	// another starting at the least significant bit of the first word
+	inline void UnpackPackedU16(const U32 *src, U16 *dst, const int count, const int bitDepth)
+	{
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src);
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		UnpackLayout layout;
+		UnpackLayoutPacked(layout, bitDepth);
+		done = UnpackWithLayout(layout, bytes, size_t((count * bitDepth + 31) / 32) * sizeof(U32), dst, count, bitDepth);
+#endif
+		const int reverse = 16 - bitDepth;
+		const int mask = (0xffff << reverse) & 0xffff;
+		for (int i = done; i < count; i++)
+		{
+			U16 d1;
+			memcpy(&d1, bytes + (i * bitDepth) / 8, sizeof(d1));
+			U16 d2 = U16(((d1 << (reverse - (i * bitDepth) % 8)) & mask) >> reverse);
+			if (bitDepth == 10)
+				BaseTypeConvertU10ToU16(d2, dst[i]);
+			else
+				BaseTypeConvertU12ToU16(d2, dst[i]);
+		}
+	}
+	
+	// promote count 12-bit filled method B values (in the low 12 bits)
+	inline void UnpackU12FilledMethodB(const U16 *src, U16 *dst, const int count)
+	{
+		int i = 0;
+#if OIIO_SIMD_AVX >= 2
+		for ( ; i + 16 <= count; i += 16)
+		{
+			__m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+			_mm256_storeu_si256((__m256i *)(dst + i), _mm256_or_si256(_mm256_slli_epi16(x, 4), _mm256_srli_epi16(x, 8)));
+		}
+#endif
+#if OIIO_SIMD_SSE
+		for ( ; i + 8 <= count; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+			_mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_slli_epi16(x, 4), _mm_srli_epi16(x, 8)));
+		}
+#endif
+		for ( ; i < count; i++)
+		{
+			U16 d1 = src[i];
+			BaseTypeConvertU12ToU16(d1, dst[i]);
+		}
+	}
+	
+	// pack 3 * nwords values into 10-bit filled words (padbits is 2 for
+	// method A, 0 for method B), the first of each three in the least
+	// significant bits unless reverse; dst may be the same memory as src.
+	// Returns the number of words packed, the caller packs the rest.
+	inline int PackU10Filled(const U16 *src, U32 *dst, const int nwords, const bool reverse, const int padbits)
+	{
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		// the 4 words of a group come from 12 values, 24 bytes, of which
+		// lo has the first 16 and hi the last 16; for each datum position
+		// in the word, gather those values into the low bits of 32-bit lanes
+		unsigned char lo[3][16], hi[3][16];
+		int shift[3];
+		for (int r = 0; r < 3; r++)
+		{
+			shift[r] = (reverse ? 10 * (2 - r) : 10 * r) + padbits;
+			for (int k = 0; k < 4; k++)
+			{
+				const int d = 3 * k + r;
+				for (int b = 0; b < 4; b++)
+				{
+					const bool inLo = (2 * d + 1 < 16);
+					lo[r][4 * k + b] = (b < 2 && inLo) ? (unsigned char)(2 * d + b) : 0x80;
+					hi[r][4 * k + b] = (b < 2 && !inLo) ? (unsigned char)(2 * d + b - 8) : 0x80;
+				}
+			}
+		}
+		const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src);
+		__m128i shiftv[3];
+		for (int r = 0; r < 3; r++)
+			shiftv[r] = _mm_cvtsi32_si128(shift[r]);
+#if OIIO_SIMD_AVX >= 2
+		__m256i lo8[3], hi8[3];
+		for (int r = 0; r < 3; r++)
+		{
+			lo8[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lo[r]));
+			hi8[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hi[r]));
+		}
+		// 8 words from 24 values at a time, all loaded before anything is
+		// stored, and the stores never pass the values still to be read
+		for ( ; done + 8 <= nwords; done += 8)
+		{
+			const unsigned char *s = bytes + 6 * done;
+			__m256i l = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+						_mm_loadu_si128((const __m128i *)(s + 24)), 1);
+			__m256i h = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(s + 8))),
+						_mm_loadu_si128((const __m128i *)(s + 32)), 1);
+			__m256i word = _mm256_setzero_si256();
+			for (int r = 0; r < 3; r++)
+			{
+				__m256i v = _mm256_or_si256(_mm256_shuffle_epi8(l, lo8[r]), _mm256_shuffle_epi8(h, hi8[r]));
+				word = _mm256_or_si256(word, _mm256_sll_epi32(_mm256_srli_epi32(v, 6), shiftv[r]));
+			}
+			_mm256_storeu_si256((__m256i *)(dst + done), word);
+		}
+#endif
+		__m128i lo4[3], hi4[3];
+		for (int r = 0; r < 3; r++)
+		{
+			lo4[r] = _mm_loadu_si128((const __m128i *)lo[r]);
+			hi4[r] = _mm_loadu_si128((const __m128i *)hi[r]);
+		}
+		for ( ; done + 4 <= nwords; done += 4)
+		{
+			const unsigned char *s = bytes + 6 * done;
+			__m128i l = _mm_loadu_si128((const __m128i *)s);
+			__m128i h = _mm_loadu_si128((const __m128i *)(s + 8));
+			__m128i word = _mm_setzero_si128();
+			for (int r = 0; r < 3; r++)
+			{
+				__m128i v = _mm_or_si128(_mm_shuffle_epi8(l, lo4[r]), _mm_shuffle_epi8(h, hi4[r]));
+				word = _mm_or_si128(word, _mm_sll_epi32(_mm_srli_epi32(v, 6), shiftv[r]));
+			}
+			_mm_storeu_si128((__m128i *)(dst + done), word);
+		}
+#endif
+		return done;
+	}
+	
+	// pack the first count values, in groups of 8, into consecutive
+	// bitDepth (10 or 12) bit fields starting at the least significant bit
+	// of dst; dst may be the same memory as src. Returns the number of
+	// values packed, the caller packs the rest.
+	inline int PackPackedU16(const U16 *src, unsigned char *dst, const int count, const int bitDepth)
+	{
+		int done = 0;
+#if OIIO_SIMD_SSE >= 3
+		// pairs of values are joined into 32-bit lanes by a multiply-add,
+		// pairs of those into 64-bit lanes, then the bytes are compacted
+		const int half = bitDepth / 2;
+		unsigned char compact[16];
+		for (int i = 0; i < 16; i++)
+			compact[i] = (i < half) ? (unsigned char)i : (i < 2 * half) ? (unsigned char)(8 + i - half) : 0x80;
+		const __m128i compactv = _mm_loadu_si128((const __m128i *)compact);
+		const __m128i down = _mm_cvtsi32_si128(16 - bitDepth);
+		const __m128i pair = _mm_set1_epi32(1 | (1 << (16 + bitDepth)));
+		const __m128i merge = _mm_cvtsi32_si128(32 - 2 * bitDepth);
+		const __m128i low = _mm_set1_epi64x((1LL << (2 * bitDepth)) - 1);
+		for ( ; done + 8 <= count; done += 8)
+		{
+			__m128i x = _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + done)), down);
+			x = _mm_madd_epi16(x, pair);
+			x = _mm_or_si128(_mm_and_si128(x, low), _mm_andnot_si128(low, _mm_srl_epi64(x, merge)));
+			_mm_storeu_si128((__m128i *)(dst + done * bitDepth / 8), _mm_shuffle_epi8(x, compactv));
+		}
+#endif
+		return done;
+	}
+
 }
 
 #endif
@@ -41,6 +41,8 @@
 
 #include <cstdio>
 
+#include <OpenImageIO/filesystem.h>
+
 
 
 /*!
@@ -80,6 +82,13 @@ class InStream
 	 * \return success true/false
 	 */
 	virtual bool Open(const char * fn);
+
+	/*!
+	 * \brief Read through an IOProxy owned by the caller
+	 * \param io IOProxy, positioned at the start of the DPX data
+	 * \return success true/false
+	 */
+	bool Open(OIIO::Filesystem::IOProxy * io);
 	
 	/*!
 	 * \brief Close file
@@ -122,8 +131,18 @@ class InStream
 	 */ 	
 	virtual bool Seek(long offset, Origin origin);
 
+	/*!
+	 * \brief Direct access to file data the stream already holds in memory
+	 * \param offset offset from the beginning of the file
+	 * \param size bytes wanted
+	 * \return pointer to the bytes, or NULL if the stream does not hold the
+	 * whole file in memory (IOMemReader or IOMMap) or they are out of range
+	 */
+	const void * Mapped(const long offset, const size_t size) const;
+
   protected:
-	FILE *fp;
+	OIIO::Filesystem::IOProxy *fp;
+	bool owned;							//!< fp was opened by us
 };
 
 
@@ -164,6 +183,13 @@ class OutStream
 	 * \return success true/false
 	 */
 	virtual bool Open(const char *fn);
+
+	/*!
+	 * \brief Write through an IOProxy owned by the caller
+	 * \param io IOProxy to write to
+	 * \return success true/false
+	 */
+	bool Open(OIIO::Filesystem::IOProxy * io);
 		
 	/*!
 	 * \brief Close file
@@ -204,7 +230,8 @@ class OutStream
 		
 		
   protected:
-	FILE *fp;
+	OIIO::Filesystem::IOProxy *fp;
+	bool owned;							//!< fp was opened by us
 };
 
 
@@ -92,6 +92,18 @@ bool dpx::ElementReadStream::ReadDirect(const dpx::Header &dpxHeader, const int
 
 
 
+const void * dpx::ElementReadStream::ReadMapped(const dpx::Header &dpxHeader, const int element, const long offset, const size_t size)
+{
+	// data in the other byte order has to be swapped, which we must not do
+	// to the stream's memory
+	if (dpxHeader.RequiresByteSwap() && dpxHeader.BitDepth(element) != 8)
+		return 0;
+
+	return this->fd->Mapped(dpxHeader.DataOffset(element) + offset, size);
+}
+
+
+
 void dpx::ElementReadStream::EndianDataCheck(const dpx::Header &dpxHeader, const int element, void *buf, const size_t size)
 {
 	if (dpxHeader.RequiresByteSwap())
@@ -54,6 +54,10 @@ namespace dpx
 		virtual bool Read(const dpx::Header &, const int element, const long offset, void * buf, const size_t size);
 		virtual bool ReadDirect(const dpx::Header &, const int element, const long offset, void * buf, const size_t size);
 
+		// pointer to the data in place if the stream holds the file in memory
+		// and the data need no byte swapping, else NULL (use Read instead)
+		virtual const void * ReadMapped(const dpx::Header &, const int element, const long offset, const size_t size);
+
 	protected:
 		void EndianDataCheck(const dpx::Header &, const int element, void *, const size_t size);
 		
@@ -40,13 +40,14 @@
 #include "DPXStream.h"
 
 
-InStream::InStream() : fp(0)
+InStream::InStream() : fp(0), owned(false)
 {
 }
 
 
 InStream::~InStream()
 {
+	this->Close();
 }
 
 
@@ -54,27 +55,43 @@ bool InStream::Open(const char *f)
 {
 	if (this->fp)
 		this->Close();
-	if ((this->fp = OIIO::Filesystem::fopen(f, "rb")) == 0)
+	OIIO::Filesystem::IOFile *io = new OIIO::Filesystem::IOFile(f, OIIO::Filesystem::IOProxy::Read);
+	if (!io->opened())
+	{
+		delete io;
 		return false;
-		
+	}
+	this->fp = io;
+	this->owned = true;
 	return true;
 }
 
 
-void InStream::Close()
+bool InStream::Open(OIIO::Filesystem::IOProxy *io)
 {
 	if (this->fp)
-	{
-		::fclose(this->fp);
-		this->fp = 0;
-	}
+		this->Close();
+	if (io == 0 || io->mode() != OIIO::Filesystem::IOProxy::Read)
+		return false;
+	this->fp = io;
+	this->owned = false;
+	return true;
+}
+
+
+void InStream::Close()
+{
+	if (this->fp && this->owned)
+		delete this->fp;
+	this->fp = 0;
+	this->owned = false;
 }
 
 
 void InStream::Rewind()
 {
 	if (this->fp)
-		::rewind(fp);
+		this->fp->seek(0);
 }
 
 
@@ -96,7 +113,7 @@ bool InStream::Seek(long offset, Origin origin)
 	
 	if (this->fp == 0)
 		return false;
-	return (::fseek(this->fp, offset, o) == 0);
+	return this->fp->seek(offset, o);
 }
 
 
@@ -105,7 +122,7 @@ size_t InStream::Read(void *buf, const size_t size)
 {
 	if (this->fp == 0)
 		return 0;
-	return ::fread(buf, 1, size, this->fp);
+	return this->fp->read(buf, size);
 }
 
 
@@ -115,14 +132,22 @@ size_t InStream::ReadDirect(void *buf, const size_t size)
 }
 
 
+const void *InStream::Mapped(const long offset, const size_t size) const
+{
+	const OIIO::Filesystem::IOMemReader *mem = dynamic_cast<const OIIO::Filesystem::IOMemReader *>(this->fp);
+	if (mem == 0 || offset < 0)
+		return 0;
+	OIIO::cspan<unsigned char> buf = mem->buffer();
+	if (size_t(offset) > size_t(buf.size()) || size > size_t(buf.size()) - size_t(offset))
+		return 0;
+	return buf.data() + offset;
+}
+
+
 bool InStream::EndOfFile() const 
 {
 	if (this->fp == 0)
 		return true;
-	return ::feof(this->fp);
+	return this->fp->tell() >= int64_t(this->fp->size());
 }
 
-
-
-
-
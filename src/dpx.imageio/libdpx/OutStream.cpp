@@ -39,13 +39,14 @@
 #include "DPXStream.h"
 
 
-OutStream::OutStream() : fp(0)
+OutStream::OutStream() : fp(0), owned(false)
 {
 }
 
 
 OutStream::~OutStream()
 {
+	this->Close();
 }
 
 
@@ -53,20 +54,36 @@ bool OutStream::Open(const char *f)
 {
 	if (this->fp)
 		this->Close();
-	if ((this->fp = OIIO::Filesystem::fopen(f, "wb")) == 0)
+	OIIO::Filesystem::IOFile *io = new OIIO::Filesystem::IOFile(f, OIIO::Filesystem::IOProxy::Write);
+	if (!io->opened())
+	{
+		delete io;
 		return false;
-		
+	}
+	this->fp = io;
+	this->owned = true;
 	return true;
 }
 
 
-void OutStream::Close()
+bool OutStream::Open(OIIO::Filesystem::IOProxy *io)
 {
 	if (this->fp)
-	{
-		::fclose(this->fp);
-		this->fp = 0;
-	}
+		this->Close();
+	if (io == 0 || io->mode() != OIIO::Filesystem::IOProxy::Write)
+		return false;
+	this->fp = io;
+	this->owned = false;
+	return true;
+}
+
+
+void OutStream::Close()
+{
+	if (this->fp && this->owned)
+		delete this->fp;
+	this->fp = 0;
+	this->owned = false;
 }
 
 
@@ -74,7 +91,7 @@ size_t OutStream::Write(void *buf, const size_t size)
 {
 	if (this->fp == 0)
 		return false;
-    return ::fwrite(buf, 1, size, this->fp);
+    return this->fp->write(buf, size);
 }
 
 
@@ -96,19 +113,13 @@ bool OutStream::Seek(long offset, Origin origin)
 	
 	if (this->fp == 0)
 		return false;
-	return (::fseek(this->fp, offset, o) == 0);
+	return this->fp->seek(offset, o);
 }
 
 
 void OutStream::Flush()
 {
 	if (this->fp)
-		::fflush(this->fp);
+		this->fp->flush();
 }
 
-
-
-
-
-
-
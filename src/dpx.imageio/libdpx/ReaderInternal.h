@@ -38,6 +38,7 @@
 
 
 #include <algorithm>
+#include <stdint.h>
 #include "BaseTypeConverter.h"
 
 
@@ -60,9 +61,69 @@
 namespace dpx 
 {
 
+	// get size bytes at offset within the image element -- in place if the
+	// stream holds the file in memory and the data need no byte swapping and
+	// are aligned for T, otherwise read into readBuf
+	template <typename IR, typename T>
+	const T *ReadOrMap(const Header &dpxHeader, IR *fd, const int element, const long offset, T *readBuf, const size_t size)
+	{
+		const void *p = fd->ReadMapped(dpxHeader, element, offset, size);
+		if (p && reinterpret_cast<uintptr_t>(p) % sizeof(T) == 0)
+			return reinterpret_cast<const T *>(p);
+		fd->Read(dpxHeader, element, offset, readBuf, size);
+		return readBuf;
+	}
+
+
+	// U16 buffers, which is what the 10 and 12-bit data are read into, are
+	// unpacked with the bulk conversions of BaseTypeConverter.h; for other
+	// buffer types these do nothing and the data are converted datum by datum
+
+	// whole words of 10-bit filled data, returns the number of words unpacked
+	inline int Unfill10bitFilledBulk(const U32 *readBuf, U16 *obuf, const int nwords, const bool lsbFirst, const int padbits)
+	{
+		UnpackU10Filled(readBuf, obuf, nwords, lsbFirst, padbits);
+		return nwords;
+	}
+
+	template <typename BUF>
+	inline int Unfill10bitFilledBulk(const U32 *, BUF *, const int, const bool, const int)
+	{
+		return 0;
+	}
+
+	// 10 or 12-bit packed data, returns whether they were unpacked
+	inline bool UnPackPackedBulk(const U32 *readBuf, const int bitDepth, U16 *obuf, const int count)
+	{
+		if (bitDepth != 10 && bitDepth != 12)
+			return false;
+		UnpackPackedU16(readBuf, obuf, count, bitDepth);
+		return true;
+	}
+
+	template <typename BUF>
+	inline bool UnPackPackedBulk(const U32 *, const int, BUF *, const int)
+	{
+		return false;
+	}
+
+	// 12-bit filled method B data, returns whether they were unpacked
+	inline bool Read12bitFilledMethodBBulk(const U16 *readBuf, U16 *obuf, const int count)
+	{
+		UnpackU12FilledMethodB(readBuf, obuf, count);
+		return true;
+	}
+
+	template <typename BUF>
+	inline bool Read12bitFilledMethodBBulk(const U16 *, BUF *, const int)
+	{
+		return false;
+	}
+
+
 	// this function is called when the DataSize is 10 bit and the packing method is kFilledMethodA or kFilledMethodB
 	template<typename BUF, int PADDINGBITS>
-	void Unfill10bitFilled(U32 *readBuf, const int x, BUF *data, int count, int bufoff, const int numberOfComponents)
+	void Unfill10bitFilled(const U32 *readBuf, const int x, BUF *data, int count, int bufoff, const int numberOfComponents)
 	{
 		// unpack the words in the buffer
 		BUF *obuf = data + bufoff;
@@ -160,20 +221,27 @@ namespace dpx
 			// determine buffer offset
 			int bufoff = line * datums;
 	
-			fd->Read(dpxHeader, element, offset, readBuf, readSize);
+			const U32 *rbuf = ReadOrMap(dpxHeader, fd, element, offset, readBuf, readSize);
 	
 			// unpack the words in the buffer
 #if RLE_WORKING			
 			int count = (block.x2 - block.x1 + 1) * numberOfComponents;
-			Unfill10bitFilled<BUF, PADDINGBITS>(readBuf, block.x1, data, count, bufoff, numberOfComponents);
+			Unfill10bitFilled<BUF, PADDINGBITS>(rbuf, block.x1, data, count, bufoff, numberOfComponents);
 #else					
 			BUF *obuf = data + bufoff;
 			int index = (block.x1 * sizeof(U32)) % numberOfComponents;
+			const int datumCount = (block.x2 - block.x1 + 1) * numberOfComponents;
+
+			// whole words in bulk when they start on a word (1-channel images
+			// have their datums in the opposite order, see below), the rest here
+			int done = 0;
+			if (index == 0)
+				done = 3 * Unfill10bitFilledBulk(rbuf, obuf, datumCount / 3, numberOfComponents == 1, PADDINGBITS);
 
-			for (int count = (block.x2 - block.x1 + 1) * numberOfComponents - 1; count >= 0; count--)
+			for (int count = datumCount - 1; count >= done; count--)
 			{
 				// unpacking the buffer backwords
-				U16 d1 = U16(readBuf[(count + index) / 3] >> ((2 - (count + index) % 3) * 10 + PADDINGBITS) & 0x3ff);
+				U16 d1 = U16(rbuf[(count + index) / 3] >> ((2 - (count + index) % 3) * 10 + PADDINGBITS) & 0x3ff);
 				BaseTypeConvertU10ToU16(d1, d1);
 
 				BaseTypeConverter(d1, obuf[count]);
@@ -207,10 +275,13 @@ namespace dpx
 	// 10 bit, packed data
 	// 12 bit, packed data
 	template <typename BUF, U32 MASK, int MULTIPLIER, int REMAIN, int REVERSE>
-	void UnPackPacked(U32 *readBuf, const int bitDepth, BUF *data, int count, int bufoff)
+	void UnPackPacked(const U32 *readBuf, const int bitDepth, BUF *data, int count, int bufoff)
 	{
 		// unpack the words in the buffer
 		BUF *obuf = data + bufoff;
+
+		if (UnPackPackedBulk(readBuf, bitDepth, obuf, count))
+			return;
 				
 		for (int i = count - 1; i >= 0; i--)
 		{
@@ -231,7 +302,7 @@ namespace dpx
 			//      the pattern repeats every 96 bits
 			
 			// first determine the word that the data element completely resides in
-			U16 *d1 = reinterpret_cast<U16 *>(reinterpret_cast<U8 *>(readBuf)+((i * bitDepth) / 8 /*bits*/));
+			const U16 *d1 = reinterpret_cast<const U16 *>(reinterpret_cast<const U8 *>(readBuf)+((i * bitDepth) / 8 /*bits*/));
 			
 			// place the component in the MSB and mask it for both 10-bit and 12-bit
 			U16 d2 = (*d1 << (REVERSE - ((i % REMAIN) * MULTIPLIER))) & MASK;
@@ -287,11 +358,11 @@ namespace dpx
 			// calculate buffer offset
 			int bufoff = line * dpxHeader.Width() * numberOfComponents;
 	
-			fd->Read(dpxHeader, element, offset, readBuf, readSize);
+			const U32 *rbuf = ReadOrMap(dpxHeader, fd, element, offset, readBuf, readSize);
 
 			// unpack the words in the buffer
 			int count = (block.x2 - block.x1 + 1) * numberOfComponents;
-			UnPackPacked<BUF, MASK, MULTIPLIER, REMAIN, REVERSE>(readBuf, dataSize, data, count, bufoff);
+			UnPackPacked<BUF, MASK, MULTIPLIER, REMAIN, REVERSE>(rbuf, dataSize, data, count, bufoff);
 		}
 
 		return true;
@@ -347,11 +418,14 @@ namespace dpx
 			}
 			else
 			{
-				fd->Read(dpxHeader, element, offset, readBuf, width*bytes);
+				const SRC *rbuf = ReadOrMap(dpxHeader, fd, element, offset, readBuf, width*bytes);
 							
 				// convert data		
 				for (int i = 0; i < width; i++)
-					BaseTypeConverter(readBuf[i], data[width*line+i]);
+				{
+					SRC d1 = rbuf[i];
+					BaseTypeConverter(d1, data[width*line+i]);
+				}
 			}
 	
 		}
@@ -385,12 +459,14 @@ namespace dpx
 			long offset = (line + block.y1) * imageWidth * numberOfComponents * 2 +
 						block.x1 * numberOfComponents * 2 + (line * eolnPad);
 	
-			fd->Read(dpxHeader, element, offset, readBuf, width*2);
+			const U16 *rbuf = ReadOrMap(dpxHeader, fd, element, offset, readBuf, width*2);
 				
 			// convert data		
+			if (Read12bitFilledMethodBBulk(rbuf, data + width*line, width))
+				continue;
 			for (int i = 0; i < width; i++)
 			{
-				U16 d1 = readBuf[i];
+				U16 d1 = rbuf[i];
 				BaseTypeConvertU12ToU16(d1, d1);
 				BaseTypeConverter(d1, data[width*line+i]);
 			}
@@ -140,6 +140,36 @@ namespace dpx
 	}
 
 
+	// U16 buffers, which is what the 10 and 12-bit data are written from,
+	// are packed with the bulk conversions of BaseTypeConverter.h as far as
+	// they go; these return the number of values packed, none for other
+	// buffer types
+
+	inline int WritePackedMethodBulk(const U16 *src, U16 *dst, const int len, const int bitDepth)
+	{
+		if (bitDepth != 10 && bitDepth != 12)
+			return 0;
+		return PackPackedU16(src, reinterpret_cast<unsigned char *>(dst), len, bitDepth);
+	}
+
+	template <typename IB>
+	inline int WritePackedMethodBulk(const IB *, IB *, const int, const int)
+	{
+		return 0;
+	}
+
+	inline int WritePackedMethodAB_10bitBulk(const U16 *src, U16 *dst, const int len, const bool reverse, const int padbits)
+	{
+		return 3 * PackU10Filled(src, reinterpret_cast<U32 *>(dst), len / 3, reverse, padbits);
+	}
+
+	template <typename IB>
+	inline int WritePackedMethodAB_10bitBulk(const IB *, IB *, const int, const bool, const int)
+	{
+		return 0;
+	}
+
+
 	template <typename IB, int BITDEPTH>
 	void WritePackedMethod(IB *src, IB *dst, const int len, const bool reverse, BufferAccess &access)
 	{	
@@ -159,7 +189,7 @@ namespace dpx
 			return;
 
 		int i, entry;
-		for (i = 0; i < len; i++)
+		for (i = WritePackedMethodBulk(src + access.offset, dst, len, BITDEPTH); i < len; i++)
 		{
 			// read value and determine write location
 			U32 value = static_cast<U32>(src[i+access.offset]) >> shift;
@@ -215,16 +245,17 @@ namespace dpx
 		// shift bits over 2 if Method A
 		const int method_shift = (METHOD == kFilledMethodA ? 2 : 0);
 		
-		// loop through the buffer
-		int i;
+		// loop through the buffer, after any whole words packed in bulk
+		int i = WritePackedMethodAB_10bitBulk(src + access.offset, dst, len, reverse, method_shift);
+		const int start = i;
 		U32 value = 0;
-		for (i = 0; i < len; i++)
+		for ( ; i < len; i++)
 		{
 			int div = i / 3;			// 3 10-bit values in a U32
 			int rem = i % 3;
 	
 			// write previously calculated value
-			if (i && rem == 0)
+			if (i > start && rem == 0)
 			{
 				dst_u32[div-1] = value;
 				value = 0;
@@ -243,7 +274,8 @@ namespace dpx
 		}
 		
 		// write last
-		dst_u32[(len+2)/3-1] = value;
+		if (len > start)
+			dst_u32[(len+2)/3-1] = value;
 
 		// adjust offset/length
 		// multiply * 2 because it takes two U16 = U32 and this func packs into a U32
@@ -45,11 +45,14 @@ public:
     virtual int supports(string_view feature) const override
     {
         return (feature == "arbitrary_metadata"
-                || feature == "exif"    // Because of arbitrary_metadata
-                || feature == "iptc");  // Because of arbitrary_metadata
+                || feature == "exif"  // Because of arbitrary_metadata
+                || feature == "iptc"  // Because of arbitrary_metadata
+                || feature == "ioproxy");
     }
     virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool close(void) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
@@ -57,13 +60,12 @@ public:
     virtual int current_subimage() const override { return m_cur_subimage; }
 
 private:
-    FILE* m_fd;
     std::string m_filename;
     int m_cur_subimage;
     int m_bitpix;              // number of bits that represents data value;
     int m_naxes;               // number of axses of the image (e.g dimensions)
     std::vector<int> m_naxis;  // axis sizes of each dimension
-    fpos_t m_filepos;          // current position in the file
+    int64_t m_filepos;         // current position in the file
     // here we store informations how many times COMMENT, HISTORY, HIERARCH
     // keywords has occured
     std::map<std::string, int> keys;
@@ -77,7 +79,6 @@ private:
 
     void init(void)
     {
-        m_fd = NULL;
         m_filename.clear();
         m_cur_subimage = 0;
         m_bitpix       = 0;
@@ -130,10 +131,9 @@ public:
                             stride_t ystride, stride_t zstride) override;
 
 private:
-    FILE* m_fd;
     std::string m_filename;
-    int m_bitpix;      // number of bits that represents data value;
-    fpos_t m_filepos;  // current position in the file
+    int m_bitpix;       // number of bits that represents data value;
+    int64_t m_filepos;  // current position in the file
     bool m_simple;     // does the header with SIMPLE key was written?
     std::vector<unsigned char> m_scratch;
     std::string m_sep;
@@ -141,7 +141,6 @@ private:
 
     void init(void)
     {
-        m_fd = NULL;
         m_filename.clear();
         m_bitpix = 0;
         m_simple = true;
@@ -150,8 +149,9 @@ private:
     }
 
     // save to FITS file all attributes from ImageSpace and after writing last
-    // attribute writes END keyword
-    void create_fits_header(void);
+    // attribute writes END keyword. Return true if all is ok, false if
+    // there was a write error.
+    bool create_fits_header(void);
 
     // save to FITS file some mandatory keywords: SIMPLE, BITPIX, NAXIS, NAXIS1
     // and NAXIS2 with their values.
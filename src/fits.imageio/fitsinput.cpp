@@ -38,15 +38,12 @@ OIIO_PLUGIN_EXPORTS_END
 bool
 FitsInput::valid_file(const std::string& filename) const
 {
-    FILE* fd = Filesystem::fopen(filename, "rb");
-    if (!fd)
+    Filesystem::IOFile file(filename, Filesystem::IOProxy::Read);
+    if (!file.opened())
         return false;
 
     char magic[6] = { 0 };
-    bool ok = (fread(magic, 1, 6, fd) == 6) && !strncmp(magic, "SIMPLE", 6);
-
-    fclose(fd);
-    return ok;
+    return (file.read(magic, 6) == 6) && !strncmp(magic, "SIMPLE", 6);
 }
 
 
@@ -58,16 +55,14 @@ FitsInput::open(const std::string& name, ImageSpec& spec)
     m_filename = name;
 
     // checking if the file exists and can be opened in READ mode
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorf("Could not open file \"%s\"", m_filename);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // checking if the file is FITS file
     char magic[6] = { 0 };
-    if (fread(magic, 1, 6, m_fd) != 6) {
+    if (ioproxy()->read(magic, 6) != 6) {
         errorf("%s isn't a FITS file", m_filename);
+        close();
         return false;  // Read failed
     }
 
@@ -77,7 +72,7 @@ FitsInput::open(const std::string& name, ImageSpec& spec)
         return false;
     }
     // moving back to the start of the file
-    fseek(m_fd, 0, SEEK_SET);
+    ioseek(0);
 
     subimage_search();
 
@@ -90,6 +85,16 @@ FitsInput::open(const std::string& name, ImageSpec& spec)
 
 
 
+bool
+FitsInput::open(const std::string& name, ImageSpec& spec,
+                const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
+}
+
+
+
 bool
 FitsInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
                                 void* data)
@@ -104,16 +109,9 @@ FitsInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
     std::vector<unsigned char> data_tmp(m_spec.scanline_bytes());
     long scanline_off = (m_spec.height - y) * m_spec.scanline_bytes();
-    fseek(m_fd, scanline_off, SEEK_CUR);
-    size_t n = fread(&data_tmp[0], 1, m_spec.scanline_bytes(), m_fd);
-    if (n != m_spec.scanline_bytes()) {
-        if (feof(m_fd))
-            errorf("Hit end of file unexpectedly (offset=%d, scanline %d)",
-                   ftell(m_fd), y);
-        else
-            errorf("read error");
+    if (!ioseek(scanline_off, SEEK_CUR)
+        || !ioread(&data_tmp[0], 1, m_spec.scanline_bytes()))
         return false;  // Read failed
-    }
 
     // in FITS image data is stored in big-endian so we have to switch to
     // little-endian on little-endian machines
@@ -136,7 +134,7 @@ FitsInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     memcpy(data, &data_tmp[0], data_tmp.size());
 
     // after reading scanline we set file pointer to the start of image data
-    fsetpos(m_fd, &m_filepos);
+    ioseek(m_filepos);
     return true;
 };
 
@@ -156,7 +154,7 @@ FitsInput::seek_subimage(int subimage, int miplevel)
 
     // setting file pointer to the beginning of IMAGE extension
     m_cur_subimage = subimage;
-    fseek(m_fd, m_subimages[m_cur_subimage].offset, SEEK_SET);
+    ioseek(m_subimages[m_cur_subimage].offset);
 
     if (!set_spec_info())
         return false;
@@ -182,7 +180,7 @@ FitsInput::set_spec_info()
     // now we can get the current position in the file
     // this is the start of the image data
     // we will need it in the read_native_scanline method
-    fgetpos(m_fd, &m_filepos);
+    m_filepos = iotell();
 
     if (m_bitpix == 8)
         m_spec.set_format(TypeDesc::UCHAR);
@@ -202,8 +200,7 @@ FitsInput::set_spec_info()
 bool
 FitsInput::close(void)
 {
-    if (m_fd)
-        fclose(m_fd);
+    ioproxy_clear();
     init();
     return true;
 }
@@ -216,13 +213,8 @@ FitsInput::read_fits_header(void)
     std::string fits_header(HEADER_SIZE, 0);
 
     // we read whole header at once
-    if (fread(&fits_header[0], 1, HEADER_SIZE, m_fd) != HEADER_SIZE) {
-        if (feof(m_fd))
-            errorf("Hit end of file unexpectedly (offset=%d)", ftell(m_fd));
-        else
-            errorf("read error");
+    if (!ioread(&fits_header[0], 1, HEADER_SIZE))
         return false;  // Read failed
-    }
 
     bool found_end = false;
     for (int i = 0; i < CARDS_PER_HEADER; ++i) {
@@ -384,18 +376,17 @@ void
 FitsInput::subimage_search()
 {
     // saving position of the file, just for safe)
-    fpos_t fpos;
-    fgetpos(m_fd, &fpos);
+    int64_t fpos = iotell();
 
     // starting reading headers from the beginning of the file
-    fseek(m_fd, 0, SEEK_SET);
+    ioseek(0);
 
     // we search for subimages by reading whole header and checking if it
     // starts by "SIMPLE" keyword (primary header is always image header)
     // or by "XTENSION= 'IMAGE   '" (it is image extensions)
     std::string hdu(HEADER_SIZE, 0);
     size_t offset = 0;
-    while (fread(&hdu[0], 1, HEADER_SIZE, m_fd) == HEADER_SIZE) {
+    while (ioproxy()->read(&hdu[0], HEADER_SIZE) == HEADER_SIZE) {
         if (!strncmp(&hdu[0], "SIMPLE", 6)
             || !strncmp(&hdu[0], "XTENSION= 'IMAGE   '", 20)) {
             fits_pvt::Subimage newSub;
@@ -405,7 +396,7 @@ FitsInput::subimage_search()
         }
         offset += HEADER_SIZE;
     }
-    fsetpos(m_fd, &fpos);
+    ioseek(fpos);
 }
 
 
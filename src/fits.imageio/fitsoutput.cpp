@@ -32,8 +32,9 @@ FitsOutput::supports(string_view feature) const
     return (feature == "multiimage" || feature == "alpha"
             || feature == "nchannels" || feature == "random_access"
             || feature == "arbitrary_metadata"
-            || feature == "exif"    // Because of arbitrary_metadata
-            || feature == "iptc");  // Because of arbitrary_metadata
+            || feature == "exif"  // Because of arbitrary_metadata
+            || feature == "iptc"  // Because of arbitrary_metadata
+            || feature == "ioproxy");
 }
 
 
@@ -57,11 +58,15 @@ FitsOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
     else if (m_spec.format == TypeDesc::UINT)
         m_spec.format = TypeDesc::INT;
 
-    // checking if the file exists and can be opened in WRITE mode
-    m_fd = Filesystem::fopen(m_filename, mode == AppendSubimage ? "r+b" : "wb");
-    if (!m_fd) {
-        errorf("Could not open \"%s\"", m_filename);
-        return false;
+    if (mode == AppendSubimage && ioproxy_opened()) {
+        // the next subimage's header and data go at the end of the file
+        if (!ioseek(0, SEEK_END))
+            return false;
+    } else {
+        // checking if the file exists and can be opened in WRITE mode
+        ioproxy_retrieve_from_config(m_spec);
+        if (!ioproxy_use_or_open(m_filename))
+            return false;
     }
 
     if (m_spec.depth != 1) {
@@ -69,11 +74,12 @@ FitsOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
         return false;
     }
 
-    create_fits_header();
+    if (!create_fits_header())
+        return false;
 
     // now we can get the current position in the file
     // we will need it int the write_native_scanline method
-    fgetpos(m_fd, &m_filepos);
+    m_filepos = iotell();
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
@@ -104,7 +110,8 @@ FitsOutput::write_scanline(int y, int /*z*/, TypeDesc format, const void* data,
 
     // computing scanline offset
     long scanline_off = (m_spec.height - y) * m_spec.scanline_bytes();
-    fseek(m_fd, scanline_off, SEEK_CUR);
+    if (!ioseek(scanline_off, SEEK_CUR))
+        return false;
 
     // in FITS image data is stored in big-endian so we have to switch to
     // big-endian on little-endian machines
@@ -122,12 +129,10 @@ FitsOutput::write_scanline(int y, int /*z*/, TypeDesc format, const void* data,
                         data_tmp.size() / sizeof(double));
     }
 
-    size_t byte_count = fwrite(&data_tmp[0], 1, data_tmp.size(), m_fd);
-
-    fsetpos(m_fd, &m_filepos);
+    bool ok = iowrite(&data_tmp[0], 1, data_tmp.size());
 
-    //byte_count == data.size --> all written
-    return byte_count == data_tmp.size();
+    ok &= ioseek(m_filepos);
+    return ok;
 }
 
 
@@ -146,7 +151,7 @@ FitsOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 FitsOutput::close(void)
 {
-    if (!m_fd) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -160,14 +165,14 @@ FitsOutput::close(void)
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    fclose(m_fd);
+    ioproxy_clear();
     init();
     return ok;
 }
 
 
 
-void
+bool
 FitsOutput::create_fits_header(void)
 {
     std::string header;
@@ -221,11 +226,7 @@ FitsOutput::create_fits_header(void)
     if (hsize)
         header.resize(header.size() + hsize, ' ');
 
-    size_t byte_count = fwrite(&header[0], 1, header.size(), m_fd);
-    if (byte_count != header.size()) {
-        // FIXME Bad Write
-        errorf("Bad header write (err %d)", byte_count);
-    }
+    return iowrite(&header[0], 1, header.size());
 }
 
 
@@ -23,7 +23,7 @@
 // USAGE:
 // Create a GifWriter struct. Pass it to GifBegin() to initialize and write the header.
 // Pass subsequent frames to GifWriteFrame().
-// Finally, call GifEnd() to close the file handle and free memory.
+// Finally, call GifEnd() to finish the file and free memory.
 //
 
 // GitHub source: https://github.com/ginsweater/gif-h
@@ -59,10 +59,26 @@ For more information, please refer to <http://unlicense.org>
 #ifndef gif_h
 #define gif_h
 
-#include <cstdio>   // for FILE*
 #include <cstring>  // for memcpy and bzero
 #include <cstdint>  // for integer typedefs
 
+// OIIO: rather than opening a file itself, the writer writes everything
+// through an OIIO::Filesystem::IOProxy, which GifBegin() is handed already
+// open and GifEnd() leaves open. The includer must include
+// <OpenImageIO/filesystem.h> first.
+typedef OIIO::Filesystem::IOProxy GifFile;
+
+inline void GifPutc( int c, GifFile* f )
+{
+    unsigned char byte = (unsigned char)c;
+    f->write(&byte, 1);
+}
+
+inline void GifPuts( const char* str, GifFile* f )
+{
+    f->write(str, strlen(str));
+}
+
 // Define these macros to hook into a custom memory allocator.
 // TEMP_MALLOC and TEMP_FREE will only be called in stack fashion - frees in the reverse order of mallocs
 // and any temp memory allocated by a function will be freed before it exits.
@@ -585,17 +601,17 @@ void GifWriteBit( GifBitStatus& stat, uint32_t bit )
 }
 
 // write all bytes so far to the file
-void GifWriteChunk( FILE* f, GifBitStatus& stat )
+void GifWriteChunk( GifFile* f, GifBitStatus& stat )
 {
-    fputc((int)stat.chunkIndex, f);
-    fwrite(stat.chunk, 1, stat.chunkIndex, f);
+    GifPutc((int)stat.chunkIndex, f);
+    f->write(stat.chunk, stat.chunkIndex);
 
     stat.bitIndex = 0;
     stat.byte = 0;
     stat.chunkIndex = 0;
 }
 
-void GifWriteCode( FILE* f, GifBitStatus& stat, uint32_t code, uint32_t length )
+void GifWriteCode( GifFile* f, GifBitStatus& stat, uint32_t code, uint32_t length )
 {
     for( uint32_t ii=0; ii<length; ++ii )
     {
@@ -617,11 +633,11 @@ struct GifLzwNode
 };
 
 // write a 256-color (8-bit) image palette to the file
-void GifWritePalette( const GifPalette* pPal, FILE* f )
+void GifWritePalette( const GifPalette* pPal, GifFile* f )
 {
-    fputc(0, f);  // first color: transparency
-    fputc(0, f);
-    fputc(0, f);
+    GifPutc(0, f);  // first color: transparency
+    GifPutc(0, f);
+    GifPutc(0, f);
 
     for(int ii=1; ii<(1 << pPal->bitDepth); ++ii)
     {
@@ -629,47 +645,47 @@ void GifWritePalette( const GifPalette* pPal, FILE* f )
         uint32_t g = pPal->g[ii];
         uint32_t b = pPal->b[ii];
 
-        fputc((int)r, f);
-        fputc((int)g, f);
-        fputc((int)b, f);
+        GifPutc((int)r, f);
+        GifPutc((int)g, f);
+        GifPutc((int)b, f);
     }
 }
 
 // write the image header, LZW-compress and write out the image
-void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top,  uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal)
+void GifWriteLzwImage(GifFile* f, uint8_t* image, uint32_t left, uint32_t top,  uint32_t width, uint32_t height, uint32_t delay, GifPalette* pPal)
 {
     // graphics control extension
-    fputc(0x21, f);
-    fputc(0xf9, f);
-    fputc(0x04, f);
-    fputc(0x05, f); // leave prev frame in place, this frame has transparency
-    fputc(delay & 0xff, f);
-    fputc((delay >> 8) & 0xff, f);
-    fputc(kGifTransIndex, f); // transparent color index
-    fputc(0, f);
-
-    fputc(0x2c, f); // image descriptor block
-
-    fputc(left & 0xff, f);           // corner of image in canvas space
-    fputc((left >> 8) & 0xff, f);
-    fputc(top & 0xff, f);
-    fputc((top >> 8) & 0xff, f);
-
-    fputc(width & 0xff, f);          // width and height of image
-    fputc((width >> 8) & 0xff, f);
-    fputc(height & 0xff, f);
-    fputc((height >> 8) & 0xff, f);
-
-    //fputc(0, f); // no local color table, no transparency
-    //fputc(0x80, f); // no local color table, but transparency
-
-    fputc(0x80 + pPal->bitDepth-1, f); // local color table present, 2 ^ bitDepth entries
+    GifPutc(0x21, f);
+    GifPutc(0xf9, f);
+    GifPutc(0x04, f);
+    GifPutc(0x05, f); // leave prev frame in place, this frame has transparency
+    GifPutc(delay & 0xff, f);
+    GifPutc((delay >> 8) & 0xff, f);
+    GifPutc(kGifTransIndex, f); // transparent color index
+    GifPutc(0, f);
+
+    GifPutc(0x2c, f); // image descriptor block
+
+    GifPutc(left & 0xff, f);           // corner of image in canvas space
+    GifPutc((left >> 8) & 0xff, f);
+    GifPutc(top & 0xff, f);
+    GifPutc((top >> 8) & 0xff, f);
+
+    GifPutc(width & 0xff, f);          // width and height of image
+    GifPutc((width >> 8) & 0xff, f);
+    GifPutc(height & 0xff, f);
+    GifPutc((height >> 8) & 0xff, f);
+
+    //GifPutc(0, f); // no local color table, no transparency
+    //GifPutc(0x80, f); // no local color table, but transparency
+
+    GifPutc(0x80 + pPal->bitDepth-1, f); // local color table present, 2 ^ bitDepth entries
     GifWritePalette(pPal, f);
 
     const int minCodeSize = pPal->bitDepth;
     const uint32_t clearCode = 1 << pPal->bitDepth;
 
-    fputc(minCodeSize, f); // min code size 8 bits
+    GifPutc(minCodeSize, f); // min code size 8 bits
 
     GifLzwNode* codetree = (GifLzwNode*)GIF_TEMP_MALLOC(sizeof(GifLzwNode)*4096);
 
@@ -749,14 +765,14 @@ void GifWriteLzwImage(FILE* f, uint8_t* image, uint32_t left, uint32_t top,  uin
     while( stat.bitIndex ) GifWriteBit(stat, 0);
     if( stat.chunkIndex ) GifWriteChunk(f, stat);
 
-    fputc(0, f); // image block terminator
+    GifPutc(0, f); // image block terminator
 
     GIF_TEMP_FREE(codetree);
 }
 
 struct GifWriter
 {
-    FILE* f;
+    GifFile* f;
     uint8_t* oldImage;
     bool firstFrame;
 };
@@ -764,15 +780,10 @@ struct GifWriter
 // Creates a gif file.
 // The input GIFWriter is assumed to be uninitialized.
 // The delay value is the time between frames in hundredths of a second - note that not all viewers pay much attention to this value.
-bool GifBegin( GifWriter* writer, const char* filename, uint32_t width, uint32_t height, uint32_t delay, int32_t bitDepth = 8, bool dither = false )
+bool GifBegin( GifWriter* writer, GifFile* file, uint32_t width, uint32_t height, uint32_t delay, int32_t bitDepth = 8, bool dither = false )
 {
     (void)bitDepth; (void)dither; // Mute "Unused argument" warnings
-#if defined(_MSC_VER) && (_MSC_VER >= 1400)
-	writer->f = 0;
-    fopen_s(&writer->f, filename, "wb");
-#else
-    writer->f = fopen(filename, "wb");
-#endif
+    writer->f = file;
     if(!writer->f) return false;
 
     writer->firstFrame = true;
@@ -780,42 +791,42 @@ bool GifBegin( GifWriter* writer, const char* filename, uint32_t width, uint32_t
     // allocate
     writer->oldImage = (uint8_t*)GIF_MALLOC(width*height*4);
 
-    fputs("GIF89a", writer->f);
+    GifPuts("GIF89a", writer->f);
 
     // screen descriptor
-    fputc(width & 0xff, writer->f);
-    fputc((width >> 8) & 0xff, writer->f);
-    fputc(height & 0xff, writer->f);
-    fputc((height >> 8) & 0xff, writer->f);
+    GifPutc(width & 0xff, writer->f);
+    GifPutc((width >> 8) & 0xff, writer->f);
+    GifPutc(height & 0xff, writer->f);
+    GifPutc((height >> 8) & 0xff, writer->f);
 
-    fputc(0xf0, writer->f);  // there is an unsorted global color table of 2 entries
-    fputc(0, writer->f);     // background color
-    fputc(0, writer->f);     // pixels are square (we need to specify this because it's 1989)
+    GifPutc(0xf0, writer->f);  // there is an unsorted global color table of 2 entries
+    GifPutc(0, writer->f);     // background color
+    GifPutc(0, writer->f);     // pixels are square (we need to specify this because it's 1989)
 
     // now the "global" palette (really just a dummy palette)
     // color 0: black
-    fputc(0, writer->f);
-    fputc(0, writer->f);
-    fputc(0, writer->f);
+    GifPutc(0, writer->f);
+    GifPutc(0, writer->f);
+    GifPutc(0, writer->f);
     // color 1: also black
-    fputc(0, writer->f);
-    fputc(0, writer->f);
-    fputc(0, writer->f);
+    GifPutc(0, writer->f);
+    GifPutc(0, writer->f);
+    GifPutc(0, writer->f);
 
     if( delay != 0 )
     {
         // animation header
-        fputc(0x21, writer->f); // extension
-        fputc(0xff, writer->f); // application specific
-        fputc(11, writer->f); // length 11
-        fputs("NETSCAPE2.0", writer->f); // yes, really
-        fputc(3, writer->f); // 3 bytes of NETSCAPE2.0 data
+        GifPutc(0x21, writer->f); // extension
+        GifPutc(0xff, writer->f); // application specific
+        GifPutc(11, writer->f); // length 11
+        GifPuts("NETSCAPE2.0", writer->f); // yes, really
+        GifPutc(3, writer->f); // 3 bytes of NETSCAPE2.0 data
 
-        fputc(1, writer->f); // JUST BECAUSE
-        fputc(0, writer->f); // loop infinitely (byte 0)
-        fputc(0, writer->f); // loop infinitely (byte 1)
+        GifPutc(1, writer->f); // JUST BECAUSE
+        GifPutc(0, writer->f); // loop infinitely (byte 0)
+        GifPutc(0, writer->f); // loop infinitely (byte 1)
 
-        fputc(0, writer->f); // block terminator
+        GifPutc(0, writer->f); // block terminator
     }
 
     return true;
@@ -845,15 +856,15 @@ bool GifWriteFrame( GifWriter* writer, const uint8_t* image, uint32_t width, uin
     return true;
 }
 
-// Writes the EOF code, closes the file handle, and frees temp memory used by a GIF.
+// Writes the EOF code and frees temp memory used by a GIF. (OIIO: the
+// IOProxy is left open for its owner to close.)
 // Many if not most viewers will still display a GIF properly if the EOF code is missing,
 // but it's still a good idea to write it out.
 bool GifEnd( GifWriter* writer )
 {
     if(!writer->f) return false;
 
-    fputc(0x3b, writer->f); // end of file
-    fclose(writer->f);
+    GifPutc(0x3b, writer->f); // end of file
     GIF_FREE(writer->oldImage);
 
     writer->f = NULL;
@@ -7,6 +7,7 @@
 
 #include <gif_lib.h>
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/thread.h>
 
@@ -35,7 +36,13 @@ public:
     GIFInput() { init(); }
     virtual ~GIFInput() { close(); }
     virtual const char* format_name(void) const override { return "gif"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close(void) override;
     virtual bool seek_subimage(int subimage, int miplevel) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
@@ -90,6 +97,10 @@ private:
     /// Print error message.
     ///
     void report_last_error(void);
+
+    /// Close the GIFLIB handle, but not our IOProxy.
+    ///
+    bool close_gif(void);
 };
 
 
@@ -130,12 +141,24 @@ GIFInput::init(void)
 
 
 
+bool
+GIFInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
 bool
 GIFInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
     m_subimage = -1;
     m_canvas.clear();
+    if (!ioproxy_use_or_open(name))
+        return false;
 
     bool ok = seek_subimage(0, 0);
     newspec = spec();
@@ -144,6 +167,16 @@ GIFInput::open(const std::string& name, ImageSpec& newspec)
 
 
 
+// GIFLIB input function: read through the IOProxy we gave DGifOpen.
+static int
+gif_read_func(GifFileType* gif, GifByteType* data, int size)
+{
+    auto io = (Filesystem::IOProxy*)gif->UserData;
+    return int(io->read(data, size));
+}
+
+
+
 inline int
 GIFInput::decode_line_number(int line_number, int height)
 {
@@ -350,22 +383,24 @@ GIFInput::seek_subimage(int subimage, int miplevel)
 
     if (m_subimage > subimage) {
         // requested subimage is located before the current one
-        // file needs to be reopened
-        if (m_gif_file && !close()) {
+        // file needs to be reread from the start
+        if (m_gif_file && !close_gif()) {
             return false;
         }
     }
 
     if (!m_gif_file) {
+        if (!ioproxy_opened() || !ioseek(0))
+            return false;
 #if GIFLIB_MAJOR >= 5
         int giflib_error;
-        if (!(m_gif_file = DGifOpenFileName(m_filename.c_str(),
-                                            &giflib_error))) {
+        if (!(m_gif_file = DGifOpen(ioproxy(), gif_read_func,
+                                    &giflib_error))) {
             errorf("%s", GifErrorString(giflib_error));
             return false;
         }
 #else
-        if (!(m_gif_file = DGifOpenFileName(m_filename.c_str()))) {
+        if (!(m_gif_file = DGifOpen(ioproxy(), gif_read_func))) {
             errorf("Error trying to open the file.");
             return false;
         }
@@ -435,6 +470,16 @@ GIFInput::report_last_error(void)
 
 inline bool
 GIFInput::close(void)
+{
+    bool ok = close_gif();
+    ioproxy_clear();
+    return ok;
+}
+
+
+
+bool
+GIFInput::close_gif(void)
 {
     if (m_gif_file) {
 #if GIFLIB_MAJOR > 5 || (GIFLIB_MAJOR == 5 && GIFLIB_MINOR >= 1)
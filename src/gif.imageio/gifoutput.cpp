@@ -9,6 +9,7 @@
 #include <cstring>
 #include <vector>
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/platform.h>
 
@@ -31,7 +32,8 @@ public:
     virtual int supports(string_view feature) const override
     {
         return (feature == "alpha" || feature == "random_access"
-                || feature == "multiimage" || feature == "appendsubimage");
+                || feature == "multiimage" || feature == "appendsubimage"
+                || feature == "ioproxy");
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode = Create) override;
@@ -121,6 +123,10 @@ GIFOutput::open(const std::string& name, int subimages, const ImageSpec* specs)
     m_spec    = specs[0];
     float fps = m_spec.get_float_attribute("FramesPerSecond", 1.0f);
     m_delay   = (fps == 0.0f ? 0 : (int)(100.0f / fps));
+
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
+        return false;
     return start_subimage();
 }
 
@@ -129,10 +135,15 @@ GIFOutput::open(const std::string& name, int subimages, const ImageSpec* specs)
 bool
 GIFOutput::close()
 {
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
     if (m_pending_write) {
         finish_subimage();
         GifEnd(&m_gifwriter);
     }
+    ioproxy_clear();
     init();
     return true;
 }
@@ -163,7 +174,7 @@ GIFOutput::start_subimage()
     m_spec.set_format(TypeDesc::UINT8);  // GIF is only 8 bit
 
     if (m_subimage == 0) {
-        bool ok = GifBegin(&m_gifwriter, m_filename.c_str(), m_spec.width,
+        bool ok = GifBegin(&m_gifwriter, ioproxy(), m_spec.width,
                            m_spec.height, m_delay, 8 /*bit depth*/,
                            true /*dither*/);
         if (!ok) {
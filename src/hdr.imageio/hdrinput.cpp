@@ -35,7 +35,13 @@ public:
     HdrInput() { init(); }
     virtual ~HdrInput() { close(); }
     virtual const char* format_name(void) const override { return "hdr"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
     virtual bool close() override;
@@ -44,14 +50,12 @@ public:
 
 private:
     std::string m_filename;  ///< File name
-    FILE* m_fd;              ///< The open file handle
     int m_subimage;          ///< What subimage are we looking at?
     int m_next_scanline;     ///< Next scanline to read
     std::string rgbe_error;  ///< Buffer for RGBE library error msgs
 
     void init()
     {
-        m_fd            = NULL;
         m_subimage      = -1;
         m_next_scanline = 0;
         rgbe_error.clear();
@@ -95,6 +99,16 @@ HdrInput::open(const std::string& name, ImageSpec& newspec)
 
 
 
+bool
+HdrInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
 bool
 HdrInput::seek_subimage(int subimage, int miplevel)
 {
@@ -107,18 +121,14 @@ HdrInput::seek_subimage(int subimage, int miplevel)
         return true;
     }
 
-    close();
-
-    // Check that file exists and can be opened
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (m_fd == NULL) {
-        errorf("Could not open file \"%s\"", m_filename);
+    // Open the file, or rewind it if it's already open
+    m_subimage = -1;
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     rgbe_header_info h;
     int width, height;
-    int r = RGBE_ReadHeader(m_fd, &width, &height, &h, rgbe_error);
+    int r = RGBE_ReadHeader(ioproxy(), &width, &height, &h, rgbe_error);
     if (r != RGBE_RETURN_SUCCESS) {
         errorf("%s", rgbe_error);
         close();
@@ -167,19 +177,15 @@ HdrInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
     if (m_next_scanline > y) {
         // User is trying to read an earlier scanline than the one we're
-        // up to.  Easy fix: close the file and re-open.
-        ImageSpec dummyspec;
-        int subimage = current_subimage();
-        int miplevel = current_miplevel();
-        if (!close() || !open(m_filename, dummyspec)
-            || !seek_subimage(subimage, miplevel))
-            return false;  // Somehow, the re-open failed
-        assert(m_next_scanline == 0 && current_subimage() == subimage
-               && current_miplevel() == miplevel);
+        // up to.  Easy fix: start over from the top of the file.
+        m_subimage = -1;
+        if (!seek_subimage(subimage, miplevel))
+            return false;  // Somehow, the re-read failed
+        OIIO_DASSERT(m_next_scanline == 0);
     }
     while (m_next_scanline <= y) {
         // Keep reading until we're read the scanline we really need
-        int r = RGBE_ReadPixels_RLE(m_fd, (float*)data, m_spec.width, 1,
+        int r = RGBE_ReadPixels_RLE(ioproxy(), (float*)data, m_spec.width, 1,
                                     rgbe_error);
         ++m_next_scanline;
         if (r != RGBE_RETURN_SUCCESS) {
@@ -195,8 +201,7 @@ HdrInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 bool
 HdrInput::close()
 {
-    if (m_fd)
-        fclose(m_fd);
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
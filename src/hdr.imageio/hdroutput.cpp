@@ -20,6 +20,10 @@ public:
     HdrOutput() { init(); }
     virtual ~HdrOutput() { close(); }
     virtual const char* format_name(void) const override { return "hdr"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode) override;
     virtual bool write_scanline(int y, int z, TypeDesc format, const void* data,
@@ -30,16 +34,11 @@ public:
     virtual bool close() override;
 
 private:
-    FILE* m_fd;
     std::vector<unsigned char> scratch;
     std::string rgbe_error;  // Buffer for RGBE library error msgs
     std::vector<unsigned char> m_tilebuffer;
 
-    void init(void)
-    {
-        m_fd = NULL;
-        rgbe_error.clear();
-    }
+    void init(void) { rgbe_error.clear(); }
 };
 
 
@@ -89,11 +88,9 @@ HdrOutput::open(const std::string& name, const ImageSpec& newspec,
 
     m_spec.set_format(TypeDesc::FLOAT);  // Native rgbe is float32 only
 
-    m_fd = Filesystem::fopen(name, "wb");
-    if (m_fd == NULL) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     rgbe_header_info h;
     h.valid = 0;
@@ -113,9 +110,13 @@ HdrOutput::open(const std::string& name, const ImageSpec& newspec,
     // FIXME -- should we do anything about gamma, exposure, software,
     // pixaspect, primaries?  (N.B. rgbe.c doesn't even handle most of them)
 
-    int r = RGBE_WriteHeader(m_fd, m_spec.width, m_spec.height, &h, rgbe_error);
-    if (r != RGBE_RETURN_SUCCESS)
+    int r = RGBE_WriteHeader(ioproxy(), m_spec.width, m_spec.height, &h,
+                             rgbe_error);
+    if (r != RGBE_RETURN_SUCCESS) {
         errorf("%s", rgbe_error);
+        close();
+        return false;
+    }
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
@@ -132,7 +133,7 @@ HdrOutput::write_scanline(int /*y*/, int /*z*/, TypeDesc format,
                           const void* data, stride_t xstride)
 {
     data  = to_native_scanline(format, data, xstride, scratch);
-    int r = RGBE_WritePixels_RLE(m_fd, (float*)data, m_spec.width, 1,
+    int r = RGBE_WritePixels_RLE(ioproxy(), (float*)data, m_spec.width, 1,
                                  rgbe_error);
     if (r != RGBE_RETURN_SUCCESS)
         errorf("%s", rgbe_error);
@@ -155,7 +156,7 @@ HdrOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 HdrOutput::close()
 {
-    if (!m_fd) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -169,8 +170,7 @@ HdrOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    fclose(m_fd);
-    m_fd = NULL;
+    ioproxy_clear();
     init();
 
     return ok;
@@ -37,6 +37,10 @@ Further changes by LG, 2018:
 * Replace unsafe string ops and fixed size buffers for error messages with
   std::string and Strutil::sprintf.
 
+Further changes:
+* Read and write through an IOProxy rather than a FILE*, so that images
+  can be decoded from and encoded to memory.
+
 */
 
 #if defined(_CPLUSPLUS) || defined(__cplusplus)
@@ -55,6 +59,39 @@ Further changes by LG, 2018:
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
 
+/* stdio-alikes that go through the IOProxy */
+static size_t rgbe_fread(void *ptr, size_t size, size_t nitems,
+                         Filesystem::IOProxy *fp)
+{
+  return size ? fp->read(ptr, size*nitems) / size : 0;
+}
+
+static size_t rgbe_fwrite(const void *ptr, size_t size, size_t nitems,
+                          Filesystem::IOProxy *fp)
+{
+  return size ? fp->write(ptr, size*nitems) / size : 0;
+}
+
+static char *rgbe_fgets(char *buf, int size, Filesystem::IOProxy *fp)
+{
+  int n = 0;
+  while (n < size-1 && fp->read(buf+n, 1) == 1)
+    if (buf[n++] == '\n')
+      break;
+  if (n == 0)
+    return NULL;
+  buf[n] = 0;
+  return buf;
+}
+
+template<typename... Args>
+static int rgbe_fprintf(Filesystem::IOProxy *fp, const char *fmt,
+                        const Args&... args)
+{
+  std::string s = Strutil::sprintf(fmt, args...);
+  return fp->write(s.data(), s.size()) == s.size() ? int(s.size()) : -1;
+}
+
 enum rgbe_error_codes {
   rgbe_read_error,
   rgbe_write_error,
@@ -163,7 +200,7 @@ rgbe2float(float* rgb, unsigned char* rgbe)
 
 
 /* default minimal header. modify if you want more information in header */
-int RGBE_WriteHeader(FILE *fp, int width, int height, rgbe_header_info *info,
+int RGBE_WriteHeader(Filesystem::IOProxy *fp, int width, int height, rgbe_header_info *info,
                      std::string &errbuf)
 {
   const char *programtype = "RADIANCE";
@@ -176,26 +213,26 @@ int RGBE_WriteHeader(FILE *fp, int width, int height, rgbe_header_info *info,
 
   if (info && (info->valid & RGBE_VALID_PROGRAMTYPE))
     programtype = info->programtype;
-  if (fprintf(fp,"#?%s\n",programtype) < 0)
+  if (rgbe_fprintf(fp,"#?%s\n",programtype) < 0)
       return rgbe_error(rgbe_write_error,NULL, errbuf);
   /* The #? is to identify file type, the programtype is optional. */
   if (info && (info->valid & RGBE_VALID_GAMMA)) {
-    if (fprintf(fp,"GAMMA=%g\n",info->gamma) < 0)
+    if (rgbe_fprintf(fp,"GAMMA=%g\n",info->gamma) < 0)
       return rgbe_error(rgbe_write_error,NULL, errbuf);
   }
   if (info && (info->valid & RGBE_VALID_EXPOSURE)) {
-    if (fprintf(fp,"EXPOSURE=%g\n",info->exposure) < 0)
+    if (rgbe_fprintf(fp,"EXPOSURE=%g\n",info->exposure) < 0)
       return rgbe_error(rgbe_write_error,NULL, errbuf);
   }
-  if (fprintf(fp,"FORMAT=32-bit_rle_rgbe\n\n") < 0)
+  if (rgbe_fprintf(fp,"FORMAT=32-bit_rle_rgbe\n\n") < 0)
     return rgbe_error(rgbe_write_error,NULL, errbuf);
-  if (fprintf(fp, "-Y %d +X %d\n", height, width) < 0)
+  if (rgbe_fprintf(fp, "-Y %d +X %d\n", height, width) < 0)
     return rgbe_error(rgbe_write_error,NULL, errbuf);
   return RGBE_RETURN_SUCCESS;
 }
 
 /* minimal header reading.  modify if you want to parse more information */
-int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
+int RGBE_ReadHeader(Filesystem::IOProxy *fp, int *width, int *height, rgbe_header_info *info,
                     std::string &errbuf)
 {
   char buf[128];
@@ -207,7 +244,7 @@ int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
     info->programtype[0] = 0;
     info->gamma = info->exposure = 1.0;
   }
-  if (fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == NULL)
+  if (rgbe_fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == NULL)
     return rgbe_error(rgbe_read_error,NULL, errbuf);
   if ((buf[0] != '#')||(buf[1] != '?')) {
     /* if you want to require the magic token then uncomment the next line */
@@ -221,7 +258,7 @@ int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
       info->programtype[i] = buf[i+2];
     }
     info->programtype[i] = 0;
-    if (fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
+    if (rgbe_fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
       return rgbe_error(rgbe_read_error,NULL, errbuf);
   }
   bool found_FORMAT_line = false;
@@ -243,7 +280,7 @@ int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
       info->exposure = tempf;
       info->valid |= RGBE_VALID_EXPOSURE;
     }
-    if (fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
+    if (rgbe_fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
       return rgbe_error(rgbe_read_error,NULL, errbuf);
   }
   if (strcmp(buf,"\n") != 0) {
@@ -251,7 +288,7 @@ int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
     return rgbe_error(rgbe_format_error,
 		      "missing blank line after FORMAT specifier", errbuf);
   }
-  if (fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
+  if (rgbe_fgets(buf,sizeof(buf)/sizeof(buf[0]),fp) == 0)
     return rgbe_error(rgbe_read_error,NULL, errbuf);
 
   if (sscanf(buf,"-Y %d +X %d",height,width) == 2) {
@@ -303,24 +340,24 @@ int RGBE_ReadHeader(FILE *fp, int *width, int *height, rgbe_header_info *info,
 /* simple write routine that does not use run length encoding */
 /* These routines can be made faster by allocating a larger buffer and
    fread-ing and fwrite-ing the data in larger chunks */
-int RGBE_WritePixels(FILE *fp, float *data, int64_t numpixels,
+int RGBE_WritePixels(Filesystem::IOProxy *fp, float *data, int64_t numpixels,
                      std::string &errbuf)
 {
     std::unique_ptr<unsigned char[]> rgbe(new unsigned char [4*numpixels]);
     for (int64_t i = 0; i < numpixels; ++i)
         float2rgbe(&rgbe[4*i], data+3*i);
-    if (fwrite(rgbe.get(), 4, numpixels, fp) != size_t(numpixels))
+    if (rgbe_fwrite(rgbe.get(), 4, numpixels, fp) != size_t(numpixels))
         return rgbe_error(rgbe_write_error, nullptr, errbuf);
     return RGBE_RETURN_SUCCESS;
 }
 
 
 /* simple read routine.  will not correctly handle run length encoding */
-int RGBE_ReadPixels(FILE *fp, float *data, int numpixels,
+int RGBE_ReadPixels(Filesystem::IOProxy *fp, float *data, int numpixels,
                     std::string &errbuf)
 {
     std::unique_ptr<unsigned char[]> rgbe(new unsigned char [4*numpixels]);
-    if (fread(rgbe.get(), 4, numpixels, fp) != size_t(numpixels))
+    if (rgbe_fread(rgbe.get(), 4, numpixels, fp) != size_t(numpixels))
         return rgbe_error(rgbe_read_error,NULL, errbuf);
     for (int64_t i = 0; i < numpixels; ++i)
         rgbe2float(&data[3*i], &rgbe[4*i]);
@@ -332,7 +369,7 @@ int RGBE_ReadPixels(FILE *fp, float *data, int numpixels,
 /* save some space.  For each scanline, each channel (r,g,b,e) is */
 /* encoded separately for better compression. */
 
-static int RGBE_WriteBytes_RLE(FILE *fp, unsigned char *data, int numbytes,
+static int RGBE_WriteBytes_RLE(Filesystem::IOProxy *fp, unsigned char *data, int numbytes,
                                std::string &errbuf)
 {
 #define MINRUNLENGTH 4
@@ -356,7 +393,7 @@ static int RGBE_WriteBytes_RLE(FILE *fp, unsigned char *data, int numbytes,
     if ((old_run_count > 1)&&(old_run_count == beg_run - cur)) {
       buf[0] = 128 + old_run_count;   /*write short run*/
       buf[1] = data[cur];
-      if (fwrite(buf,sizeof(buf[0])*2,1,fp) < 1)
+      if (rgbe_fwrite(buf,sizeof(buf[0])*2,1,fp) < 1)
 	return rgbe_error(rgbe_write_error,NULL, errbuf);
       cur = beg_run;
     }
@@ -366,9 +403,9 @@ static int RGBE_WriteBytes_RLE(FILE *fp, unsigned char *data, int numbytes,
       if (nonrun_count > 128) 
 	nonrun_count = 128;
       buf[0] = nonrun_count;
-      if (fwrite(buf,sizeof(buf[0]),1,fp) < 1)
+      if (rgbe_fwrite(buf,sizeof(buf[0]),1,fp) < 1)
 	return rgbe_error(rgbe_write_error,NULL, errbuf);
-      if (fwrite(&data[cur],sizeof(data[0])*nonrun_count,1,fp) < 1)
+      if (rgbe_fwrite(&data[cur],sizeof(data[0])*nonrun_count,1,fp) < 1)
 	return rgbe_error(rgbe_write_error,NULL, errbuf);
       cur += nonrun_count;
     }
@@ -376,7 +413,7 @@ static int RGBE_WriteBytes_RLE(FILE *fp, unsigned char *data, int numbytes,
     if (run_count >= MINRUNLENGTH) {
       buf[0] = 128 + run_count;
       buf[1] = data[beg_run];
-      if (fwrite(buf,sizeof(buf[0])*2,1,fp) < 1)
+      if (rgbe_fwrite(buf,sizeof(buf[0])*2,1,fp) < 1)
 	return rgbe_error(rgbe_write_error,NULL, errbuf);
       cur += run_count;
     }
@@ -385,7 +422,7 @@ static int RGBE_WriteBytes_RLE(FILE *fp, unsigned char *data, int numbytes,
 #undef MINRUNLENGTH
 }
 
-int RGBE_WritePixels_RLE(FILE *fp, float *data, int scanline_width,
+int RGBE_WritePixels_RLE(Filesystem::IOProxy *fp, float *data, int scanline_width,
 			 int num_scanlines, std::string &errbuf)
 {
   unsigned char rgbe[4];
@@ -404,7 +441,7 @@ int RGBE_WritePixels_RLE(FILE *fp, float *data, int scanline_width,
     rgbe[1] = 2;
     rgbe[2] = scanline_width >> 8;
     rgbe[3] = scanline_width & 0xFF;
-    if (fwrite(rgbe, sizeof(rgbe), 1, fp) < 1) {
+    if (rgbe_fwrite(rgbe, sizeof(rgbe), 1, fp) < 1) {
       free(buffer);
       return rgbe_error(rgbe_write_error,NULL, errbuf);
     }
@@ -431,7 +468,7 @@ int RGBE_WritePixels_RLE(FILE *fp, float *data, int scanline_width,
   return RGBE_RETURN_SUCCESS;
 }
       
-int RGBE_ReadPixels_RLE(FILE *fp, float *data, int scanline_width,
+int RGBE_ReadPixels_RLE(Filesystem::IOProxy *fp, float *data, int scanline_width,
 			int num_scanlines, std::string &errbuf)
 {
   unsigned char rgbe[4], *scanline_buffer, *ptr, *ptr_end;
@@ -444,7 +481,7 @@ int RGBE_ReadPixels_RLE(FILE *fp, float *data, int scanline_width,
   scanline_buffer = NULL;
   /* read in each successive scanline */
   while(num_scanlines > 0) {
-    if (fread(rgbe,sizeof(rgbe),1,fp) < 1) {
+    if (rgbe_fread(rgbe,sizeof(rgbe),1,fp) < 1) {
       free(scanline_buffer);
       return rgbe_error(rgbe_read_error,NULL, errbuf);
     }
@@ -470,7 +507,7 @@ int RGBE_ReadPixels_RLE(FILE *fp, float *data, int scanline_width,
     for(i=0;i<4;i++) {
       ptr_end = &scanline_buffer[(i+1)*scanline_width];
       while(ptr < ptr_end) {
-	if (fread(buf,sizeof(buf[0])*2,1,fp) < 1) {
+	if (rgbe_fread(buf,sizeof(buf[0])*2,1,fp) < 1) {
 	  free(scanline_buffer);
 	  return rgbe_error(rgbe_read_error,NULL, errbuf);
 	}
@@ -493,7 +530,7 @@ int RGBE_ReadPixels_RLE(FILE *fp, float *data, int scanline_width,
 	  }
 	  *ptr++ = buf[1];
 	  if (--count > 0) {
-	    if (fread(ptr,sizeof(*ptr)*count,1,fp) < 1) {
+	    if (rgbe_fread(ptr,sizeof(*ptr)*count,1,fp) < 1) {
 	      free(scanline_buffer);
 	      return rgbe_error(rgbe_read_error,NULL, errbuf);
 	    }
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/tiffutils.h>
 
@@ -19,6 +20,39 @@
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
 
+namespace {
+
+// Lets libheif read the file through an IOProxy.
+class MyHeifReader : public heif::Context::Reader {
+public:
+    MyHeifReader(Filesystem::IOProxy* ioproxy)
+        : m_ioproxy(ioproxy)
+    {
+    }
+    virtual int64_t get_position() const { return m_ioproxy->tell(); }
+    virtual int read(void* data, size_t size)
+    {
+        return m_ioproxy->read(data, size) == size ? 0 : -1;
+    }
+    virtual int seek(int64_t position)
+    {
+        return m_ioproxy->seek(position) ? 0 : -1;
+    }
+    virtual heif_reader_grow_status wait_for_file_size(int64_t target_size)
+    {
+        return target_size <= int64_t(m_ioproxy->size())
+                   ? heif_reader_grow_status_size_reached
+                   : heif_reader_grow_status_size_beyond_eof;
+    }
+
+private:
+    Filesystem::IOProxy* m_ioproxy = nullptr;
+};
+
+}  // namespace
+
+
+
 class HeifInput final : public ImageInput {
 public:
     HeifInput() {}
@@ -26,7 +60,7 @@ public:
     virtual const char* format_name(void) const override { return "heif"; }
     virtual int supports(string_view feature) const override
     {
-        return feature == "exif";
+        return feature == "exif" || feature == "ioproxy";
     }
     // virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
@@ -42,6 +76,7 @@ private:
     int m_subimage      = -1;
     int m_num_subimages = 0;
     int m_has_alpha     = false;
+    std::unique_ptr<MyHeifReader> m_reader;  // must outlive m_ctx
     std::unique_ptr<heif::Context> m_ctx;
     heif_item_id m_primary_id;             // id of primary image
     std::vector<heif_item_id> m_item_ids;  // ids of all other images
@@ -105,18 +140,22 @@ HeifInput::open(const std::string& name, ImageSpec& newspec)
 
 bool
 HeifInput::open(const std::string& name, ImageSpec& newspec,
-                const ImageSpec& /*config*/)
+                const ImageSpec& config)
 {
     m_filename = name;
     m_subimage = -1;
 
+    ioproxy_retrieve_from_config(config);
+    if (!ioproxy_use_or_open(name))
+        return false;
+
     m_ctx.reset(new heif::Context);
+    m_reader.reset(new MyHeifReader(ioproxy()));
     m_himage  = heif::Image();
     m_ihandle = heif::ImageHandle();
 
     try {
-        m_ctx->read_from_file(name);
-        // FIXME: should someday be read_from_reader to give full flexibility
+        m_ctx->read_from_reader(*m_reader);
 
         m_item_ids   = m_ctx->get_list_of_top_level_image_IDs();
         m_primary_id = m_ctx->get_primary_image_ID();
@@ -152,6 +191,8 @@ HeifInput::close()
     m_himage  = heif::Image();
     m_ihandle = heif::ImageHandle();
     m_ctx.reset();
+    m_reader.reset();
+    ioproxy_clear();
     m_subimage      = -1;
     m_num_subimages = 0;
     return true;
@@ -19,7 +19,7 @@ public:
     virtual const char* format_name(void) const override { return "heif"; }
     virtual int supports(string_view feature) const override
     {
-        return feature == "alpha" || feature == "exif";
+        return feature == "alpha" || feature == "exif" || feature == "ioproxy";
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode) override;
@@ -119,6 +119,10 @@ HeifOutput::open(const std::string& name, const ImageSpec& newspec,
 
     m_spec.set_format(TypeUInt8);  // Only uint8 for now
 
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
+        return false;
+
     try {
         m_ctx.reset(new heif::Context);
         m_himage = heif::Image();
@@ -181,6 +185,7 @@ bool
 HeifOutput::close()
 {
     if (!m_ctx) {  // already closed
+        ioproxy_clear();
         return true;
     }
 
@@ -220,25 +225,20 @@ HeifOutput::close()
 #endif
         }
         m_ctx->set_primary_image(m_ihandle);
-        Filesystem::IOFile ioproxy(m_filename, Filesystem::IOProxy::Write);
-        if (ioproxy.mode() != Filesystem::IOProxy::Write) {
-            errorf("Could not open \"%s\"", m_filename);
-            ok = false;
-        } else {
-            MyHeifWriter writer(&ioproxy);
-            m_ctx->write(writer);
-        }
+        MyHeifWriter writer(ioproxy());
+        m_ctx->write(writer);
     } catch (const heif::Error& err) {
         std::string e = err.get_message();
         errorf("%s", e.empty() ? "unknown exception" : e.c_str());
-        return false;
+        ok = false;
     } catch (const std::exception& err) {
         std::string e = err.what();
         errorf("%s", e.empty() ? "unknown exception" : e.c_str());
-        return false;
+        ok = false;
     }
 
     m_ctx.reset();
+    ioproxy_clear();
     return ok;
 }
 
@@ -25,7 +25,13 @@ public:
     ICOInput() { init(); }
     virtual ~ICOInput() { close(); }
     virtual const char* format_name(void) const override { return "ico"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual int current_subimage(void) const override
     {
@@ -38,7 +44,6 @@ public:
 
 private:
     std::string m_filename;            ///< Stash the filename
-    FILE* m_file;                      ///< Open image handle
     ico_header m_ico;                  ///< ICO header
     std::vector<unsigned char> m_buf;  ///< Buffer the image pixels
     int m_subimage;                    ///< What subimage are we looking at?
@@ -58,7 +63,6 @@ private:
     void init()
     {
         m_subimage = -1;
-        m_file     = NULL;
         m_png      = NULL;
         m_info     = NULL;
         memset(&m_ico, 0, sizeof(m_ico));
@@ -73,10 +77,16 @@ private:
     ///
     bool fread(void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Read error");
-        return n == nitems;
+        return ioread(buf, itemsize, nitems);
+    }
+
+    // Callback for PNG that reads from the IOProxy.
+    static void PngReadCallback(png_structp png_ptr, png_bytep data,
+                                png_size_t length)
+    {
+        ICOInput* icoinput = (ICOInput*)png_get_io_ptr(png_ptr);
+        OIIO_DASSERT(icoinput);
+        icoinput->ioread(data, length);
     }
 };
 
@@ -110,11 +120,8 @@ ICOInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
 
-    m_file = Filesystem::fopen(name, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     if (!fread(&m_ico, 1, sizeof(m_ico)))
         return false;
@@ -163,8 +170,7 @@ ICOInput::seek_subimage(int subimage, int miplevel)
     m_subimage = subimage;
 
     // read subimage header
-    fseek(m_file, sizeof(ico_header) + m_subimage * sizeof(ico_subimage),
-          SEEK_SET);
+    ioseek(sizeof(ico_header) + m_subimage * sizeof(ico_subimage));
     ico_subimage subimg;
     if (!fread(&subimg, 1, sizeof(subimg)))
         return false;
@@ -179,7 +185,7 @@ ICOInput::seek_subimage(int subimage, int miplevel)
         swap_endian(&subimg.numColours);
     }
 
-    fseek(m_file, subimg.ofs, SEEK_SET);
+    ioseek(subimg.ofs);
 
     // test for a PNG icon
     char temp[8];
@@ -202,7 +208,7 @@ ICOInput::seek_subimage(int subimage, int miplevel)
 
         //std::cerr << "[ico] reading PNG info\n";
 
-        png_init_io(m_png, m_file);
+        png_set_read_fn(m_png, this, PngReadCallback);
         png_set_sig_bytes(m_png, 8);  // already read 8 bytes
 
         PNG_pvt::read_info(m_png, m_info, m_bpp, m_color_type, m_interlace_type,
@@ -215,7 +221,7 @@ ICOInput::seek_subimage(int subimage, int miplevel)
 
     // otherwise it's a plain, ol' windoze DIB (device-independent bitmap)
     // roll back to where we began and read in the DIB header
-    fseek(m_file, subimg.ofs, SEEK_SET);
+    ioseek(subimg.ofs);
 
     ico_bitmapinfo bmi;
     if (!fread(&bmi, 1, sizeof(bmi)))
@@ -401,16 +407,22 @@ ICOInput::readimg()
 
 
 
+bool
+ICOInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
 bool
 ICOInput::close()
 {
     if (m_png && m_info)
         PNG_pvt::destroy_read_struct(m_png, m_info);
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
-
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
@@ -11,6 +11,7 @@
 #include "ico.h"
 
 #include <OpenImageIO/dassert.h>
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
@@ -38,7 +39,6 @@ public:
 
 private:
     std::string m_filename;                ///< Stash the filename
-    FILE* m_file;                          ///< Open image handle
     int m_color_type;                      ///< Requested colour type
     bool m_want_png;                       ///< Whether the client requested PNG
     std::vector<unsigned char> m_scratch;  ///< Scratch buffer
@@ -56,7 +56,6 @@ private:
     /// Initialize private members to pre-opened state
     void init(void)
     {
-        m_file = NULL;
         m_png  = NULL;
         m_info = NULL;
         m_pngtext.clear();
@@ -69,26 +68,33 @@ private:
     /// Finish the writing of a PNG subimage
     void finish_png_image();
 
-    /// Helper: read, with error detection
+    /// Helper: write, with error detection
     ///
     template<class T>
     bool fwrite(const T* buf, size_t itemsize = sizeof(T), size_t nitems = 1)
     {
-        size_t n = ::fwrite(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Write error");
-        return n == nitems;
+        return iowrite(buf, itemsize, nitems);
     }
 
-    /// Helper: read, with error detection
-    ///
-    template<class T>
-    bool fread(T* buf, size_t itemsize = sizeof(T), size_t nitems = 1)
+    /// Helper: retrieve the contents of the file we're appending to, which
+    /// is either the named file or the app's IOVecOutput.
+    bool read_existing(const std::string& name,
+                       std::vector<unsigned char>& data);
+
+    // Callbacks for PNG that write to the IOProxy.
+    static void PngWriteCallback(png_structp png_ptr, png_bytep data,
+                                 png_size_t length)
+    {
+        ICOOutput* icooutput = (ICOOutput*)png_get_io_ptr(png_ptr);
+        OIIO_DASSERT(icooutput);
+        icooutput->iowrite(data, length);
+    }
+
+    static void PngFlushCallback(png_structp png_ptr)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Read error");
-        return n == nitems;
+        ICOOutput* icooutput = (ICOOutput*)png_get_io_ptr(png_ptr);
+        OIIO_DASSERT(icooutput);
+        icooutput->ioproxy()->flush();
     }
 };
 
@@ -132,7 +138,14 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
         return false;
     }
 
-    close();                                 // Close any already-opened file
+    // Appending a subimage re-opens the file we were writing, so if that
+    // was the app's proxy, hang onto it across the close().
+    Filesystem::IOProxy* io = (mode == AppendSubimage && !ioproxy_owned())
+                                  ? ioproxy()
+                                  : nullptr;
+    close();  // Close any already-opened file
+    if (io)
+        set_ioproxy(io);
     m_spec = userspec;                       // Stash the spec
     if (m_spec.format == TypeDesc::UNKNOWN)  // if unknown, default to 8 bits
         m_spec.set_format(TypeDesc::UINT8);
@@ -201,14 +214,12 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
 
     //std::cerr << "[ico] writing at " << m_bpp << "bpp\n";
 
-    m_file = Filesystem::fopen(name, mode == AppendSubimage ? "r+b" : "wb");
-    if (!m_file) {
-        errorf("Could not open \"%s\"", name);
-        return false;
-    }
+    ioproxy_retrieve_from_config(m_spec);
 
     ico_header ico;
     if (mode == Create) {
+        if (!ioproxy_use_or_open(name))
+            return false;
         // creating new file, write ICO header
         memset(&ico, 0, sizeof(ico));
         ico.type  = 1;
@@ -223,9 +234,17 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
         }
         m_offset = sizeof(ico_header) + sizeof(ico_subimage);
     } else {
-        // we'll be appending data, so see what's already in the file
-        if (!fread(&ico))
+        // We'll be appending data. ICO files are small, so rather than
+        // shuffling things around in place, read what's already there and
+        // write it back out with room for another subimage header.
+        std::vector<unsigned char> olddata;
+        if (!read_existing(name, olddata))
+            return false;
+        if (olddata.size() < sizeof(ico)) {
+            errorf("File failed ICO header check");
             return false;
+        }
+        memcpy(&ico, olddata.data(), sizeof(ico));
         if (bigendian()) {
             // ICOs are little endian
             swap_endian(&ico.type);
@@ -235,79 +254,53 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
         /*std::cerr << "[ico] reserved = " << ico.reserved << " type = "
                   << ico.type << " count = " << ico.count << "\n";*/
 
-        if (ico.reserved != 0 || ico.type != 1) {
+        size_t skip = sizeof(ico_header) + sizeof(ico_subimage) * ico.count;
+        if (ico.reserved != 0 || ico.type != 1 || olddata.size() < skip) {
             errorf("File failed ICO header check");
             return false;
         }
 
-        // need to move stuff around to make room for another subimage header
         int subimage = ico.count++;
-        fseek(m_file, 0, SEEK_END);
-        int len = ftell(m_file);
-        unsigned char buf[512];
-        // append null data at the end of file so that we don't seek beyond eof
-        if (!fwrite(buf, sizeof(ico_subimage))) {
+        if (!ioproxy_use_or_open(name))
             return false;
-        }
 
-        // do the actual moving, 0.5kB per iteration
-        int skip = sizeof(ico_header) + sizeof(ico_subimage) * (subimage - 1);
-        for (int left = len - skip; left > 0; left -= sizeof(buf)) {
-            int amount = std::min(left, (int)sizeof(buf));
-            /*std::cerr << "[ico] moving " << amount << " bytes (" << left
-                      << " vs " << sizeof (buf) << ")\n";*/
-            fseek(m_file, skip + left - amount, SEEK_SET);
-            if (!fread(buf, 1, amount))
-                return false;
-            fseek(m_file, skip + left - amount + sizeof(ico_subimage),
-                  SEEK_SET);
-            if (!fwrite(buf, 1, amount)) {
-                return false;
-            }
-        }
-
-        // update header
-        fseek(m_file, 0, SEEK_SET);
-        // swap these back to little endian, if needed
+        // write the updated header, swapping back to little endian if needed
         if (bigendian()) {
             swap_endian(&ico.type);
             swap_endian(&ico.count);
         }
-
-        if (!fwrite(&ico)) {
+        if (!fwrite(&ico))
             return false;
-        }
 
-        // and finally, update the offsets in subimage headers to point to
-        // their data correctly
-        uint32_t temp;
-        fseek(m_file, offsetof(ico_subimage, ofs), SEEK_CUR);
+        // copy the existing subimage headers, with their offsets updated to
+        // point to where their data moves to
         for (int i = 0; i < subimage; i++) {
-            if (!fread(&temp))
-                return false;
+            ico_subimage subimg;
+            memcpy(&subimg,
+                   olddata.data() + sizeof(ico_header)
+                       + i * sizeof(ico_subimage),
+                   sizeof(subimg));
             if (bigendian())
-                swap_endian(&temp);
-            temp += sizeof(ico_subimage);
+                swap_endian(&subimg.ofs);
+            subimg.ofs += sizeof(ico_subimage);
             if (bigendian())
-                swap_endian(&temp);
-            // roll back 4 bytes, we need to rewrite the value we just read
-            fseek(m_file, -4, SEEK_CUR);
-            if (!fwrite(&temp)) {
+                swap_endian(&subimg.ofs);
+            if (!fwrite(&subimg))
                 return false;
-            }
-
-            // skip to the next subimage; subtract 4 bytes because that's how
-            // much we've just written
-            fseek(m_file, sizeof(ico_subimage) - 4, SEEK_CUR);
         }
 
+        // then the existing image data, after the new subimage header
+        if (!ioseek(skip + sizeof(ico_subimage))
+            || !fwrite(olddata.data() + skip, 1, olddata.size() - skip))
+            return false;
+
         // offset at which we'll be writing new image data
-        m_offset = len + sizeof(ico_subimage);
+        m_offset = olddata.size() + sizeof(ico_subimage);
 
         // next part of code expects the file pointer to be where the new
         // subimage header is to be written
-        fseek(m_file, sizeof(ico_header) + subimage * sizeof(ico_subimage),
-              SEEK_SET);
+        if (!ioseek(skip))
+            return false;
     }
 
     // write subimage header
@@ -332,13 +325,14 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
         return false;
     }
 
-    fseek(m_file, m_offset, SEEK_SET);
+    if (!ioseek(m_offset))
+        return false;
     if (m_want_png) {
         // unused still, should do conversion to unassociated
         bool convert_alpha;
         float gamma;
 
-        png_init_io(m_png, m_file);
+        png_set_write_fn(m_png, this, PngWriteCallback, PngFlushCallback);
         png_set_compression_level(m_png, Z_BEST_COMPRESSION);
 
         PNG_pvt::write_info(m_png, m_info, m_color_type, m_spec, m_pngtext,
@@ -375,7 +369,8 @@ ICOOutput::open(const std::string& name, const ImageSpec& userspec,
                 return false;
             }
         }
-        fseek(m_file, m_offset + sizeof(bmi), SEEK_SET);
+        if (!ioseek(m_offset + sizeof(bmi)))
+            return false;
     }
 
     // If user asked for tiles -- which this format doesn't support, emulate
@@ -396,6 +391,8 @@ ICOOutput::supports(string_view feature) const
         return true;
     if (Strutil::iequals(feature, "alpha"))
         return true;
+    if (Strutil::iequals(feature, "ioproxy"))
+        return true;
     return false;
 }
 
@@ -404,7 +401,7 @@ ICOOutput::supports(string_view feature) const
 bool
 ICOOutput::close()
 {
-    if (!m_file) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -421,8 +418,7 @@ ICOOutput::close()
     if (m_png) {
         PNG_pvt::finish_image(m_png, m_info);
     }
-    fclose(m_file);
-    m_file = NULL;
+    ioproxy_clear();
     init();  // re-initialize
     return ok;
 }
@@ -451,10 +447,9 @@ ICOOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
         unsigned char* bdata = (unsigned char*)data;
         unsigned char buf[4];
 
-        fseek(m_file,
-              m_offset + sizeof(ico_bitmapinfo)
-                  + (m_spec.height - y - 1) * m_xor_slb,
-              SEEK_SET);
+        if (!ioseek(m_offset + sizeof(ico_bitmapinfo)
+                    + (m_spec.height - y - 1) * m_xor_slb))
+            return false;
         // write the XOR mask
         size_t buff_size = 0;
         for (int x = 0; x < m_spec.width; x++) {
@@ -489,10 +484,10 @@ ICOOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
             }
         }
 
-        fseek(m_file,
-              m_offset + sizeof(ico_bitmapinfo) + m_spec.height * m_xor_slb
-                  + (m_spec.height - y - 1) * m_and_slb,
-              SEEK_SET);
+        if (!ioseek(m_offset + sizeof(ico_bitmapinfo)
+                    + m_spec.height * m_xor_slb
+                    + (m_spec.height - y - 1) * m_and_slb))
+            return false;
         // write the AND mask
         // It's required even for 32-bit images because it can be used when
         // drawing at colour depths lower than 24-bit. If it's not present,
@@ -529,6 +524,32 @@ ICOOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
 
 
 
+bool
+ICOOutput::read_existing(const std::string& name,
+                         std::vector<unsigned char>& data)
+{
+    if (ioproxy()) {
+        // We can only read back what we wrote to a proxy if it's in memory
+        if (strcmp(ioproxy()->proxytype(), "vecoutput")) {
+            errorf("Can't append a subimage to a %s proxy",
+                   ioproxy()->proxytype());
+            return false;
+        }
+        data.swap(((Filesystem::IOVecOutput*)ioproxy())->buffer());
+        return ioproxy()->seek(0);
+    }
+    data.resize(Filesystem::file_size(name));
+    if (data.empty()
+        || Filesystem::read_bytes(name, data.data(), data.size())
+               != data.size()) {
+        errorf("Could not read \"%s\"", name);
+        return false;
+    }
+    return true;
+}
+
+
+
 bool
 ICOOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
                       stride_t xstride, stride_t ystride, stride_t zstride)
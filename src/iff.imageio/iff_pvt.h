@@ -33,7 +33,7 @@ const uint32_t BLACK   = 0x00000010;
 class IffFileHeader {
 public:
     // reads information about IFF file
-    bool read_header(FILE* fd, std::string& err);
+    bool read_header(Filesystem::IOProxy* fd, std::string& err);
 
     // header information
     uint32_t x;
@@ -60,23 +60,24 @@ public:
     uint32_t for4_start;
 
 private:
-    bool read(FILE* fd, uint32_t& data)
+    bool read(Filesystem::IOProxy* fd, uint32_t& data)
     {
-        bool ok = (fread(&data, 1, sizeof(data), fd) == sizeof(data));
+        bool ok = (fd->read(&data, sizeof(data)) == sizeof(data));
         if (littleendian())
             swap_endian(&data);
         return ok;
     }
-    bool read(FILE* fd, uint16_t& data)
+    bool read(Filesystem::IOProxy* fd, uint16_t& data)
     {
-        bool ok = (fread(&data, 1, sizeof(data), fd) == sizeof(data));
+        bool ok = (fd->read(&data, sizeof(data)) == sizeof(data));
         if (littleendian())
             swap_endian(&data);
         return ok;
     }
-    bool read_typesize(FILE* fd, uint8_t type[4], uint32_t& size)
+    bool read_typesize(Filesystem::IOProxy* fd, uint8_t type[4],
+                       uint32_t& size)
     {
-        return (fread(type, 1, 4, fd) == 4) && read(fd, size);
+        return (fd->read(type, 4) == 4) && read(fd, size);
     }
 };
 
@@ -135,7 +136,13 @@ public:
     IffInput() { init(); }
     virtual ~IffInput() { close(); }
     virtual const char* format_name(void) const override { return "iff"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool close(void) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
@@ -143,7 +150,6 @@ public:
                                   int z, void* data) override;
 
 private:
-    FILE* m_fd;
     std::string m_filename;
     iff_pvt::IffFileHeader m_iff_header;
     std::vector<uint8_t> m_buf;
@@ -153,7 +159,6 @@ private:
     // init to initialize state
     void init(void)
     {
-        m_fd = NULL;
         m_filename.clear();
         m_buf.clear();
     }
@@ -166,7 +171,7 @@ private:
 
     bool read_short(uint16_t& val)
     {
-        bool ok = fread(&val, sizeof(val), 1, m_fd);
+        bool ok = ioread(&val, sizeof(val));
         if (littleendian())
             swap_endian(&val);
         return ok;
@@ -174,7 +179,7 @@ private:
 
     bool read_int(uint32_t& val)
     {
-        bool ok = fread(&val, sizeof(val), 1, m_fd);
+        bool ok = ioread(&val, sizeof(val));
         if (littleendian())
             swap_endian(&val);
         return ok;
@@ -185,10 +190,10 @@ private:
         const uint32_t big = 1024;
         char strbuf[big];
         len     = std::min(len, big);
-        bool ok = fread(strbuf, len, 1, m_fd);
+        bool ok = ioread(strbuf, len);
         val.assign(strbuf, len);
-        for (uint32_t pad = len % round; pad; --pad)
-            fgetc(m_fd);
+        if (uint32_t pad = len % round)
+            ok &= ioseek(pad, SEEK_CUR);
         return ok;
     }
 
@@ -222,18 +227,13 @@ public:
                             stride_t ystride, stride_t zstride) override;
 
 private:
-    FILE* m_fd;
     std::string m_filename;
     iff_pvt::IffFileHeader m_iff_header;
     std::vector<uint8_t> m_buf;
     unsigned int m_dither;
     std::vector<uint8_t> scratch;
 
-    void init(void)
-    {
-        m_fd = NULL;
-        m_filename.clear();
-    }
+    void init(void) { m_filename.clear(); }
 
     // writes information about iff file to give file
     bool write_header(iff_pvt::IffFileHeader& header);
@@ -242,21 +242,21 @@ private:
     {
         if (littleendian())
             swap_endian(&val);
-        return fwrite(&val, sizeof(val), 1, m_fd);
+        return iowrite(&val, sizeof(val));
     }
     bool write_int(uint32_t val)
     {
         if (littleendian())
             swap_endian(&val);
-        return fwrite(&val, sizeof(val), 1, m_fd);
+        return iowrite(&val, sizeof(val));
     }
 
     bool write_str(string_view val, size_t round = 4)
     {
-        bool ok = fwrite(val.data(), val.size(), 1, m_fd);
+        bool ok = iowrite(val.data(), val.size());
         for (size_t i = val.size(); i < round_to_multiple(val.size(), round);
              ++i)
-            ok &= (fputc(' ', m_fd) != EOF);
+            ok &= iowrite(" ", 1);
         return ok;
     }
 
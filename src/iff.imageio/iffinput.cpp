@@ -32,6 +32,16 @@ OIIO_PLUGIN_EXPORTS_END
 
 
 
+bool
+IffInput::open(const std::string& name, ImageSpec& spec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
+}
+
+
+
 bool
 IffInput::open(const std::string& name, ImageSpec& spec)
 {
@@ -60,15 +70,12 @@ IffInput::open(const std::string& name, ImageSpec& spec)
     // saving 'name' for later use
     m_filename = name;
 
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // we read header of the file that we think is IFF file
     std::string err;
-    if (!m_iff_header.read_header(m_fd, err)) {
+    if (!m_iff_header.read_header(ioproxy(), err)) {
         errorf("\"%s\": could not read iff header (%s)", m_filename,
                err.size() ? err : std::string("unknown"));
         close();
@@ -173,10 +180,7 @@ IffInput::read_native_tile(int subimage, int miplevel, int x, int y, int /*z*/,
 
 bool inline IffInput::close(void)
 {
-    if (m_fd) {
-        fclose(m_fd);
-        m_fd = NULL;
-    }
+    ioproxy_clear();
     init();
     return true;
 }
@@ -192,16 +196,17 @@ IffInput::readimg()
 
     // seek pos
     // set position tile may be called randomly
-    fseek(m_fd, m_tbmp_start, SEEK_SET);
+    if (!ioseek(m_tbmp_start))
+        return false;
 
     // resize buffer
     m_buf.resize(m_spec.image_bytes());
 
     for (unsigned int t = 0; t < m_iff_header.tiles;) {
         // get type
-        if (!fread(&type, 1, sizeof(type), m_fd) ||
+        if (!ioread(&type, sizeof(type)) ||
             // get length
-            !fread(&size, 1, sizeof(size), m_fd))
+            !ioread(&size, sizeof(size)))
             return false;
 
         if (littleendian())
@@ -214,10 +219,10 @@ IffInput::readimg()
             && type[3] == 'A') {
             // get tile coordinates.
             uint16_t xmin, xmax, ymin, ymax;
-            if (!fread(&xmin, 1, sizeof(xmin), m_fd)
-                || !fread(&ymin, 1, sizeof(ymin), m_fd)
-                || !fread(&xmax, 1, sizeof(xmax), m_fd)
-                || !fread(&ymax, 1, sizeof(ymax), m_fd))
+            if (!ioread(&xmin, sizeof(xmin))
+                || !ioread(&ymin, sizeof(ymin))
+                || !ioread(&xmax, sizeof(xmax))
+                || !ioread(&ymax, sizeof(ymax)))
                 return false;
 
             // swap endianness
@@ -268,7 +273,7 @@ IffInput::readimg()
                 // set bytes.
                 scratch.resize(image_size);
 
-                if (!fread(&scratch[0], 1, scratch.size(), m_fd))
+                if (!ioread(&scratch[0], scratch.size()))
                     return false;
 
                 // set tile data
@@ -330,7 +335,7 @@ IffInput::readimg()
                 // set bytes.
                 scratch.resize(image_size);
 
-                if (!fread(&scratch[0], 1, scratch.size(), m_fd))
+                if (!ioread(&scratch[0], scratch.size()))
                     return false;
 
                 // set tile data
@@ -431,7 +436,7 @@ IffInput::readimg()
 
         } else {
             // skip to the next block
-            if (fseek(m_fd, chunksize, SEEK_CUR))
+            if (!ioseek(chunksize, SEEK_CUR))
                 return false;
         }
     }
@@ -27,7 +27,8 @@ OIIO_PLUGIN_EXPORTS_END
 int
 IffOutput::supports(string_view feature) const
 {
-    return (feature == "tiles" || feature == "alpha" || feature == "nchannels");
+    return (feature == "tiles" || feature == "alpha" || feature == "nchannels"
+            || feature == "ioproxy");
 }
 
 
@@ -72,11 +73,9 @@ IffOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
     m_spec.tile_height = tile_height();
     m_spec.tile_depth  = 1;
 
-    m_fd = Filesystem::fopen(m_filename, "wb");
-    if (!m_fd) {
-        errorf("Could not open \"%s\"", m_filename);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // IFF image files only supports UINT8 and UINT16.  If something
     // else was requested, revert to the one most likely to be readable
@@ -186,7 +185,12 @@ IffOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 inline bool
 IffOutput::close(void)
 {
-    if (m_fd && m_buf.size()) {
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
+
+    if (m_buf.size()) {
         // flip buffer to make write tile easier,
         // from tga.imageio:
 
@@ -227,7 +231,7 @@ IffOutput::close(void)
 
                 // write 'RGBA' type
                 std::string tmpstr = "RGBA";
-                if (!fwrite(tmpstr.c_str(), tmpstr.length(), 1, m_fd))
+                if (!iowrite(tmpstr.c_str(), tmpstr.length()))
                     return false;
 
                 // length.
@@ -456,7 +460,7 @@ IffOutput::close(void)
                 if (littleendian())
                     swap_endian(&length);
 
-                if (!fwrite(&length, sizeof(length), 1, m_fd))
+                if (!iowrite(&length, sizeof(length)))
                     return false;
 
                 // write xmin, xmax, ymin and ymax
@@ -467,57 +471,56 @@ IffOutput::close(void)
                     swap_endian(&ymax);
                 }
 
-                if (!fwrite(&xmin, sizeof(xmin), 1, m_fd)
-                    || !fwrite(&ymin, sizeof(ymin), 1, m_fd)
-                    || !fwrite(&xmax, sizeof(xmax), 1, m_fd)
-                    || !fwrite(&ymax, sizeof(ymax), 1, m_fd))
+                if (!iowrite(&xmin, sizeof(xmin))
+                    || !iowrite(&ymin, sizeof(ymin))
+                    || !iowrite(&xmax, sizeof(xmax))
+                    || !iowrite(&ymax, sizeof(ymax)))
                     return false;
 
                 // write tile
-                if (!fwrite(&scratch[0], tile_length, 1, m_fd))
+                if (!iowrite(&scratch[0], tile_length))
                     return false;
             }
         }
 
         // set sizes
         uint32_t pos, tmppos;
-        pos = ftell(m_fd);
+        pos = iotell();
 
         uint32_t p0 = pos - 8;
         uint32_t p1 = p0 - m_iff_header.for4_start;
 
         // set pos
         tmppos = 4;
-        fseek(m_fd, tmppos, SEEK_SET);
+        if (!ioseek(tmppos))
+            return false;
 
         // write FOR4 <size> CIMG
         if (littleendian()) {
             swap_endian(&p0);
         }
 
-        if (!fwrite(&p0, sizeof(p0), 1, m_fd))
+        if (!iowrite(&p0, sizeof(p0)))
             return false;
 
         // set pos
         tmppos = m_iff_header.for4_start + 4;
-        fseek(m_fd, tmppos, SEEK_SET);
+        if (!ioseek(tmppos))
+            return false;
 
         // write FOR4 <size> TBMP
         if (littleendian()) {
             swap_endian(&p1);
         }
 
-        if (!fwrite(&p1, sizeof(p1), 1, m_fd))
+        if (!iowrite(&p1, sizeof(p1)))
             return false;
 
         m_buf.resize(0);
         m_buf.shrink_to_fit();
     }
-    if (m_fd) {
-        // close the stream
-        fclose(m_fd);
-        m_fd = NULL;
-    }
+    ioproxy_clear();
+    init();
     return true;
 }
 
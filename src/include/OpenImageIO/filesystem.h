@@ -351,7 +351,7 @@ public:
     bool seek (int64_t offset, int origin) {
         return seek ((origin == SEEK_SET ? offset : 0) +
                      (origin == SEEK_CUR ? offset+tell() : 0) +
-                     (origin == SEEK_END ? size() : 0));
+                     (origin == SEEK_END ? offset+int64_t(size()) : 0));
     }
 
 #if OIIO_VERSION >= 20101
@@ -466,6 +466,46 @@ protected:
     cspan<unsigned char> m_buf;
 };
 
+
+/// IOProxy subclass for reading that memory-maps a whole file, read-only.
+/// Reads are plain copies out of the mapping, and since it's an
+/// IOMemReader, buffer() gives readers direct access to the mapped bytes.
+/// If the file can't be mapped (including if it's empty), the proxy is
+/// left Closed. N.B. if the file is truncated by someone else while it's
+/// mapped, touching the lost pages will crash, so only map files that
+/// aren't being written.
+class OIIO_API IOMMap : public IOMemReader {
+public:
+    IOMMap(string_view filename);
+    virtual ~IOMMap();
+    IOMMap(const IOMMap&) = delete;
+    IOMMap& operator=(const IOMMap&) = delete;
+    virtual const char* proxytype() const { return "mmap"; }
+    virtual void close();
+};
+
+
+/// std::streambuf that reads through an IOProxy, for the benefit of
+/// parsers written in terms of std::istream. It reads in blocks and
+/// supports seeking; the proxy is not owned. If the proxy is an
+/// IOMemReader (or IOMMap), the stream reads its buffer in place.
+class OIIO_API IOProxyStreambuf : public std::streambuf {
+public:
+    IOProxyStreambuf(IOProxy* io, size_t bufsize = 64 * 1024);
+
+protected:
+    virtual int_type underflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+    IOProxy* m_io;
+    std::vector<char> m_buf;
+    int64_t m_bufpos;  // file position of the start of m_buf
+    bool m_inmemory = false;  // get area is the proxy's whole buffer
+};
+
 };  // namespace Filesystem
 
 OIIO_NAMESPACE_END
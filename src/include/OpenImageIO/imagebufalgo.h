@@ -24,6 +24,7 @@
 #include <OpenEXR/ImathMatrix.h>       /* because we need M33f */
 
 #include <limits>
+#include <memory>
 
 #if !defined(__OPENCV_CORE_TYPES_H__) && !defined(OPENCV_CORE_TYPES_H)
 struct IplImage;  // Forward declaration; used by Intel Image lib & OpenCV
@@ -1314,6 +1315,11 @@ inline bool make_kernel (ImageBuf &dst, string_view name,
 /// it defaults to the full size `src`. If `normalized` is true, the kernel will
 /// be normalized for the  convolution, otherwise the original values will
 /// be used.
+///
+/// Separable kernels (such as those made by `make_kernel()` for most
+/// filters) are applied as two 1D passes, and other kernels of 5x5 or more
+/// by FFT, so large kernels are not much more expensive than small ones.
+/// The global `"convolve_method"` attribute can override the choice.
 ImageBuf OIIO_API convolve (const ImageBuf &src, const ImageBuf &kernel,
                             bool normalize = true, ROI roi={}, int nthreads=0);
 /// Write to an exsisting image `dst` (allocating if it is uninitialized).
@@ -1468,7 +1474,9 @@ bool OIIO_API fillholes_pushpull (ImageBuf &dst, const ImageBuf &src,
 ///
 /// Median filters are good for removing high-frequency detail smaller than
 /// the window size (including noise), without blurring edges that are
-/// larger than the window size.
+/// larger than the window size. For uint8, uint16, and half images, the
+/// median is found with a histogram that slides along with the window, so
+/// the cost grows only slowly with the window size.
 ImageBuf OIIO_API median_filter (const ImageBuf &src,
                                  int width = 3, int height = -1,
                                  ROI roi={}, int nthreads=0);
@@ -1514,7 +1522,8 @@ bool OIIO_API unsharp_mask (ImageBuf &dst, const ImageBuf &src,
 /// the structuring element (which is taken to be a width x height square).
 /// If height is not set, it will default to be the same as width. Dilation
 /// makes bright features wider and more prominent, dark features thinner,
-/// and removes small isolated dark spots.
+/// and removes small isolated dark spots. The cost per pixel doesn't
+/// depend on the window size, so large windows are not expensive.
 ImageBuf OIIO_API dilate (const ImageBuf &src, int width=3, int height=-1,
                           ROI roi={}, int nthreads=0);
 /// Write to an exsisting image `dst` (allocating if it is uninitialized).
@@ -1810,6 +1819,104 @@ bool OIIO_API repremult (ImageBuf &dst, const ImageBuf &src,
 
 
 
+/// @defgroup PixelExpr (PixelExpr -- fused per-pixel expressions)
+/// @{
+///
+/// A `PixelExpr` describes a chain of per-pixel operations on images and
+/// constants without computing anything. Only `eval()` does the work, in a
+/// single parallel pass over the ROI, a short strip of pixels at a time,
+/// so the intermediate results stay in cache and no full-size ImageBuf is
+/// ever allocated for them. For example,
+///
+///     using OIIO::ImageBufAlgo::PixelExpr;
+///     ImageBuf R = (PixelExpr(A) * 0.5f).over(PixelExpr(B) + C).eval();
+///
+/// gives the same result as
+///
+///     ImageBuf R = ImageBufAlgo::over(ImageBufAlgo::mul(A, 0.5f),
+///                                     ImageBufAlgo::add(B, C));
+///
+/// but reads each of A, B, and C once and writes R once, without the two
+/// temporary images. A subexpression that is used more than once is still
+/// computed only once per pixel.
+///
+/// An expression holds a *reference* to each ImageBuf it uses, so those
+/// images must stay alive (and not be modified by anyone else) until the
+/// last `eval()`. Constants are a single float for all channels, or
+/// per-channel values (the last one repeats if there are too few).
+///
+/// Each operation works like the ImageBufAlgo function of the same name,
+/// with all math done in float. When two images with different numbers of
+/// channels are combined, the result has the smaller number of channels.
+/// Pixels outside an image's data window are zero. The alpha and z
+/// channels (used by `premult`, `unpremult`, `over` and `clamp`) are the
+/// ones designated by the spec of the image they came from.
+class OIIO_API PixelExpr {
+public:
+    /// An empty expression.
+    PixelExpr ();
+    /// The pixels of an image.
+    PixelExpr (const ImageBuf &img);
+    /// A constant value for every channel.
+    PixelExpr (float val);
+    /// A constant with per-channel values.
+    PixelExpr (cspan<float> val);
+    PixelExpr (const std::vector<float> &val);
+
+    /// Is this a non-empty expression?
+    bool initialized () const { return m_node != nullptr; }
+
+    /// The number of channels in the result, or 0 if the expression is
+    /// made only of constants.
+    int nchannels () const;
+
+    friend OIIO_API PixelExpr operator+ (const PixelExpr &A, const PixelExpr &B);
+    friend OIIO_API PixelExpr operator- (const PixelExpr &A, const PixelExpr &B);
+    friend OIIO_API PixelExpr operator* (const PixelExpr &A, const PixelExpr &B);
+    /// Division by zero yields zero, as with `ImageBufAlgo::div()`.
+    friend OIIO_API PixelExpr operator/ (const PixelExpr &A, const PixelExpr &B);
+
+    /// `*this * B + C`
+    PixelExpr mad (const PixelExpr &B, const PixelExpr &C) const;
+    PixelExpr abs () const;
+    PixelExpr absdiff (const PixelExpr &B) const;
+    PixelExpr min (const PixelExpr &B) const;
+    PixelExpr max (const PixelExpr &B) const;
+    PixelExpr pow (cspan<float> exponent) const;
+    PixelExpr clamp (cspan<float> min = -std::numeric_limits<float>::max(),
+                     cspan<float> max = std::numeric_limits<float>::max(),
+                     bool clampalpha01 = false) const;
+    PixelExpr premult () const;
+    PixelExpr unpremult () const;
+    /// Shuffle channels, as with `ImageBufAlgo::channels()`: channel i of
+    /// the result is channel `channelorder[i]` of this expression, or
+    /// `channelvalues[i]` (or 0) if `channelorder[i]` is < 0.
+    PixelExpr channels (int nchannels, cspan<int> channelorder,
+                        cspan<float> channelvalues = {}) const;
+    /// `*this` composited over B. Requires an alpha channel.
+    PixelExpr over (const PixelExpr &B) const;
+
+    /// Compute the expression into the ROI of `dst`. If `dst` is
+    /// uninitialized, it is allocated with the union of the data windows
+    /// of all the images in the expression (or the ROI, if defined) and
+    /// the widest of their pixel types. `dst` may also be one of the
+    /// expression's own images. Return true upon success, or false with an
+    /// error set in `dst`.
+    bool eval (ImageBuf &dst, ROI roi={}, int nthreads=0) const;
+    /// Return the computed expression as a new image.
+    ImageBuf eval (ROI roi={}, int nthreads=0) const;
+
+    struct Node;  // Internal implementation details
+
+private:
+    std::shared_ptr<const Node> m_node;
+    PixelExpr (std::shared_ptr<const Node> node) : m_node(node) {}
+};
+
+/// @}
+
+
+
 enum OIIO_API MakeTextureMode {
     MakeTxTexture, MakeTxShadow, MakeTxEnvLatl,
     MakeTxEnvLatlFromLightProbe,
@@ -1943,6 +2050,22 @@ enum OIIO_API MakeTextureMode {
 ///                           The fastest path may result in a slight shift
 ///                           in the image, accumulated for each mip level
 ///                           with an odd resolution. (0)
+///    - `maketx:pipeline` (int) :
+///                           If nonzero, compute each MIP level while the
+///                           previous ones are still being written, and
+///                           write each level in strips as soon as they
+///                           are computed. (1)
+///    - `maketx:stream` (int) :
+///                           If nonzero, read the source through a private
+///                           ImageCache and build the MIP levels a tile row
+///                           at a time, using temporary files beside the
+///                           output for the lower levels, so that memory
+///                           use stays a small multiple of a tile row of
+///                           the source. Only plain textures and shadow
+///                           maps that need no whole-image operations
+///                           (resizing, color conversion, sharpening,
+///                           etc.) can be streamed; otherwise this is
+///                           ignored. (0)
 ///    - `maketx:bumpformat` (string) :
 ///                           For the MakeTxBumpWithSlopes mode, chooses
 ///                           whether to assume the map is a height map
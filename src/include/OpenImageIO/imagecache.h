@@ -210,6 +210,66 @@ public:
     ///           enabled, this reduces the number of file opens, at the
     ///           expense of not being able to open files if their format do
     ///           not actually match their filename extension). Default: 0
+    /// - `int prefetch_threads` :
+    ///           The number of background threads that read tiles named
+    ///           by `prefetch()` hints into the cache ahead of their use.
+    ///           The default is 0, meaning that prefetching is disabled and
+    ///           `prefetch()` hints are ignored.
+    /// - `int mmap_tiles` :
+    ///           When nonzero, tiles that the file stores exactly as the
+    ///           cache would hold them in memory (such as uncompressed
+    ///           tiled TIFF files whose data type is cached unchanged) are
+    ///           used directly from a memory mapping of the file, rather
+    ///           than being read into newly allocated memory. Such tiles
+    ///           don't count against `max_memory_MB`, and their pages may
+    ///           be shared with other processes reading the same files.
+    ///           Files must not be modified while they are mapped. The
+    ///           default is 0.
+    /// - `int compress_tiles` :
+    ///           When nonzero, tiles that would be evicted to stay within
+    ///           `max_memory_MB`, but that have been used more than
+    ///           briefly, are first kept in memory losslessly compressed,
+    ///           and only evicted if they go unused for another pass of
+    ///           the cache's paging; using one expands it again. This
+    ///           lets many more tiles fit in the same memory (especially
+    ///           of smooth float or half images) at the cost of
+    ///           compressing and expanding them. Tiles are compressed by
+    ///           background threads, not by the threads looking up
+    ///           texture. The default is 0.
+    /// - `string disk_cache_dir` :
+    ///           When set to a directory name, enables a persistent
+    ///           on-disk "second level" cache of decoded tiles in that
+    ///           directory (creating it if needed). Tiles that are not in
+    ///           memory are looked for there before being read from their
+    ///           image files, and tiles read from image files are stored
+    ///           there, so later processes on the same machine can skip
+    ///           reading and decompressing them again. Entries are keyed
+    ///           by the file's fingerprint (or its name and modification
+    ///           time), so modified files are never served stale tiles.
+    ///           The default is the empty string, which disables it.
+    /// - `float disk_cache_max_MB` :
+    ///           The maximum total size of the disk cache directory; the
+    ///           least recently used tiles are deleted as needed to stay
+    ///           within it. (Default: 4096.0)
+    ///
+    /// - `string shared_cache_name` :
+    ///           When set, attaches to the named POSIX shared memory
+    ///           segment (creating it if no process has yet), which holds
+    ///           decoded tiles for every process on the machine that
+    ///           attaches to the same name, so that they are read and
+    ///           stored only once. Tiles are used in place, and only tiles
+    ///           that no process is using are evicted. Only processes of
+    ///           the same user may share a segment, and tiles larger than
+    ///           64KB are not shared. The segment is removed when the
+    ///           last process attached to it detaches (or destroys its
+    ///           cache). Tiles in use by a process that crashes stay
+    ///           pinned until then, but a crashed process never blocks the
+    ///           others. (Default: "", which disables sharing.)
+    ///
+    /// - `float shared_cache_max_MB` :
+    ///           The size of the shared tile segment, if this process is
+    ///           the one to create it. Must be set before
+    ///           `shared_cache_name`. (Default: 1024.0)
     ///
     /// - `string options`
     ///           This catch-all is simply a comma-separated list of
@@ -247,6 +307,28 @@ public:
     ///           query), and the peak number of tiles in memory at any
     ///           time.
     ///
+    /// - `int64 stat:tile_evictions` ,
+    ///   `int64[] stat:tile_evictions_per_shard` :
+    ///           Total number of tiles evicted from the cache to stay
+    ///           within `max_memory_MB`, and the same count broken down
+    ///           by each shard of the tile cache (the array is filled with
+    ///           as many shards as it has room for).
+    ///
+    /// - `int64 stat:tiles_prefetched` :
+    ///           Number of tiles read into the cache by the background
+    ///           prefetch threads.
+    ///
+    /// - `int64 stat:disk_cache_hits` ,
+    ///   `int64 stat:disk_cache_misses` ,
+    ///   `int64 stat:disk_cache_writes` :
+    ///           Number of tiles found in the on-disk cache, not found
+    ///           there, and stored there.
+    ///
+    /// - `int64 stat:shared_cache_hits` ,
+    ///   `int64 stat:shared_cache_adds` :
+    ///           Number of tiles found in the shared tile segment, and
+    ///           read by this process and added there.
+    ///
     /// - `int stat:open_files_created` ,
     ///   `int stat:open_files_current` ,
     ///   `int stat:open_files_peak` :
@@ -269,6 +351,16 @@ public:
     /// - `int64 stat:bytes_read` :
     ///           Total size (uncompressed bytes of pixel data) read.
     ///
+    /// - `int64 stat:tiles_mapped` :
+    ///           Number of tiles used directly from memory-mapped files
+    ///           (see `mmap_tiles`).
+    ///
+    /// - `int64 stat:tiles_compressed` ,
+    ///   `int64 stat:tiles_decompressed` :
+    ///           Number of cold tiles compressed rather than evicted, and
+    ///           number of those expanded again when used (see
+    ///           `compress_tiles`).
+    ///
     /// - `int stat:unique_files` :
     ///           Number of unique files opened.
     ///
@@ -462,6 +554,18 @@ public:
     virtual ImageHandle* get_image_handle (ustring filename,
                                             Perthread *thread_info=NULL) = 0;
 
+    /// Retrieve opaque handles for many images at once, storing the handle
+    /// for `filenames[i]` in `handles[i]` (which must be at least as long).
+    /// The result is the same as calling `get_image_handle()` for each
+    /// name, but resolving the names of files not yet in the cache, and
+    /// opening them, happen in parallel, which is much faster when a scene
+    /// refers to very many textures (such as the many tiles of UDIM
+    /// textures). (This is not virtual, so that adding it left the
+    /// class's ABI unchanged.)
+    void get_image_handles (cspan<ustring> filenames,
+                            span<ImageHandle*> handles,
+                            Perthread *thread_info=NULL);
+
     /// Return true if the image handle (previously returned by
     /// `get_image_handle()`) is a valid image that can be subsequently read.
     virtual bool good(ImageHandle* file) = 0;
@@ -883,6 +987,39 @@ public:
     /// not yet been released with `release_tile()`.
     virtual const void* tile_pixels(Tile* tile, TypeDesc& format) const = 0;
 
+    /// Hint that the tiles covering the pixel region `[xbegin,xend) x
+    /// [ybegin,yend) x [zbegin,zend)` of the given subimage and MIP level
+    /// (and optionally a channel range, with the same meaning as for
+    /// `get_tile()`) will be needed soon.  If the `prefetch_threads`
+    /// attribute is nonzero, the tiles not already in the cache are
+    /// queued to be read by background threads and this call returns
+    /// immediately; a thread that needs one of those tiles before it has
+    /// been read will just wait for it, or read it itself if the
+    /// prefetch has not started yet.  Typical hints are the neighbors of
+    /// a tile just used, the corresponding region of the next MIP level,
+    /// or all the tiles a batch of shading points is about to touch.
+    ///
+    /// @returns
+    ///         `true` if the hint was queued, `false` if prefetching is
+    ///         disabled, the file, subimage or MIP level is invalid, or
+    ///         an `invalidate()` or `close()` is in progress (hints are
+    ///         turned away until it finishes).
+    ///
+    /// (This is not virtual, so that adding it left the class's ABI
+    /// unchanged.)
+    bool prefetch (ustring filename, int subimage, int miplevel,
+                   int xbegin, int xend, int ybegin, int yend,
+                   int zbegin = 0, int zend = 1,
+                   int chbegin = 0, int chend = -1);
+    /// A slightly more efficient variety of `prefetch()` for cases where
+    /// you can use an `ImageHandle*` to specify the image and optionally
+    /// have a `Perthread*` for the calling thread.
+    bool prefetch (ImageHandle *file, Perthread *thread_info,
+                   int subimage, int miplevel,
+                   int xbegin, int xend, int ybegin, int yend,
+                   int zbegin = 0, int zend = 1,
+                   int chbegin = 0, int chend = -1);
+
     /// The add_file() call causes a file to be opened or added to the
     /// cache. There is no reason to use this method unless you are
     /// supplying a custom creator, or configuration, or both.
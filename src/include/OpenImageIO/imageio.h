@@ -24,6 +24,7 @@
 #endif
 
 #include <cmath>
+#include <cstdio>
 #include <limits>
 #include <string>
 #include <vector>
@@ -1543,9 +1544,7 @@ public:
     /// (`supports("ioproxy")`). The caller retains ownership of the proxy.
     ///
     /// @returns `true` for success, `false` for failure.
-    virtual bool set_ioproxy (Filesystem::IOProxy* ioproxy) {
-        return (ioproxy == nullptr);
-    }
+    virtual bool set_ioproxy (Filesystem::IOProxy* ioproxy);
 
     /// If any of the API routines returned false indicating an error, this
     /// method will return the error string (and clear any error flags).  If
@@ -1616,6 +1615,41 @@ public:
     typedef ImageInput* (*Creator)();
 
 protected:
+    /// @{
+    /// @name Helpers for readers that do their I/O through an IOProxy
+    ///
+    /// A reader that supports "ioproxy" calls
+    /// `ioproxy_retrieve_from_config()` in its `open(name,spec,config)` to
+    /// honor an "oiio:ioproxy" configuration hint, then
+    /// `ioproxy_use_or_open(name)` to use the proxy set by the app or else
+    /// open the named file (issuing an error and returning false if that
+    /// fails), and does all its reading with `ioread()`, `ioseek()` and
+    /// `iotell()`, or directly through `ioproxy()`. Its `close()` does
+    /// nothing if `!ioproxy_opened()`, and otherwise calls
+    /// `ioproxy_clear()`, which closes the file if we opened it ourselves
+    /// and forgets any proxy supplied by the app.
+    void ioproxy_retrieve_from_config (const ImageSpec& config);
+    bool ioproxy_use_or_open (string_view name);
+    void ioproxy_clear ();
+    bool ioproxy_opened () const;
+    Filesystem::IOProxy* ioproxy () const;
+
+    /// Read `nitems` items of `itemsize` bytes each into `buf`. If they
+    /// couldn't all be read, issue an error and return false.
+    bool ioread (void *buf, size_t itemsize, size_t nitems=1);
+    /// Seek to `pos`, relative to `origin` (`SEEK_SET`, `SEEK_CUR` or
+    /// `SEEK_END`), issuing an error and returning false upon failure.
+    bool ioseek (int64_t pos, int origin=SEEK_SET);
+    /// Return the current position in the proxy.
+    int64_t iotell () const;
+    /// If the proxy holds its whole contents in memory (an IOMemReader or
+    /// IOMMap), return a pointer to the `size` bytes starting at `offset`,
+    /// so they may be decoded in place. Return nullptr if the proxy isn't
+    /// in memory or the range is out of bounds, in which case the reader
+    /// should fall back to `ioread()`. The memory must not be modified.
+    const unsigned char* iomapped (int64_t offset, size_t size) const;
+    /// @}
+
     mutable mutex m_mutex;   // lock of the thread-safe methods
     ImageSpec m_spec;  // format spec of the current open subimage/MIPlevel
                        // BEWARE using m_spec directly -- not thread-safe
@@ -2152,9 +2186,7 @@ public:
     /// (`supports("ioproxy")`). The caller retains ownership of the proxy.
     ///
     /// @returns `true` for success, `false` for failure.
-    virtual bool set_ioproxy (Filesystem::IOProxy* ioproxy) {
-        return (ioproxy == nullptr);
-    }
+    virtual bool set_ioproxy (Filesystem::IOProxy* ioproxy);
 
     /// If any of the API routines returned false indicating an error, this
     /// method will return the error string (and clear any error flags).  If
@@ -2272,6 +2304,43 @@ protected:
                                     void *image_buffer,
                                     TypeDesc buf_format = TypeDesc::UNKNOWN);
 
+    /// @{
+    /// @name Helpers for writers that do their I/O through an IOProxy
+    ///
+    /// A writer that supports "ioproxy" calls
+    /// `ioproxy_retrieve_from_config(spec)` in its `open()` to honor an
+    /// "oiio:ioproxy" attribute of the spec, then
+    /// `ioproxy_use_or_open(name)` to use the proxy set by the app or else
+    /// create the named file (issuing an error and returning false if that
+    /// fails), and does all its writing with `iowrite()`, `iowritef()`,
+    /// `ioseek()` and `iotell()`, or directly through `ioproxy()`. Its
+    /// `close()` does nothing if `!ioproxy_opened()`, and otherwise calls
+    /// `ioproxy_clear()`, which closes the file if we opened it ourselves
+    /// and forgets any proxy supplied by the app.
+    void ioproxy_retrieve_from_config (const ImageSpec& config);
+    bool ioproxy_use_or_open (string_view name);
+    void ioproxy_clear ();
+    bool ioproxy_opened () const;
+    Filesystem::IOProxy* ioproxy () const;
+    /// Is the current proxy one we created ourselves (versus the app's)?
+    bool ioproxy_owned () const;
+
+    /// Write `nitems` items of `itemsize` bytes each from `buf`. If they
+    /// couldn't all be written, issue an error and return false.
+    bool iowrite (const void *buf, size_t itemsize, size_t nitems=1);
+    /// Write text formatted printf-style, as with `iowrite()`.
+    template<typename... Args>
+    bool iowritef (const char* fmt, const Args&... args) {
+        std::string s = Strutil::sprintf (fmt, args...);
+        return iowrite (s.data(), s.size());
+    }
+    /// Seek to `pos`, relative to `origin` (`SEEK_SET`, `SEEK_CUR` or
+    /// `SEEK_END`), issuing an error and returning false upon failure.
+    bool ioseek (int64_t pos, int origin=SEEK_SET);
+    /// Return the current position in the proxy.
+    int64_t iotell () const;
+    /// @}
+
 protected:
     ImageSpec m_spec;           ///< format spec of the currently open image
 
@@ -2417,6 +2486,14 @@ OIIO_API std::string geterror ();
 ///    The report of totals can be retrieved as the value of the
 ///    `"timing_report"` attribute, using `OIIO:get_attribute()` call.
 ///
+/// - `string convolve_method`
+///
+///    Chooses how `ImageBufAlgo::convolve()` computes its result: `"auto"`
+///    (the default) picks by kernel, `"direct"` sums over every kernel tap,
+///    `"separable"` uses two 1D passes if the kernel is separable, and
+///    `"fft"` uses blocked FFTs. All give the same results up to float
+///    rounding. Volume images are always convolved directly.
+///
 ///    
 ///
 OIIO_API bool attribute (string_view name, TypeDesc type, const void *val);
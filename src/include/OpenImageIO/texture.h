@@ -757,6 +757,18 @@ public:
     virtual TextureHandle * get_texture_handle (ustring filename,
                                             Perthread *thread_info=nullptr) = 0;
 
+    /// Retrieve opaque handles for many textures at once, storing the
+    /// handle for `filenames[i]` in `handles[i]` (which must be at least as
+    /// long). The result is the same as calling `get_texture_handle()` for
+    /// each name, but resolving the names of files not yet in the cache
+    /// happens in parallel, which is much faster when a scene refers to
+    /// very many textures (such as the many tiles of UDIM textures).
+    /// (This is not virtual, so that adding it left the class's ABI
+    /// unchanged.)
+    void get_texture_handles (cspan<ustring> filenames,
+                              span<TextureHandle*> handles,
+                              Perthread *thread_info=nullptr);
+
     /// Return true if the texture handle (previously returned by
     /// `get_image_handle()`) is a valid texture that can be subsequently
     /// read.
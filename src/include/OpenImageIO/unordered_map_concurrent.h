@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/thread.h>
@@ -387,11 +389,61 @@ public:
         Bin& bin(m_bins[b]);
         if (do_lock)
             bin.lock();
-        bin.map.erase(key, hash);
+        if (bin.map.erase(key, hash))
+            --m_size;
         if (do_lock)
             bin.unlock();
     }
 
+    /// Incrementally sweep ("clock" style) through the entries of bin b,
+    /// holding only that bin's lock. Entries are examined in bin order,
+    /// starting with the one whose key is `hand` (or the first entry of
+    /// the bin if `hand` is KEY() or is no longer present) and wrapping
+    /// around, until `maxvisit` entries have been examined, every entry
+    /// of the bin has been examined once, or `done()` returns true. For
+    /// each entry, `visit(value)` is called and returns true if the entry
+    /// should be erased. On return, `hand` holds the key of the entry to
+    /// examine next time (or KEY() if the bin is empty). Return the number
+    /// of entries erased.
+    template<class VISIT, class DONE>
+    size_t sweep_bin(size_t b, KEY& hand, size_t maxvisit, VISIT&& visit,
+                     DONE&& done)
+    {
+        OIIO_DASSERT(b < BINS);
+        Bin& bin(m_bins[b]);
+        bin.lock();
+        auto& map(bin.map);
+        auto it = map.end();
+        if (!PRED()(hand, KEY()))
+            it = find_with_hash(map, hand, m_hash(hand));
+        if (it == map.end())
+            it = map.begin();
+        size_t nerased = 0;
+        for (size_t n = std::min(maxvisit, map.size()); n && !done(); --n) {
+            if (it == map.end())
+                it = map.begin();
+            if (visit(it->second)) {
+                it = map.erase(it);
+                --m_size;
+                ++nerased;
+            } else {
+                ++it;
+            }
+        }
+        if (it == map.end())
+            it = map.begin();
+        hand = (it != map.end()) ? KEY(it->first) : KEY();
+        bin.unlock();
+        return nerased;
+    }
+
+    /// Return the number of bins.
+    static constexpr size_t nbins() { return BINS; }
+
+    /// Return the number of entries in bin b (without locking, so this is
+    /// only a hint if other threads are modifying the map).
+    size_t bin_size(size_t b) const { return m_bins[b].map.size(); }
+
     /// Return true if the entire map is empty.
     bool empty() { return m_size == 0; }
 
@@ -33,7 +33,8 @@ public:
     virtual const char* format_name(void) const override { return "jpeg"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "exif" || feature == "iptc");
+        return (feature == "exif" || feature == "iptc"
+                || feature == "ioproxy");
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode = Create) override;
@@ -45,21 +46,28 @@ public:
     virtual bool close() override;
     virtual bool copy_image(ImageInput* in) override;
 
+    // A libjpeg destination manager that writes through our IOProxy.
+    struct my_destination_mgr {
+        struct jpeg_destination_mgr pub;  // "public" fields
+        Filesystem::IOProxy* io;          // where to write
+        bool ok;                          // have all writes succeeded?
+        JOCTET buffer[4096];
+    };
+
 private:
-    FILE* m_fd;
     std::string m_filename;
     unsigned int m_dither;
     int m_next_scanline;  // Which scanline is the next to write?
     std::vector<unsigned char> m_scratch;
     struct jpeg_compress_struct m_cinfo;
     struct jpeg_error_mgr c_jerr;
+    my_destination_mgr m_dest;
     jvirt_barray_ptr* m_copy_coeffs;
     struct jpeg_decompress_struct* m_copy_decompressor;
     std::vector<unsigned char> m_tilebuffer;
 
     void init(void)
     {
-        m_fd                = NULL;
         m_copy_coeffs       = NULL;
         m_copy_decompressor = NULL;
     }
@@ -97,6 +105,45 @@ OIIO_PLUGIN_EXPORTS_END
 
 
 
+static void
+init_destination(j_compress_ptr cinfo)
+{
+    JpgOutput::my_destination_mgr* dest = (JpgOutput::my_destination_mgr*)
+                                              cinfo->dest;
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer   = sizeof(dest->buffer);
+}
+
+
+
+static boolean
+empty_output_buffer(j_compress_ptr cinfo)
+{
+    // Always write the whole buffer, as libjpeg asks, even if it isn't
+    // full. A failed write is noted and reported when we close.
+    JpgOutput::my_destination_mgr* dest = (JpgOutput::my_destination_mgr*)
+                                              cinfo->dest;
+    if (dest->io->write(dest->buffer, sizeof(dest->buffer))
+        != sizeof(dest->buffer))
+        dest->ok = false;
+    init_destination(cinfo);
+    return TRUE;
+}
+
+
+
+static void
+term_destination(j_compress_ptr cinfo)
+{
+    JpgOutput::my_destination_mgr* dest = (JpgOutput::my_destination_mgr*)
+                                              cinfo->dest;
+    size_t size = sizeof(dest->buffer) - dest->pub.free_in_buffer;
+    if (size && dest->io->write(dest->buffer, size) != size)
+        dest->ok = false;
+}
+
+
+
 bool
 JpgOutput::open(const std::string& name, const ImageSpec& newspec,
                 OpenMode mode)
@@ -123,15 +170,19 @@ JpgOutput::open(const std::string& name, const ImageSpec& newspec,
         return false;
     }
 
-    m_fd = Filesystem::fopen(name, "wb");
-    if (m_fd == NULL) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     m_cinfo.err = jpeg_std_error(&c_jerr);  // set error handler
     jpeg_create_compress(&m_cinfo);         // create compressor
-    jpeg_stdio_dest(&m_cinfo, m_fd);        // set output stream
+    // Set the output stream to be our IOProxy
+    m_dest.pub.init_destination    = init_destination;
+    m_dest.pub.empty_output_buffer = empty_output_buffer;
+    m_dest.pub.term_destination    = term_destination;
+    m_dest.io                      = ioproxy();
+    m_dest.ok                      = true;
+    m_cinfo.dest                   = &m_dest.pub;
 
     // Set image and compression parameters
     m_cinfo.image_width  = m_spec.width;
@@ -395,9 +446,9 @@ JpgOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 JpgOutput::close()
 {
-    if (!m_fd) {  // Already closed
-        return true;
+    if (!ioproxy_opened()) {  // Already closed
         init();
+        return true;
     }
 
     bool ok = true;
@@ -433,8 +484,11 @@ JpgOutput::close()
     }
     DBG std::cout << "out close: about to destroy_compress\n";
     jpeg_destroy_compress(&m_cinfo);
-    fclose(m_fd);
-    m_fd = NULL;
+    if (!m_dest.ok) {
+        errorf("Could not write all of \"%s\"", m_filename);
+        ok = false;
+    }
+    ioproxy_clear();
     init();
 
     return ok;
@@ -445,7 +499,10 @@ JpgOutput::close()
 bool
 JpgOutput::copy_image(ImageInput* in)
 {
-    if (in && !strcmp(in->format_name(), "jpeg")) {
+    // Copying the coefficients means opening the output twice, which only
+    // works when we write the file ourselves; for an IOProxy supplied by
+    // the app, decode and recompress instead.
+    if (in && !strcmp(in->format_name(), "jpeg") && ioproxy_owned()) {
         JpgInput* jpg_in    = dynamic_cast<JpgInput*>(in);
         std::string in_name = jpg_in->filename();
         DBG std::cout << "JPG copy_image from " << in_name << "\n";
@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
-#include <cstdio>
 #include <vector>
 
 #include <openjpeg.h>
@@ -67,7 +66,7 @@ public:
     virtual const char* format_name(void) const override { return "jpeg2000"; }
     virtual int supports(string_view feature) const override
     {
-        return false;
+        return feature == "ioproxy";
         // FIXME: we should support Exif/IPTC, but currently don't.
     }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
@@ -81,7 +80,6 @@ private:
     std::string m_filename;
     std::vector<int> m_bpp;  // per channel bpp
     opj_image_t* m_image;
-    FILE* m_file;
     bool m_keep_unassociated_alpha;  // Do not convert unassociated alpha
 
     void init(void);
@@ -102,14 +100,6 @@ private:
         return (uint16_t)((src << 4) | (src >> 8));
     }
 
-    size_t get_file_length(FILE* p_file)
-    {
-        fseek(p_file, 0, SEEK_END);
-        const size_t fileLength = ftell(p_file);
-        rewind(m_file);
-        return fileLength;
-    }
-
     template<typename T> void yuv_to_rgb(T* p_scanline)
     {
         for (int x = 0, i = 0; x < m_spec.width; ++x, i += m_spec.nchannels) {
@@ -133,14 +123,6 @@ private:
         event_mgr.info_handler    = openjpeg_dummy_callback;
         opj_set_event_mgr((opj_common_ptr)p_decompressor, &event_mgr, NULL);
     }
-
-    bool fread(void* p_buf, size_t p_itemSize, size_t p_nitems)
-    {
-        size_t n = ::fread(p_buf, p_itemSize, p_nitems, m_file);
-        if (n != p_nitems)
-            errorf("Read error");
-        return n == p_nitems;
-    }
 };
 
 
@@ -167,7 +149,6 @@ OIIO_PLUGIN_EXPORTS_END
 void
 Jpeg2000Input::init(void)
 {
-    m_file                    = NULL;
     m_image                   = NULL;
     m_keep_unassociated_alpha = false;
 }
@@ -177,11 +158,8 @@ bool
 Jpeg2000Input::open(const std::string& p_name, ImageSpec& p_spec)
 {
     m_filename = p_name;
-    m_file     = Filesystem::fopen(m_filename, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", m_filename);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     opj_dinfo_t* decompressor = create_decompressor();
     if (!decompressor) {
@@ -197,9 +175,13 @@ Jpeg2000Input::open(const std::string& p_name, ImageSpec& p_spec)
     opj_set_default_decoder_parameters(&parameters);
     opj_setup_decoder(decompressor, &parameters);
 
-    const size_t fileLength = get_file_length(m_file);
+    const size_t fileLength = ioproxy()->size();
     std::vector<uint8_t> fileContent(fileLength + 1, 0);
-    fread(&fileContent[0], sizeof(uint8_t), fileLength);
+    if (!ioread(&fileContent[0], 1, fileLength)) {
+        opj_destroy_decompress(decompressor);
+        close();
+        return false;
+    }
 
     opj_cio_t* cio = opj_cio_open((opj_common_ptr)decompressor, &fileContent[0],
                                   (int)fileLength);
@@ -289,6 +271,7 @@ Jpeg2000Input::open(const std::string& name, ImageSpec& newspec,
     // Check 'config' for any special requests
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
@@ -326,14 +309,11 @@ Jpeg2000Input::read_native_scanline(int subimage, int miplevel, int y, int z,
 inline bool
 Jpeg2000Input::close(void)
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
     if (m_image) {
         opj_image_destroy(m_image);
         m_image = NULL;
     }
+    ioproxy_clear();
     return true;
 }
 
@@ -360,7 +340,7 @@ opj_dinfo_t*
 Jpeg2000Input::create_decompressor()
 {
     int magic[3];
-    if (::fread(&magic, 4, 3, m_file) != 3) {
+    if (ioproxy()->pread(magic, sizeof(magic), 0) != sizeof(magic)) {
         errorf("Empty file \"%s\"", m_filename);
         return NULL;
     }
@@ -369,7 +349,6 @@ Jpeg2000Input::create_decompressor()
         dinfo = opj_create_decompress(CODEC_JP2);
     else
         dinfo = opj_create_decompress(CODEC_J2K);
-    rewind(m_file);
     return dinfo;
 }
 
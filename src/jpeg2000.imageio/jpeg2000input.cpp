@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
-#include <cstdio>
 #include <vector>
 
 #include <openjpeg.h>
@@ -70,6 +69,34 @@ associateAlpha(T* data, int size, int channels, int alpha_channel, float gamma)
     }
 }
 
+
+
+// OpenJpeg stream callbacks that read through the ImageInput's IOProxy,
+// which arrives as the stream's user data.
+static OPJ_SIZE_T
+stream_read(void* buffer, OPJ_SIZE_T nbytes, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    size_t r = io->read(buffer, nbytes);
+    return r ? OPJ_SIZE_T(r) : OPJ_SIZE_T(-1);  // -1 signals end of stream
+}
+
+
+static OPJ_OFF_T
+stream_skip(OPJ_OFF_T nbytes, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    return io->seek(nbytes, SEEK_CUR) ? nbytes : OPJ_OFF_T(-1);
+}
+
+
+static OPJ_BOOL
+stream_seek(OPJ_OFF_T offset, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    return io->seek(offset) ? OPJ_TRUE : OPJ_FALSE;
+}
+
 }  // namespace
 
 
@@ -78,9 +105,9 @@ public:
     Jpeg2000Input() { init(); }
     virtual ~Jpeg2000Input() { close(); }
     virtual const char* format_name(void) const override { return "jpeg2000"; }
-    virtual int supports(string_view /*feature*/) const override
+    virtual int supports(string_view feature) const override
     {
-        return false;
+        return feature == "ioproxy";
         // FIXME: we should support Exif/IPTC, but currently don't.
     }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
@@ -94,7 +121,6 @@ private:
     std::string m_filename;
     std::vector<int> m_bpp;  // per channel bpp
     opj_image_t* m_image;
-    FILE* m_file;
     opj_codec_t* m_codec;
     opj_stream_t* m_stream;
     bool m_keep_unassociated_alpha;  // Do not convert unassociated alpha
@@ -104,6 +130,7 @@ private:
     bool isJp2File(const int* const p_magicTable) const;
 
     opj_codec_t* create_decompressor();
+    opj_stream_t* create_stream();
     void destroy_decompressor();
 
     void destroy_stream()
@@ -173,7 +200,6 @@ OIIO_PLUGIN_EXPORTS_END
 void
 Jpeg2000Input::init(void)
 {
-    m_file                    = NULL;
     m_image                   = NULL;
     m_codec                   = NULL;
     m_stream                  = NULL;
@@ -185,10 +211,8 @@ bool
 Jpeg2000Input::open(const std::string& p_name, ImageSpec& p_spec)
 {
     m_filename = p_name;
-    if (!Filesystem::exists(m_filename)) {
-        errorf("Could not open file \"%s\"", m_filename);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     m_codec = create_decompressor();
     if (!m_codec) {
@@ -203,14 +227,7 @@ Jpeg2000Input::open(const std::string& p_name, ImageSpec& p_spec)
     opj_set_default_decoder_parameters(&parameters);
     opj_setup_decoder(m_codec, &parameters);
 
-#if defined(OPJ_VERSION_MAJOR)
-    // OpenJpeg >= 2.1
-    m_stream = opj_stream_create_default_file_stream(m_filename.c_str(), true);
-#else
-    // OpenJpeg 2.0: need to open a stream ourselves
-    m_file   = Filesystem::fopen(m_filename, "rb");
-    m_stream = opj_stream_create_default_file_stream(m_file, true);
-#endif
+    m_stream = create_stream();
     if (!m_stream) {
         errorf("Could not open Jpeg2000 stream");
         close();
@@ -225,8 +242,10 @@ Jpeg2000Input::open(const std::string& p_name, ImageSpec& p_spec)
     }
     opj_decode(m_codec, m_stream, m_image);
 
+    // The whole image is decoded now, so the file is no longer needed.
     destroy_decompressor();
     destroy_stream();
+    ioproxy_clear();
 
     // we support only one, three or four components in image
     const int channelCount = m_image->numcomps;
@@ -298,6 +317,7 @@ Jpeg2000Input::open(const std::string& name, ImageSpec& newspec,
     // Check 'config' for any special requests
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
@@ -341,10 +361,7 @@ Jpeg2000Input::close(void)
     }
     destroy_decompressor();
     destroy_stream();
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
+    ioproxy_clear();
     return true;
 }
 
@@ -371,7 +388,7 @@ opj_codec_t*
 Jpeg2000Input::create_decompressor()
 {
     int magic[3];
-    size_t r = Filesystem::read_bytes(m_filename, magic, sizeof(magic));
+    size_t r = ioproxy()->pread(magic, sizeof(magic), 0);
     if (r != 3 * sizeof(int)) {
         errorf("Empty file \"%s\"", m_filename);
         return NULL;
@@ -387,6 +404,30 @@ Jpeg2000Input::create_decompressor()
 
 
 
+opj_stream_t*
+Jpeg2000Input::create_stream()
+{
+    Filesystem::IOProxy* io = ioproxy();
+    io->seek(0);
+    opj_stream_t* stream = opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE,
+                                             OPJ_TRUE);
+    if (!stream)
+        return NULL;
+    opj_stream_set_read_function(stream, stream_read);
+    opj_stream_set_skip_function(stream, stream_skip);
+    opj_stream_set_seek_function(stream, stream_seek);
+#if defined(OPJ_VERSION_MAJOR)
+    // OpenJpeg >= 2.1
+    opj_stream_set_user_data(stream, io, NULL);
+#else
+    opj_stream_set_user_data(stream, io);
+#endif
+    opj_stream_set_user_data_length(stream, io->size());
+    return stream;
+}
+
+
+
 void
 Jpeg2000Input::destroy_decompressor()
 {
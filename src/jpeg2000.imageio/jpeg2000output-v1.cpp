@@ -25,7 +25,7 @@ public:
     virtual const char* format_name(void) const { return "jpeg2000"; }
     virtual int supports(string_view feature) const
     {
-        return (feature == "alpha");
+        return (feature == "alpha" || feature == "ioproxy");
         // FIXME: we should support Exif/IPTC, but currently don't.
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
@@ -39,7 +39,6 @@ public:
 
 private:
     std::string m_filename;
-    FILE* m_file;
     opj_cparameters_t m_compression_parameters;
     opj_image_t* m_image;
     unsigned int m_dither;
@@ -49,7 +48,6 @@ private:
 
     void init(void)
     {
-        m_file          = NULL;
         m_image         = NULL;
         m_convert_alpha = true;
     }
@@ -129,11 +127,9 @@ Jpeg2000Output::open(const std::string& name, const ImageSpec& spec,
     m_convert_alpha = m_spec.alpha_channel != -1
                       && !m_spec.get_int_attribute("oiio:UnassociatedAlpha", 0);
 
-    m_file = Filesystem::fopen(m_filename, "wb");
-    if (m_file == NULL) {
-        errorf("Could not open \"%s\"", m_filename);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
@@ -234,9 +230,9 @@ Jpeg2000Output::write_tile(int x, int y, int z, TypeDesc format,
 bool
 Jpeg2000Output::close()
 {
-    if (!m_file) {  // Already closed
-        return true;
+    if (!ioproxy_opened()) {  // Already closed
         init();
+        return true;
     }
 
     bool ok = true;
@@ -248,12 +244,11 @@ Jpeg2000Output::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    fclose(m_file);
-    m_file = NULL;
     if (m_image) {
         opj_image_destroy(m_image);
         m_image = NULL;
     }
+    ioproxy_clear();
     return ok;
 }
 
@@ -278,16 +273,11 @@ Jpeg2000Output::save_image()
 
     opj_encode(compressor, cio, m_image, NULL);
 
-    size_t wb = fwrite(cio->buffer, 1, cio_tell(cio), m_file);
-    if (wb != (size_t)cio_tell(cio)) {
-        errorf("Failed write jpeg2000::save_image (err: %d)", wb);
-        return false;
-    }
+    bool ok = iowrite(cio->buffer, 1, cio_tell(cio));
 
     opj_destroy_compress(compressor);
     opj_cio_close(cio);
-
-    return true;
+    return ok;
 }
 
 
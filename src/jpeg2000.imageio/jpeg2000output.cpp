@@ -31,6 +31,33 @@ openjpeg_dummy_callback(const char* /*msg*/, void* /*data*/)
 }
 
 
+// OpenJpeg stream callbacks that write through the ImageOutput's IOProxy,
+// which arrives as the stream's user data.
+static OPJ_SIZE_T
+stream_write(void* buffer, OPJ_SIZE_T nbytes, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    size_t r = io->write(buffer, nbytes);
+    return r == nbytes ? OPJ_SIZE_T(r) : OPJ_SIZE_T(-1);
+}
+
+
+static OPJ_OFF_T
+stream_skip(OPJ_OFF_T nbytes, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    return io->seek(nbytes, SEEK_CUR) ? nbytes : OPJ_OFF_T(-1);
+}
+
+
+static OPJ_BOOL
+stream_seek(OPJ_OFF_T offset, void* user_data)
+{
+    auto io = static_cast<Filesystem::IOProxy*>(user_data);
+    return io->seek(offset) ? OPJ_TRUE : OPJ_FALSE;
+}
+
+
 
 class Jpeg2000Output final : public ImageOutput {
 public:
@@ -39,7 +66,7 @@ public:
     virtual const char* format_name(void) const override { return "jpeg2000"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "alpha");
+        return (feature == "alpha" || feature == "ioproxy");
         // FIXME: we should support Exif/IPTC, but currently don't.
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
@@ -53,7 +80,6 @@ public:
 
 private:
     std::string m_filename;
-    FILE* m_file;
     opj_cparameters_t m_compression_parameters;
     opj_image_t* m_image;
     opj_codec_t* m_codec;
@@ -65,7 +91,6 @@ private:
 
     void init(void)
     {
-        m_file          = NULL;
         m_image         = NULL;
         m_codec         = NULL;
         m_stream        = NULL;
@@ -163,11 +188,9 @@ Jpeg2000Output::open(const std::string& name, const ImageSpec& spec,
     m_convert_alpha = m_spec.alpha_channel != -1
                       && !m_spec.get_int_attribute("oiio:UnassociatedAlpha", 0);
 
-    m_file = Filesystem::fopen(m_filename, "wb");
-    if (m_file == NULL) {
-        errorf("Could not open \"%s\"", m_filename);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
@@ -268,7 +291,8 @@ Jpeg2000Output::write_tile(int x, int y, int z, TypeDesc format,
 bool
 Jpeg2000Output::close()
 {
-    if (!m_stream) {  // Already closed
+    if (!ioproxy_opened()) {  // Already closed
+        init();
         return true;
     }
 
@@ -287,10 +311,8 @@ Jpeg2000Output::close()
     }
     destroy_compressor();
     destroy_stream();
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
+    ioproxy_clear();
+    init();
     return ok;
 }
 
@@ -309,18 +331,20 @@ Jpeg2000Output::save_image()
 
     opj_setup_encoder(m_codec, &m_compression_parameters, m_image);
 
-#if defined(OPJ_VERSION_MAJOR)
-    // OpenJpeg >= 2.1
-    m_stream = opj_stream_create_default_file_stream(m_filename.c_str(), false);
-#else
-    // OpenJpeg 2.0: need to open a stream ourselves
-    m_file   = Filesystem::fopen(m_filename, "wb");
-    m_stream = opj_stream_create_default_file_stream(m_file, false);
-#endif
+    m_stream = opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE, OPJ_FALSE);
     if (!m_stream) {
         errorf("Failed write jpeg2000::save_image");
         return false;
     }
+    opj_stream_set_write_function(m_stream, stream_write);
+    opj_stream_set_skip_function(m_stream, stream_skip);
+    opj_stream_set_seek_function(m_stream, stream_seek);
+#if defined(OPJ_VERSION_MAJOR)
+    // OpenJpeg >= 2.1
+    opj_stream_set_user_data(m_stream, ioproxy(), NULL);
+#else
+    opj_stream_set_user_data(m_stream, ioproxy());
+#endif
 
     if (!opj_start_compress(m_codec, m_image, m_stream)
         || !opj_encode(m_codec, m_stream)
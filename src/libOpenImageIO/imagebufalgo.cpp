@@ -3,7 +3,10 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 #include <cmath>
+#include <complex>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include <OpenEXR/half.h>
 
@@ -12,6 +15,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/thread.h>
 
@@ -423,6 +427,255 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
 
 
 
+// If the 2D float kernel K is (to within float rounding) the outer
+// product of a row and a column, return true and store the two 1D factors
+// in xk and yk, so that K(x,y) == xk[x] * yk[y].
+static bool
+kernel_is_separable(const ImageBuf& K, std::vector<float>& xk,
+                    std::vector<float>& yk)
+{
+    const ImageSpec& spec(K.spec());
+    if (spec.depth > 1)
+        return false;
+    int w = spec.width, h = spec.height, kchans = spec.nchannels;
+    const float* k = (const float*)K.localpixels();
+    auto kval = [=](int x, int y) { return k[(size_t(y) * w + x) * kchans]; };
+
+    // Factor through the element of largest magnitude
+    int px = 0, py = 0;
+    float maxabs = 0.0f;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (fabsf(kval(x, y)) > maxabs) {
+                maxabs = fabsf(kval(x, y));
+                px     = x;
+                py     = y;
+            }
+    if (maxabs == 0.0f)
+        return false;
+    xk.resize(w);
+    yk.resize(h);
+    for (int x = 0; x < w; ++x)
+        xk[x] = kval(x, py) / kval(px, py);
+    for (int y = 0; y < h; ++y)
+        yk[y] = kval(px, y);
+    float tolerance = 1.0e-5f * maxabs;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (fabsf(kval(x, y) - xk[x] * yk[y]) > tolerance)
+                return false;
+    return true;
+}
+
+
+
+// Convolution with a separable kernel: filter each needed source row
+// horizontally with xk into a ring of yk.size() rows, then filter those
+// vertically with yk. Same results as convolve_ (to float rounding), but
+// with kw+kh rather than kw*kh taps per pixel.
+template<typename DSTTYPE, typename SRCTYPE>
+static bool
+convolve_separable_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
+                    const std::vector<float>& xk, const std::vector<float>& yk,
+                    float scale, ROI roi, int nthreads)
+{
+    using namespace ImageBufAlgo;
+    ROI kroi = kernel.roi();
+    parallel_image(roi, nthreads, [&](ROI roi) {
+        int nc         = roi.nchannels();
+        int w          = roi.width();
+        int kw         = int(xk.size());
+        int kh         = int(yk.size());
+        size_t rowvals = size_t(w) * nc;
+        std::vector<float> padded(size_t(w + kw - 1) * nc);
+        std::vector<float> ring(rowvals * kh);
+        std::vector<float> out(rowvals);
+
+        // Horizontally filter source row y into ring slot y % kh
+        ImageBuf::ConstIterator<SRCTYPE> s(src, roi, ImageBuf::WrapClamp);
+        auto hfilter = [&](int y) {
+            s.rerange(roi.xbegin + kroi.xbegin, roi.xend + kroi.xend - 1, y,
+                      y + 1, roi.zbegin, roi.zbegin + 1, ImageBuf::WrapClamp);
+            float* p = padded.data();
+            for (; !s.done(); ++s, p += nc)
+                for (int c = 0; c < nc; ++c)
+                    p[c] = s[roi.chbegin + c];
+            float* h = &ring[size_t(((y % kh) + kh) % kh) * rowvals];
+            std::fill(h, h + rowvals, 0.0f);
+            for (int i = 0; i < kw; ++i) {
+                const float* sp = &padded[size_t(i) * nc];
+                float ki        = xk[i];
+                for (size_t j = 0; j < rowvals; ++j)
+                    h[j] += ki * sp[j];
+            }
+        };
+
+        ImageBuf::Iterator<DSTTYPE> d(dst, roi);
+        int ynext = roi.ybegin + kroi.ybegin;  // next source row to filter
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            for (; ynext < y + kroi.yend; ++ynext)
+                hfilter(ynext);
+            std::fill(out.begin(), out.end(), 0.0f);
+            for (int j = 0; j < kh; ++j) {
+                int sy         = y + kroi.ybegin + j;
+                const float* h = &ring[size_t(((sy % kh) + kh) % kh)
+                                       * rowvals];
+                float kj       = yk[j];
+                for (size_t i = 0; i < rowvals; ++i)
+                    out[i] += kj * h[i];
+            }
+            const float* o = out.data();
+            for (int x = 0; x < w; ++x, ++d, o += nc)
+                for (int c = 0; c < nc; ++c)
+                    d[roi.chbegin + c] = scale * o[c];
+        }
+    });
+    return true;
+}
+
+
+
+// In-place unnormalized 2D FFT of an nx by ny complex array, rows then
+// columns. The scratch array must hold 2*max(nx,ny) values.
+static void
+fft2d_(std::complex<float>* data, int nx, int ny, kissfft<float>& fx,
+       kissfft<float>& fy, std::complex<float>* scratch)
+{
+    for (int y = 0; y < ny; ++y) {
+        std::complex<float>* row = data + size_t(y) * nx;
+        fx.transform(row, scratch);
+        std::copy(scratch, scratch + nx, row);
+    }
+    std::complex<float>* col = scratch + ny;
+    for (int x = 0; x < nx; ++x) {
+        for (int y = 0; y < ny; ++y)
+            scratch[y] = data[size_t(y) * nx + x];
+        fy.transform(scratch, col);
+        for (int y = 0; y < ny; ++y)
+            data[size_t(y) * nx + x] = col[y];
+    }
+}
+
+
+
+// Pick the FFT length along an axis with `res` output pixels and a kernel
+// `k` pixels wide: each block of n yields n-k+1 output pixels, so choose
+// the power of two minimizing the total n*log(n) work over all blocks.
+// Below 64, the per-block overhead outweighs the savings. Return 0 if the
+// kernel is too wide for any block size we'll use.
+static int
+convolve_fft_size(int res, int k)
+{
+    int best        = 0;
+    double bestcost = std::numeric_limits<double>::max();
+    for (int n = 64; n <= 4096; n *= 2) {
+        if (n - k + 1 < 1)
+            continue;
+        int blocks  = (res + (n - k)) / (n - k + 1);
+        double cost = double(blocks) * n * log2(double(n));
+        if (cost < bestcost) {
+            best     = n;
+            bestcost = cost;
+        }
+    }
+    return best;
+}
+
+
+
+// Convolution by FFT, block by block ("overlap-save"): each block of
+// nx*ny source pixels (with the same WrapClamp edge handling as convolve_)
+// is transformed, multiplied by the kernel's spectrum, and transformed
+// back, and the (nx-kw+1)*(ny-kh+1) pixels that didn't wrap around are the
+// result. Pairs of channels ride along as the real and imaginary parts,
+// since the kernel is real. The cost per pixel grows only with the log of
+// the kernel size.
+template<typename DSTTYPE, typename SRCTYPE>
+static bool
+convolve_fft_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
+              float scale, ROI roi, int nthreads)
+{
+    typedef std::complex<float> cfloat;
+    ROI kroi   = kernel.roi();
+    int kw     = kroi.width();
+    int kh     = kroi.height();
+    int kchans = kernel.nchannels();
+    int nx     = convolve_fft_size(roi.width(), kw);
+    int ny     = convolve_fft_size(roi.height(), kh);
+    if (!nx || !ny) {
+        dst.errorf("convolve: %dx%d kernel is too large for FFT", kw, kh);
+        return false;
+    }
+    int bw     = nx - kw + 1;  // output pixels per block
+    int bh     = ny - kh + 1;
+    int nbx    = (roi.width() + bw - 1) / bw;
+    int nby    = (roi.height() + bh - 1) / bh;
+    size_t npixels = size_t(nx) * size_t(ny);
+
+    // Spectrum of the zero-padded kernel. It's conjugated because convolve_
+    // is really a correlation (the kernel is not flipped), and the
+    // normalization and the 1/(nx*ny) of the inverse FFT are folded in.
+    std::vector<cfloat> kspec(npixels, cfloat(0.0f));
+    {
+        const float* k = (const float*)kernel.localpixels();
+        float kscale   = scale / float(npixels);
+        for (int y = 0; y < kh; ++y)
+            for (int x = 0; x < kw; ++x)
+                kspec[size_t(y) * nx + x] = k[(size_t(y) * kw + x) * kchans]
+                                            * kscale;
+        kissfft<float> fx(nx, false), fy(ny, false);
+        std::vector<cfloat> scratch(2 * std::max(nx, ny));
+        fft2d_(kspec.data(), nx, ny, fx, fy, scratch.data());
+        for (auto& v : kspec)
+            v = std::conj(v);
+    }
+
+    parallel_options opt(nthreads, Split_Y, 1);
+    parallel_for_chunked(0, int64_t(nbx) * nby, 0, [&](int64_t b, int64_t e) {
+        int nc = roi.nchannels();
+        kissfft<float> fx(nx, false), fy(ny, false);
+        kissfft<float> ifx(nx, true), ify(ny, true);
+        std::vector<float> in(npixels * nc);
+        std::vector<cfloat> buf(npixels);
+        std::vector<cfloat> scratch(2 * std::max(nx, ny));
+        ImageBuf::ConstIterator<SRCTYPE> s(src, roi, ImageBuf::WrapClamp);
+        for (int64_t block = b; block < e; ++block) {
+            int x0 = roi.xbegin + int(block % nbx) * bw;
+            int y0 = roi.ybegin + int(block / nbx) * bh;
+            s.rerange(x0 + kroi.xbegin, x0 + kroi.xbegin + nx,
+                      y0 + kroi.ybegin, y0 + kroi.ybegin + ny, roi.zbegin,
+                      roi.zbegin + 1, ImageBuf::WrapClamp);
+            float* p = in.data();
+            for (; !s.done(); ++s, p += nc)
+                for (int c = 0; c < nc; ++c)
+                    p[c] = s[roi.chbegin + c];
+            ROI broi(x0, std::min(x0 + bw, roi.xend), y0,
+                     std::min(y0 + bh, roi.yend), roi.zbegin, roi.zbegin + 1,
+                     roi.chbegin, roi.chend);
+            for (int c = 0; c < nc; c += 2) {
+                bool pair = (c + 1 < nc);
+                for (size_t i = 0; i < npixels; ++i)
+                    buf[i] = cfloat(in[i * nc + c],
+                                    pair ? in[i * nc + c + 1] : 0.0f);
+                fft2d_(buf.data(), nx, ny, fx, fy, scratch.data());
+                for (size_t i = 0; i < npixels; ++i)
+                    buf[i] *= kspec[i];
+                fft2d_(buf.data(), nx, ny, ifx, ify, scratch.data());
+                for (ImageBuf::Iterator<DSTTYPE> d(dst, broi); !d.done();
+                     ++d) {
+                    const cfloat& v = buf[size_t(d.y() - y0) * nx + d.x() - x0];
+                    d[roi.chbegin + c] = v.real();
+                    if (pair)
+                        d[roi.chbegin + c + 1] = v.imag();
+                }
+            }
+        }
+    }, opt);
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
                        const ImageBuf& kernel, bool normalize, ROI roi,
@@ -439,9 +692,66 @@ ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
         Ktmp.copy(kernel, TypeDesc::FLOAT);
         K = &Ktmp;
     }
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_, dst.spec().format,
-                                src.spec().format, dst, src, *K, normalize, roi,
-                                nthreads);
+
+    // Choose a method. Separable kernels are done in two 1D passes, other
+    // kernels of 5x5 or more with FFTs, and volumes and small kernels
+    // directly. Only for very large separable kernels (more than about
+    // 64x64) does the FFT beat two 1D passes. The "convolve_method"
+    // attribute can force a choice, but it can't make a non-separable
+    // kernel separable, and volumes are always done directly.
+    int method = pvt::oiio_convolve_method;
+    bool flat  = (src.spec().depth <= 1 && K->spec().depth <= 1
+                 && roi.depth() == 1);
+    int kw     = K->spec().width;
+    int kh     = K->spec().height;
+    std::vector<float> xk, yk;
+    bool separable = flat && method != pvt::ConvolveDirect
+                     && method != pvt::ConvolveFFT
+                     && kernel_is_separable(*K, xk, yk);
+    if (method == pvt::ConvolveAuto) {
+        if (separable && kw + kh >= 128)
+            separable = false;
+        if (!separable)
+            method = (flat && kw * kh >= 25) ? pvt::ConvolveFFT
+                                             : pvt::ConvolveDirect;
+    }
+    if (method == pvt::ConvolveFFT && flat && !separable
+        && (!convolve_fft_size(roi.width(), kw)
+            || !convolve_fft_size(roi.height(), kh))) {
+        // Kernels wider than our largest FFT block are done directly, in
+        // two 1D passes if possible.
+        method    = pvt::ConvolveDirect;
+        separable = kernel_is_separable(*K, xk, yk);
+    }
+    if (separable) {
+        float scale = 1.0f;
+        if (normalize) {
+            float xsum = 0.0f, ysum = 0.0f;
+            for (auto v : xk)
+                xsum += v;
+            for (auto v : yk)
+                ysum += v;
+            scale = 1.0f / (xsum * ysum);
+        }
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_separable_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, *K, xk, yk, scale, roi, nthreads);
+    } else if (method == pvt::ConvolveFFT && flat) {
+        float scale = 1.0f;
+        if (normalize) {
+            scale = 0.0f;
+            for (ImageBuf::ConstIterator<float> k(*K); !k.done(); ++k)
+                scale += k[0];
+            scale = 1.0f / scale;
+        }
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_fft_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, *K, scale, roi, nthreads);
+    } else {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, *K, normalize, roi, nthreads);
+    }
     return ok;
 }
 
@@ -664,18 +974,199 @@ ImageBufAlgo::laplacian(const ImageBuf& src, ROI roi, int nthreads)
 
 
 
+// Map the values of a pixel type with at most 16 bits to histogram bins
+// that sort in the same order as the values (bits == 0 means the type is
+// too big for a histogram of every value).
+template<class T> struct MedianBins {
+    enum { bits = 0 };
+    static int key(T) { return 0; }
+    static T value(int) { return T(0); }
+};
+
+template<> struct MedianBins<unsigned char> {
+    enum { bits = 8 };
+    static int key(unsigned char v) { return v; }
+    static unsigned char value(int k) { return (unsigned char)k; }
+};
+
+template<> struct MedianBins<unsigned short> {
+    enum { bits = 16 };
+    static int key(unsigned short v) { return v; }
+    static unsigned short value(int k) { return (unsigned short)k; }
+};
+
+// Flip the sign bit of positive halfs and all the bits of negative ones,
+// so that the bit patterns sort like the values.
+template<> struct MedianBins<half> {
+    enum { bits = 16 };
+    static int key(half v)
+    {
+        int b = v.bits();
+        return (b & 0x8000) ? (~b & 0xffff) : (b | 0x8000);
+    }
+    static half value(int k)
+    {
+        half h;
+        h.setBits((unsigned short)((k & 0x8000) ? (k & 0x7fff)
+                                                : (~k & 0xffff)));
+        return h;
+    }
+};
+
+
+
+// Median filter by sliding histogram (Huang's algorithm): the window
+// snakes across the rows, right along one and left along the next, so
+// each step only removes one column or row of pixels from the per-channel
+// histograms and adds another, O(height) per pixel instead of a sort of
+// the whole window. The median is found through a second, coarse level of
+// histogram whose median bin is tracked as the window moves, so finding it
+// is cheap too. Every value has its own bin, so the results are exact.
+template<class Rtype, class Atype>
+static void
+median_filter_histogram(ImageBuf& R, const ImageBuf& A, int width, int height,
+                        int w_2, int h_2, ROI roi)
+{
+    typedef MedianBins<Atype> Bins;
+    const int nbins   = 1 << Bins::bits;
+    const int cshift  = Bins::bits / 2;  // coarse bins of 2^cshift values
+    const int ncoarse = nbins >> cshift;
+    int nchannels     = R.nchannels();
+    ROI data          = A.roi();
+
+    // Keys of the source rows the window covers, in a ring of height+1
+    // rows (-1 for pixels outside A's data window)
+    int x0       = roi.xbegin - w_2;  // first column of any window
+    int ncols    = roi.width() + width - 1;
+    int nrows    = height + 1;
+    size_t rowsz = size_t(ncols) * nchannels;
+    std::vector<int> keys(rowsz * nrows);
+    ImageBuf::ConstIterator<Atype> a(A, roi);
+    auto loadrow = [&](int y) {
+        int* k = &keys[size_t(((y % nrows) + nrows) % nrows) * rowsz];
+        std::fill(k, k + rowsz, -1);
+        int xb = std::max(x0, data.xbegin), xe = std::min(x0 + ncols,
+                                                          data.xend);
+        if (y < data.ybegin || y >= data.yend || xb >= xe)
+            return;
+        a.rerange(xb, xe, y, y + 1, roi.zbegin, roi.zbegin + 1);
+        for (k += size_t(xb - x0) * nchannels; !a.done(); ++a) {
+            const Atype* p = (const Atype*)a.rawptr();
+            for (int c = 0; c < nchannels; ++c)
+                *k++ = Bins::key(p[c]);
+        }
+    };
+    auto keyrow = [&](int y) {
+        return &keys[size_t(((y % nrows) + nrows) % nrows) * rowsz];
+    };
+
+    std::vector<int> hist(size_t(nbins) * nchannels, 0);
+    std::vector<int> coarse(size_t(ncoarse) * nchannels, 0);
+    std::vector<int> cbin(nchannels, 0);   // coarse bin holding the median
+    std::vector<int> below(nchannels, 0);  // count in coarse bins < cbin
+    int n = 0;                             // pixels in the window
+    // Add (dir=1) or remove (dir=-1) the pixels of column x, rows
+    // [ybegin,yend) of the ring.
+    auto update = [&](int x, int ybegin, int yend, int dir) {
+        for (int y = ybegin; y < yend; ++y) {
+            const int* k = keyrow(y) + size_t(x - x0) * nchannels;
+            if (k[0] < 0)
+                continue;
+            n += dir;
+            for (int c = 0; c < nchannels; ++c) {
+                int cb = k[c] >> cshift;
+                hist[size_t(c) * nbins + k[c]] += dir;
+                coarse[size_t(c) * ncoarse + cb] += dir;
+                if (cb < cbin[c])
+                    below[c] += dir;
+            }
+        }
+    };
+    auto median = [&](int c) {
+        int m     = n / 2;
+        int* h    = &hist[size_t(c) * nbins];
+        int* cs   = &coarse[size_t(c) * ncoarse];
+        int& cb   = cbin[c];
+        int& cnt  = below[c];
+        while (cnt > m)
+            cnt -= cs[--cb];
+        while (cnt + cs[cb] <= m)
+            cnt += cs[cb++];
+        int v = cb << cshift, sum = cnt;
+        while (sum + h[v] <= m)
+            sum += h[v++];
+        return convert_type<Atype, float>(Bins::value(v));
+    };
+
+    std::vector<float> out(size_t(roi.width()) * nchannels);
+    auto emit = [&](int x) {
+        float* o = &out[size_t(x - roi.xbegin) * nchannels];
+        for (int c = 0; c < nchannels; ++c)
+            o[c] = n ? median(c) : 0.0f;
+    };
+
+    // Prime the ring and the histogram for the first window
+    int ytop = roi.ybegin - h_2;  // first row of the current window
+    for (int y = ytop; y < ytop + height; ++y)
+        loadrow(y);
+    for (int x = x0; x < x0 + width; ++x)
+        update(x, ytop, ytop + height, 1);
+
+    ImageBuf::Iterator<Rtype> r(R, roi);
+    int x = roi.xbegin;  // window is [x-w_2, x-w_2+width)
+    for (int y = roi.ybegin; y < roi.yend; ++y) {
+        bool rightward = ((y - roi.ybegin) & 1) == 0;
+        if (y != roi.ybegin) {
+            // Move the window down a row
+            loadrow(ytop + height);
+            for (int wx = x - w_2; wx < x - w_2 + width; ++wx) {
+                update(wx, ytop, ytop + 1, -1);
+                update(wx, ytop + height, ytop + height + 1, 1);
+            }
+            ++ytop;
+        }
+        emit(x);
+        if (rightward) {
+            for (; x + 1 < roi.xend; ++x) {
+                update(x - w_2, ytop, ytop + height, -1);
+                update(x - w_2 + width, ytop, ytop + height, 1);
+                emit(x + 1);
+            }
+        } else {
+            for (; x - 1 >= roi.xbegin; --x) {
+                update(x - w_2 + width - 1, ytop, ytop + height, -1);
+                update(x - w_2 - 1, ytop, ytop + height, 1);
+                emit(x - 1);
+            }
+        }
+        const float* o = out.data();
+        for (int i = 0, e = roi.width(); i < e; ++i, ++r)
+            for (int c = 0; c < nchannels; ++c)
+                r[c] = *o++;
+    }
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 median_filter_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
                    ROI roi, int nthreads)
 {
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+    int w_2 = std::max(1, width / 2);
+    int h_2 = std::max(1, height / 2);
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (width < 1)
-            width = 1;
-        if (height < 1)
-            height = width;
-        int w_2        = std::max(1, width / 2);
-        int h_2        = std::max(1, height / 2);
+        // Types of 16 bits or less can use histograms, for which the cost
+        // doesn't grow with the window width, except for tiny windows.
+        if (MedianBins<Atype>::bits > 0 && width * height >= 9) {
+            median_filter_histogram<Rtype, Atype>(R, A, width, height, w_2,
+                                                  h_2, roi);
+            return;
+        }
         int windowsize = width * height;
         int nchannels  = R.nchannels();
         float** chans  = OIIO_ALLOCA(float*, nchannels);
@@ -698,7 +1189,8 @@ median_filter_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
             if (n) {
                 int mid = n / 2;
                 for (int c = 0; c < nchannels; ++c) {
-                    std::sort(chans[c] + 0, chans[c] + n);
+                    std::nth_element(chans[c] + 0, chans[c] + mid,
+                                     chans[c] + n);
                     r[c] = chans[c][mid];
                 }
             } else {
@@ -745,49 +1237,128 @@ ImageBufAlgo::median_filter(const ImageBuf& src, int width, int height, ROI roi,
 
 enum MorphOp { MorphDilate, MorphErode };
 
+
+
+// Running max (or min) of every run of k consecutive elements of in[0..n),
+// by the van Herk/Gil-Werman method: split the input into blocks of k,
+// take prefix maxima g within each block and suffix maxima h, and then any
+// window of k is max(h[i], g[i+k-1]) -- about 3 comparisons per element
+// no matter how big k is. Each "element" is a vector of `stride` floats
+// (channels, or whole rows), all processed together. Writes n-k+1 results
+// to out; g and h are scratch space for n elements.
+template<bool dilate>
+static void
+morph_vhgw_(const float* in, float* out, int n, int k, size_t stride,
+            float* g, float* h)
+{
+    for (int b = 0; b < n; b += k) {
+        int e = std::min(b + k, n);
+        std::copy(in + b * stride, in + (b + 1) * stride, g + b * stride);
+        for (int i = b + 1; i < e; ++i) {
+            const float* f = in + i * stride;
+            const float* p = g + (i - 1) * stride;
+            float* q       = g + i * stride;
+            for (size_t c = 0; c < stride; ++c)
+                q[c] = dilate ? std::max(p[c], f[c]) : std::min(p[c], f[c]);
+        }
+        std::copy(in + (e - 1) * stride, in + e * stride, h + (e - 1) * stride);
+        for (int i = e - 2; i >= b; --i) {
+            const float* f = in + i * stride;
+            const float* p = h + (i + 1) * stride;
+            float* q       = h + i * stride;
+            for (size_t c = 0; c < stride; ++c)
+                q[c] = dilate ? std::max(p[c], f[c]) : std::min(p[c], f[c]);
+        }
+    }
+    for (int i = 0; i + k <= n; ++i) {
+        const float* p = h + i * stride;
+        const float* q = g + (i + k - 1) * stride;
+        float* o       = out + i * stride;
+        for (size_t c = 0; c < stride; ++c)
+            o[c] = dilate ? std::max(p[c], q[c]) : std::min(p[c], q[c]);
+    }
+}
+
+
+
+// Rectangular dilate/erode, done separably: a running max (min) along each
+// row into a buffer, then down the columns of that buffer. Pixels outside
+// A's data window don't take part, as if they held the identity value.
+template<bool dilate, class Rtype, class Atype>
+static void
+morph_separable_(ImageBuf& R, const ImageBuf& A, int width, int height,
+                 int w_2, int h_2, ROI roi)
+{
+    const float ident = dilate ? -std::numeric_limits<float>::max()
+                               : std::numeric_limits<float>::max();
+    int nchannels     = R.nchannels();
+    ROI data          = A.roi();
+    int x0            = roi.xbegin - w_2;  // first column of any window
+    int ncols         = roi.width() + width - 1;
+    size_t rowsz      = size_t(roi.width()) * nchannels;
+    // Work in bands of output rows to bound the buffer memory.
+    int band       = std::max(64, height);
+    size_t bufrows = size_t(band + height - 1);
+    // The scratch g and h serve both passes: ncols pixels for the rows,
+    // bufrows rows for the columns.
+    size_t scratchsz = std::max(bufrows * rowsz, size_t(ncols) * nchannels);
+    std::vector<float> src(size_t(ncols) * nchannels);
+    std::vector<float> hrows(bufrows * rowsz), g(scratchsz), h(scratchsz),
+        out(size_t(band) * rowsz);
+    ImageBuf::ConstIterator<Atype> a(A, roi);
+    for (int ybegin = roi.ybegin; ybegin < roi.yend; ybegin += band) {
+        int yend  = std::min(ybegin + band, roi.yend);
+        int nrows = yend - ybegin + height - 1;
+        // Horizontal pass over rows [ybegin-h_2, ybegin-h_2+nrows)
+        for (int j = 0; j < nrows; ++j) {
+            int y = ybegin - h_2 + j;
+            std::fill(src.begin(), src.end(), ident);
+            int xb = std::max(x0, data.xbegin);
+            int xe = std::min(x0 + ncols, data.xend);
+            if (y >= data.ybegin && y < data.yend && xb < xe) {
+                a.rerange(xb, xe, y, y + 1, roi.zbegin, roi.zbegin + 1);
+                float* s = &src[size_t(xb - x0) * nchannels];
+                for (; !a.done(); ++a)
+                    for (int c = 0; c < nchannels; ++c)
+                        *s++ = a[c];
+            }
+            morph_vhgw_<dilate>(src.data(), &hrows[j * rowsz], ncols, width,
+                                nchannels, g.data(), h.data());
+        }
+        // Vertical pass, a whole row at a time
+        morph_vhgw_<dilate>(hrows.data(), out.data(), nrows, height, rowsz,
+                            g.data(), h.data());
+        const float* o = out.data();
+        for (ImageBuf::Iterator<Rtype> r(R, ROI(roi.xbegin, roi.xend, ybegin,
+                                                yend, roi.zbegin, roi.zend));
+             !r.done(); ++r)
+            for (int c = 0; c < nchannels; ++c)
+                r[c] = *o++;
+    }
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 morph_impl(ImageBuf& R, const ImageBuf& A, int width, int height, MorphOp op,
            ROI roi, int nthreads)
 {
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+    int w_2 = std::max(1, width / 2);
+    int h_2 = std::max(1, height / 2);
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (width < 1)
-            width = 1;
-        if (height < 1)
-            height = width;
-        int w_2       = std::max(1, width / 2);
-        int h_2       = std::max(1, height / 2);
-        int nchannels = R.nchannels();
-        float* vals   = OIIO_ALLOCA(float, nchannels);
-        ImageBuf::ConstIterator<Atype> a(A, roi);
-        for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r) {
-            a.rerange(r.x() - w_2, r.x() - w_2 + width, r.y() - h_2,
-                      r.y() - h_2 + height, r.z(), r.z() + 1,
-                      ImageBuf::WrapClamp);
-            if (op == MorphDilate) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = -std::numeric_limits<float>::max();
-                for (; !a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0; c < nchannels; ++c)
-                            vals[c] = std::max(vals[c], a[c]);
-                    }
-                }
-            } else if (op == MorphErode) {
-                for (int c = 0; c < nchannels; ++c)
-                    vals[c] = std::numeric_limits<float>::max();
-                for (; !a.done(); ++a) {
-                    if (a.exists()) {
-                        for (int c = 0; c < nchannels; ++c)
-                            vals[c] = std::min(vals[c], a[c]);
-                    }
-                }
-            } else {
-                OIIO_ASSERT(0 && "Unknown morphological operator");
-            }
-            for (int c = 0; c < nchannels; ++c)
-                r[c] = vals[c];
-        }
+        if (op == MorphDilate)
+            morph_separable_<true, Rtype, Atype>(R, A, width, height, w_2, h_2,
+                                                 roi);
+        else if (op == MorphErode)
+            morph_separable_<false, Rtype, Atype>(R, A, width, height, w_2,
+                                                  h_2, roi);
+        else
+            OIIO_ASSERT(0 && "Unknown morphological operator");
     });
     return true;
 }
@@ -18,18 +18,44 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 
+#include "imagebufalgo_pvt.h"
 #include "imageio_pvt.h"
 
 
 OIIO_NAMESPACE_BEGIN
 
 
+// Operations for the scanline kernels, on either float or vfloat8
+struct AddOp {
+    template<class T> T operator()(const T& a, const T& b) const
+    {
+        return a + b;
+    }
+    template<class T> T operator()(const T& a, const T& b, const T&) const
+    {
+        return a + b;
+    }
+};
+
+struct SubOp {
+    template<class T> T operator()(const T& a, const T& b) const
+    {
+        return a - b;
+    }
+};
+
+
+
 template<class Rtype, class Atype, class Btype>
 static bool
 add_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, AddOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -47,6 +73,10 @@ static bool
 add_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A)) {
+            pvt::scanline_op<Rtype, Atype>(R, A, b, {}, roi, AddOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (; !r.done(); ++r, ++a)
@@ -159,6 +189,10 @@ sub_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, SubOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -0,0 +1,718 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
+
+/// \file
+/// Implementation of ImageBufAlgo::PixelExpr, lazily built per-pixel
+/// expressions that are evaluated in one fused pass.
+
+#include <OpenEXR/half.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include <OpenImageIO/dassert.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagebufalgo_util.h>
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+using ImageBufAlgo::PixelExpr;
+
+
+struct PixelExpr::Node {
+    enum Op {
+        Image,
+        Const,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Mad,
+        Abs,
+        Absdiff,
+        Min,
+        Max,
+        Pow,
+        Clamp,
+        Premult,
+        Unpremult,
+        Channels,
+        Over
+    };
+    Op op;
+    int nchannels     = 0;  // 0 for constants: they fit anything
+    int alpha_channel = -1;
+    int z_channel     = -1;
+    std::vector<std::string> channelnames;
+    const ImageBuf* img = nullptr;
+    std::shared_ptr<const Node> args[3];
+    std::vector<float> vals, vals2;  // constant, exponents, clamp min/max
+    std::vector<int> order;          // channel shuffle
+    bool clampalpha01 = false;
+
+    Node(Op op)
+        : op(op)
+    {
+    }
+};
+
+typedef PixelExpr::Node Node;
+
+
+
+// A node that combines the channels of its arguments pixel by pixel. The
+// result takes the channel count, names, and alpha/z designation of the
+// first argument that has any channels, and the fewest channels of any of
+// them.
+static std::shared_ptr<Node>
+combine(Node::Op op, const std::shared_ptr<const Node>& a,
+        const std::shared_ptr<const Node>& b = nullptr,
+        const std::shared_ptr<const Node>& c = nullptr)
+{
+    std::shared_ptr<Node> n(new Node(op));
+    n->args[0]         = a;
+    n->args[1]         = b;
+    n->args[2]         = c;
+    const Node* layout = nullptr;
+    for (auto& arg : n->args) {
+        if (!arg || !arg->nchannels)
+            continue;
+        if (!layout)
+            layout = arg.get();
+        n->nchannels = n->nchannels ? std::min(n->nchannels, arg->nchannels)
+                                    : arg->nchannels;
+    }
+    if (layout) {
+        n->channelnames.assign(layout->channelnames.begin(),
+                               layout->channelnames.begin() + n->nchannels);
+        if (layout->alpha_channel < n->nchannels)
+            n->alpha_channel = layout->alpha_channel;
+        if (layout->z_channel < n->nchannels)
+            n->z_channel = layout->z_channel;
+    }
+    return n;
+}
+
+
+
+PixelExpr::PixelExpr() {}
+
+
+
+PixelExpr::PixelExpr(const ImageBuf& img)
+{
+    std::shared_ptr<Node> n(new Node(Node::Image));
+    n->img           = &img;
+    n->nchannels     = img.nchannels();
+    n->alpha_channel = img.spec().alpha_channel;
+    n->z_channel     = img.spec().z_channel;
+    n->channelnames  = img.spec().channelnames;
+    n->channelnames.resize(n->nchannels);
+    m_node = n;
+}
+
+
+
+PixelExpr::PixelExpr(float val)
+{
+    std::shared_ptr<Node> n(new Node(Node::Const));
+    n->vals.push_back(val);
+    m_node = n;
+}
+
+
+
+PixelExpr::PixelExpr(cspan<float> val)
+{
+    std::shared_ptr<Node> n(new Node(Node::Const));
+    n->vals.assign(val.begin(), val.end());
+    if (n->vals.empty())
+        n->vals.push_back(0.0f);
+    m_node = n;
+}
+
+
+
+PixelExpr::PixelExpr(const std::vector<float>& val)
+    : PixelExpr(cspan<float>(val))
+{
+}
+
+
+
+int
+PixelExpr::nchannels() const
+{
+    return m_node ? m_node->nchannels : 0;
+}
+
+
+
+namespace ImageBufAlgo {
+
+PixelExpr
+operator+(const PixelExpr& A, const PixelExpr& B)
+{
+    return PixelExpr(combine(Node::Add, A.m_node, B.m_node));
+}
+
+
+
+PixelExpr
+operator-(const PixelExpr& A, const PixelExpr& B)
+{
+    return PixelExpr(combine(Node::Sub, A.m_node, B.m_node));
+}
+
+
+
+PixelExpr
+operator*(const PixelExpr& A, const PixelExpr& B)
+{
+    return PixelExpr(combine(Node::Mul, A.m_node, B.m_node));
+}
+
+
+
+PixelExpr
+operator/(const PixelExpr& A, const PixelExpr& B)
+{
+    return PixelExpr(combine(Node::Div, A.m_node, B.m_node));
+}
+
+}  // namespace ImageBufAlgo
+
+
+
+PixelExpr
+PixelExpr::mad(const PixelExpr& B, const PixelExpr& C) const
+{
+    return PixelExpr(combine(Node::Mad, m_node, B.m_node, C.m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::abs() const
+{
+    return PixelExpr(combine(Node::Abs, m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::absdiff(const PixelExpr& B) const
+{
+    return PixelExpr(combine(Node::Absdiff, m_node, B.m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::min(const PixelExpr& B) const
+{
+    return PixelExpr(combine(Node::Min, m_node, B.m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::max(const PixelExpr& B) const
+{
+    return PixelExpr(combine(Node::Max, m_node, B.m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::pow(cspan<float> exponent) const
+{
+    auto n = combine(Node::Pow, m_node);
+    n->vals.assign(exponent.begin(), exponent.end());
+    return PixelExpr(n);
+}
+
+
+
+PixelExpr
+PixelExpr::clamp(cspan<float> min, cspan<float> max, bool clampalpha01) const
+{
+    auto n = combine(Node::Clamp, m_node);
+    n->vals.assign(min.begin(), min.end());
+    n->vals2.assign(max.begin(), max.end());
+    n->clampalpha01 = clampalpha01;
+    return PixelExpr(n);
+}
+
+
+
+PixelExpr
+PixelExpr::premult() const
+{
+    // Just like ImageBufAlgo::premult(), it's a copy without alpha.
+    if (!m_node || m_node->alpha_channel < 0)
+        return *this;
+    return PixelExpr(combine(Node::Premult, m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::unpremult() const
+{
+    if (!m_node || m_node->alpha_channel < 0)
+        return *this;
+    return PixelExpr(combine(Node::Unpremult, m_node));
+}
+
+
+
+PixelExpr
+PixelExpr::channels(int nchannels, cspan<int> channelorder,
+                    cspan<float> channelvalues) const
+{
+    auto n        = combine(Node::Channels, m_node);
+    const Node* a = m_node.get();
+    int ach       = a ? a->nchannels : 0;
+    n->nchannels  = std::max(nchannels, 0);
+    n->channelnames.assign(n->nchannels, std::string());
+    n->order.assign(n->nchannels, -1);
+    n->vals.assign(n->nchannels, 0.0f);
+    n->alpha_channel = -1;
+    n->z_channel     = -1;
+    for (int c = 0; c < n->nchannels; ++c) {
+        int o = c < int(channelorder.size()) ? channelorder[c] : -1;
+        // Any channel of a constant will do (the values repeat).
+        if (o >= 0 && (o < ach || (a && !ach))) {
+            n->order[c] = o;
+            if (ach) {
+                n->channelnames[c] = a->channelnames[o];
+                if (o == a->alpha_channel)
+                    n->alpha_channel = c;
+                if (o == a->z_channel)
+                    n->z_channel = c;
+            }
+        } else if (c < int(channelvalues.size())) {
+            n->vals[c] = channelvalues[c];
+        }
+    }
+    return PixelExpr(n);
+}
+
+
+
+PixelExpr
+PixelExpr::over(const PixelExpr& B) const
+{
+    return PixelExpr(combine(Node::Over, m_node, B.m_node));
+}
+
+
+
+// Pad per-channel values to n, repeating the last one, or using zdef if
+// there were none at all.
+static std::vector<float>
+perchan(const std::vector<float>& v, int n, float zdef)
+{
+    std::vector<float> r(std::max<size_t>(n, v.size()), zdef);
+    for (size_t c = 0; c < r.size(); ++c)
+        r[c] = c < v.size() ? v[c] : (c ? r[c - 1] : zdef);
+    return r;
+}
+
+
+
+template<class S>
+static bool
+read_strip_(const ImageBuf& src, ROI roi, float* out)
+{
+    int nc = roi.nchannels();
+    for (ImageBuf::ConstIterator<S> s(src, roi); !s.done(); ++s, out += nc)
+        for (int c = 0; c < nc; ++c)
+            out[c] = s[c];
+    return true;
+}
+
+
+
+template<class D>
+static bool
+write_strip_(ImageBuf& dst, ROI roi, const float* in, int nc)
+{
+    for (ImageBuf::Iterator<D> d(dst, roi); !d.done(); ++d, in += nc)
+        if (d.exists())
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                d[c] = in[c];
+    return true;
+}
+
+
+
+namespace {
+
+// Everything eval needs: the expression's nodes in an order where each
+// comes after its arguments (each shared node just once), and for each,
+// where in a strip buffer its values live.
+struct ExprPlan {
+    struct Step {
+        const Node* node;
+        int args[3];    // step index of each argument, or -1
+        size_t offset;  // of this step's values in the strip buffer
+        int stride;     // floats per pixel: nchannels, or 0 for constants
+        std::vector<float> p1, p2;  // padded per-channel parameters
+    };
+    std::vector<Step> steps;
+    std::unordered_map<const Node*, int> index;
+    size_t bufsize = 0;  // floats per strip pixel, over all steps
+    int maxchans   = 1;
+
+    int add(const Node* n)
+    {
+        auto found = index.find(n);
+        if (found != index.end())
+            return found->second;
+        Step s;
+        s.node = n;
+        for (int i = 0; i < 3; ++i)
+            s.args[i] = n->args[i] ? add(n->args[i].get()) : -1;
+        s.stride = n->nchannels;
+        maxchans = std::max(maxchans, n->nchannels);
+        steps.push_back(s);
+        return index[n] = int(steps.size()) - 1;
+    }
+};
+
+}  // namespace
+
+
+
+// Pixels per strip: enough to amortize the per-strip overhead, few enough
+// that the values of a modest expression all stay in L1/L2 cache.
+static const int strip_pixels = 512;
+
+
+
+// Compute one step of the plan for npixels pixels
+static void
+eval_step(const ExprPlan& plan, const ExprPlan::Step& s, float* buf,
+          int npixels)
+{
+    const Node* n = s.node;
+    float* r      = buf + s.offset * npixels;
+    int nc        = s.stride;
+    const float* a[3];
+    int as[3] = { 0, 0, 0 };
+    for (int i = 0; i < 3; ++i) {
+        a[i] = nullptr;
+        if (s.args[i] >= 0) {
+            const ExprPlan::Step& arg = plan.steps[s.args[i]];
+            a[i]  = arg.stride ? buf + arg.offset * npixels : arg.p1.data();
+            as[i] = arg.stride;
+        }
+    }
+    const float* A = a[0];
+    const float* B = a[1];
+    const float* C = a[2];
+    int sa = as[0], sb = as[1], sc = as[2];
+    switch (n->op) {
+    case Node::Image:
+    case Node::Const: break;  // done by the caller or in p1
+    case Node::Add:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = A[c] + B[c];
+        break;
+    case Node::Sub:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = A[c] - B[c];
+        break;
+    case Node::Mul:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = A[c] * B[c];
+        break;
+    case Node::Div:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = (B[c] == 0.0f) ? 0.0f : (A[c] / B[c]);
+        break;
+    case Node::Mad:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb, C += sc)
+            for (int c = 0; c < nc; ++c)
+                r[c] = A[c] * B[c] + C[c];
+        break;
+    case Node::Abs:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa)
+            for (int c = 0; c < nc; ++c)
+                r[c] = std::abs(A[c]);
+        break;
+    case Node::Absdiff:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = std::abs(A[c] - B[c]);
+        break;
+    case Node::Min:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = std::min(A[c], B[c]);
+        break;
+    case Node::Max:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb)
+            for (int c = 0; c < nc; ++c)
+                r[c] = std::max(A[c], B[c]);
+        break;
+    case Node::Pow:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa)
+            for (int c = 0; c < nc; ++c)
+                r[c] = safe_pow(A[c], s.p1[c]);
+        break;
+    case Node::Clamp: {
+        int alpha = n->clampalpha01 ? n->alpha_channel : -1;
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa) {
+            for (int c = 0; c < nc; ++c)
+                r[c] = OIIO::clamp(A[c], s.p1[c], s.p2[c]);
+            if (alpha >= 0)
+                r[alpha] = OIIO::clamp(r[alpha], 0.0f, 1.0f);
+        }
+        break;
+    }
+    case Node::Premult:
+    case Node::Unpremult: {
+        int alpha = n->alpha_channel, z = n->z_channel;
+        bool pre  = (n->op == Node::Premult);
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa) {
+            float al      = A[alpha];
+            bool justcopy = pre ? (al == 1.0f) : (al == 0.0f || al == 1.0f);
+            for (int c = 0; c < nc; ++c)
+                r[c] = (justcopy || c == alpha || c == z)
+                           ? A[c]
+                           : (pre ? A[c] * al : A[c] / al);
+        }
+        break;
+    }
+    case Node::Channels:
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa)
+            for (int c = 0; c < nc; ++c)
+                r[c] = n->order[c] >= 0 ? A[n->order[c]] : n->vals[c];
+        break;
+    case Node::Over: {
+        int alpha = n->alpha_channel, z = n->z_channel;
+        for (int p = 0; p < npixels; ++p, r += nc, A += sa, B += sb) {
+            float al = OIIO::clamp(A[alpha], 0.0f, 1.0f);
+            for (int c = 0; c < nc; ++c)
+                r[c] = A[c] + (1.0f - al) * B[c];
+            if (z >= 0)
+                r[z] = (al != 0.0f) ? A[z] : B[z];
+        }
+        break;
+    }
+    }
+}
+
+
+
+bool
+PixelExpr::eval(ImageBuf& dst, ROI roi, int nthreads) const
+{
+    pvt::LoggedTimer logtime("IBA::PixelExpr::eval");
+    if (!m_node) {
+        dst.errorf("PixelExpr::eval: empty expression");
+        return false;
+    }
+
+    // Gather the nodes, check that they make sense, and find out about the
+    // images involved.
+    ExprPlan plan;
+    plan.add(m_node.get());
+    const ImageBuf* first = nullptr;
+    ROI allroi, allfull;
+    TypeDesc format;
+    for (auto& s : plan.steps) {
+        const Node* n = s.node;
+        if (n->op == Node::Image) {
+            const ImageBuf& img(*n->img);
+            if (!img.initialized()) {
+                dst.errorf("PixelExpr::eval: uninitialized input image");
+                return false;
+            }
+            if (img.deep()) {
+                dst.errorf("PixelExpr::eval: deep images are not supported");
+                return false;
+            }
+            if (!first) {
+                first   = &img;
+                allroi  = img.roi();
+                allfull = img.roi_full();
+                format  = img.spec().format;
+            } else {
+                allroi  = roi_union(allroi, img.roi());
+                allfull = roi_union(allfull, img.roi_full());
+                format  = ImageBufAlgo::type_merge(format, img.spec().format);
+            }
+        }
+        if (n->op == Node::Over && n->alpha_channel < 0) {
+            dst.errorf("PixelExpr::eval: over() requires an alpha channel");
+            return false;
+        }
+    }
+
+    int nchannels = m_node->nchannels;
+    if (!dst.initialized()) {
+        if (!roi.defined() && !first) {
+            dst.errorf("PixelExpr::eval: no image or ROI to give the size");
+            return false;
+        }
+        ImageSpec spec = first ? first->spec() : ImageSpec();
+        if (roi.defined()) {
+            spec.set_roi(roi);
+            if (!first)
+                spec.set_roi_full(roi);
+            if (!nchannels)
+                nchannels = roi.nchannels();
+        } else {
+            spec.set_roi(allroi);
+            spec.set_roi_full(allfull);
+        }
+        spec.set_format(first ? format : TypeDesc(TypeDesc::FLOAT));
+        spec.nchannels = std::max(nchannels, 1);
+        spec.channelnames.clear();
+        spec.default_channel_names();
+        for (int c = 0; c < nchannels && c < int(m_node->channelnames.size());
+             ++c)
+            if (m_node->channelnames[c].size())
+                spec.channelnames[c] = m_node->channelnames[c];
+        spec.alpha_channel = m_node->alpha_channel;
+        spec.z_channel     = m_node->z_channel;
+        dst.reset(spec);
+    }
+    if (!roi.defined())
+        roi = dst.roi();
+    else
+        roi = roi_intersection(roi, dst.roi());
+    if (!nchannels)
+        nchannels = dst.nchannels();
+    roi.chend = std::min(std::min(roi.chend, nchannels), dst.nchannels());
+    if (roi.chbegin >= roi.chend || roi.npixels() == 0)
+        return true;
+
+    // Lay out each step's values within a strip buffer, and pad the
+    // per-channel constants so that any channel can be looked up.
+    int maxchans = std::max(plan.maxchans, nchannels);
+    for (auto& s : plan.steps)
+        for (int o : s.node->order)
+            maxchans = std::max(maxchans, o + 1);
+    for (auto& s : plan.steps) {
+        const Node* n = s.node;
+        s.offset      = plan.bufsize;
+        if (n->op == Node::Const) {
+            s.p1 = perchan(n->vals, maxchans, 0.0f);
+            continue;
+        }
+        if (!s.stride)
+            s.stride = maxchans;  // only constants: compute every channel
+        plan.bufsize += s.stride;
+        const float big = std::numeric_limits<float>::max();
+        if (n->op == Node::Pow)
+            s.p1 = perchan(n->vals, maxchans, 0.0f);
+        else if (n->op == Node::Clamp) {
+            s.p1 = perchan(n->vals, maxchans, -big);
+            s.p2 = perchan(n->vals2, maxchans, big);
+        }
+    }
+
+    const ExprPlan& cplan(plan);
+    const Node* root = m_node.get();
+    const ExprPlan::Step& top(cplan.steps[cplan.index.find(root)->second]);
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        std::vector<float> buf(cplan.bufsize * strip_pixels);
+        // A constant result is written by replicating it for each pixel.
+        std::vector<float> rep;
+        if (!top.stride)
+            for (int p = 0; p < strip_pixels; ++p)
+                rep.insert(rep.end(), top.p1.data(), top.p1.data() + maxchans);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                for (int x = roi.xbegin; x < roi.xend; x += strip_pixels) {
+                    int npixels = std::min(strip_pixels, roi.xend - x);
+                    ROI strip(x, x + npixels, y, y + 1, z, z + 1);
+                    for (auto& s : cplan.steps) {
+                        if (s.node->op == Node::Image) {
+                            const ImageBuf& img(*s.node->img);
+                            float* r = buf.data() + s.offset * npixels;
+                            ROI sr   = strip;
+                            sr.chend = s.stride;
+                            stride_t packed = s.stride
+                                              * img.spec().format.size();
+                            if (img.localpixels() && img.roi().contains(sr)
+                                && img.pixel_stride() == packed) {
+                                convert_pixel_values(img.spec().format,
+                                                     img.pixeladdr(x, y, z),
+                                                     TypeFloat, r,
+                                                     npixels * s.stride);
+                            } else {
+                                bool ok;
+                                OIIO_DISPATCH_TYPES(ok, "PixelExpr",
+                                                    read_strip_,
+                                                    img.spec().format, img,
+                                                    sr, r);
+                                (void)ok;
+                            }
+                        } else {
+                            eval_step(cplan, s, buf.data(), npixels);
+                        }
+                    }
+                    const float* r = top.stride
+                                         ? buf.data() + top.offset * npixels
+                                         : top.p1.data();
+                    int nc     = top.stride;
+                    ROI wr     = strip;
+                    wr.chbegin = roi.chbegin;
+                    wr.chend   = roi.chend;
+                    if (nc && dst.localpixels() && dst.roi().contains(wr)
+                        && roi.chbegin == 0 && roi.chend == nc
+                        && nc == dst.nchannels()
+                        && dst.pixel_stride()
+                               == stride_t(nc * dst.spec().format.size())) {
+                        convert_pixel_values(TypeFloat, r, dst.spec().format,
+                                             dst.pixeladdr(x, y, z),
+                                             npixels * nc);
+                    } else {
+                        if (!nc) {
+                            nc = maxchans;
+                            r  = rep.data();
+                        }
+                        bool ok;
+                        OIIO_DISPATCH_TYPES(ok, "PixelExpr", write_strip_,
+                                            dst.spec().format, dst, wr, r,
+                                            nc);
+                        (void)ok;
+                    }
+                }
+            }
+        }
+    });
+    return !dst.has_error();
+}
+
+
+
+ImageBuf
+PixelExpr::eval(ROI roi, int nthreads) const
+{
+    ImageBuf result;
+    bool ok = eval(result, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorf("PixelExpr::eval() error");
+    return result;
+}
+
+
+OIIO_NAMESPACE_END
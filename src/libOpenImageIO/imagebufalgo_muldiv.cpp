@@ -19,18 +19,49 @@
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/simd.h>
 
+#include "imagebufalgo_pvt.h"
 #include "imageio_pvt.h"
 
 
 OIIO_NAMESPACE_BEGIN
 
 
+// Operations for the scanline kernels, on either float or vfloat8
+struct MulOp {
+    template<class T> T operator()(const T& a, const T& b) const
+    {
+        return a * b;
+    }
+    template<class T> T operator()(const T& a, const T& b, const T&) const
+    {
+        return a * b;
+    }
+};
+
+struct DivOp {
+    float operator()(float a, float b) const
+    {
+        return (b == 0.0f) ? 0.0f : (a / b);
+    }
+    simd::vfloat8 operator()(const simd::vfloat8& a,
+                             const simd::vfloat8& b) const
+    {
+        return simd::safe_div(a, b);
+    }
+};
+
+
+
 template<class Rtype, class Atype, class Btype>
 static bool
 mul_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, MulOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -48,6 +79,10 @@ static bool
 mul_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A)) {
+            pvt::scanline_op<Rtype, Atype>(R, A, b, {}, roi, MulOp());
+            return;
+        }
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r, ++a)
             for (int c = roi.chbegin; c < roi.chend; ++c)
@@ -143,6 +178,10 @@ div_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, DivOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -20,18 +20,75 @@
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/simd.h>
 
+#include "imagebufalgo_pvt.h"
 #include "imageio_pvt.h"
 
 
 OIIO_NAMESPACE_BEGIN
 
 
+// Operations for the scanline kernels, on either float or vfloat8. The
+// argument order of the SIMD min/max makes NaN come out the same as with
+// std::min/max.
+struct MinOp {
+    float operator()(float a, float b, float = 0.0f) const
+    {
+        return std::min(a, b);
+    }
+    simd::vfloat8 operator()(const simd::vfloat8& a, const simd::vfloat8& b,
+                             const simd::vfloat8& = 0.0f) const
+    {
+        return simd::min(b, a);
+    }
+};
+
+struct MaxOp {
+    float operator()(float a, float b, float = 0.0f) const
+    {
+        return std::max(a, b);
+    }
+    simd::vfloat8 operator()(const simd::vfloat8& a, const simd::vfloat8& b,
+                             const simd::vfloat8& = 0.0f) const
+    {
+        return simd::max(b, a);
+    }
+};
+
+struct AbsdiffOp {
+    float operator()(float a, float b, float = 0.0f) const
+    {
+        return std::abs(a - b);
+    }
+    simd::vfloat8 operator()(const simd::vfloat8& a, const simd::vfloat8& b,
+                             const simd::vfloat8& = 0.0f) const
+    {
+        return simd::abs(a - b);
+    }
+};
+
+struct ClampOp {
+    float operator()(float a, float lo, float hi) const
+    {
+        return OIIO::clamp(a, lo, hi);
+    }
+    simd::vfloat8 operator()(const simd::vfloat8& a, const simd::vfloat8& lo,
+                             const simd::vfloat8& hi) const
+    {
+        return simd::min(simd::max(a, lo), hi);
+    }
+};
+
+
 template<class Rtype, class Atype, class Btype>
 static bool
 min_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, MinOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -49,6 +106,10 @@ static bool
 min_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A)) {
+            pvt::scanline_op<Rtype, Atype>(R, A, b, {}, roi, MinOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (; !r.done(); ++r, ++a)
@@ -129,6 +190,10 @@ max_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
          int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, MaxOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -146,6 +211,10 @@ static bool
 max_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A)) {
+            pvt::scanline_op<Rtype, Atype>(R, A, b, {}, roi, MaxOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (; !r.done(); ++r, ++a)
@@ -226,6 +295,22 @@ clamp_(ImageBuf& dst, const ImageBuf& src, const float* min, const float* max,
        bool clampalpha01, ROI roi, int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, dst, src)) {
+            // Fold the alpha clamp into that channel's limits
+            int nc    = roi.nchannels();
+            float* lo = OIIO_ALLOCA(float, nc);
+            float* hi = OIIO_ALLOCA(float, nc);
+            std::copy(min, min + nc, lo);
+            std::copy(max, max + nc, hi);
+            int a = src.spec().alpha_channel;
+            if (clampalpha01 && a >= 0 && a < nc) {
+                lo[a] = OIIO::clamp(lo[a], 0.0f, 1.0f);
+                hi[a] = OIIO::clamp(hi[a], 0.0f, 1.0f);
+            }
+            pvt::scanline_op<D, S>(dst, src, cspan<float>(lo, nc),
+                                   cspan<float>(hi, nc), roi, ClampOp());
+            return;
+        }
         ImageBuf::ConstIterator<S> s(src, roi);
         for (ImageBuf::Iterator<D> d(dst, roi); !d.done(); ++d, ++s) {
             for (int c = roi.chbegin; c < roi.chend; ++c)
@@ -282,6 +367,10 @@ absdiff_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
              int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A, &B)) {
+            pvt::scanline_op<Rtype, Atype, Btype>(R, A, B, roi, AbsdiffOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         ImageBuf::ConstIterator<Btype> b(B, roi);
@@ -299,6 +388,10 @@ absdiff_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi,
              int nthreads)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        if (pvt::scanline_ok(roi, R, A)) {
+            pvt::scanline_op<Rtype, Atype>(R, A, b, {}, roi, AbsdiffOp());
+            return;
+        }
         ImageBuf::Iterator<Rtype> r(R, roi);
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (; !r.done(); ++r, ++a)
@@ -0,0 +1,186 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
+
+/// \file
+/// Internal helpers shared by the ImageBufAlgo implementation files:
+/// kernels that process whole scanlines of in-memory pixels with SIMD,
+/// for the common case where iterators are not needed.
+
+#pragma once
+
+#include <OpenEXR/half.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/simd.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+// Convert 8 values to and from float, giving the same answers as
+// convert_type<> does one value at a time.
+inline simd::vfloat8
+scanline_load(const float* p)
+{
+    return simd::vfloat8(p);
+}
+
+inline simd::vfloat8
+scanline_load(const half* p)
+{
+    return simd::vfloat8(p);
+}
+
+inline simd::vfloat8
+scanline_load(const unsigned char* p)
+{
+    return simd::vfloat8(p) * simd::vfloat8(1.0f / 255.0f);
+}
+
+inline simd::vfloat8
+scanline_load(const unsigned short* p)
+{
+    return simd::vfloat8(p) * simd::vfloat8(1.0f / 65535.0f);
+}
+
+inline void
+scanline_store(const simd::vfloat8& v, float* p)
+{
+    v.store(p);
+}
+
+inline void
+scanline_store(const simd::vfloat8& v, half* p)
+{
+    v.store(p);
+}
+
+inline void
+scanline_store(const simd::vfloat8& v, unsigned char* p)
+{
+    simd::vint8 i(clamp(v * simd::vfloat8(255.0f) + simd::vfloat8(0.5f),
+                        simd::vfloat8::Zero(), simd::vfloat8(255.0f)));
+    i.store(p);
+}
+
+inline void
+scanline_store(const simd::vfloat8& v, unsigned short* p)
+{
+    simd::vint8 i(clamp(v * simd::vfloat8(65535.0f) + simd::vfloat8(0.5f),
+                        simd::vfloat8::Zero(), simd::vfloat8(65535.0f)));
+    i.store(p);
+}
+
+// Less common types just convert one value at a time.
+template<class T>
+inline simd::vfloat8
+scanline_load(const T* p)
+{
+    simd::vfloat8 v;
+    for (int i = 0; i < 8; ++i)
+        v[i] = convert_type<T, float>(p[i]);
+    return v;
+}
+
+template<class T>
+inline void
+scanline_store(const simd::vfloat8& v, T* p)
+{
+    for (int i = 0; i < 8; ++i)
+        p[i] = convert_type<float, T>(v[i]);
+}
+
+
+
+/// Can the `roi` of R and of each of the inputs be processed as whole,
+/// contiguous scanlines of raw values? They must all be in memory, contain
+/// the roi, and have exactly the roi's channels, and none may be deep.
+inline bool
+scanline_ok(ROI roi, const ImageBuf& R, const ImageBuf& A,
+            const ImageBuf* B = nullptr)
+{
+    const ImageBuf* bufs[] = { &R, &A, B };
+    if (roi.chbegin != 0)
+        return false;
+    for (auto buf : bufs) {
+        if (buf
+            && (!buf->localpixels() || buf->deep() || !buf->contains_roi(roi)
+                || buf->nchannels() != roi.chend
+                || buf->pixel_stride()
+                       != stride_t(buf->nchannels()
+                                   * buf->spec().format.size())))
+            return false;
+    }
+    return true;
+}
+
+
+
+/// R = op(A, B) over the roi, a scanline at a time, with `op` called with
+/// either vfloat8 or float arguments. The caller has checked scanline_ok().
+template<class Rtype, class Atype, class Btype, class OP>
+void
+scanline_op(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi, OP op)
+{
+    int n = roi.width() * roi.nchannels();
+    for (int z = roi.zbegin; z < roi.zend; ++z) {
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            Rtype* r       = (Rtype*)R.pixeladdr(roi.xbegin, y, z);
+            const Atype* a = (const Atype*)A.pixeladdr(roi.xbegin, y, z);
+            const Btype* b = (const Btype*)B.pixeladdr(roi.xbegin, y, z);
+            int i          = 0;
+            for (; i + 8 <= n; i += 8)
+                scanline_store(op(scanline_load(a + i), scanline_load(b + i)),
+                               r + i);
+            for (; i < n; ++i)
+                r[i] = convert_type<float, Rtype>(
+                    op(convert_type<Atype, float>(a[i]),
+                       convert_type<Btype, float>(b[i])));
+        }
+    }
+}
+
+
+
+/// R = op(A, b, c) over the roi, a scanline at a time, where b and c are
+/// per-channel constants (already as long as the number of channels).
+template<class Rtype, class Atype, class OP>
+void
+scanline_op(ImageBuf& R, const ImageBuf& A, cspan<float> b, cspan<float> c,
+            ROI roi, OP op)
+{
+    // Repeat the per-channel values so that the 8 values starting at the
+    // channel of any position can be loaded directly.
+    int nc = roi.nchannels();
+    std::vector<float> bpat(nc + 8), cpat(nc + 8);
+    for (int i = 0; i < nc + 8; ++i) {
+        bpat[i] = b.size() ? b[i % nc] : 0.0f;
+        cpat[i] = c.size() ? c[i % nc] : 0.0f;
+    }
+    int n = roi.width() * nc;
+    for (int z = roi.zbegin; z < roi.zend; ++z) {
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            Rtype* r       = (Rtype*)R.pixeladdr(roi.xbegin, y, z);
+            const Atype* a = (const Atype*)A.pixeladdr(roi.xbegin, y, z);
+            int i = 0, ch = 0;  // ch is the channel of value i
+            for (; i + 8 <= n; i += 8, ch = (ch + 8) % nc)
+                scanline_store(op(scanline_load(a + i),
+                                  simd::vfloat8(&bpat[ch]),
+                                  simd::vfloat8(&cpat[ch])),
+                               r + i);
+            for (; i < n; ++i, ch = (ch + 1) % nc)
+                r[i] = convert_type<float, Rtype>(
+                    op(convert_type<Atype, float>(a[i]), bpat[ch], cpat[ch]));
+        }
+    }
+}
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
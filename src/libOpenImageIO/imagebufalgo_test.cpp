@@ -14,6 +14,7 @@
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/filter.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
@@ -28,6 +29,7 @@ static int iterations     = 1;
 static int numthreads     = 16;
 static int ntrials        = 1;
 static bool verbose       = false;
+static bool benchmarks    = false;
 static bool wedge         = false;
 static int threadcounts[] = { 1,  2,  4,  8,  12,  16,   20,
                               24, 28, 32, 64, 128, 1024, 1 << 30 };
@@ -50,6 +52,7 @@ getargs(int argc, char* argv[])
         "--iters %d", &iterations,
             ustring::sprintf("Number of iterations (default: %d)", iterations).c_str(),
         "--trials %d", &ntrials, "Number of trials",
+        "--bench", &benchmarks, "Also run the slow benchmarks",
         "--wedge", &wedge, "Do a wedge test",
         nullptr);
     // clang-format on
@@ -460,6 +463,68 @@ test_mul()
 
 
 
+// Tests the whole-scanline kernels of the pixel math ops against the same
+// math done in float, for integer images whose scanlines are not a
+// multiple of the SIMD width.
+void
+test_pixelmath_scanlines()
+{
+    std::cout << "test pixelmath scanlines\n";
+    // 13 pixels of 3 channels per scanline, so the SIMD loop has a tail
+    const float lo[] = { 0.1f, 0.2f, 0.3f }, hi[] = { 0.9f, 0.8f, 0.7f };
+    const char* opnames[] = { "add",  "addc", "sub",     "mul",
+                              "mulc", "div",  "min",     "minc",
+                              "max",  "maxc", "absdiff", "absdiffc",
+                              "clamp" };
+    auto apply = [&](int op, ImageBuf& R, const ImageBuf& A,
+                     const ImageBuf& B, ROI roi) {
+        switch (op) {
+        case 0: return ImageBufAlgo::add(R, A, B, roi);
+        case 1: return ImageBufAlgo::add(R, A, lo, roi);
+        case 2: return ImageBufAlgo::sub(R, A, B, roi);
+        case 3: return ImageBufAlgo::mul(R, A, B, roi);
+        case 4: return ImageBufAlgo::mul(R, A, hi, roi);
+        case 5: return ImageBufAlgo::div(R, A, B, roi);
+        case 6: return ImageBufAlgo::min(R, A, B, roi);
+        case 7: return ImageBufAlgo::min(R, A, cspan<float>(hi), roi);
+        case 8: return ImageBufAlgo::max(R, A, B, roi);
+        case 9: return ImageBufAlgo::max(R, A, cspan<float>(lo), roi);
+        case 10: return ImageBufAlgo::absdiff(R, A, B, roi);
+        case 11: return ImageBufAlgo::absdiff(R, A, hi, roi);
+        default: return ImageBufAlgo::clamp(R, A, lo, hi, false, roi);
+        }
+    };
+    for (TypeDesc t : { TypeUInt8, TypeUInt16, TypeHalf }) {
+        ImageSpec spec(13, 5, 3, t);
+        ImageBuf A(spec), B(spec);
+        ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false, 1);
+        ImageBufAlgo::noise(B, "uniform", 0.0f, 1.0f, false, 2);
+        ImageBuf Af, Bf;
+        Af.copy(A, TypeDesc::FLOAT);
+        Bf.copy(B, TypeDesc::FLOAT);
+        for (int op = 0; op < 13; ++op) {
+            // The scanline path, vs. the same op in float, vs. the generic
+            // path (which a channel subset forces).
+            ImageBuf R(spec), Rf(Af.spec()), Ref(spec), G(spec);
+            ImageBufAlgo::zero(G);
+            OIIO_CHECK_ASSERT(apply(op, R, A, B, ROI()));
+            OIIO_CHECK_ASSERT(apply(op, Rf, Af, Bf, ROI()));
+            ROI sub     = R.roi();
+            sub.chbegin = 1;
+            OIIO_CHECK_ASSERT(apply(op, G, A, B, sub));
+            Ref.copy(Rf, t);
+            auto comp  = ImageBufAlgo::compare(R, Ref, 0.0f, 0.0f);
+            auto gcomp = ImageBufAlgo::compare(R, G, 0.0f, 0.0f, sub);
+            OIIO_CHECK_EQUAL(comp.maxerror, 0.0f);
+            OIIO_CHECK_EQUAL(gcomp.maxerror, 0.0f);
+            if (comp.maxerror != 0.0f || gcomp.maxerror != 0.0f)
+                std::cout << "  failed " << opnames[op] << " " << t << "\n";
+        }
+    }
+}
+
+
+
 // Tests ImageBufAlgo::mad
 void
 test_mad()
@@ -547,6 +612,460 @@ test_over()
 
 
 
+// Test ImageBufAlgo::convolve, checking that the separable and FFT methods
+// match direct convolution, and time them all to show the crossovers.
+void
+test_convolve()
+{
+    std::cout << "test convolve\n";
+
+    ImageBuf src = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                       ROI(0, 97, 0, 61, 0, 1, 0, 3));
+    const char* methods[] = { "direct", "separable", "fft", "auto" };
+    // Symmetric and lopsided kernels, separable and not
+    ImageSpec kspec(9, 6, 1, TypeFloat);
+    kspec.x = -2;
+    kspec.y = -4;
+    ImageBuf Ksep(kspec);
+    for (ImageBuf::Iterator<float> k(Ksep); !k.done(); ++k)
+        k[0] = float(k.x() + 3) * float(k.y() * k.y() + 1);
+    ImageBuf Krand = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 2,
+                                         get_roi(kspec));
+    Krand.set_origin(kspec.x, kspec.y);
+    ImageBuf kernels[] = { ImageBufAlgo::make_kernel("gaussian", 15, 11),
+                           ImageBufAlgo::make_kernel("disk", 15, 11), Ksep,
+                           Krand };
+    for (auto& K : kernels) {
+        ImageBuf ref;
+        OIIO::attribute("convolve_method", "direct");
+        ImageBufAlgo::convolve(ref, src, K);
+        for (auto m : methods) {
+            OIIO::attribute("convolve_method", m);
+            // Whole image, and a region of an existing image
+            ImageBuf R = ImageBufAlgo::convolve(src, K);
+            auto comp  = ImageBufAlgo::compare(R, ref, 1.0e-4f, 1.0e-4f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+            ROI roi(10, 80, 5, 50, 0, 1, 1, 3);
+            ImageBuf Rroi(src.spec());
+            ImageBufAlgo::zero(Rroi);
+            ImageBufAlgo::convolve(Rroi, src, K, true, roi);
+            comp = ImageBufAlgo::compare(Rroi, ref, 1.0e-4f, 1.0e-4f, roi);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+            OIIO_CHECK_EQUAL(Rroi.getchannel(5, 5, 0, 0), 0.0f);
+        }
+    }
+
+    // Kernels wider than the largest FFT block fall back to the direct
+    // methods, even when the FFT is asked for.
+    ImageBuf wsrc = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 3,
+                                        ROI(0, 13, 0, 7, 0, 1, 0, 2));
+    ImageBuf Kwide = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 4,
+                                         ROI(0, 4099, 0, 3, 0, 1, 0, 1));
+    Kwide.set_origin(-2049, -1);
+    ImageBuf wkernels[] = { ImageBufAlgo::make_kernel("gaussian", 4099, 3),
+                            Kwide };
+    for (auto& K : wkernels) {
+        ImageBuf ref;
+        OIIO::attribute("convolve_method", "direct");
+        OIIO_CHECK_ASSERT(ImageBufAlgo::convolve(ref, wsrc, K));
+        for (auto m : methods) {
+            OIIO::attribute("convolve_method", m);
+            ImageBuf R;
+            OIIO_CHECK_ASSERT(ImageBufAlgo::convolve(R, wsrc, K));
+            auto comp = ImageBufAlgo::compare(R, ref, 1.0e-4f, 1.0e-4f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+    }
+    OIIO::attribute("convolve_method", "auto");
+    OIIO_CHECK_ASSERT(!OIIO::attribute("convolve_method", "bogus"));
+}
+
+
+
+// Time the convolution methods for a range of kernel sizes (--bench only,
+// since the direct method is slow for the larger ones).
+void
+benchmark_convolve()
+{
+    std::cout << "benchmark convolve\n";
+    const char* methods[] = { "direct", "separable", "fft", "auto" };
+    Benchmarker bench;
+    bench.iterations(std::max(1, iterations)).trials(std::max(1, ntrials));
+    ImageBuf img = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                       ROI(0, 512, 0, 512, 0, 1, 0, 3));
+    ImageBuf R(img.spec());
+    for (int k : { 3, 7, 15, 31, 61 }) {
+        for (auto kname : { "gaussian", "disk" }) {
+            ImageBuf K = ImageBufAlgo::make_kernel(kname, k, k);
+            for (auto m : methods) {
+                // Skip the slowest cases and the non-separable separable
+                if ((k > 31 && Strutil::iequals(m, "direct"))
+                    || (Strutil::iequals(kname, "disk")
+                        && Strutil::iequals(m, "separable")))
+                    continue;
+                OIIO::attribute("convolve_method", m);
+                bench(Strutil::sprintf("  IBA::convolve %s %dx%d %s ", kname,
+                                       k, k, m),
+                      [&]() { ImageBufAlgo::convolve(R, img, K); });
+            }
+        }
+    }
+    OIIO::attribute("convolve_method", "auto");
+}
+
+
+
+// Tests that the two-pass separable path of ImageBufAlgo::resize gives
+// the same results as the general one, which double buffers still take.
+void
+test_resize()
+{
+    std::cout << "test resize\n";
+    const char* filters[] = { "triangle", "gaussian", "catmull-rom",
+                              "lanczos3", "blackman-harris" };
+    // Down, up, and both at once, all odd sizes
+    const int sizes[][2] = { { 23, 17 }, { 33, 21 }, { 131, 97 }, { 29, 83 } };
+    for (int nc : { 3, 4 }) {
+        // One source with its data window away from the origin
+        for (ROI srcroi : { ROI(0, 67, 0, 41, 0, 1, 0, nc),
+                            ROI(5, 72, -3, 38, 0, 1, 0, nc) }) {
+            ImageBuf src = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false,
+                                               1, srcroi);
+            ImageBuf srcd;
+            srcd.copy(src, TypeDesc::DOUBLE);
+            for (auto f : filters) {
+                for (auto size : sizes) {
+                    ImageBuf ref(ImageSpec(size[0], size[1], nc,
+                                           TypeDesc::DOUBLE));
+                    ImageBufAlgo::resize(ref, srcd, f);
+                    ImageBuf R(ImageSpec(size[0], size[1], nc, TypeFloat));
+                    ImageBufAlgo::resize(R, src, f);
+                    auto comp = ImageBufAlgo::compare(R, ref, 1.0e-4f,
+                                                      1.0e-4f);
+                    OIIO_CHECK_EQUAL(comp.nfail, 0);
+                    // To uint8, within rounding of the (clamped) result
+                    ImageBuf R8(ImageSpec(size[0], size[1], nc, TypeUInt8));
+                    ImageBufAlgo::resize(R8, src, f);
+                    ImageBuf ref01 = ImageBufAlgo::clamp(ref, 0.0f, 1.0f);
+                    comp = ImageBufAlgo::compare(R8, ref01, 0.501f / 255.0f,
+                                                 0.501f / 255.0f);
+                    OIIO_CHECK_EQUAL(comp.nfail, 0);
+                }
+            }
+        }
+    }
+}
+
+
+
+// The median of each pixel's window the way median_filter always did it:
+// gather the values of the window's pixels inside the data window of A,
+// sort them, and take the middle one.
+static ImageBuf
+median_by_sort(const ImageBuf& A, int width, int height)
+{
+    ImageBuf R(A.spec());
+    const ImageSpec& spec(A.spec());
+    int w_2 = std::max(1, width / 2);
+    int h_2 = std::max(1, height / 2);
+    std::vector<float> pixel(spec.nchannels);
+    std::vector<std::vector<float>> vals(spec.nchannels);
+    for (int y = spec.y; y < spec.y + spec.height; ++y) {
+        for (int x = spec.x; x < spec.x + spec.width; ++x) {
+            for (auto& v : vals)
+                v.clear();
+            for (int j = y - h_2; j < y - h_2 + height; ++j) {
+                for (int i = x - w_2; i < x - w_2 + width; ++i) {
+                    if (i < spec.x || i >= spec.x + spec.width || j < spec.y
+                        || j >= spec.y + spec.height)
+                        continue;
+                    A.getpixel(i, j, pixel.data());
+                    for (int c = 0; c < spec.nchannels; ++c)
+                        vals[c].push_back(pixel[c]);
+                }
+            }
+            for (int c = 0; c < spec.nchannels; ++c) {
+                std::sort(vals[c].begin(), vals[c].end());
+                pixel[c] = vals[c][vals[c].size() / 2];
+            }
+            R.setpixel(x, y, pixel.data());
+        }
+    }
+    return R;
+}
+
+
+
+// Tests ImageBufAlgo::median_filter
+void
+test_median()
+{
+    std::cout << "test median_filter\n";
+
+    // The histogram methods used for the small types (for windows of 9 or
+    // more pixels) and the gathering used for the others must all give
+    // exactly what sorting each window's values gives.
+    ImageBuf src = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                       ROI(0, 37, 0, 29, 0, 1, 0, 3));
+    ImageBufAlgo::noise(src, "salt", 1.0f, 0.1f, false, 2);
+    const int windows[][2] = { { 3, 1 }, { 3, 3 }, { 5, 5 },
+                               { 7, 7 }, { 7, 5 }, { 4, 6 } };
+    for (auto t : { TypeUInt8, TypeUInt16, TypeHalf, TypeFloat }) {
+        ImageBuf A;
+        A.copy(src, t);
+        for (auto win : windows) {
+            int w = win[0], h = win[1];
+            ImageBuf ref = median_by_sort(A, w, h);
+            ImageBuf R   = ImageBufAlgo::median_filter(A, w, h);
+            auto comp    = ImageBufAlgo::compare(R, ref, 0.0f, 0.0f);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+            ROI roi(10, 30, 5, 20, 0, 1, 0, 3);
+            ImageBuf Rroi(A.spec());
+            ImageBufAlgo::zero(Rroi);
+            ImageBufAlgo::median_filter(Rroi, A, w, h, roi);
+            comp = ImageBufAlgo::compare(Rroi, ref, 0.0f, 0.0f, roi);
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+            OIIO_CHECK_EQUAL(Rroi.getchannel(5, 5, 0, 0), 0.0f);
+        }
+    }
+}
+
+
+
+// Time median_filter for a few types and window sizes (--bench only).
+void
+benchmark_median()
+{
+    std::cout << "benchmark median_filter\n";
+    Benchmarker bench;
+    bench.iterations(std::max(1, iterations)).trials(std::max(1, ntrials));
+    for (auto t : { TypeUInt8, TypeHalf, TypeFloat }) {
+        ImageBuf img = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                           ROI(0, 512, 0, 512, 0, 1, 0, 3));
+        ImageBuf A;
+        A.copy(img, t);
+        ImageBuf R(A.spec());
+        for (int k : { 3, 7, 15 })
+            bench(Strutil::sprintf("  IBA::median_filter %s %dx%d ", t, k, k),
+                  [&]() { ImageBufAlgo::median_filter(R, A, k, k); });
+    }
+}
+
+
+
+// Tests ImageBufAlgo::dilate and erode
+void
+test_dilate_erode()
+{
+    std::cout << "test dilate/erode\n";
+
+    // Random images and windows, including windows wider and taller than
+    // the image, against the min/max of each window found the slow way.
+    // The window of width w covers [x-w/2, x-w/2+w) (but at least one
+    // pixel to the left), and pixels outside the image don't take part.
+    uint32_t seed = 42;
+    auto rnd      = [&](int n) {
+        seed = seed * 1664525u + 1013904223u;
+        return int((seed >> 8) % uint32_t(n));
+    };
+    for (int trial = 0; trial < 40; ++trial) {
+        ImageSpec spec(1 + rnd(40), 1 + rnd(30), 1 + rnd(3),
+                       trial % 2 ? TypeUInt8 : TypeFloat);
+        spec.x  = rnd(7) - 3;
+        spec.y  = rnd(7) - 3;
+        int w   = 1 + rnd(spec.width + 10);
+        int h   = 1 + rnd(spec.height + 10);
+        int w_2 = std::max(1, w / 2);
+        int h_2 = std::max(1, h / 2);
+        int nc  = spec.nchannels;
+        ImageBuf src(spec);
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, false, trial);
+        ImageBuf D = ImageBufAlgo::dilate(src, w, h);
+        ImageBuf E = ImageBufAlgo::erode(src, w, h);
+        ImageBuf Dref(spec), Eref(spec);
+        std::vector<float> p(nc), dmax(nc), emin(nc);
+        ROI roi = src.roi();
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            for (int x = roi.xbegin; x < roi.xend; ++x) {
+                std::fill(dmax.begin(), dmax.end(), -1.0e30f);
+                std::fill(emin.begin(), emin.end(), 1.0e30f);
+                for (int j = y - h_2; j < y - h_2 + h; ++j) {
+                    for (int i = x - w_2; i < x - w_2 + w; ++i) {
+                        if (!roi.contains(i, j))
+                            continue;
+                        src.getpixel(i, j, p.data());
+                        for (int c = 0; c < nc; ++c) {
+                            dmax[c] = std::max(dmax[c], p[c]);
+                            emin[c] = std::min(emin[c], p[c]);
+                        }
+                    }
+                }
+                Dref.setpixel(x, y, dmax.data());
+                Eref.setpixel(x, y, emin.data());
+            }
+        }
+        auto comp = ImageBufAlgo::compare(D, Dref, 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+        comp = ImageBufAlgo::compare(E, Eref, 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+        if (comp.nfail)
+            std::cout << "  failed for " << spec.width << "x" << spec.height
+                      << " " << spec.format << " window " << w << "x" << h
+                      << "\n";
+    }
+}
+
+
+
+// Time dilate and erode for a range of window sizes (--bench only).
+void
+benchmark_dilate_erode()
+{
+    std::cout << "benchmark dilate/erode\n";
+    Benchmarker bench;
+    bench.iterations(std::max(1, iterations)).trials(std::max(1, ntrials));
+    ImageBuf img = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                       ROI(0, 512, 0, 512, 0, 1, 0, 4));
+    ImageBuf R(img.spec());
+    for (int k : { 3, 15, 61 }) {
+        bench(Strutil::sprintf("  IBA::dilate %dx%d ", k, k),
+              [&]() { ImageBufAlgo::dilate(R, img, k, k); });
+        bench(Strutil::sprintf("  IBA::erode %dx%d ", k, k),
+              [&]() { ImageBufAlgo::erode(R, img, k, k); });
+    }
+}
+
+
+
+// Tests ImageBufAlgo::PixelExpr
+void
+test_pixelexpr()
+{
+    std::cout << "test PixelExpr\n";
+    using ImageBufAlgo::PixelExpr;
+
+    ImageSpec spec(71, 43, 4, TypeHalf);
+    spec.alpha_channel = 3;
+    ImageBuf A = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1,
+                                     get_roi(spec));
+    ImageBuf B = ImageBufAlgo::noise("uniform", -0.5f, 1.0f, false, 2,
+                                     get_roi(spec));
+    A.specmod().alpha_channel = 3;
+    B.specmod().alpha_channel = 3;
+    ImageBuf C(spec);  // different data window and type than A and B
+    C.set_origin(5, -3);
+    C.copy(ImageBufAlgo::noise("gaussian", 0.0f, 0.2f, false, 3, C.roi()),
+           TypeFloat);
+    std::vector<float> k { 0.5f, 0.25f, 2.0f, 0.75f };
+
+    // over(mul(A,k), add(B,C)) the old way and the fused way
+    ImageBuf ref = ImageBufAlgo::over(ImageBufAlgo::mul(A, k),
+                                      ImageBufAlgo::add(B, C));
+    ImageBuf R   = (PixelExpr(A) * k).over(PixelExpr(B) + C).eval();
+    OIIO_CHECK_EQUAL(R.roi(), ref.roi());
+    OIIO_CHECK_EQUAL(R.spec().format, ref.spec().format);
+    auto comp = ImageBufAlgo::compare(R, ref, 1.0e-6f, 1.0e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // A shared subexpression, constants on either side, and the other ops
+    // (in float, so the rounding of intermediate images doesn't matter)
+    ImageBuf Af, Bf;
+    Af.copy(A, TypeFloat);
+    Bf.copy(B, TypeFloat);
+    PixelExpr d   = PixelExpr(Af).absdiff(Bf);
+    ImageBuf ref2 = ImageBufAlgo::clamp(
+        ImageBufAlgo::mad(ImageBufAlgo::absdiff(Af, Bf),
+                          ImageBufAlgo::absdiff(Af, Bf),
+                          ImageBufAlgo::sub(ImageBufAlgo::div(Bf, Af), 2.0f)),
+        0.0f, 1.0f);
+    R = ((d * d) + (PixelExpr(Bf) / Af - 2.0f)).clamp(0.0f, 1.0f).eval();
+    comp = ImageBufAlgo::compare(R, ref2, 1.0e-5f, 1.0e-5f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    R    = (d.mad(d, PixelExpr(Bf) / Af) - 2.0f).clamp(0.0f, 1.0f).eval();
+    comp = ImageBufAlgo::compare(R, ref2, 1.0e-5f, 1.0e-5f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    R    = (2.0f - PixelExpr(Af)).eval();
+    comp = ImageBufAlgo::compare(R, ImageBufAlgo::mad(Af, -1.0f, 2.0f), 0.0f,
+                                 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    ref2 = ImageBufAlgo::premult(ImageBufAlgo::channels(
+        ImageBufAlgo::pow(ImageBufAlgo::max(A, 0.25f), 2.0f), 4,
+        { 2, 1, -1, 3 }, { 0.0f, 0.0f, 0.5f, 0.0f }));
+    R = PixelExpr(A)
+            .max(0.25f)
+            .pow(2.0f)
+            .channels(4, { 2, 1, -1, 3 }, { 0.0f, 0.0f, 0.5f, 0.0f })
+            .premult()
+            .eval();
+    comp = ImageBufAlgo::compare(R, ref2, 1.0e-6f, 1.0e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    OIIO_CHECK_EQUAL(R.spec().channel_name(0), "B");
+
+    // Into a region of an existing uint8 image, in place
+    ImageBuf Q;
+    Q.copy(A, TypeUInt8);
+    ImageBuf Qref;
+    Qref.copy(Q);
+    ROI roi(10, 60, 5, 30, 0, 1, 0, 3);
+    ImageBufAlgo::mad(Qref, Qref, 0.5f, C, roi);
+    OIIO_CHECK_ASSERT(PixelExpr(Q).mad(0.5f, C).eval(Q, roi));
+    comp = ImageBufAlgo::compare(Q, Qref, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Application buffers, read and written through the contiguous fast
+    // paths, and a constant result replicated into each strip.
+    ImageSpec fspec(A.spec().width, A.spec().height, 4, TypeFloat);
+    std::vector<float> ain(fspec.image_pixels() * 4);
+    std::vector<float> rout(fspec.image_pixels() * 4, -1.0f);
+    ImageBuf Aapp(fspec, ain.data());
+    ImageBufAlgo::copy(Aapp, Af);
+    ImageBuf Rapp(fspec, rout.data());
+    OIIO_CHECK_ASSERT((PixelExpr(Aapp) * k + Bf).eval(Rapp));
+    comp = ImageBufAlgo::compare(Rapp, ImageBufAlgo::mad(Af, k, Bf), 1.0e-6f,
+                                 1.0e-6f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+    OIIO_CHECK_ASSERT(PixelExpr(k).eval(Rapp));
+    comp = ImageBufAlgo::compare(Rapp, ImageBufAlgo::fill(k, Rapp.roi()),
+                                 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Errors
+    ImageBuf bad;
+    ImageBuf RGB = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 4,
+                                       ROI(0, 8, 0, 8, 0, 1, 0, 3));
+    OIIO_CHECK_ASSERT(!PixelExpr(RGB).over(A).eval(bad));
+    OIIO_CHECK_ASSERT(bad.has_error());
+}
+
+
+
+// Time a fused PixelExpr chain vs. the same chain of separate IBA calls
+// (--bench only).
+void
+benchmark_pixelexpr()
+{
+    std::cout << "benchmark PixelExpr\n";
+    using ImageBufAlgo::PixelExpr;
+    std::vector<float> k { 0.5f, 0.25f, 2.0f, 0.75f };
+    Benchmarker bench;
+    bench.iterations(std::max(1, iterations)).trials(std::max(1, ntrials));
+    ImageSpec bigspec(2048, 1024, 4, TypeFloat);
+    bigspec.alpha_channel = 3;
+    ImageBuf BA(bigspec), BB(bigspec), BC(bigspec), BR(bigspec);
+    ImageBufAlgo::fill(BA, { 0.5f, 0.25f, 0.125f, 0.5f });
+    ImageBufAlgo::fill(BB, { 0.1f, 0.2f, 0.3f, 1.0f });
+    ImageBufAlgo::fill(BC, { 0.0f, 0.1f, 0.2f, 0.0f });
+    bench("  IBA over(mul(A,k),add(B,C)) separately ", [&]() {
+        BR = ImageBufAlgo::over(ImageBufAlgo::mul(BA, k),
+                                ImageBufAlgo::add(BB, BC));
+    });
+    bench("  IBA over(mul(A,k),add(B,C)) PixelExpr  ", [&]() {
+        (PixelExpr(BA) * k).over(PixelExpr(BB) + BC).eval(BR);
+    });
+}
+
+
+
 // Tests ImageBufAlgo::compare
 void
 test_compare()
@@ -795,6 +1314,56 @@ test_maketx_from_imagebuf()
 
 
 
+// Tests that the MIP levels make_texture computes with a separable filter,
+// using the fast exact 2:1 downsize when the level halves exactly and
+// IBA::resize otherwise, are what IBA::resize gives from the level above.
+void
+test_maketx_downsize()
+{
+    std::cout << "test make_texture MIP downsizing\n";
+    const char* txname = "oiio-downsize.tx";
+    // Even levels halve exactly for a while before odd sizes take over;
+    // odd ones never do.
+    for (ROI roi : { ROI(0, 124, 0, 84, 0, 1, 0, 4),
+                     ROI(0, 125, 0, 83, 0, 1, 0, 3) }) {
+        ImageBuf A = ImageBufAlgo::noise("uniform", 0.0f, 1.0f, false, 1, roi);
+        for (int pipeline : { 0, 1 }) {
+            remove(txname);
+            ImageSpec configspec;
+            configspec.attribute("maketx:filtername", "lanczos3");
+            configspec.attribute("maketx:pipeline", pipeline);
+            OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+                ImageBufAlgo::MakeTxTexture, A, txname, configspec));
+            ImageBuf prev(txname, 0, 0);
+            prev.read(0, 0, true, TypeFloat);
+            int nmips = prev.nmiplevels();
+            OIIO_CHECK_ASSERT(nmips > 1);
+            for (int m = 1; m < nmips; ++m) {
+                ImageBuf level(txname, 0, m);
+                level.read(0, m, true, TypeFloat);
+                ImageSpec refspec = level.spec();
+                refspec.set_format(TypeFloat);
+                OIIO_CHECK_EQUAL(refspec.width,
+                                 std::max(1, prev.spec().width / 2));
+                OIIO_CHECK_EQUAL(refspec.height,
+                                 std::max(1, prev.spec().height / 2));
+                ImageBuf ref(refspec);
+                std::shared_ptr<Filter2D> filter(
+                    Filter2D::create("lanczos3", 6.0f, 6.0f),
+                    Filter2D::destroy);
+                ImageBufAlgo::resize(ref, prev, filter.get());
+                auto comp = ImageBufAlgo::compare(level, ref, 1.0e-4f,
+                                                  1.0e-4f);
+                OIIO_CHECK_EQUAL(comp.nfail, 0);
+                prev.swap(level);
+            }
+        }
+    }
+    remove(txname);
+}
+
+
+
 // Test various IBAprep features
 void
 test_IBAprep()
@@ -986,8 +1555,14 @@ main(int argc, char** argv)
     test_add();
     test_sub();
     test_mul();
+    test_pixelmath_scanlines();
     test_mad();
     test_over();
+    test_convolve();
+    test_resize();
+    test_median();
+    test_dilate_erode();
+    test_pixelexpr();
     test_compare();
     test_isConstantColor();
     test_isConstantChannel();
@@ -995,6 +1570,7 @@ main(int argc, char** argv)
     test_computePixelStats();
     histogram_computation_test();
     test_maketx_from_imagebuf();
+    test_maketx_downsize();
     test_IBAprep();
     test_opencv();
 
@@ -1002,6 +1578,12 @@ main(int argc, char** argv)
     benchmark_parallel_image(512, iterations * 16);
     benchmark_parallel_image(1024, iterations * 4);
     benchmark_parallel_image(2048, iterations);
+    if (benchmarks) {
+        benchmark_convolve();
+        benchmark_median();
+        benchmark_pixelexpr();
+        benchmark_dilate_erode();
+    }
 
     return unit_test_failures;
 }
@@ -11,7 +11,9 @@
 #include <OpenEXR/half.h>
 
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "imageio_pvt.h"
 #include <OpenImageIO/dassert.h>
@@ -19,6 +21,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/thread.h>
 
 OIIO_NAMESPACE_BEGIN
@@ -420,6 +423,200 @@ resize_(ImageBuf& dst, const ImageBuf& src, Filter2D* filter, ROI roi,
 
 
 
+// Two-pass resize for separable filters. Each source scanline that the
+// output needs is converted to float once, filtered horizontally to the
+// destination width, and kept in a ring buffer of ytaps rows; each output
+// scanline is then a weighted sum of ytaps of those rows. This costs
+// O(xtaps + ytaps) per output pixel instead of O(xtaps * ytaps), and
+// both passes run over contiguous float data. It computes the same
+// weights and edge handling (WrapClamp against the source full window)
+// as the separable case of resize_().
+static bool
+resize_separable(ImageBuf& dst, const ImageBuf& src, Filter2D* filter,
+                 ROI roi, int nthreads)
+{
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const ImageSpec& srcspec(src.spec());
+        const ImageSpec& dstspec(dst.spec());
+        int nchannels        = dstspec.nchannels;
+        int srcchannels      = std::min(srcspec.nchannels, nchannels);
+        int width            = roi.width();
+        float srcfx          = srcspec.full_x;
+        float srcfy          = srcspec.full_y;
+        float srcfw          = srcspec.full_width;
+        float srcfh          = srcspec.full_height;
+        float xratio         = float(dstspec.full_width) / srcfw;
+        float yratio         = float(dstspec.full_height) / srcfh;
+        float dstfx          = float(dstspec.full_x);
+        float dstfy          = float(dstspec.full_y);
+        float dstpixelwidth  = 1.0f / float(dstspec.full_width);
+        float dstpixelheight = 1.0f / float(dstspec.full_height);
+        float filterrad      = filter->width() / 2.0f;
+        int radi             = (int)ceilf(filterrad / xratio);
+        int radj             = (int)ceilf(filterrad / yratio);
+        int xtaps            = 2 * radi + 1;
+        int ytaps            = 2 * radj + 1;
+
+        // Horizontal weights for every output column, normalized, with
+        // the leading and trailing zero taps trimmed off. xfirst[x] is the
+        // first source column (relative to xlo) that column x reads.
+        std::vector<float> xweights(size_t(xtaps) * width);
+        std::vector<int> xfirst(width), xbegintap(width), xendtap(width);
+        int xlo = std::numeric_limits<int>::max();
+        int xhi = std::numeric_limits<int>::min();
+        for (int x = roi.xbegin; x < roi.xend; ++x) {
+            int xi          = x - roi.xbegin;
+            float* xfiltval = &xweights[size_t(xi) * xtaps];
+            float s         = (x - dstfx + 0.5f) * dstpixelwidth;
+            float src_xf    = srcfx + s * srcfw;
+            int src_x;
+            float src_xf_frac   = floorfrac(src_xf, &src_x);
+            float totalweight_x = 0.0f;
+            for (int i = 0; i < xtaps; ++i) {
+                float w = filter->xfilt(
+                    xratio * (i - radi - (src_xf_frac - 0.5f)));
+                xfiltval[i] = w;
+                totalweight_x += w;
+            }
+            int b = 0, e = xtaps;
+            if (totalweight_x != 0.0f) {
+                for (int i = 0; i < xtaps; ++i)
+                    xfiltval[i] /= totalweight_x;
+                while (b < e && xfiltval[b] == 0.0f)
+                    ++b;
+                while (e > b && xfiltval[e - 1] == 0.0f)
+                    --e;
+            } else {
+                e = b;  // all-zero weights make a black column
+            }
+            xbegintap[xi] = b;
+            xendtap[xi]   = e;
+            xfirst[xi]    = src_x - radi;
+            xlo           = std::min(xlo, src_x - radi);
+            xhi           = std::max(xhi, src_x + radi + 1);
+        }
+        for (auto& f : xfirst)
+            f -= xlo;
+
+        // The part of [xlo,xhi) that is inside the source data window
+        // after clamping to the full window is what we actually read.
+        int fullx0 = srcspec.full_x;
+        int fullx1 = srcspec.full_x + srcspec.full_width;
+        int fully0 = srcspec.full_y;
+        int fully1 = srcspec.full_y + srcspec.full_height;
+        int readx0 = std::max(OIIO::clamp(xlo, fullx0, fullx1 - 1), srcspec.x);
+        int readx1 = std::min(OIIO::clamp(xhi - 1, fullx0, fullx1 - 1) + 1,
+                              srcspec.x + srcspec.width);
+        int readw  = std::max(readx1 - readx0, 0);
+        int srcz   = srcspec.z;
+
+        int padw = xhi - xlo;
+        std::vector<float> readrow(size_t(std::max(readw, 1)) * srcchannels);
+        std::vector<float> padrow(size_t(padw) * nchannels);
+        std::vector<float> ring(size_t(ytaps) * width * nchannels);
+        std::vector<int> ringrow(ytaps, std::numeric_limits<int>::min());
+        std::vector<float> outrow(size_t(width) * nchannels);
+        std::vector<float> yfiltval(ytaps);
+        size_t rowfloats = size_t(width) * nchannels;
+
+        // Fill ring slot for source row sy with the horizontally filtered
+        // (unclamped) source row.
+        auto filter_row = [&](int sy, float* hrow) {
+            std::fill(padrow.begin(), padrow.end(), 0.0f);
+            int cy = OIIO::clamp(sy, fully0, fully1 - 1);
+            if (readw > 0 && cy >= srcspec.y
+                && cy < srcspec.y + srcspec.height) {
+                if (src.localpixels())
+                    convert_image(srcchannels, readw, 1, 1,
+                                  src.pixeladdr(readx0, cy, srcz, 0),
+                                  srcspec.format, src.pixel_stride(),
+                                  src.scanline_stride(), src.z_stride(),
+                                  readrow.data(), TypeFloat, AutoStride,
+                                  AutoStride, AutoStride);
+                else
+                    src.get_pixels(ROI(readx0, readx1, cy, cy + 1, srcz,
+                                       srcz + 1, 0, srcchannels),
+                                   TypeFloat, readrow.data());
+                for (int px = xlo; px < xhi; ++px) {
+                    int cx = OIIO::clamp(px, fullx0, fullx1 - 1);
+                    if (cx < readx0 || cx >= readx1)
+                        continue;
+                    const float* r
+                        = &readrow[size_t(cx - readx0) * srcchannels];
+                    float* p = &padrow[size_t(px - xlo) * nchannels];
+                    for (int c = 0; c < srcchannels; ++c)
+                        p[c] = r[c];
+                }
+            }
+            for (int xi = 0; xi < width; ++xi) {
+                const float* w = &xweights[size_t(xi) * xtaps];
+                const float* p = &padrow[size_t(xfirst[xi]) * nchannels];
+                float* h       = hrow + size_t(xi) * nchannels;
+                int b = xbegintap[xi], e = xendtap[xi];
+                if (nchannels == 4) {
+                    simd::vfloat4 sum = 0.0f;
+                    for (int i = b; i < e; ++i)
+                        sum += simd::vfloat4(w[i]) * simd::vfloat4(p + 4 * i);
+                    sum.store(h);
+                } else {
+                    for (int c = 0; c < nchannels; ++c)
+                        h[c] = 0.0f;
+                    for (int i = b; i < e; ++i)
+                        for (int c = 0; c < nchannels; ++c)
+                            h[c] += w[i] * p[i * nchannels + c];
+                }
+            }
+        };
+
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            float t      = (y - dstfy + 0.5f) * dstpixelheight;
+            float src_yf = srcfy + t * srcfh;
+            int src_y;
+            float src_yf_frac   = floorfrac(src_yf, &src_y);
+            float totalweight_y = 0.0f;
+            for (int j = 0; j < ytaps; ++j) {
+                float w = filter->yfilt(
+                    yratio * (j - radj - (src_yf_frac - 0.5f)));
+                yfiltval[j] = w;
+                totalweight_y += w;
+            }
+            std::fill(outrow.begin(), outrow.end(), 0.0f);
+            if (totalweight_y != 0.0f) {
+                for (int j = 0; j < ytaps; ++j) {
+                    float wy = yfiltval[j] / totalweight_y;
+                    if (wy == 0.0f)
+                        continue;
+                    int sy   = src_y - radj + j;
+                    int slot = sy % ytaps;
+                    if (slot < 0)
+                        slot += ytaps;
+                    float* hrow = &ring[size_t(slot) * rowfloats];
+                    if (ringrow[slot] != sy) {
+                        filter_row(sy, hrow);
+                        ringrow[slot] = sy;
+                    }
+                    float* o  = outrow.data();
+                    size_t i  = 0;
+                    simd::vfloat4 w4(wy);
+                    for (; i + 4 <= rowfloats; i += 4)
+                        (simd::vfloat4(o + i) + w4 * simd::vfloat4(hrow + i))
+                            .store(o + i);
+                    for (; i < rowfloats; ++i)
+                        o[i] += wy * hrow[i];
+                }
+            }
+            convert_image(nchannels, width, 1, 1, outrow.data(), TypeFloat,
+                          AutoStride, AutoStride, AutoStride,
+                          dst.pixeladdr(roi.xbegin, y, dstspec.z, 0),
+                          dstspec.format, dst.pixel_stride(),
+                          dst.scanline_stride(), dst.z_stride());
+        }
+    });  // end of parallel_image
+    return true;
+}
+
+
+
 static std::shared_ptr<Filter2D>
 get_resize_filter(string_view filtername, float fwidth, ImageBuf& dst,
                   float wratio, float hratio)
@@ -478,6 +675,13 @@ ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, Filter2D* filter,
         filterptr.reset(filter);
     }
 
+    // Separable filters take the two-pass path, except for double
+    // buffers, which keep the double-precision accumulation of resize_().
+    if (filter->separable() && dst.localpixels()
+        && dst.spec().format != TypeDesc::DOUBLE
+        && src.spec().format != TypeDesc::DOUBLE)
+        return resize_separable(dst, src, filter, roi, nthreads);
+
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "resize", resize_, dst.spec().format,
                                 src.spec().format, dst, src, filter, roi,
@@ -3,13 +3,21 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/texture.h>
 #include <OpenImageIO/unittest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 using namespace OIIO;
 
@@ -134,6 +142,547 @@ test_app_buffer()
 
 
 
+// Test that the tile cache evicts to stay near its memory limit when we
+// touch far more tiles than fit, and that tiles in constant use survive
+// the sweeps rather than being read over and over.
+void
+test_tile_eviction()
+{
+    std::cout << "\nTesting tile eviction\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    const int max_mb = 10;  // the smallest limit an optimized build allows
+    imagecache->attribute("max_memory_MB", max_mb);
+    imagecache->attribute("autotile", 0);
+
+    // A "null" image whose 64x64 float RGBA tiles total 64 MB, with no
+    // disk I/O needed to "read" them.
+    ustring name("evictme");
+    const int res = 2048, tsize = 64, ntiles = (res / tsize) * (res / tsize);
+    ImageSpec config(res, res, 4, TypeDesc::FLOAT);
+    config.tile_width  = tsize;
+    config.tile_height = tsize;
+    config.attribute("null:force", 1);
+    OIIO_CHECK_ASSERT(imagecache->add_file(name, NullInputCreator, &config));
+
+    // Leave room for the tile just added and for the few tiles that a
+    // thread's microcache may still hold after the main cache let go.
+    const long long limit = (long long)max_mb * 1024 * 1024;
+    const long long slack = limit / 2;
+    long long peak        = 0;
+    const int hotx[] = { 0, res - tsize, res / 2 };
+    const int hoty[] = { 0, tsize, res / 2 };
+    for (int t = 0; t < ntiles; ++t) {
+        int x = (t % (res / tsize)) * tsize;
+        int y = (t / (res / tsize)) * tsize;
+        ImageCache::Tile* tile = imagecache->get_tile(name, 0, 0, x, y, 0);
+        OIIO_CHECK_ASSERT(tile != nullptr);
+        imagecache->release_tile(tile);
+        // Keep the hot tiles in use, as a renderer would its busiest
+        // textures.
+        if ((t % 8) == 0) {
+            for (int h = 0; h < 3; ++h) {
+                tile = imagecache->get_tile(name, 0, 0, hotx[h], hoty[h], 0);
+                OIIO_CHECK_ASSERT(tile != nullptr);
+                imagecache->release_tile(tile);
+            }
+        }
+        long long used = 0;
+        imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64,
+                                 &used);
+        peak = std::max(peak, used);
+    }
+    std::cout << "  peak memory " << peak << " with limit " << limit << "\n";
+    OIIO_CHECK_LE(peak, limit + slack);
+
+    long long evictions = 0;
+    imagecache->getattribute("stat:tile_evictions", TypeDesc::INT64,
+                             &evictions);
+    OIIO_CHECK_GT(evictions, ntiles / 2);
+
+    // Every tile was read exactly once: the hot tiles were never evicted
+    // and read again.
+    long long tilesread = 0;
+    imagecache->get_image_info(name, 0, 0, ustring("stat:tilesread"),
+                               TypeDesc::INT64, &tilesread);
+    OIIO_CHECK_EQUAL(tilesread, ntiles);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Test that the tiles a thread's microcache holds don't stay pinned in
+// memory after the main cache evicts them: with tiles so large that the
+// microcache alone could hold several times the limit, memory must still
+// stay within a couple of tiles of the limit.
+void
+test_microcache_pins()
+{
+    std::cout << "\nTesting microcache pinned tiles\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    const int max_mb = 10;
+    imagecache->attribute("max_memory_MB", max_mb);
+    imagecache->attribute("autotile", 0);
+
+    // 256x256 float RGBA tiles are 1 MB each, and there are 256 of them.
+    ustring name("pinme");
+    const int res = 4096, tsize = 256, ntiles = (res / tsize) * (res / tsize);
+    const long long tilebytes = (long long)tsize * tsize * 4 * sizeof(float);
+    ImageSpec config(res, res, 4, TypeDesc::FLOAT);
+    config.tile_width  = tsize;
+    config.tile_height = tsize;
+    config.attribute("null:force", 1);
+    OIIO_CHECK_ASSERT(imagecache->add_file(name, NullInputCreator, &config));
+
+    const long long limit = (long long)max_mb * 1024 * 1024;
+    long long peak        = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int t = 0; t < ntiles; ++t) {
+            int x = (t % (res / tsize)) * tsize;
+            int y = (t / (res / tsize)) * tsize;
+            ImageCache::Tile* tile = imagecache->get_tile(name, 0, 0, x, y, 0);
+            OIIO_CHECK_ASSERT(tile != nullptr);
+            imagecache->release_tile(tile);
+            long long used = 0;
+            imagecache->getattribute("stat:cache_memory_used",
+                                     TypeDesc::INT64, &used);
+            peak = std::max(peak, used);
+        }
+    }
+    std::cout << "  peak memory " << peak << " with limit " << limit << "\n";
+    OIIO_CHECK_LE(peak, limit + 3 * tilebytes);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Test that tiles used in place in a memory-mapped file hold exactly what
+// reading them would, for several data types and partial edge tiles.
+void
+test_mapped_tiles()
+{
+    std::cout << "\nTesting memory-mapped tiles\n";
+    ustring filename("mapped.tif");
+    const int xres = 200, yres = 150, tsize = 64;
+    const TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::UINT16,
+                               TypeDesc::FLOAT };
+    for (TypeDesc type : types) {
+        for (int nchannels : { 1, 3, 4 }) {
+            ImageSpec spec(xres, yres, nchannels, type);
+            spec.tile_width  = tsize;
+            spec.tile_height = tsize;
+            spec.attribute("compression", "none");
+            ImageBuf A(spec);
+            ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+            OIIO_CHECK_ASSERT(A.write(filename));
+
+            ImageCache* mapped = ImageCache::create(false /*not shared*/);
+            mapped->attribute("mmap_tiles", 1);
+            ImageCache* read = ImageCache::create(false /*not shared*/);
+            read->attribute("mmap_tiles", 0);
+            size_t tilebytes = spec.tile_bytes(true);
+            for (int y = 0; y < yres; y += tsize) {
+                for (int x = 0; x < xres; x += tsize) {
+                    ImageCache::Tile* mt = mapped->get_tile(filename, 0, 0, x,
+                                                            y, 0);
+                    ImageCache::Tile* rt = read->get_tile(filename, 0, 0, x, y,
+                                                          0);
+                    OIIO_CHECK_ASSERT(mt && rt);
+                    if (mt && rt) {
+                        TypeDesc mformat, rformat;
+                        const void* mp = mapped->tile_pixels(mt, mformat);
+                        const void* rp = read->tile_pixels(rt, rformat);
+                        OIIO_CHECK_EQUAL(mformat, rformat);
+                        OIIO_CHECK_ASSERT(mp && rp
+                                          && !memcmp(mp, rp, tilebytes));
+                    }
+                    mapped->release_tile(mt);
+                    read->release_tile(rt);
+                }
+            }
+            long long nmapped = 0, nread = 0;
+            mapped->getattribute("stat:tiles_mapped", TypeDesc::INT64,
+                                 &nmapped);
+            read->getattribute("stat:tiles_mapped", TypeDesc::INT64, &nread);
+            std::cout << "  " << type << " " << nchannels << " channels: "
+                      << nmapped << " tiles mapped\n";
+            OIIO_CHECK_GT(nmapped, 0);
+            OIIO_CHECK_EQUAL(nread, 0);
+            ImageCache::destroy(mapped);
+            ImageCache::destroy(read);
+        }
+    }
+    Filesystem::remove(filename);
+}
+
+
+
+// Test the shared memory tile store within one process: tiles read by
+// one cache are found there by another attached to the same name, and the
+// segment goes away once neither is attached.
+void
+test_shared_cache()
+{
+    std::cout << "\nTesting shared tile cache\n";
+    ustring filename("sharedcached.tif");
+    const int res = 256, tsize = 64, ntiles = (res / tsize) * (res / tsize);
+    ImageSpec spec(res, res, 3, TypeDesc::FLOAT);
+    spec.tile_width  = tsize;
+    spec.tile_height = tsize;
+    ImageBuf A(spec);
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+    OIIO_CHECK_ASSERT(A.write(filename));
+    std::vector<float> original(res * res * 3);
+    A.get_pixels(A.roi(), TypeDesc::FLOAT, original.data());
+
+    std::string name = Filesystem::unique_path("oiio_imagecache_test_%%%%%%");
+    auto read_image = [&](ImageCache* ic, long long& hits, long long& adds) {
+        std::vector<float> pixels(res * res * 3, -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(filename, 0, 0, 0, res, 0, res, 0, 1,
+                                         TypeDesc::FLOAT, pixels.data()));
+        OIIO_CHECK_ASSERT(pixels == original);
+        ic->getattribute("stat:shared_cache_hits", TypeDesc::INT64, &hits);
+        ic->getattribute("stat:shared_cache_adds", TypeDesc::INT64, &adds);
+    };
+    ImageCache* first = ImageCache::create(false /*not shared*/);
+    first->attribute("shared_cache_max_MB", 4);
+    first->attribute("shared_cache_name", name);
+    std::string attached;
+    first->getattribute("shared_cache_name", attached);
+    if (attached.empty()) {
+        std::cout << "  shared tile cache not supported, skipping\n";
+        ImageCache::destroy(first);
+        Filesystem::remove(filename);
+        return;
+    }
+    long long hits, adds;
+    read_image(first, hits, adds);
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(adds, ntiles);
+
+    ImageCache* second = ImageCache::create(false /*not shared*/);
+    second->attribute("shared_cache_name", name);
+    read_image(second, hits, adds);
+    OIIO_CHECK_EQUAL(hits, ntiles);
+    OIIO_CHECK_EQUAL(adds, 0);
+
+    // Once both are gone, a new attachment starts from an empty segment.
+    ImageCache::destroy(first);
+    ImageCache::destroy(second);
+    ImageCache* third = ImageCache::create(false /*not shared*/);
+    third->attribute("shared_cache_name", name);
+    read_image(third, hits, adds);
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(adds, ntiles);
+    ImageCache::destroy(third);
+
+    Filesystem::remove(filename);
+}
+
+
+
+// Test that tiles kept compressed in memory (compress_tiles) expand back
+// to exactly the pixels read from the file, for each size of channel the
+// byte shuffling handles, and that pixels that don't compress are simply
+// evicted instead.
+void
+test_compressed_tiles()
+{
+    std::cout << "\nTesting compressed tiles\n";
+    ustring filename("compressme.tif");
+    const int res = 256, tsize = 64;  // 16 "hot" tiles
+    // A "null" image whose tiles are streamed through the cache to page
+    // the hot ones out. Its tiles are each used once, so are never worth
+    // compressing themselves.
+    ustring stream("compressme_stream");
+    const int sres = 2048, sntiles = sres / tsize;
+    ImageSpec sconfig(sres, sres, 4, TypeDesc::FLOAT);
+    sconfig.tile_width  = tsize;
+    sconfig.tile_height = tsize;
+    sconfig.attribute("null:force", 1);
+
+    const TypeDesc types[] = { TypeDesc::UINT8, TypeDesc::HALF,
+                               TypeDesc::FLOAT };
+    for (TypeDesc type : types) {
+        for (bool noisy : { false, true }) {
+            ImageSpec spec(res, res, 4, type);
+            spec.tile_width  = tsize;
+            spec.tile_height = tsize;
+            ImageBuf A(spec);
+            if (noisy) {
+                ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+            } else {
+                const float top[4] = { 0.0f, 0.25f, 0.5f, 1.0f };
+                const float bot[4] = { 1.0f, 0.75f, 0.125f, 1.0f };
+                ImageBufAlgo::fill(A, top, bot);
+            }
+            OIIO_CHECK_ASSERT(A.write(filename));
+            std::vector<float> original(res * res * 4);
+            A.get_pixels(A.roi(), TypeDesc::FLOAT, original.data());
+
+            ImageCache* ic = ImageCache::create(false /*not shared*/);
+            ic->attribute("max_memory_MB", 10);
+            ic->attribute("autotile", 0);
+            ic->attribute("compress_tiles", 1);
+            OIIO_CHECK_ASSERT(ic->add_file(stream, NullInputCreator, &sconfig));
+            auto read_hot = [&]() {
+                std::vector<float> pixels(res * res * 4, -1.0f);
+                OIIO_CHECK_ASSERT(ic->get_pixels(filename, 0, 0, 0, res, 0,
+                                                 res, 0, 1, TypeDesc::FLOAT,
+                                                 pixels.data()));
+                OIIO_CHECK_ASSERT(pixels == original);
+            };
+            int s             = 0;
+            auto stream_tiles = [&](int n) {
+                for (int i = 0; i < n; ++i, ++s) {
+                    int x = (s % sntiles) * tsize;
+                    int y = ((s / sntiles) % sntiles) * tsize;
+                    ImageCache::Tile* tile = ic->get_tile(stream, 0, 0, x, y,
+                                                          0);
+                    OIIO_CHECK_ASSERT(tile != nullptr);
+                    ic->release_tile(tile);
+                }
+            };
+
+            // Keep the hot tiles busy while enough tiles stream through to
+            // sweep past them several times, then let them go cold until
+            // some are compressed, and use them again right away.
+            for (int i = 0; i < 64; ++i) {
+                stream_tiles(8);
+                read_hot();
+            }
+            long long compressed = 0, decompressed = 0;
+            for (int i = 0; i < 100 && !compressed; ++i) {
+                stream_tiles(8);
+                ic->getattribute("stat:tiles_compressed", TypeDesc::INT64,
+                                 &compressed);
+            }
+            read_hot();
+            ic->getattribute("stat:tiles_decompressed", TypeDesc::INT64,
+                             &decompressed);
+            std::cout << "  " << type << (noisy ? " noise" : " gradient")
+                      << ": " << compressed << " tiles compressed, "
+                      << decompressed << " expanded\n";
+            if (!noisy) {
+                OIIO_CHECK_GT(compressed, 0);
+                OIIO_CHECK_GT(decompressed, 0);
+            } else if (type == TypeDesc::UINT8) {
+                // Random bytes don't compress; those tiles are evicted.
+                OIIO_CHECK_EQUAL(compressed, 0);
+            }
+            ImageCache::destroy(ic);
+        }
+    }
+    Filesystem::remove(filename);
+}
+
+
+
+// Test that retrieving many handles at once gives the same handles as
+// retrieving them one at a time, including for repeated names, names of
+// files that don't exist, and names already in the cache.
+void
+test_get_handles()
+{
+    std::cout << "\nTesting get_image_handles and get_texture_handles\n";
+    std::vector<ustring> filenames;
+    for (int i = 0; i < 8; ++i) {
+        ustring name = ustring::sprintf("handles%d.tif", i);
+        ImageSpec spec(16, 16, 1, TypeDesc::UINT8);
+        ImageBuf A(spec);
+        const float value = i / 8.0f;
+        ImageBufAlgo::fill(A, cspan<float>(&value, 1));
+        OIIO_CHECK_ASSERT(A.write(name));
+        filenames.push_back(name);
+    }
+    filenames.push_back(filenames[3]);                    // repeated
+    filenames.push_back(ustring("handles_missing.tif"));  // nonexistent
+
+    // Each image cache and texture system gets its first few files one at
+    // a time, so the batch call finds some already in the cache.
+    auto check = [&](bool texture) {
+        ImageCache* ic     = ImageCache::create(false /*not shared*/);
+        TextureSystem* ts  = TextureSystem::create(false, ic);
+        const size_t nseen = 2;
+        std::vector<void*> single(filenames.size(), nullptr);
+        for (size_t i = 0; i < nseen; ++i)
+            single[i] = texture ? (void*)ts->get_texture_handle(filenames[i])
+                                : (void*)ic->get_image_handle(filenames[i]);
+        std::vector<void*> batch(filenames.size(), nullptr);
+        if (texture)
+            ts->get_texture_handles(filenames,
+                                    span<TextureSystem::TextureHandle*>(
+                                        (TextureSystem::TextureHandle**)
+                                            batch.data(),
+                                        batch.size()));
+        else
+            ic->get_image_handles(filenames,
+                                  span<ImageCache::ImageHandle*>(
+                                      (ImageCache::ImageHandle**)batch.data(),
+                                      batch.size()));
+        for (size_t i = nseen; i < filenames.size(); ++i)
+            single[i] = texture ? (void*)ts->get_texture_handle(filenames[i])
+                                : (void*)ic->get_image_handle(filenames[i]);
+        OIIO_CHECK_ASSERT(batch == single);
+        OIIO_CHECK_EQUAL(batch[3], batch[8]);
+        for (size_t i = 0; i < filenames.size(); ++i) {
+            bool good = texture ? ts->good((TextureSystem::TextureHandle*)
+                                               batch[i])
+                                : ic->good((ImageCache::ImageHandle*)batch[i]);
+            OIIO_CHECK_EQUAL(good, i != filenames.size() - 1);
+        }
+        ic->geterror();  // eat the error about the missing file
+        TextureSystem::destroy(ts);
+        ImageCache::destroy(ic);
+    };
+    check(false);
+    check(true);
+    for (size_t i = 0; i < 8; ++i)
+        Filesystem::remove(filenames[i].string());
+}
+
+
+
+// Test that prefetch hints arriving while the cache is being invalidated
+// or closed are either turned away or finished before the invalidation
+// proceeds, never left to read into a file that was just invalidated.
+void
+test_prefetch_during_invalidate()
+{
+    std::cout << "\nTesting prefetch during invalidate\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("prefetch_threads", 2);
+
+    ustring filename("prefetchme.tif");
+    const float color[3] = { 0.25f, 0.5f, 0.75f };
+    ImageSpec spec(256, 256, 3, TypeDesc::FLOAT);
+    spec.tile_width  = 16;
+    spec.tile_height = 16;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, color);
+    OIIO_CHECK_ASSERT(A.write(filename));
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> hinters;
+    for (int i = 0; i < 2; ++i)
+        hinters.emplace_back([&]() {
+            while (!done)
+                imagecache->prefetch(filename, 0, 0, 0, 256, 0, 256);
+        });
+    for (int i = 0; i < 100; ++i) {
+        switch (i % 4) {
+        case 0: imagecache->invalidate(filename); break;
+        case 1: imagecache->invalidate_all(true); break;
+        case 2: imagecache->close(filename); break;
+        case 3: imagecache->close_all(); break;
+        }
+        float p[3] = { -1, -1, -1 };
+        OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 100, 101,
+                                                 200, 201, 0, 1,
+                                                 TypeDesc::FLOAT, p));
+        OIIO_CHECK_EQUAL(p[0], color[0]);
+        OIIO_CHECK_EQUAL(p[2], color[2]);
+    }
+    done = true;
+    for (auto& t : hinters)
+        t.join();
+
+    // Changing the pool size also has to wait for outstanding hints.
+    imagecache->attribute("prefetch_threads", 1);
+    OIIO_CHECK_ASSERT(imagecache->prefetch(filename, 0, 0, 0, 256, 0, 256));
+    imagecache->attribute("prefetch_threads", 0);
+    OIIO_CHECK_ASSERT(!imagecache->prefetch(filename, 0, 0, 0, 256, 0, 256));
+
+    ImageCache::destroy(imagecache);
+    Filesystem::remove(filename);
+}
+
+
+
+static int
+count_disk_cache_entries(const std::string& dir)
+{
+    std::vector<std::string> entries;
+    Filesystem::get_directory_entries(dir, entries, true);
+    return (int)std::count_if(entries.begin(), entries.end(),
+                              [](const std::string& e) {
+                                  return Strutil::ends_with(e, ".tile");
+                              });
+}
+
+
+
+// Test the on-disk second level tile cache: entries are found by a later
+// cache, a file rewritten right away doesn't match its old entries, and
+// the directory is trimmed when it outgrows its cap.
+void
+test_disk_cache()
+{
+    std::cout << "\nTesting disk cache\n";
+    std::string dir = Filesystem::unique_path("imagecache_test_%%%%%%");
+    ustring filename("diskcached.tif");
+    const int res = 256, tsize = 64, ntiles = (res / tsize) * (res / tsize);
+    auto write_image = [&](float value, bool extra) {
+        ImageSpec spec(res, res, 3, TypeDesc::FLOAT);
+        spec.tile_width  = tsize;
+        spec.tile_height = tsize;
+        if (extra)  // make sure the file differs in size, too
+            spec.attribute("ImageDescription", "rewritten");
+        ImageBuf A(spec);
+        const float color[3] = { value, value, value };
+        ImageBufAlgo::fill(A, color);
+        OIIO_CHECK_ASSERT(A.write(filename));
+    };
+    auto read_image = [&](float maxmb, float value, long long& hits,
+                          long long& writes) {
+        ImageCache* ic = ImageCache::create(false /*not shared*/);
+        ic->attribute("disk_cache_dir", dir);
+        ic->attribute("disk_cache_max_MB", maxmb);
+        std::vector<float> pixels(res * res * 3, -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(filename, 0, 0, 0, res, 0, res, 0, 1,
+                                         TypeDesc::FLOAT, pixels.data()));
+        OIIO_CHECK_EQUAL(pixels.front(), value);
+        OIIO_CHECK_EQUAL(pixels.back(), value);
+        ic->getattribute("stat:disk_cache_hits", TypeDesc::INT64, &hits);
+        ic->getattribute("stat:disk_cache_writes", TypeDesc::INT64, &writes);
+        ImageCache::destroy(ic);  // waits for any trim under way
+    };
+
+    long long hits, writes;
+    write_image(0.25f, false);
+    read_image(100.0f, 0.25f, hits, writes);
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(writes, ntiles);
+    read_image(100.0f, 0.25f, hits, writes);
+    OIIO_CHECK_EQUAL(hits, ntiles);
+    OIIO_CHECK_EQUAL(writes, 0);
+
+    // Rewritten within the same second: must not be served stale tiles.
+    write_image(0.75f, true);
+    read_image(100.0f, 0.75f, hits, writes);
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(writes, ntiles);
+    OIIO_CHECK_EQUAL(count_disk_cache_entries(dir), 2 * ntiles);
+
+    // A cap of a few tiles trims the directory (in the background), but
+    // doesn't change what we read. The least recently used entries, those
+    // of the earlier versions of the file, go first. (How many of the new
+    // ones survive depends on how the trim overlapped with the writes.)
+    write_image(0.5f, false);
+    read_image(0.2f, 0.5f, hits, writes);
+    OIIO_CHECK_EQUAL(writes, ntiles);
+    int remaining = count_disk_cache_entries(dir);
+    std::cout << "  " << remaining << " disk cache entries after trim\n";
+    OIIO_CHECK_GT(remaining, 0);
+    OIIO_CHECK_LE(remaining, ntiles);
+
+    Filesystem::remove_all(dir);
+    Filesystem::remove(filename);
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -145,6 +694,14 @@ main(int /*argc*/, char* /*argv*/[])
     test_get_pixels_cachechannels(6, 9, 6, 9);
 
     test_app_buffer();
+    test_tile_eviction();
+    test_microcache_pins();
+    test_mapped_tiles();
+    test_compressed_tiles();
+    test_get_handles();
+    test_prefetch_during_invalidate();
+    test_disk_cache();
+    test_shared_cache();
 
     return unit_test_failures;
 }
@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <OpenImageIO/dassert.h>
@@ -15,6 +16,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/typedesc.h>
 
 #include "imageio_pvt.h"
@@ -45,6 +47,55 @@ ImageInput::operator delete(void* ptr)
 
 
 
+namespace {
+
+// The state of an ImageInput's I/O through an IOProxy.
+struct IOState {
+    Filesystem::IOProxy* io = nullptr;  // the proxy we're reading through
+    std::unique_ptr<Filesystem::IOProxy> io_local;  // ...if we opened it
+    bool opened = false;  // between ioproxy_use_or_open and ioproxy_clear
+    bool mmap   = false;  // "oiio:mmap" hint: map the file rather than read it
+};
+
+// The I/O states of all ImageInputs, kept in a side table keyed by the
+// ImageInput so that the layout of the class is that of the 2.2 releases.
+// The table is never destroyed, since ImageInputs held by statics (such as
+// those of the shared ImageCache) may be destroyed after it would be.
+struct IOStateTable {
+    mutex lock;
+    std::unordered_map<const ImageInput*, IOState> states;
+};
+
+IOStateTable&
+iostate_table()
+{
+    static IOStateTable* table = new IOStateTable;
+    return *table;
+}
+
+// Return the I/O state of `in`, creating it if it doesn't exist yet. The
+// reference stays valid until `in` is destroyed.
+IOState&
+iostate(const ImageInput* in)
+{
+    IOStateTable& table(iostate_table());
+    lock_guard lock(table.lock);
+    return table.states[in];
+}
+
+// Forget the I/O state of `in`, which is being destroyed.
+void
+iostate_erase(const ImageInput* in)
+{
+    IOStateTable& table(iostate_table());
+    lock_guard lock(table.lock);
+    table.states.erase(in);
+}
+
+}  // namespace
+
+
+
 ImageInput::ImageInput()
     : m_threads(0)
 {
@@ -52,7 +103,7 @@ ImageInput::ImageInput()
 
 
 
-ImageInput::~ImageInput() {}
+ImageInput::~ImageInput() { iostate_erase(this); }
 
 
 
@@ -875,15 +926,16 @@ ImageInput::read_image(int subimage, int miplevel, int chbegin, int chend,
         if (progress_callback(progress_callback_data, 0.0f))
             return ok;
     if (spec.tile_width) {  // Tiled image -- rely on read_tiles
-        // Read in chunks of a whole row of tiles at once. If tiles are
-        // 64x64, a 2k image has 32 tiles across. That's fine for now (for
-        // parallelization purposes), but as typical core counts increase,
-        // we may someday want to revisit this to batch multiple rows.
+        // Read in chunks of whole rows of tiles. If tiles are 64x64, a 2k
+        // image has only 32 tiles across, too few to keep many threads
+        // busy, so read as many rows at once as it takes to give each
+        // thread a few tiles.
+        int chunk = image_chunk_rows(spec, threads(), 0, spec.tile_height);
         for (int z = 0; z < spec.depth; z += spec.tile_depth) {
-            for (int y = 0; y < spec.height && ok; y += spec.tile_height) {
+            for (int y = 0; y < spec.height && ok; y += chunk) {
                 ok &= read_tiles(subimage, miplevel, spec.x,
                                  spec.x + spec.width, y + spec.y,
-                                 std::min(y + spec.y + spec.tile_height,
+                                 std::min(y + spec.y + chunk,
                                           spec.y + spec.height),
                                  z + spec.z,
                                  std::min(z + spec.z + spec.tile_depth,
@@ -900,10 +952,11 @@ ImageInput::read_image(int subimage, int miplevel, int chbegin, int chend,
     } else {  // Scanline image -- rely on read_scanlines.
         // Split into reasonable chunks -- try to use around 64 MB or the
         // oiio_read_chunk value, which ever is bigger, but also round up to
-        // a multiple of the TIFF rows per strip (or 64).
+        // a multiple of the TIFF rows per strip (or 64), and make sure
+        // there are enough strips for all the threads.
         int chunk = std::max(1, (1 << 26) / int(spec.scanline_bytes(true)));
         chunk     = std::max(chunk, int(oiio_read_chunk));
-        chunk     = round_to_multiple(chunk, rps);
+        chunk     = image_chunk_rows(spec, threads(), rps, chunk);
         for (int z = 0; z < spec.depth; ++z) {
             for (int y = 0; y < spec.height && ok; y += chunk) {
                 int yend = std::min(y + spec.y + chunk, spec.y + spec.height);
@@ -999,6 +1052,148 @@ ImageInput::send_to_client(const char* /*format*/, ...)
 
 
 
+bool
+ImageInput::set_ioproxy(Filesystem::IOProxy* ioproxy)
+{
+    if (ioproxy && !supports("ioproxy"))
+        return false;
+    IOState& st(iostate(this));
+    st.io_local.reset();
+    st.io     = ioproxy;
+    st.opened = false;
+    return true;
+}
+
+
+
+void
+ImageInput::ioproxy_retrieve_from_config(const ImageSpec& config)
+{
+    auto ioparam = config.find_attribute("oiio:ioproxy", TypeDesc::PTR);
+    if (ioparam)
+        set_ioproxy(ioparam->get<Filesystem::IOProxy*>());
+    iostate(this).mmap = config.get_int_attribute("oiio:mmap") != 0;
+}
+
+
+
+bool
+ImageInput::ioproxy_use_or_open(string_view name)
+{
+    IOState& st(iostate(this));
+    if (!st.io && st.mmap) {
+        // Asked to map the file. If it can't be mapped (e.g., it's empty
+        // or not a regular file), fall back to reading it.
+        st.io_local.reset(new Filesystem::IOMMap(name));
+        if (st.io_local->mode() == Filesystem::IOProxy::Mode::Read)
+            st.io = st.io_local.get();
+        else
+            st.io_local.reset();
+    }
+    if (!st.io) {
+        // If no proxy was supplied, create a file reader
+        st.io_local.reset(
+            new Filesystem::IOFile(name, Filesystem::IOProxy::Mode::Read));
+        st.io = st.io_local.get();
+    }
+    if (st.io->mode() != Filesystem::IOProxy::Mode::Read) {
+        errorf("Could not open file \"%s\"", name);
+        ioproxy_clear();
+        return false;
+    }
+    // A proxy supplied by the app may have been read by another reader
+    // trying to open it first, so always start from the beginning.
+    st.io->seek(0);
+    st.opened = true;
+    return true;
+}
+
+
+
+void
+ImageInput::ioproxy_clear()
+{
+    IOState& st(iostate(this));
+    st.io_local.reset();
+    st.io     = nullptr;
+    st.opened = false;
+    st.mmap   = false;
+}
+
+
+
+bool
+ImageInput::ioproxy_opened() const
+{
+    return iostate(this).opened;
+}
+
+
+
+Filesystem::IOProxy*
+ImageInput::ioproxy() const
+{
+    return iostate(this).io;
+}
+
+
+
+bool
+ImageInput::ioread(void* buf, size_t itemsize, size_t nitems)
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    size_t size             = itemsize * nitems;
+    size_t n                = io ? io->read(buf, size) : 0;
+    if (n != size) {
+        if (io && n < size && io->tell() >= int64_t(io->size()))
+            errorf("Read error: hit end of file in %s reader", format_name());
+        else
+            errorf("Read error: requested %d bytes, got %d", size, n);
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+ImageInput::ioseek(int64_t pos, int origin)
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    if (!io || !io->seek(pos, origin)) {
+        errorf("Seek error: could not seek to %d", pos);
+        return false;
+    }
+    return true;
+}
+
+
+
+int64_t
+ImageInput::iotell() const
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    return io ? io->tell() : 0;
+}
+
+
+
+const unsigned char*
+ImageInput::iomapped(int64_t offset, size_t size) const
+{
+    auto mem = dynamic_cast<const Filesystem::IOMemReader*>(
+        iostate(this).io);
+    if (!mem)
+        return nullptr;
+    cspan<unsigned char> buf = mem->buffer();
+    if (offset < 0 || buf.empty() || size_t(offset) > size_t(buf.size())
+        || size > size_t(buf.size()) - size_t(offset))
+        return nullptr;
+    return buf.data() + offset;
+}
+
+
+
 void
 ImageInput::append_error(const std::string& message) const
 {
@@ -56,6 +56,9 @@ int oiio_print_debug(oiio_debug_env ? Strutil::stoi(oiio_debug_env) : 1);
 int oiio_log_times = Strutil::from_string<int>(
     Sysutil::getenv("OPENIMAGEIO_LOG_TIMES"));
 std::vector<float> oiio_missingcolor;
+atomic_int oiio_convolve_method(ConvolveAuto);
+static const char* convolve_method_names[] = { "auto", "direct", "separable",
+                                               "fft", nullptr };
 }  // namespace pvt
 
 using namespace pvt;
@@ -322,6 +325,15 @@ attribute(string_view name, TypeDesc type, const void* val)
             *(const char**)val);
         return true;
     }
+    if (name == "convolve_method" && type == TypeString) {
+        string_view method(*(const char**)val);
+        for (int i = 0; convolve_method_names[i]; ++i)
+            if (Strutil::iequals(method, convolve_method_names[i])) {
+                oiio_convolve_method = i;
+                return true;
+            }
+        return false;
+    }
 
     return false;
 }
@@ -394,6 +406,10 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = oiio_log_times;
         return true;
     }
+    if (name == "convolve_method" && type == TypeString) {
+        *(ustring*)val = ustring(convolve_method_names[oiio_convolve_method]);
+        return true;
+    }
     if (name == "timing_report" && type == TypeString) {
         *(ustring*)val = ustring(timing_log.report());
         return true;
@@ -626,6 +642,38 @@ pvt::parallel_convert_from_float(const float* src, void* dst, size_t nvals,
 
 
 
+int
+pvt::image_chunk_rows(const ImageSpec& spec, int nthreads, int rowsperstrip,
+                      int minrows)
+{
+    if (nthreads <= 0)
+        nthreads = oiio_threads;
+    // A "block" is a tile, or a strip of a scanline image. Find how many
+    // scanlines make up one row of blocks, and how many blocks that is.
+    int64_t blockrows = std::max(1, spec.tile_width ? spec.tile_height
+                                                    : rowsperstrip);
+    int64_t rowblocks = 1;
+    if (spec.tile_width)
+        rowblocks = (spec.width + spec.tile_width - 1) / spec.tile_width;
+    rowblocks = std::max(rowblocks, int64_t(1));
+
+    // Give each thread a few blocks, so that readers and writers that
+    // decode or encode blocks in parallel (such as OpenEXR) can keep all
+    // their threads busy even when some blocks take longer than others.
+    const int64_t blocks_per_thread = 4;
+    int64_t rows = (blocks_per_thread * nthreads + rowblocks - 1) / rowblocks
+                   * blockrows;
+    int64_t maxrows = int64_t(1 << 26)
+                      / std::max(int64_t(spec.scanline_bytes(true)),
+                                 int64_t(1));
+    rows = std::min(rows, std::max(maxrows, blockrows));
+    rows = round_to_multiple(std::max(rows, int64_t(minrows)), blockrows);
+    int64_t height = std::max(int64_t(spec.height), int64_t(1));
+    return int(std::min(rows, round_to_multiple(height, blockrows)));
+}
+
+
+
 bool
 convert_pixel_values(TypeDesc src_type, const void* src, TypeDesc dst_type,
                      void* dst, int n)
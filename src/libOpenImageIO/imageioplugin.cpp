@@ -40,6 +40,13 @@ static std::map<std::string, Plugin::Handle> plugin_handles;
 static std::map<std::string, std::string> plugin_filepaths;
 // Map format name to underlying implementation library
 static std::map<std::string, std::string> format_library_versions;
+// Map (lowercased extension or format name, feature) to the answer of
+// ImageInput::supports(), so that asking doesn't require instantiating a
+// reader (or rescanning the plugin searchpath) every time. It has its own
+// reader/writer lock, so that the answers already known can be read
+// concurrently, without the global imageio_mutex.
+static std::map<std::pair<std::string, std::string>, int> input_supports;
+static spin_rw_mutex input_supports_mutex;
 
 
 
@@ -99,6 +106,11 @@ declare_imageio_format(const std::string& format_name,
     // Add the name to the master list of format_names, and extensions to
     // their master list.
     recursive_lock_guard lock(pvt::imageio_mutex);
+    {
+        // Answers may change with a new plugin
+        spin_rw_write_lock supports_lock(input_supports_mutex);
+        input_supports.clear();
+    }
     if (format_list.length())
         format_list += std::string(",");
     format_list += format_name;
@@ -506,10 +518,10 @@ ImageOutput::create(string_view filename, Filesystem::IOProxy* ioproxy,
     }
     if (out && ioproxy) {
         if (!out->supports("ioproxy")) {
-            out.reset();
             OIIO::pvt::errorf(
                 "ImageOutput::create called with IOProxy, but format %s does not support IOProxy",
                 out->format_name());
+            out.reset();
         } else {
             out->set_ioproxy(ioproxy);
         }
@@ -627,7 +639,7 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         // deal with it robustly.
         formats_tried.push_back(create_function);
         in = std::unique_ptr<ImageInput>(create_function());
-        if (!do_open && in && in->valid_file(filename)) {
+        if (!do_open && !ioproxy && in && in->valid_file(filename)) {
             // Special case: we don't need to return the file
             // already opened, and this ImageInput says that the
             // file is the right type.
@@ -643,9 +655,12 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                 ok = in->open(filename, tmpspec);
         }
         if (ok) {
-            // It worked
-            if (!do_open)
+            // It worked. If we were only asked to create it, close it
+            // again, but keep it reading through the caller's proxy.
+            if (!do_open) {
                 in->close();
+                in->set_ioproxy(ioproxy);
+            }
             return in;
         } else {
             // Oops, it failed.  Apparently, this file can't be
@@ -698,8 +713,10 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
             in->set_ioproxy(ioproxy);
             bool ok = in->open(filename, tmpspec, myconfig);
             if (ok) {
-                if (!do_open)
+                if (!do_open) {
                     in->close();
+                    in->set_ioproxy(ioproxy);
+                }
                 return in;
             }
             in.reset();
@@ -745,4 +762,48 @@ ImageInput::destroy(ImageInput* x)
 }
 
 
+
+int
+pvt::input_format_supports(string_view filename, string_view feature)
+{
+    std::string filename_stripped;
+    std::map<std::string, std::string> args;
+    if (!Strutil::get_rest_arguments(filename, filename_stripped, args))
+        return 0;
+    if (filename_stripped.empty())
+        filename_stripped = filename;
+    std::string format = Filesystem::extension(filename_stripped, false);
+    if (format.empty())
+        format = filename;  // maybe it was itself the format name
+    Strutil::to_lower(format);
+
+    auto key = std::make_pair(format, std::string(feature));
+    {
+        spin_rw_read_lock supports_lock(input_supports_mutex);
+        auto found = input_supports.find(key);
+        if (found != input_supports.end())
+            return found->second;
+    }
+
+    // Not asked before. Find the plugin (scanning the searchpath just once
+    // for an unknown extension, since the answer is remembered either way),
+    // and ask a default-constructed reader.
+    recursive_lock_guard lock(imageio_mutex);  // Ensure thread safety
+    InputPluginMap::const_iterator creator = input_formats.find(format);
+    if (creator == input_formats.end()) {
+        catalog_all_plugins(plugin_searchpath.string());
+        creator = input_formats.find(format);
+    }
+    int result = 0;
+    if (creator != input_formats.end() && creator->second) {
+        std::unique_ptr<ImageInput> in(creator->second());
+        if (in)
+            result = in->supports(feature);
+    }
+    spin_rw_write_lock supports_lock(input_supports_mutex);
+    input_supports[key] = result;
+    return result;
+}
+
+
 OIIO_NAMESPACE_END
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <OpenImageIO/dassert.h>
@@ -44,6 +45,53 @@ ImageOutput::operator delete(void* ptr)
 
 
 
+namespace {
+
+// The state of an ImageOutput's I/O through an IOProxy.
+struct IOState {
+    Filesystem::IOProxy* io = nullptr;  // the proxy we're writing through
+    std::unique_ptr<Filesystem::IOProxy> io_local;  // ...if we opened it
+    bool opened = false;  // between ioproxy_use_or_open and ioproxy_clear
+};
+
+// The I/O states of all ImageOutputs, kept in a side table keyed by the
+// ImageOutput so that the layout of the class is that of the 2.2 releases.
+// As for ImageInput, the table is never destroyed.
+struct IOStateTable {
+    mutex lock;
+    std::unordered_map<const ImageOutput*, IOState> states;
+};
+
+IOStateTable&
+iostate_table()
+{
+    static IOStateTable* table = new IOStateTable;
+    return *table;
+}
+
+// Return the I/O state of `out`, creating it if it doesn't exist yet. The
+// reference stays valid until `out` is destroyed.
+IOState&
+iostate(const ImageOutput* out)
+{
+    IOStateTable& table(iostate_table());
+    lock_guard lock(table.lock);
+    return table.states[out];
+}
+
+// Forget the I/O state of `out`, which is being destroyed.
+void
+iostate_erase(const ImageOutput* out)
+{
+    IOStateTable& table(iostate_table());
+    lock_guard lock(table.lock);
+    table.states.erase(out);
+}
+
+}  // namespace
+
+
+
 ImageOutput::ImageOutput()
     : m_threads(0)
 {
@@ -51,7 +99,7 @@ ImageOutput::ImageOutput()
 
 
 
-ImageOutput::~ImageOutput() {}
+ImageOutput::~ImageOutput() { iostate_erase(this); }
 
 
 
@@ -207,6 +255,123 @@ ImageOutput::write_deep_image(const DeepData& deepdata)
 
 
 
+bool
+ImageOutput::set_ioproxy(Filesystem::IOProxy* ioproxy)
+{
+    if (ioproxy && !supports("ioproxy"))
+        return false;
+    IOState& st(iostate(this));
+    st.io_local.reset();
+    st.io     = ioproxy;
+    st.opened = false;
+    return true;
+}
+
+
+
+void
+ImageOutput::ioproxy_retrieve_from_config(const ImageSpec& config)
+{
+    auto ioparam = config.find_attribute("oiio:ioproxy", TypeDesc::PTR);
+    if (ioparam)
+        set_ioproxy(ioparam->get<Filesystem::IOProxy*>());
+}
+
+
+
+bool
+ImageOutput::ioproxy_use_or_open(string_view name)
+{
+    IOState& st(iostate(this));
+    if (!st.io) {
+        // If no proxy was supplied, create a file writer
+        st.io_local.reset(
+            new Filesystem::IOFile(name, Filesystem::IOProxy::Mode::Write));
+        st.io = st.io_local.get();
+    }
+    if (st.io->mode() != Filesystem::IOProxy::Mode::Write) {
+        errorf("Could not open file \"%s\"", name);
+        ioproxy_clear();
+        return false;
+    }
+    st.opened = true;
+    return true;
+}
+
+
+
+void
+ImageOutput::ioproxy_clear()
+{
+    IOState& st(iostate(this));
+    st.io_local.reset();
+    st.io     = nullptr;
+    st.opened = false;
+}
+
+
+
+bool
+ImageOutput::ioproxy_opened() const
+{
+    return iostate(this).opened;
+}
+
+
+
+Filesystem::IOProxy*
+ImageOutput::ioproxy() const
+{
+    return iostate(this).io;
+}
+
+
+
+bool
+ImageOutput::ioproxy_owned() const
+{
+    return iostate(this).io_local != nullptr;
+}
+
+
+
+bool
+ImageOutput::iowrite(const void* buf, size_t itemsize, size_t nitems)
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    size_t size             = itemsize * nitems;
+    size_t n                = io ? io->write(buf, size) : 0;
+    if (n != size) {
+        errorf("Write error: wrote %d bytes of %d", n, size);
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+ImageOutput::ioseek(int64_t pos, int origin)
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    if (!io || !io->seek(pos, origin)) {
+        errorf("Seek error: could not seek to %d", pos);
+        return false;
+    }
+    return true;
+}
+
+
+
+int64_t
+ImageOutput::iotell() const
+{
+    Filesystem::IOProxy* io = iostate(this).io;
+    return io ? io->tell() : 0;
+}
+
+
+
 int
 ImageOutput::send_to_output(const char* /*format*/, ...)
 {
@@ -451,15 +616,17 @@ ImageOutput::write_image(TypeDesc format, const void* data, stride_t xstride,
     if (progress_callback && progress_callback(progress_callback_data, 0.0f))
         return ok;
     if (m_spec.tile_width && supports("tiles")) {  // Tiled image
-        // Write chunks of a whole row of tiles at once. If tiles are
-        // 64x64, a 2k image has 32 tiles across. That's fine for now (for
-        // parallelization purposes), but as typical core counts increase,
-        // we may someday want to revisit this to batch multiple rows.
+        // Write chunks of whole rows of tiles. If tiles are 64x64, a 2k
+        // image has only 32 tiles across, too few to keep many threads
+        // busy, so write as many rows at once as it takes to give each
+        // thread a few tiles.
+        int chunk = image_chunk_rows(m_spec, threads(), 0,
+                                     m_spec.tile_height);
         for (int z = 0; z < m_spec.depth; z += m_spec.tile_depth) {
             int zend = std::min(z + m_spec.z + m_spec.tile_depth,
                                 m_spec.z + m_spec.depth);
-            for (int y = 0; y < m_spec.height; y += m_spec.tile_height) {
-                int yend      = std::min(y + m_spec.y + m_spec.tile_height,
+            for (int y = 0; y < m_spec.height; y += chunk) {
+                int yend      = std::min(y + m_spec.y + chunk,
                                     m_spec.y + m_spec.height);
                 const char* d = (const char*)data + z * zstride + y * ystride;
                 ok &= write_tiles(m_spec.x, m_spec.x + m_spec.width,
@@ -474,10 +641,11 @@ ImageOutput::write_image(TypeDesc format, const void* data, stride_t xstride,
         }
     } else {  // Scanline image
         // Split into reasonable chunks -- try to use around 64 MB, but
-        // round up to a multiple of the TIFF rows per strip (or 64).
+        // round up to a multiple of the TIFF rows per strip (or 64), and
+        // make sure there are enough strips for all the threads.
         int rps   = m_spec.get_int_attribute("tiff:RowsPerStrip", 64);
         int chunk = std::max(1, (1 << 26) / int(m_spec.scanline_bytes(true)));
-        chunk     = round_to_multiple(chunk, rps);
+        chunk     = image_chunk_rows(m_spec, threads(), rps, chunk);
         for (int z = 0; z < m_spec.depth; ++z)
             for (int y = 0; y < m_spec.height && ok; y += chunk) {
                 int yend      = std::min(y + m_spec.y + chunk,
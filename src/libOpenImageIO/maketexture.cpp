@@ -2,14 +2,21 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <deque>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include <OpenEXR/ImathMatrix.h>
 #include <OpenEXR/half.h>
@@ -23,6 +30,7 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
@@ -329,6 +337,129 @@ resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
 
 
 
+// Exact 2:1 downsize with an arbitrary separable filter, for the common
+// MIP-map case of float buffers whose resolution halves exactly in both
+// directions. Every output pixel sits at the same phase relative to the
+// source grid, so a single set of 2*R symmetric weights serves all rows and
+// columns. Each output row is made by a vertical pass that sums the 2*R
+// source rows into a padded float row (SIMD over contiguous floats, in
+// column blocks that stay in L1), followed by a horizontal 2:1 pass over
+// that row. Edges clamp, like the WrapClamp used by IBA::resize. Only the
+// rows of roi are computed. Returns false without touching dst if the
+// images don't qualify.
+static bool
+downsize_2to1_separable(ImageBuf& dst, const ImageBuf& src, Filter2D* filter,
+                        ROI roi)
+{
+    const ImageSpec& srcspec(src.spec());
+    const ImageSpec& dstspec(dst.spec());
+    if (!filter->separable() || !src.localpixels() || !dst.localpixels()
+        || srcspec.format != TypeFloat || dstspec.format != TypeFloat
+        || srcspec.nchannels != dstspec.nchannels || srcspec.depth != 1
+        || dstspec.depth != 1 || srcspec.width != 2 * dstspec.width
+        || srcspec.height != 2 * dstspec.height || srcspec.x != 0
+        || srcspec.y != 0 || dstspec.x != 0 || dstspec.y != 0
+        || srcspec.full_x != 0 || srcspec.full_y != 0
+        || srcspec.full_width != srcspec.width
+        || srcspec.full_height != srcspec.height
+        || src.pixel_stride() != stride_t(srcspec.pixel_bytes())
+        || dst.pixel_stride() != stride_t(dstspec.pixel_bytes()))
+        return false;
+
+    // Output pixel x is centered between source pixels 2x and 2x+1. The
+    // filter width is in output pixels; source pixel 2x+1-R+k is
+    // (k-R+0.5)/2 output pixels from the center.
+    float fwidth = std::max(filter->width(), filter->height());
+    int R        = std::max(1, (int)ceilf(fwidth));
+    int ntaps    = 2 * R;
+    std::vector<float> xw(ntaps), yw(ntaps);
+    float xtotal = 0.0f, ytotal = 0.0f;
+    for (int k = 0; k < ntaps; ++k) {
+        float d = 0.5f * (k - R + 0.5f);
+        xw[k]   = filter->xfilt(d);
+        yw[k]   = filter->yfilt(d);
+        xtotal += xw[k];
+        ytotal += yw[k];
+    }
+    for (int k = 0; k < ntaps; ++k) {
+        xw[k] = xtotal != 0.0f ? xw[k] / xtotal : 0.0f;
+        yw[k] = ytotal != 0.0f ? yw[k] / ytotal : 0.0f;
+    }
+
+    const int nc         = srcspec.nchannels;
+    const int sw         = srcspec.width;
+    const int sh         = srcspec.height;
+    const int dw         = dstspec.width;
+    const size_t srcrow  = size_t(sw) * nc;  // floats per source scanline
+    const float* srcbase = (const float*)src.localpixels();
+    float* dstbase       = (float*)dst.localpixels();
+    const stride_t sys   = src.scanline_stride() / stride_t(sizeof(float));
+    const stride_t dys   = dst.scanline_stride() / stride_t(sizeof(float));
+
+    ImageBufAlgo::parallel_image(roi, [&](ROI roi) {
+        // The vertically filtered row, with R replicated pixels of padding
+        // on each side so the horizontal pass needs no clamping.
+        std::vector<float> vrowbuf((size_t(sw) + 2 * R) * nc);
+        float* vrow = vrowbuf.data() + size_t(R) * nc;
+        std::vector<const float*> rows(ntaps);
+        const size_t block = 2048;  // floats per vertical pass block
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            for (int k = 0; k < ntaps; ++k)
+                rows[k] = srcbase
+                          + OIIO::clamp(2 * y + 1 - R + k, 0, sh - 1) * sys;
+            for (size_t b = 0; b < srcrow; b += block) {
+                size_t e = std::min(b + block, srcrow);
+                float* v = vrow + b;
+                size_t n = e - b;
+                for (size_t i = 0; i < n; ++i)
+                    v[i] = 0.0f;
+                for (int k = 0; k < ntaps; ++k) {
+                    float w = yw[k];
+                    if (w == 0.0f)
+                        continue;
+                    const float* r = rows[k] + b;
+                    simd::vfloat4 w4(w);
+                    size_t i = 0;
+                    for (; i + 4 <= n; i += 4)
+                        (simd::vfloat4(v + i) + w4 * simd::vfloat4(r + i))
+                            .store(v + i);
+                    for (; i < n; ++i)
+                        v[i] += w * r[i];
+                }
+            }
+            for (int p = 1; p <= R; ++p) {
+                std::copy(vrow, vrow + nc, vrow - p * nc);
+                std::copy(vrow + srcrow - nc, vrow + srcrow,
+                          vrow + srcrow + (p - 1) * nc);
+            }
+
+            float* d = dstbase + y * dys;
+            if (nc == 4) {
+                for (int x = 0; x < dw; ++x) {
+                    const float* s = vrow + (2 * x + 1 - R) * 4;
+                    simd::vfloat4 sum = 0.0f;
+                    for (int k = 0; k < ntaps; ++k)
+                        sum += simd::vfloat4(xw[k]) * simd::vfloat4(s + 4 * k);
+                    sum.store(d + 4 * x);
+                }
+            } else {
+                for (int x = 0; x < dw; ++x) {
+                    const float* s = vrow + (2 * x + 1 - R) * nc;
+                    float* o       = d + x * nc;
+                    for (int c = 0; c < nc; ++c)
+                        o[c] = 0.0f;
+                    for (int k = 0; k < ntaps; ++k)
+                        for (int c = 0; c < nc; ++c)
+                            o[c] += xw[k] * s[k * nc + c];
+                }
+            }
+        }
+    });
+    return true;
+}
+
+
+
 // Copy src into dst, but only for the range [x0,x1) x [y0,y1).
 static void
 check_nan_block(const ImageBuf& src, ROI roi, int& found_nonfinite)
@@ -592,28 +723,13 @@ maketx_merge_spec(ImageSpec& dstspec, const ImageSpec& srcspec)
 
 
 
+// Adjust the output spec for the constraints of the output format.
+// Return true if the format samples environment maps at the pixel
+// borders (so the lat-long edges need fixing up).
 static bool
-write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
-             const ImageSpec& outspec_template, std::string outputfilename,
-             ImageOutput* out, TypeDesc outputdatatype, bool mipmap,
-             string_view filtername, const ImageSpec& configspec,
-             std::ostream& outstream, double& stat_writetime,
-             double& stat_miptime, size_t& peak_mem)
+adjust_output_spec(ImageOutput* out, ImageSpec& outspec, bool mipmap,
+                   bool envlatlmode, bool verbose, std::ostream& outstream)
 {
-    bool envlatlmode       = (mode == ImageBufAlgo::MakeTxEnvLatl);
-    bool orig_was_overscan = (img->spec().x || img->spec().y || img->spec().z
-                              || img->spec().full_x || img->spec().full_y
-                              || img->spec().full_z);
-    ImageSpec outspec      = outspec_template;
-    outspec.set_format(outputdatatype);
-
-    if (mipmap && !out->supports("multiimage") && !out->supports("mipmap")) {
-        outstream << "maketx ERROR: \"" << outputfilename
-                  << "\" format does not support multires images\n";
-        return false;
-    }
-
-    bool verbose = configspec.get_int_attribute("maketx:verbose") != 0;
     bool src_samples_border = false;
 
     // Some special constraints for OpenEXR
@@ -641,6 +757,182 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                     << "WARNING: Changing unsupported DWA compression for this case to zip.\n";
         }
     }
+    return src_samples_border;
+}
+
+
+
+// Write rows [ybegin,yend) of a finished MIP level, which must be whole
+// tile rows (or reach the bottom of the image) if the output is tiled.
+static bool
+write_mip_strip(ImageOutput* out, const ImageBuf& buf, int ybegin, int yend)
+{
+    const ImageSpec& spec(buf.spec());
+    const void* data = buf.pixeladdr(spec.x, ybegin, spec.z);
+    if (out->spec().tile_width)
+        return out->write_tiles(spec.x, spec.x + spec.width, ybegin, yend,
+                                spec.z, spec.z + spec.depth, spec.format, data,
+                                buf.pixel_stride(), buf.scanline_stride(),
+                                buf.z_stride());
+    return out->write_scanlines(ybegin, yend, spec.z, spec.format, data,
+                                buf.pixel_stride(), buf.scanline_stride());
+}
+
+
+
+// Runs the ImageOutput calls made by write_mipmap, in the order they were
+// enqueued. If threaded, they run on a background thread, so the caller
+// can compute the next MIP level (or the rest of this one) while earlier
+// pixels are being converted, compressed and written; otherwise each task
+// runs immediately. Once a task fails, the remaining ones are skipped.
+// The caller marks the end of each level's tasks with end_level(), and
+// wait_levels() keeps it from getting more than a level or two ahead of
+// the writes, so only that many levels' pixels are held at once.
+class MipWriter {
+public:
+    typedef std::function<bool(std::string& err)> Task;
+
+    explicit MipWriter(bool threaded)
+    {
+        if (threaded)
+            m_thread = std::thread(&MipWriter::run, this);
+    }
+
+    ~MipWriter() { finish(); }
+
+    void enqueue(Task task)
+    {
+        if (!m_thread.joinable()) {
+            run_task(task);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(task));
+        m_cv.notify_one();
+    }
+
+    // Mark the end of the tasks of one MIP level.
+    void end_level()
+    {
+        if (!m_thread.joinable())
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_levels_queued;
+        m_queue.push_back(nullptr);
+        m_cv.notify_one();
+    }
+
+    // Wait until at most `pending` of the levels ended by end_level()
+    // still have tasks queued or running.
+    void wait_levels(int pending)
+    {
+        if (!m_thread.joinable())
+            return;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_level_done.wait(lock, [&]() {
+            return m_levels_queued - m_levels_done <= pending;
+        });
+    }
+
+    // Wait for all enqueued tasks to finish. Return true if they all
+    // succeeded.
+    bool finish()
+    {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_done = true;
+            }
+            m_cv.notify_one();
+            m_thread.join();
+        }
+        return ok();
+    }
+
+    bool ok() const { return !m_failed; }
+
+    // The error message of the failed task, and the total time spent in
+    // the tasks. Only meaningful after finish().
+    const std::string& error() const { return m_error; }
+    double write_time() const { return m_writetime; }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cv.wait(lock, [&]() { return m_done || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+            Task task = std::move(m_queue.front());
+            m_queue.pop_front();
+            if (!task) {  // end of a level
+                ++m_levels_done;
+                m_level_done.notify_one();
+                continue;
+            }
+            lock.unlock();
+            run_task(task);
+            // Release what the task holds (such as the level's pixels)
+            // before waking anyone waiting for the level to be done.
+            task = nullptr;
+            lock.lock();
+        }
+    }
+
+    void run_task(Task& task)
+    {
+        if (m_failed)
+            return;
+        Timer timer;
+        std::string err;
+        if (!task(err)) {
+            m_error  = err;
+            m_failed = true;
+        }
+        m_writetime += timer();
+    }
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_level_done;
+    std::deque<Task> m_queue;  // nullptr marks the end of a level
+    int m_levels_queued = 0;
+    int m_levels_done   = 0;
+    bool m_done = false;
+    std::atomic<bool> m_failed { false };
+    std::string m_error;
+    double m_writetime = 0.0;
+};
+
+
+
+static bool
+write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
+             const ImageSpec& outspec_template, std::string outputfilename,
+             ImageOutput* out, TypeDesc outputdatatype, bool mipmap,
+             string_view filtername, const ImageSpec& configspec,
+             std::ostream& outstream, double& stat_writetime,
+             double& stat_miptime, size_t& peak_mem)
+{
+    bool envlatlmode       = (mode == ImageBufAlgo::MakeTxEnvLatl);
+    bool orig_was_overscan = (img->spec().x || img->spec().y || img->spec().z
+                              || img->spec().full_x || img->spec().full_y
+                              || img->spec().full_z);
+    ImageSpec outspec      = outspec_template;
+    outspec.set_format(outputdatatype);
+
+    if (mipmap && !out->supports("multiimage") && !out->supports("mipmap")) {
+        outstream << "maketx ERROR: \"" << outputfilename
+                  << "\" format does not support multires images\n";
+        return false;
+    }
+
+    bool verbose = configspec.get_int_attribute("maketx:verbose") != 0;
+    bool src_samples_border = adjust_output_spec(out, outspec, mipmap,
+                                                 envlatlmode, verbose,
+                                                 outstream);
 
     if (envlatlmode && src_samples_border)
         fix_latl_edges(*img);
@@ -666,6 +958,7 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                   << "\" : " << out->geterror() << "\n";
         return false;
     }
+    stat_writetime += writetimer();
 
     // Write out the image
     if (verbose) {
@@ -674,16 +967,35 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
         outstream << "  Top level is " << formatres(outspec) << std::endl;
     }
 
-    if (!img->write(out)) {
-        // ImageBuf::write transfers any errors from the ImageOutput to
-        // the ImageBuf.
-        outstream << "maketx ERROR: Write failed \" : " << img->geterror()
-                  << "\n";
-        out->close();
-        return false;
-    }
-
-    stat_writetime += writetimer();
+    // All further ImageOutput calls go through the MipWriter. When
+    // pipelining, they run in order on a background thread, so each MIP
+    // level is computed while the previous one is still being converted,
+    // compressed and written.
+    bool pipeline = configspec.get_int_attribute("maketx:pipeline", 1) != 0;
+    MipWriter writer(pipeline);
+    std::shared_ptr<ImageBuf> top = img;
+    if (mipmap) {
+        // Trick: to get the resize working properly, we reset both display
+        // and pixel windows to match, and have 0 offset, AND doctor the big
+        // image to have its display and pixel windows match.  Don't worry,
+        // the texture engine doesn't care what the upper MIP levels have
+        // for the window sizes, it uses level 0 to determine the
+        // relatinship between texture 0-1 space (display window) and the
+        // pixels. Each level's spec is finished before the writer sees it.
+        img->set_full(img->xbegin(), img->xend(), img->ybegin(), img->yend(),
+                      img->zbegin(), img->zend());
+    }
+    writer.enqueue([=](std::string& err) {
+        if (!top->write(out)) {
+            // ImageBuf::write transfers any errors from the ImageOutput to
+            // the ImageBuf.
+            err = Strutil::sprintf("maketx ERROR: Write failed \" : %s",
+                                   top->geterror());
+            return false;
+        }
+        return true;
+    });
+    writer.end_level();
 
     if (mipmap) {  // Mipmap levels:
         if (verbose)
@@ -696,10 +1008,25 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
         bool allow_shift
             = configspec.get_int_attribute("maketx:allow_pixel_shift") != 0;
 
-        std::shared_ptr<ImageBuf> small(new ImageBuf);
-        while (outspec.width > 1 || outspec.height > 1) {
+        // If the format explicitly supports MIP-maps, use that,
+        // otherwise try to simulate MIP-mapping with multi-image.
+        ImageOutput::OpenMode appendmode = out->supports("mipmap")
+                                               ? ImageOutput::AppendMIPLevel
+                                               : ImageOutput::AppendSubimage;
+
+        while ((outspec.width > 1 || outspec.height > 1) && writer.ok()) {
+            // Each level gets its own buffer, since the writer may still be
+            // reading the previous one. But don't get more than one level
+            // ahead of it, so at most two levels besides the one we read
+            // from are held at once.
+            writer.wait_levels(1);
             Timer miptimer;
             ImageSpec smallspec;
+            std::shared_ptr<ImageBuf> small(new ImageBuf);
+            // If set, computes the level a strip at a time, and each strip
+            // is handed to the writer as soon as it is done.
+            std::function<void(ROI)> compute_strip;
+            std::shared_ptr<Filter2D> filter;
 
             if (mipimages.size()) {
                 // Special case -- the user specified a custom MIP level
@@ -735,36 +1062,29 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                     || configspec.get_int_attribute("maketx:forcefloat", 1))
                     smallspec.set_format(TypeDesc::FLOAT);
 
-                // Trick: to get the resize working properly, we reset
-                // both display and pixel windows to match, and have 0
-                // offset, AND doctor the big image to have its display
-                // and pixel windows match.  Don't worry, the texture
-                // engine doesn't care what the upper MIP levels have
-                // for the window sizes, it uses level 0 to determine
-                // the relatinship between texture 0-1 space (display
-                // window) and the pixels.
+                // Display and pixel windows match (see above).
                 smallspec.x      = 0;
                 smallspec.y      = 0;
                 smallspec.full_x = 0;
                 smallspec.full_y = 0;
                 small->reset(smallspec);  // Realocate with new size
-                img->set_full(img->xbegin(), img->xend(), img->ybegin(),
-                              img->yend(), img->zbegin(), img->zend());
 
                 if (filtername == "box" && !orig_was_overscan
                     && sharpen <= 0.0f) {
-                    ImageBufAlgo::parallel_image(get_roi(small->spec()),
-                                                 std::bind(resize_block,
-                                                           std::ref(*small),
-                                                           std::cref(*img), _1,
-                                                           envlatlmode,
-                                                           allow_shift));
+                    compute_strip = [&](ROI roi) {
+                        ImageBufAlgo::parallel_image(
+                            roi, std::bind(resize_block, std::ref(*small),
+                                           std::cref(*img), _1, envlatlmode,
+                                           allow_shift));
+                    };
                 } else {
-                    Filter2D* filter = setup_filter(small->spec(), img->spec(),
-                                                    filtername);
+                    filter.reset(setup_filter(small->spec(), img->spec(),
+                                              filtername),
+                                 Filter2D::destroy);
                     if (!filter) {
                         outstream << "maketx ERROR: could not make filter \""
                                   << filtername << "\"\n";
+                        writer.finish();
                         return false;
                     }
                     if (verbose) {
@@ -779,8 +1099,12 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                         }
                         outstream << "\n";
                     }
-                    if (do_highlight_compensation)
-                        ImageBufAlgo::rangecompress(*img, *img);
+                    if (do_highlight_compensation) {
+                        // Not in place: the writer may still be reading img.
+                        std::shared_ptr<ImageBuf> comp(new ImageBuf);
+                        ImageBufAlgo::rangecompress(*comp, *img);
+                        std::swap(img, comp);
+                    }
                     if (sharpen > 0.0f && sharpen_first) {
                         std::shared_ptr<ImageBuf> sharp(new ImageBuf);
                         bool uok = ImageBufAlgo::unsharp_mask(*sharp, *img,
@@ -791,8 +1115,24 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                                       << "\n";
                         std::swap(img, sharp);
                     }
-                    ImageBufAlgo::resize(*small, *img, filter);
+                    auto resize_strip = [&](ROI roi) {
+                        if (!downsize_2to1_separable(*small, *img, filter.get(),
+                                                     roi))
+                            ImageBufAlgo::resize(*small, *img, filter.get(),
+                                                 roi);
+                    };
+                    auto expand_strip = [&](ROI roi) {
+                        if (do_highlight_compensation) {
+                            ImageBufAlgo::rangeexpand(*small, *small, false,
+                                                      roi);
+                            float fmax = std::numeric_limits<float>::max();
+                            ImageBufAlgo::clamp(*small, *small, 0.0f, fmax,
+                                                true, roi);
+                        }
+                    };
                     if (sharpen > 0.0f && !sharpen_first) {
+                        // Sharpening after the resize needs the whole level
+                        resize_strip(get_roi(small->spec()));
                         std::shared_ptr<ImageBuf> sharp(new ImageBuf);
                         bool uok = ImageBufAlgo::unsharp_mask(*sharp, *small,
                                                               sharpenfilt, 3.0,
@@ -801,44 +1141,75 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                             outstream << "maketx ERROR: " << sharp->geterror()
                                       << "\n";
                         std::swap(small, sharp);
+                        expand_strip(get_roi(small->spec()));
+                    } else {
+                        compute_strip = [resize_strip, expand_strip](ROI roi) {
+                            resize_strip(roi);
+                            expand_strip(roi);
+                        };
                     }
-                    if (do_highlight_compensation) {
-                        ImageBufAlgo::rangeexpand(*small, *small);
-                        ImageBufAlgo::clamp(*small, *small, 0.0f,
-                                            std::numeric_limits<float>::max(),
-                                            true);
-                    }
-                    Filter2D::destroy(filter);
                 }
             }
 
-            stat_miptime += miptimer();
+            // Finish the level's spec now, before the writer can see it,
+            // rather than when it's the source of the next level.
+            small->set_full(small->xbegin(), small->xend(), small->ybegin(),
+                            small->yend(), small->zbegin(), small->zend());
             outspec = smallspec;
             outspec.set_format(outputdatatype);
+            ImageSpec levelspec = outspec;
+            writer.enqueue([=](std::string& err) {
+                if (!out->open(outputfilename.c_str(), levelspec,
+                               appendmode)) {
+                    err = Strutil::sprintf(
+                        "maketx ERROR: Could not append \"%s\" : %s",
+                        outputfilename, out->geterror());
+                    return false;
+                }
+                return true;
+            });
+
+            // The lat-long edge fixup and volumes need the whole level.
             if (envlatlmode && src_samples_border)
-                fix_latl_edges(*small);
-
-            Timer writetimer;
-            // If the format explicitly supports MIP-maps, use that,
-            // otherwise try to simulate MIP-mapping with multi-image.
-            ImageOutput::OpenMode mode = out->supports("mipmap")
-                                             ? ImageOutput::AppendMIPLevel
-                                             : ImageOutput::AppendSubimage;
-            if (!out->open(outputfilename.c_str(), outspec, mode)) {
-                outstream << "maketx ERROR: Could not append \""
-                          << outputfilename << "\" : " << out->geterror()
-                          << "\n";
-                return false;
-            }
-            if (!small->write(out)) {
-                // ImageBuf::write transfers any errors from the
-                // ImageOutput to the ImageBuf.
-                outstream << "maketx ERROR writing \"" << outputfilename
-                          << "\" : " << small->geterror() << "\n";
-                out->close();
-                return false;
+                compute_strip = nullptr;
+            if (compute_strip && smallspec.depth == 1) {
+                int strip = outspec.tile_width ? outspec.tile_height : 1;
+                strip *= std::max(1, 64 / strip);
+                for (int y = 0; y < smallspec.height && writer.ok();
+                     y += strip) {
+                    ROI roi(0, smallspec.width, y,
+                            std::min(y + strip, smallspec.height));
+                    compute_strip(roi);
+                    writer.enqueue([=](std::string& err) {
+                        if (!write_mip_strip(out, *small, roi.ybegin,
+                                             roi.yend)) {
+                            err = Strutil::sprintf(
+                                "maketx ERROR writing \"%s\" : %s",
+                                outputfilename, out->geterror());
+                            return false;
+                        }
+                        return true;
+                    });
+                }
+            } else {
+                if (compute_strip)
+                    compute_strip(get_roi(small->spec()));
+                if (envlatlmode && src_samples_border)
+                    fix_latl_edges(*small);
+                writer.enqueue([=](std::string& err) {
+                    if (!small->write(out)) {
+                        // ImageBuf::write transfers any errors from the
+                        // ImageOutput to the ImageBuf.
+                        err = Strutil::sprintf(
+                            "maketx ERROR writing \"%s\" : %s",
+                            outputfilename, small->geterror());
+                        return false;
+                    }
+                    return true;
+                });
             }
-            stat_writetime += writetimer();
+            writer.end_level();
+            stat_miptime += miptimer();
             if (verbose) {
                 size_t mem = Sysutil::memory_used(true);
                 peak_mem   = std::max(peak_mem, mem);
@@ -847,10 +1218,17 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                                               Strutil::memformat(mem))
                           << std::endl;
             }
-            std::swap(img, small);
+            img = small;
         }
     }
 
+    bool ok = writer.finish();
+    stat_writetime += writer.write_time();
+    if (!ok) {
+        outstream << writer.error() << "\n";
+        out->close();
+        return false;
+    }
     if (verbose)
         outstream << "  Wrote file: " << outputfilename << "  ("
                   << Strutil::memformat(Sysutil::memory_used(true)) << ")\n";
@@ -867,6 +1245,381 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
 
 
 
+// One axis of a separable resampling from srcres to dstres pixels: output
+// pixel i is the sum over t of weights[i*ntaps+t] times source pixel
+// taps[i*ntaps+t], where the tap indices are already clamped to the image.
+struct ResampleAxis {
+    int ntaps = 0;
+    std::vector<int> taps;
+    std::vector<float> weights;
+
+    // Index of the last source pixel that output pixel i reads.
+    int last(int i) const
+    {
+        int m = 0;
+        for (int t = 0; t < ntaps; ++t)
+            m = std::max(m, taps[size_t(i) * ntaps + t]);
+        return m;
+    }
+};
+
+
+
+// Bilinear interpolation at output pixel centers, matching what
+// interppixel_NDC_clamped does for the box filter in resize_block.
+static void
+make_bilinear_axis(ResampleAxis& axis, int srcres, int dstres)
+{
+    axis.ntaps = 2;
+    axis.taps.resize(2 * size_t(dstres));
+    axis.weights.resize(2 * size_t(dstres));
+    float scale = 1.0f / (float)dstres;
+    for (int i = 0; i < dstres; ++i) {
+        float x = ((i + 0.5f) * scale) * float(srcres) - 0.5f;
+        int texel;
+        float frac              = floorfrac(x, &texel);
+        axis.taps[2 * i]        = OIIO::clamp(texel, 0, srcres - 1);
+        axis.taps[2 * i + 1]    = OIIO::clamp(texel + 1, 0, srcres - 1);
+        axis.weights[2 * i]     = 1.0f - frac;
+        axis.weights[2 * i + 1] = frac;
+    }
+}
+
+
+
+// Filtered resampling with the same taps and normalized weights that
+// IBA::resize uses for a separable filter (clamping at the edges).
+static void
+make_filter_axis(ResampleAxis& axis, int srcres, int dstres,
+                 const Filter2D* filter, bool xaxis)
+{
+    float ratio = float(dstres) / float(srcres);
+    float frad  = filter->width() / 2.0f;  // for both axes, like resize
+    int rad     = (int)ceilf(frad / ratio);
+    axis.ntaps  = 2 * rad + 1;
+    axis.taps.resize(size_t(axis.ntaps) * dstres);
+    axis.weights.resize(size_t(axis.ntaps) * dstres);
+    float dstpixel = 1.0f / float(dstres);
+    for (int i = 0; i < dstres; ++i) {
+        float s     = (i + 0.5f) * dstpixel;
+        float src_f = s * float(srcres);
+        int src_i;
+        float frac  = floorfrac(src_f, &src_i);
+        int* taps   = &axis.taps[size_t(i) * axis.ntaps];
+        float* w    = &axis.weights[size_t(i) * axis.ntaps];
+        float total = 0.0f;
+        for (int t = 0; t < axis.ntaps; ++t) {
+            float d = ratio * (t - rad - (frac - 0.5f));
+            w[t]    = xaxis ? filter->xfilt(d) : filter->yfilt(d);
+            taps[t] = OIIO::clamp(src_i - rad + t, 0, srcres - 1);
+            total += w[t];
+        }
+        for (int t = 0; t < axis.ntaps; ++t)
+            w[t] = (total != 0.0f) ? w[t] / total : 0.0f;
+    }
+}
+
+
+
+// Computes the next MIP level from the scanlines of the current level as
+// they stream past in order. Each source scanline is filtered horizontally
+// into a ring of the most recent ytaps scanlines, and every output
+// scanline whose vertical taps are all available is finished and appended
+// to a file. Memory use is a few scanlines, regardless of image height.
+class MipLevelStreamer {
+public:
+    MipLevelStreamer(int srcw, int srch, int dstw, int dsth, int nchannels,
+                     const Filter2D* filter, FILE* file)
+        : m_nchannels(nchannels)
+        , m_dstw(dstw)
+        , m_dsth(dsth)
+        , m_file(file)
+    {
+        if (filter) {
+            make_filter_axis(m_xaxis, srcw, dstw, filter, true);
+            make_filter_axis(m_yaxis, srch, dsth, filter, false);
+        } else {
+            make_bilinear_axis(m_xaxis, srcw, dstw);
+            make_bilinear_axis(m_yaxis, srch, dsth);
+        }
+        m_ringsize = m_yaxis.ntaps;
+        m_ring.resize(size_t(m_ringsize) * dstw * nchannels);
+        m_ringrow.resize(m_ringsize, -1);
+        m_out.resize(size_t(dstw) * nchannels);
+    }
+
+    // Add the next scanline of the source level. Return false if writing
+    // to the file failed.
+    bool add_scanline(const float* row)
+    {
+        int y    = m_nextrow++;
+        int nc   = m_nchannels;
+        int ntx  = m_xaxis.ntaps;
+        float* h = &m_ring[size_t(y % m_ringsize) * m_dstw * nc];
+        m_ringrow[y % m_ringsize] = y;
+        for (int x = 0; x < m_dstw; ++x, h += nc) {
+            const int* taps = &m_xaxis.taps[size_t(x) * ntx];
+            const float* w  = &m_xaxis.weights[size_t(x) * ntx];
+            if (nc == 4) {
+                simd::vfloat4 sum = 0.0f;
+                for (int t = 0; t < ntx; ++t)
+                    sum += simd::vfloat4(w[t])
+                           * simd::vfloat4(row + 4 * taps[t]);
+                sum.store(h);
+            } else {
+                for (int c = 0; c < nc; ++c)
+                    h[c] = 0.0f;
+                for (int t = 0; t < ntx; ++t)
+                    for (int c = 0; c < nc; ++c)
+                        h[c] += w[t] * row[taps[t] * nc + c];
+            }
+        }
+        while (m_nexty < m_dsth && m_yaxis.last(m_nexty) <= y)
+            if (!emit(m_nexty++))
+                return false;
+        return true;
+    }
+
+    // Have all the output scanlines been written?
+    bool done() const { return m_nexty == m_dsth; }
+
+private:
+    bool emit(int y)
+    {
+        size_t n        = m_out.size();
+        float* o        = m_out.data();
+        int nty         = m_yaxis.ntaps;
+        const int* taps = &m_yaxis.taps[size_t(y) * nty];
+        const float* w  = &m_yaxis.weights[size_t(y) * nty];
+        std::fill(m_out.begin(), m_out.end(), 0.0f);
+        for (int t = 0; t < nty; ++t) {
+            if (w[t] == 0.0f)
+                continue;
+            int slot = taps[t] % m_ringsize;
+            OIIO_DASSERT(m_ringrow[slot] == taps[t]);
+            const float* h = &m_ring[size_t(slot) * n];
+            simd::vfloat4 w4(w[t]);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+                (simd::vfloat4(o + i) + w4 * simd::vfloat4(h + i)).store(o + i);
+            for (; i < n; ++i)
+                o[i] += w[t] * h[i];
+        }
+        return fwrite(o, sizeof(float), n, m_file) == n;
+    }
+
+    int m_nchannels, m_dstw, m_dsth;
+    FILE* m_file;
+    ResampleAxis m_xaxis, m_yaxis;
+    int m_ringsize;
+    std::vector<float> m_ring;
+    std::vector<int> m_ringrow;
+    std::vector<float> m_out;
+    int m_nextrow = 0;
+    int m_nexty   = 0;
+};
+
+
+
+// Bounded-memory alternative to write_mipmap, for sources too big to hold
+// in memory. Level 0 is read from src (normally backed by an ImageCache)
+// in strips of whole tile rows, and each strip is written out (as tiles,
+// if the output is tiled) while it also feeds a MipLevelStreamer that
+// produces the next level into a temporary float file beside the output.
+// Each following level is then streamed from its temporary file in the
+// same way. Memory use is a few tile rows of the largest level; the
+// temporary files need at most a quarter of the float size of level 0.
+static bool
+write_mipmap_streaming(ImageBuf& src, const ImageSpec& outspec_template,
+                       std::string outputfilename, ImageOutput* out,
+                       TypeDesc outputdatatype, bool mipmap,
+                       string_view filtername, const ImageSpec& configspec,
+                       std::ostream& outstream, double& stat_writetime,
+                       double& stat_miptime, size_t& peak_mem)
+{
+    ImageSpec outspec = outspec_template;
+    outspec.set_format(outputdatatype);
+    if (mipmap && !out->supports("multiimage") && !out->supports("mipmap")) {
+        outstream << "maketx ERROR: \"" << outputfilename
+                  << "\" format does not support multires images\n";
+        return false;
+    }
+    bool verbose = configspec.get_int_attribute("maketx:verbose") != 0;
+    adjust_output_spec(out, outspec, mipmap, false, verbose, outstream);
+    if (Strutil::istarts_with(filtername, "post-"))
+        filtername.remove_prefix(5);
+
+    Timer writetimer;
+    if (!out->open(outputfilename.c_str(), outspec)) {
+        outstream << "maketx ERROR: Could not open \"" << outputfilename
+                  << "\" : " << out->geterror() << "\n";
+        return false;
+    }
+    stat_writetime += writetimer();
+    if (verbose) {
+        outstream << "  Writing file (streaming): " << outputfilename
+                  << std::endl;
+        outstream << "  Filter \"" << filtername << "\"\n";
+        outstream << "  Top level is " << formatres(outspec) << std::endl;
+    }
+    ImageOutput::OpenMode appendmode = out->supports("mipmap")
+                                           ? ImageOutput::AppendMIPLevel
+                                           : ImageOutput::AppendSubimage;
+
+    const int nc = outspec.nchannels;
+    const int z  = outspec.z;
+    int strip    = outspec.tile_width ? outspec.tile_height : 1;
+    strip *= std::max(1, 64 / strip);
+
+    ImageSpec levelspec = outspec;  // the level being written
+    FILE* infile        = nullptr;  // its pixels, if not level 0
+    std::string infilename;
+    bool ok = true;
+    while (ok) {
+        const int w = levelspec.width, h = levelspec.height;
+        bool more   = mipmap && (w > 1 || h > 1);
+        ImageSpec smallspec;
+        std::shared_ptr<Filter2D> filter;
+        std::unique_ptr<MipLevelStreamer> next;
+        FILE* outfile = nullptr;
+        std::string outfilename;
+        if (more) {
+            smallspec        = levelspec;
+            smallspec.width  = std::max(1, w / 2);
+            smallspec.height = std::max(1, h / 2);
+            smallspec.x = smallspec.y = smallspec.full_x = smallspec.full_y
+                = 0;
+            smallspec.full_width  = smallspec.width;
+            smallspec.full_height = smallspec.height;
+            if (filtername != "box") {
+                filter.reset(setup_filter(smallspec, levelspec, filtername),
+                             Filter2D::destroy);
+                if (!filter) {
+                    outstream << "maketx ERROR: could not make filter \""
+                              << filtername << "\"\n";
+                    ok = false;
+                    break;
+                }
+            }
+            outfilename = Filesystem::unique_path(outputfilename
+                                                  + ".%%%%%%%%.level");
+            outfile     = Filesystem::fopen(outfilename, "wb");
+            if (!outfile) {
+                outstream << "maketx ERROR: could not create temporary file \""
+                          << outfilename << "\"\n";
+                ok = false;
+                break;
+            }
+            next.reset(new MipLevelStreamer(w, h, smallspec.width,
+                                            smallspec.height, nc, filter.get(),
+                                            outfile));
+        }
+
+        std::vector<float> pixels(size_t(w) * strip * nc);
+        for (int y = 0; y < h && ok; y += strip) {
+            int yend = std::min(y + strip, h);
+            Timer readtimer;
+            size_t n = size_t(w) * (yend - y) * nc;
+            if (infile)
+                ok = fread(pixels.data(), sizeof(float), n, infile) == n;
+            else
+                ok = src.get_pixels(ROI(levelspec.x, levelspec.x + w,
+                                        levelspec.y + y, levelspec.y + yend,
+                                        z, z + 1, 0, nc),
+                                    TypeFloat, pixels.data());
+            if (!ok) {
+                outstream << "maketx ERROR: Could not read pixels of \""
+                          << (infile ? infilename : std::string(src.name()))
+                          << "\"\n";
+                break;
+            }
+            stat_miptime += readtimer();
+            writetimer.reset();
+            writetimer.start();
+            if (outspec.tile_width)
+                ok = out->write_tiles(levelspec.x, levelspec.x + w,
+                                      levelspec.y + y, levelspec.y + yend, z,
+                                      z + 1, TypeFloat, pixels.data());
+            else
+                ok = out->write_scanlines(levelspec.y + y, levelspec.y + yend,
+                                          z, TypeFloat, pixels.data());
+            stat_writetime += writetimer();
+            if (!ok) {
+                outstream << "maketx ERROR writing \"" << outputfilename
+                          << "\" : " << out->geterror() << "\n";
+                break;
+            }
+            if (next) {
+                Timer miptimer;
+                for (int j = 0; j < yend - y && ok; ++j)
+                    ok = next->add_scanline(&pixels[size_t(j) * w * nc]);
+                stat_miptime += miptimer();
+                if (!ok)
+                    outstream << "maketx ERROR: could not write temporary "
+                              << "file \"" << outfilename << "\"\n";
+            }
+        }
+
+        if (infile) {
+            fclose(infile);
+            Filesystem::remove(infilename);
+            infile = nullptr;
+        }
+        if (outfile) {
+            ok &= (fclose(outfile) == 0) && next->done();
+            if (ok)
+                infile = Filesystem::fopen(outfilename, "rb");
+            if (!infile) {
+                Filesystem::remove(outfilename);
+                if (ok)
+                    outstream << "maketx ERROR: could not read temporary "
+                              << "file \"" << outfilename << "\"\n";
+                ok = false;
+            }
+            infilename = outfilename;
+        }
+        if (verbose) {
+            size_t mem = Sysutil::memory_used(true);
+            peak_mem   = std::max(peak_mem, mem);
+            outstream << Strutil::sprintf("    %-15s (%s)",
+                                          formatres(levelspec),
+                                          Strutil::memformat(mem))
+                      << std::endl;
+        }
+        if (!ok || !more)
+            break;
+
+        levelspec = smallspec;
+        writetimer.reset();
+        writetimer.start();
+        if (!out->open(outputfilename.c_str(), levelspec, appendmode)) {
+            outstream << "maketx ERROR: Could not append \"" << outputfilename
+                      << "\" : " << out->geterror() << "\n";
+            ok = false;
+        }
+        stat_writetime += writetimer();
+    }
+    if (infile) {
+        fclose(infile);
+        Filesystem::remove(infilename);
+    }
+
+    writetimer.reset();
+    writetimer.start();
+    if (!out->close() && ok) {
+        outstream << "maketx ERROR writing \"" << outputfilename
+                  << "\" : " << out->geterror() << "\n";
+        ok = false;
+    }
+    stat_writetime += writetimer();
+    if (ok && verbose)
+        outstream << "  Wrote file: " << outputfilename << "  ("
+                  << Strutil::memformat(Sysutil::memory_used(true)) << ")\n";
+    return ok;
+}
+
+
+
 // Deconstruct the command line string, stripping directory names off of
 // any arguments. This is used for "update mode" to not think it's doing
 // a fresh maketx for relative paths and whatnot.
@@ -971,6 +1724,10 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         return false;
     }
 
+    // Private ImageCache for streaming mode. It's declared before any of
+    // the ImageBufs so that it outlives those that refer to it.
+    std::shared_ptr<ImageCache> streamcache;
+
     std::shared_ptr<ImageBuf> src;
     if (input == NULL) {
         // No buffer supplied -- create one to read the file
@@ -1084,7 +1841,81 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     bool read_local     = (src->spec().image_bytes()
                        < imagesize_t(local_mb_thresh * 1024 * 1024));
 
-    bool verbose       = configspec.get_int_attribute("maketx:verbose") != 0;
+    bool verbose = configspec.get_int_attribute("maketx:verbose") != 0;
+
+    // Streaming mode reads the source through a private ImageCache and
+    // builds the whole MIP pyramid a tile row at a time, for images too
+    // big to hold in memory. It can only do that when nothing requires
+    // the whole image at once.
+    bool stream = configspec.get_int_attribute("maketx:stream") != 0;
+    if (stream) {
+        const ImageSpec& spec(src->spec());
+        std::string incs  = configspec.get_string_attribute(
+            "maketx:incolorspace");
+        std::string outcs = configspec.get_string_attribute(
+            "maketx:outcolorspace");
+        std::string fixnan = configspec.get_string_attribute("maketx:fixnan");
+        int nchans = configspec.get_int_attribute("maketx:nchannels", -1);
+        const char* why = nullptr;
+        if (!from_filename)
+            why = "ImageBuf input";
+        else if (mode != ImageBufAlgo::MakeTxTexture
+                 && mode != ImageBufAlgo::MakeTxShadow)
+            why = "environment or bump maps";
+        else if (spec.depth > 1 || spec.x || spec.y || spec.z
+                 || get_roi(spec) != get_roi_full(spec))
+            why = "volumes, crops or overscan";
+        else if (configspec.get_int_attribute("maketx:resize"))
+            why = "resizing";
+        else if (incs.size() && outcs.size() && incs != outcs)
+            why = "color conversion";
+        else if (fixnan.size() && fixnan != "none")
+            why = "fixing NaNs";
+        else if (configspec.get_float_attribute("maketx:sharpen") != 0.0f
+                 || configspec.get_int_attribute("maketx:highlightcomp")
+                 || Strutil::istarts_with(configspec.get_string_attribute(
+                                              "maketx:filtername"),
+                                          "unsharp-"))
+            why = "sharpening or highlight compensation";
+        else if (configspec.get_string_attribute("maketx:mipimages").size())
+            why = "custom MIP levels";
+        else if (nchans > 0 && nchans != spec.nchannels)
+            why = "changing the number of channels";
+        else if (!configspec.get_int_attribute("maketx:forcefloat", 1)
+                 && configspec.get_int_attribute("maketx:allow_pixel_shift"))
+            why = "non-float MIP computation";
+        if (why) {
+            if (verbose)
+                outstream << "  Streaming is not supported with " << why
+                          << ", reading the whole image.\n";
+            stream = false;
+        }
+    }
+    if (stream) {
+        const ImageSpec& spec(src->spec());
+        // Cache enough tile rows for every thread of the parallel passes
+        // over the source (stats, hash) to have its own, plus a few.
+        int tileh = configspec.tile_height ? configspec.tile_height : 64;
+        int nthreads = 0;
+        OIIO::getattribute("threads", nthreads);
+        double tilerow_MB = double(spec.width) * tileh * spec.nchannels
+                            * sizeof(float) / (1024.0 * 1024.0);
+        streamcache.reset(ImageCache::create(false),
+                          [](ImageCache* ic) { ImageCache::destroy(ic); });
+        streamcache->attribute("forcefloat", 1);
+        streamcache->attribute("autotile", tileh);
+        streamcache->attribute("autoscanline", 1);
+        streamcache->attribute("max_memory_MB",
+                               float(std::max(64.0, (nthreads + 4)
+                                                        * tilerow_MB)));
+        src.reset(new ImageBuf(filename, 0, 0, streamcache.get()));
+        src->init_spec(filename, 0, 0);
+        read_local = false;
+        if (verbose)
+            outstream << "  Streaming mode: opaque and monochrome detection "
+                      << "are skipped.\n";
+    }
+
     double misc_time_1 = alltime.lap();
     STATUS("prep", misc_time_1);
     if (from_filename) {
@@ -1194,7 +2025,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     int nchannels = configspec.get_int_attribute("maketx:nchannels", -1);
 
     // If requested -- and alpha is 1.0 everywhere -- drop it.
-    if (opaque_detect && src->spec().alpha_channel == src->nchannels() - 1
+    if (opaque_detect && !stream
+        && src->spec().alpha_channel == src->nchannels() - 1
         && nchannels <= 0 && pixel_stats.min[src->spec().alpha_channel] == 1.0f
         && pixel_stats.max[src->spec().alpha_channel] == 1.0f) {
         if (verbose)
@@ -1207,7 +2039,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     }
 
     // If requested - and we're a monochrome image - drop the extra channels
-    if (configspec.get_int_attribute("maketx:monochrome_detect")
+    if (configspec.get_int_attribute("maketx:monochrome_detect") && !stream
         && nchannels <= 0 && src->nchannels() == 3
         && src->spec().alpha_channel < 0 &&  // RGB only
         ImageBufAlgo::isMonochrome(*src)) {
@@ -1570,7 +2402,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     STATUS("misc3", misc_time_4);
 
     std::shared_ptr<ImageBuf> toplevel;  // Ptr to top level of mipmap
-    if (!do_resize && dstspec.format == src->spec().format) {
+    if (stream || (!do_resize && dstspec.format == src->spec().format)) {
         // No resize needed, no format conversion needed -- just stick to
         // the image we've already got
         toplevel = src;
@@ -1714,10 +2546,17 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
 
     // Write out, and compute, the mipmap levels for the specified image
     bool nomipmap = configspec.get_int_attribute("maketx:nomipmap") != 0;
-    bool ok = write_mipmap(mode, toplevel, dstspec, tmpfilename, out.get(),
-                           out_dataformat, !shadowmode && !nomipmap, filtername,
-                           configspec, outstream, stat_writetime, stat_miptime,
-                           peak_mem);
+    bool ok;
+    if (stream)
+        ok = write_mipmap_streaming(*toplevel, dstspec, tmpfilename, out.get(),
+                                    out_dataformat, !shadowmode && !nomipmap,
+                                    filtername, configspec, outstream,
+                                    stat_writetime, stat_miptime, peak_mem);
+    else
+        ok = write_mipmap(mode, toplevel, dstspec, tmpfilename, out.get(),
+                          out_dataformat, !shadowmode && !nomipmap, filtername,
+                          configspec, outstream, stat_writetime, stat_miptime,
+                          peak_mem);
     out.reset();  // don't need it any more
 
     // If using update mode, stamp the output file with a modification time
@@ -208,6 +208,15 @@ namespace {  // anonymous
 
 static EightBitConverter<float> uchar2float;
 
+// One sample of one MIP level of a lane of a batched environment lookup,
+// padded as the samplers expect, and what it contributes to the lane.
+struct EnvProbe {
+    OIIO_SIMD4_ALIGN float s[4];
+    OIIO_SIMD4_ALIGN float t[4];
+    OIIO_SIMD4_ALIGN float weight[4];
+    vfloat4 r, drds, drdt;
+};
+
 }  // end anonymous namespace
 
 namespace pvt {  // namespace pvt
@@ -426,6 +435,28 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
         minorlength = xfilt;
     }
 
+    bool ok = environment_lookup(*texturefile, thread_info, options, nchannels,
+                                 actualchannels, R, Rmajor, majorlength,
+                                 minorlength, naturalres, result, dresultds,
+                                 dresultdt);
+
+    if (actualchannels < nchannels && options.firstchannel == 0
+        && m_gray_to_rgb)
+        fill_gray_channels(spec, nchannels, result, dresultds, dresultdt);
+
+    return ok;
+}
+
+
+
+bool
+TextureSystemImpl::environment_lookup(
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels, int actualchannels, const Imath::V3f& R,
+    const Imath::V3f& Rmajor, float majorlength, float minorlength,
+    int naturalres, float* result, float* dresultds, float* dresultdt)
+{
+    ImageCacheStatistics& stats(thread_info->m_stats);
     sampler_prototype sampler;
     long long* probecount;
     switch (options.interpmode) {
@@ -469,7 +500,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     }
 
     ImageCacheFile::SubimageInfo& subinfo(
-        texturefile->subimageinfo(options.subimage));
+        texturefile.subimageinfo(options.subimage));
     int min_mip_level = subinfo.min_mip_level;
 
     // FIXME -- assuming latlong
@@ -478,7 +509,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     for (int sample = 0; sample < nsamples; ++sample, pos += invsamples) {
         Imath::V3f Rsamp = R + pos * Rmajor;
         float s, t;
-        vector_to_latlong(Rsamp, texturefile->m_y_up, s, t);
+        vector_to_latlong(Rsamp, texturefile.m_y_up, s, t);
 
         // Determine the MIP-map level(s) we need: we will blend
         //  data(miplevel[0]) * (1-levelblend) + data(miplevel[1]) * levelblend
@@ -539,7 +570,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
             int lev = miplevel[level];
             if (options.interpmode == TextureOpt::InterpSmartBicubic) {
                 if (lev == 0
-                    || (texturefile->spec(options.subimage, lev).full_height
+                    || (texturefile.spec(options.subimage, lev).full_height
                         < naturalres / 2)) {
                     sampler = &TextureSystemImpl::sample_bicubic;
                     ++stats.cubic_interps;
@@ -556,7 +587,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
             OIIO_SIMD4_ALIGN float weight[4]
                 = { levelweight[level] * invsamples, 0.0f, 0.0f, 0.0f };
             vfloat4 r, drds, drdt;
-            ok &= (this->*sampler)(1, sval, tval, miplevel[level], *texturefile,
+            ok &= (this->*sampler)(1, sval, tval, miplevel[level], texturefile,
                                    thread_info, options, nchannels,
                                    actualchannels, weight, &r,
                                    dresultds ? &drds : NULL,
@@ -574,10 +605,6 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     stats.aniso_probes += nsamples;
     ++stats.aniso_queries;
 
-    if (actualchannels < nchannels && options.firstchannel == 0
-        && m_gray_to_rgb)
-        fill_gray_channels(spec, nchannels, result, dresultds, dresultdt);
-
     return ok;
 }
 
@@ -591,52 +618,325 @@ TextureSystemImpl::environment(TextureHandle* texture_handle,
                                int nchannels, float* result, float* dresultds,
                                float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    // Handle >4 channel lookups by recursion, 4 channels at a time.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= environment(texture_handle, thread_info, options, mask, R,
+                              dRdx, dRdy, n, result, dresultds, dresultdt);
+            result += n * Tex::BatchWidth;
+            if (dresultds)
+                dresultds += n * Tex::BatchWidth;
+            if (dresultdt)
+                dresultdt += n * Tex::BatchWidth;
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
+    PerThreadInfo* threadinfo = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle,
+                                                  threadinfo);
+    ImageCacheStatistics& stats(threadinfo->m_stats);
+    ++stats.environment_batches;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++stats.environment_queries;
+
     TextureOpt opt;
-    opt.firstchannel        = options.firstchannel;
-    opt.subimage            = options.subimage;
-    opt.subimagename        = options.subimagename;
-    opt.swrap               = (TextureOpt::Wrap)options.swrap;
-    opt.twrap               = (TextureOpt::Wrap)options.twrap;
-    opt.mipmode             = (TextureOpt::MipMode)options.mipmode;
-    opt.interpmode          = (TextureOpt::InterpMode)options.interpmode;
-    opt.anisotropic         = options.anisotropic;
-    opt.conservative_filter = options.conservative_filter;
-    opt.fill                = options.fill;
-    opt.missingcolor        = options.missingcolor;
-
-    bool ok          = true;
+    batch_uniform_options(options, opt);
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture_batch(opt, mask, nchannels, result, dresultds,
+                                     dresultdt);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int s = m_imagecache->subimage_from_name(texturefile,
+                                                 opt.subimagename);
+        if (s < 0) {
+            errorf("Unknown subimage \"%s\" in texture \"%s\"",
+                   opt.subimagename, texturefile->filename());
+            return missing_texture_batch(opt, mask, nchannels, result,
+                                         dresultds, dresultdt);
+        }
+        opt.subimage = s;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        errorf("Unknown subimage \"%s\" in texture \"%s\"",
+               opt.subimagename, texturefile->filename());
+        return missing_texture_batch(opt, mask, nchannels, result, dresultds,
+                                     dresultdt);
+    }
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Environment maps dictate particular wrap modes
+    opt.swrap = texturefile->m_sample_border
+                    ? TextureOpt::WrapPeriodicSharedBorder
+                    : TextureOpt::WrapPeriodic;
+    opt.twrap = TextureOpt::WrapClamp;
+
+    opt.envlayout      = LayoutLatLong;
+    int actualchannels = Imath::clamp(spec.nchannels - opt.firstchannel, 0,
+                                      nchannels);
+    // As with the single point lookup, the derivatives of the result are
+    // only computed when both are asked for. One asked for on its own is
+    // zeroed.
+    float* dresult[2] = { dresultds, dresultdt };
+    const bool derivs = dresultds && dresultdt;
+
+    // Compute the filter ellipse of all lanes at once: unit-length vectors
+    // in the direction of R, R+dRdx, R+dRdy, and the angles between them.
+    using Tex::FloatWide;
+    const int BW = Tex::BatchWidth;
+    FloatWide Rx(R), Ry(R + BW), Rz(R + 2 * BW);
+    FloatWide Xx = Rx + FloatWide(dRdx), Xy = Ry + FloatWide(dRdx + BW);
+    FloatWide Xz = Rz + FloatWide(dRdx + 2 * BW);
+    FloatWide Yx = Rx + FloatWide(dRdy), Yy = Ry + FloatWide(dRdy + BW);
+    FloatWide Yz = Rz + FloatWide(dRdy + 2 * BW);
+    auto normalize = [](FloatWide& x, FloatWide& y, FloatWide& z) {
+        FloatWide len = sqrt(x * x + y * y + z * z);
+        len           = select(len == 0.0f, FloatWide(1.0f), len);
+        x /= len;
+        y /= len;
+        z /= len;
+    };
+    normalize(Rx, Ry, Rz);  // center
+    normalize(Xx, Xy, Xz);  // x axis of the ellipse
+    normalize(Yx, Yy, Yz);  // y axis of the ellipse
+    alignas(Tex::BatchAlign) float xdot[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float ydot[Tex::BatchWidth];
+    (Rx * Xx + Ry * Xy + Rz * Xz).store(xdot);
+    (Rx * Yx + Ry * Yy + Rz * Yz).store(ydot);
+    for (int i = 0; i < BW; ++i) {
+        xdot[i] = std::max(safe_acos(xdot[i]), 1e-8f);
+        ydot[i] = std::max(safe_acos(ydot[i]), 1e-8f);
+    }
+    FloatWide xfilt_noblur(xdot), yfilt_noblur(ydot);
+    FloatWide natres = float(M_PI) / min(xfilt_noblur, yfilt_noblur);
+
+    // Account for width and blur, and figure out major versus minor axis
+    FloatWide xfilt = xfilt_noblur * FloatWide(options.swidth)
+                      + FloatWide(options.sblur);
+    FloatWide yfilt = yfilt_noblur * FloatWide(options.twidth)
+                      + FloatWide(options.tblur);
+    auto x_is_majoraxis = (xfilt >= yfilt);
+    alignas(Tex::BatchAlign) float Mx[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float My[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float Mz[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float majorlength[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float minorlength[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float naturalres[Tex::BatchWidth];
+    select(x_is_majoraxis, Xx, Yx).store(Mx);
+    select(x_is_majoraxis, Xy, Yy).store(My);
+    select(x_is_majoraxis, Xz, Yz).store(Mz);
+    select(x_is_majoraxis, xfilt, yfilt).store(majorlength);
+    select(x_is_majoraxis, yfilt, xfilt).store(minorlength);
+    natres.store(naturalres);
+    alignas(Tex::BatchAlign) float Rnx[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float Rny[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float Rnz[Tex::BatchWidth];
+    Rx.store(Rnx);
+    Ry.store(Rny);
+    Rz.store(Rnz);
+
+    // The aspect ratio, number of samples and MIP levels of every lane.
+    const bool aniso = (opt.mipmode == TextureOpt::MipModeDefault
+                        || opt.mipmode == TextureOpt::MipModeAniso);
+    alignas(Tex::BatchAlign) float filtwidth[Tex::BatchWidth];
+    int nsamples[Tex::BatchWidth];
+    float invsamples[Tex::BatchWidth];
     Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            Imath::V3f R_(R[i], R[i + Tex::BatchWidth],
-                          R[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdx_(dRdx[i], dRdx[i + Tex::BatchWidth],
-                             dRdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdy_(dRdy[i], dRdy[i + Tex::BatchWidth],
-                             dRdy[i + 2 * Tex::BatchWidth]);
-            if (dresultds) {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r, drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        filtwidth[i]  = 1.0f;
+        nsamples[i]   = 1;
+        invsamples[i] = 1.0f;
+        if (!(mask & bit))
+            continue;
+        if (aniso) {
+            float trueaspect;
+            float aspect = anisotropic_aspect(majorlength[i], minorlength[i],
+                                              opt, trueaspect);
+            filtwidth[i] = minorlength[i];
+            if (trueaspect > stats.max_aniso)
+                stats.max_aniso = trueaspect;
+            nsamples[i]   = std::max(1, (int)ceilf(aspect - 0.25f));
+            invsamples[i] = 1.0f / nsamples[i];
+        } else {
+            filtwidth[i] = opt.conservative_filter ? majorlength[i]
+                                                   : minorlength[i];
+        }
+    }
+    Tex::IntWide levw[2];
+    FloatWide weightw[2];
+    compute_miplevels_batch(*texturefile, opt, true, FloatWide(filtwidth),
+                            FloatWide(filtwidth), NULL, levw, weightw);
+    if (opt.mipmode == TextureOpt::MipModeOneLevel) {
+        // Force use of just one mipmap level
+        levw[1]    = levw[0];
+        weightw[0] = FloatWide(1.0f);
+        weightw[1] = FloatWide::Zero();
+    } else if (opt.mipmode == TextureOpt::MipModeNoMIP) {
+        // Just sample from lowest level
+        const ImageCacheFile::SubimageInfo& subinfo(
+            texturefile->subimageinfo(opt.subimage));
+        levw[0] = levw[1] = Tex::IntWide(subinfo.min_mip_level);
+        weightw[0]        = FloatWide(1.0f);
+        weightw[1]        = FloatWide::Zero();
+    }
+    alignas(Tex::BatchAlign) int miplevel[2][Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float levelweight[2][Tex::BatchWidth];
+    for (int level = 0; level < 2; ++level) {
+        levw[level].store(miplevel[level]);
+        weightw[level].store(levelweight[level]);
+    }
+
+    bool fill_gray = (actualchannels < nchannels && opt.firstchannel == 0
+                      && m_gray_to_rgb);
+    bool ok        = true;
+    auto store_lane = [&](int i, vfloat4& r, vfloat4& drds, vfloat4& drdt) {
+        if (fill_gray)
+            fill_gray_channels(spec, nchannels, (float*)&r,
+                               derivs ? (float*)&drds : NULL,
+                               derivs ? (float*)&drdt : NULL);
+        for (int c = 0; c < nchannels; ++c)
+            result[c * BW + i] = r[c];
+        const vfloat4* dr[2] = { &drds, &drdt };
+        for (int d = 0; d < 2; ++d)
+            if (dresult[d])
+                for (int c = 0; c < nchannels; ++c)
+                    dresult[d][c * BW + i] = (*dr[d])[c];
+    };
+
+    // Lay out the samples of the lanes along their major axes, a group of
+    // lanes at a time. The bilinear samples of all the lanes of a group
+    // are gathered together, so that a tile shared by several of them is
+    // found just once; closest and bicubic samples are done one by one.
+    enum { MaxProbes = 64 };
+    EnvProbe probes[MaxProbes];
+    BilinearJob jobs[MaxProbes];
+    int nprobes = 0, njobs = 0;
+    int grouplanes[Tex::BatchWidth], firstprobe[Tex::BatchWidth + 1];
+    int ngroup = 0;
+    auto flush = [&]() {
+        ok &= sample_bilinear_batch(jobs, njobs, *texturefile, threadinfo,
+                                    opt, nchannels, actualchannels);
+        firstprobe[ngroup] = nprobes;
+        for (int g = 0; g < ngroup; ++g) {
+            vfloat4 r = vfloat4::Zero(), drds = vfloat4::Zero(),
+                    drdt = vfloat4::Zero();
+            for (int p = firstprobe[g]; p < firstprobe[g + 1]; ++p) {
+                r += probes[p].r;
+                if (derivs) {
+                    drds += probes[p].drds;
+                    drdt += probes[p].drdt;
                 }
-            } else {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
+            }
+            store_lane(grouplanes[g], r, drds, drdt);
+        }
+        nprobes = njobs = ngroup = 0;
+    };
+    bit = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        Imath::V3f Rn(Rnx[i], Rny[i], Rnz[i]);
+        Imath::V3f Rmajor(Mx[i], My[i], Mz[i]);
+        int nlevels = (levelweight[0][i] != 0.0f)
+                      + (levelweight[1][i] != 0.0f);
+        if (nsamples[i] * nlevels > MaxProbes) {
+            // Too many samples to group, look this lane up by itself.
+            vfloat4 r = vfloat4::Zero(), drds = vfloat4::Zero(),
+                    drdt = vfloat4::Zero();
+            ok &= environment_lookup(*texturefile, threadinfo, opt, nchannels,
+                                     actualchannels, Rn, Rmajor,
+                                     majorlength[i], minorlength[i],
+                                     int(naturalres[i]), (float*)&r,
+                                     derivs ? (float*)&drds : NULL,
+                                     derivs ? (float*)&drdt : NULL);
+            store_lane(i, r, drds, drdt);
+            continue;
+        }
+        if (nprobes + nsamples[i] * nlevels > MaxProbes)
+            flush();
+        grouplanes[ngroup] = i;
+        firstprobe[ngroup] = nprobes;
+        ++ngroup;
+
+        // FIXME -- assuming latlong
+        float pos = -0.5f + 0.5f * invsamples[i];
+        for (int sample = 0; sample < nsamples[i];
+             ++sample, pos += invsamples[i]) {
+            Imath::V3f Rsamp = Rn + pos * Rmajor;
+            float s, t;
+            vector_to_latlong(Rsamp, texturefile->m_y_up, s, t);
+            for (int level = 0; level < 2; ++level) {
+                if (!levelweight[level][i])
+                    continue;
+                int lev = miplevel[level][i];
+                EnvProbe& probe(probes[nprobes++]);
+                for (int j = 0; j < 4; ++j) {
+                    probe.s[j]      = j ? 0.0f : s;
+                    probe.t[j]      = j ? 0.0f : t;
+                    probe.weight[j] = j ? 0.0f
+                                        : levelweight[level][i]
+                                              * invsamples[i];
+                }
+                vfloat4* drds = derivs ? &probe.drds : NULL;
+                vfloat4* drdt = derivs ? &probe.drdt : NULL;
+                TextureOpt::InterpMode interp = opt.interpmode;
+                if (interp == TextureOpt::InterpSmartBicubic) {
+                    const ImageSpec& levspec(
+                        texturefile->spec(opt.subimage, lev));
+                    interp = (lev == 0
+                              || levspec.full_height < int(naturalres[i]) / 2)
+                                 ? TextureOpt::InterpBicubic
+                                 : TextureOpt::InterpBilinear;
+                }
+                if (interp == TextureOpt::InterpBilinear) {
+                    BilinearJob& job(jobs[njobs++]);
+                    job.miplevel = lev;
+                    job.nsamples = 1;
+                    job.s        = probe.s;
+                    job.t        = probe.t;
+                    job.weight   = probe.weight;
+                    job.accum    = &probe.r;
+                    job.daccumds = drds;
+                    job.daccumdt = drdt;
+                    ++stats.bilinear_interps;
+                } else if (interp == TextureOpt::InterpClosest) {
+                    ok &= sample_closest(1, probe.s, probe.t, lev,
+                                         *texturefile, threadinfo, opt,
+                                         nchannels, actualchannels,
+                                         probe.weight, &probe.r, drds, drdt);
+                    ++stats.closest_interps;
+                } else {
+                    ok &= sample_bicubic(1, probe.s, probe.t, lev,
+                                         *texturefile, threadinfo, opt,
+                                         nchannels, actualchannels,
+                                         probe.weight, &probe.r, drds, drdt);
+                    ++stats.cubic_interps;
                 }
             }
         }
+        stats.aniso_probes += nsamples[i];
+        ++stats.aniso_queries;
     }
+    if (ngroup)
+        flush();
     return ok;
 }
 
@@ -3,6 +3,8 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -18,6 +20,7 @@
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/optparser.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -28,6 +31,14 @@
 #include <OpenImageIO/ustring.h>
 #include <OpenImageIO/varyingref.h>
 
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <signal.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 #include "imagecache_pvt.h"
 #include "imageio_pvt.h"
 
@@ -109,6 +120,34 @@ redundantbytes_compare(const ImageCacheFileRef& a, const ImageCacheFileRef& b)
 }
 
 
+
+// Retrieve a file's modification time in nanoseconds and its size. The
+// disk and shared tile caches key tiles on these, and whole seconds are
+// too coarse to tell apart a file that was rewritten right after it was
+// first read. (Windows only gets whole seconds, but the size still helps.)
+static bool
+file_stamp(const std::string& path, int64_t& mtime_ns, int64_t& size)
+{
+#ifdef _WIN32
+    mtime_ns = int64_t(Filesystem::last_write_time(path)) * 1000000000;
+    size     = int64_t(Filesystem::file_size(path));
+    return mtime_ns != 0;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+#    ifdef __APPLE__
+    const struct timespec& t(st.st_mtimespec);
+#    else
+    const struct timespec& t(st.st_mtim);
+#    endif
+    mtime_ns = int64_t(t.tv_sec) * 1000000000 + int64_t(t.tv_nsec);
+    size     = int64_t(st.st_size);
+    return true;
+#endif
+}
+
+
 };  // end anonymous namespace
 
 
@@ -120,15 +159,19 @@ void
 ImageCacheStatistics::init()
 {
     // ImageCache stats:
-    find_tile_calls             = 0;
-    find_tile_microcache_misses = 0;
-    find_tile_cache_misses      = 0;
+    find_tile_calls               = 0;
+    find_tile_microcache_misses   = 0;
+    find_tile_microcache_set_hits = 0;
+    find_tile_cache_misses        = 0;
     //    tiles_created = 0;
     //    tiles_current = 0;
     //    tiles_peak = 0;
     files_totalsize        = 0;
     files_totalsize_ondisk = 0;
     bytes_read             = 0;
+    tiles_mapped           = 0;
+    tiles_compressed       = 0;
+    tiles_decompressed     = 0;
     //    open_files_created = 0;
     //    open_files_current = 0;
     //    open_files_peak = 0;
@@ -168,6 +211,7 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     // ImageCache stats:
     find_tile_calls += s.find_tile_calls;
     find_tile_microcache_misses += s.find_tile_microcache_misses;
+    find_tile_microcache_set_hits += s.find_tile_microcache_set_hits;
     find_tile_cache_misses += s.find_tile_cache_misses;
     //    tiles_created += s.tiles_created;
     //    tiles_current += s.tiles_current;
@@ -175,6 +219,9 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     files_totalsize += s.files_totalsize;
     files_totalsize_ondisk += s.files_totalsize_ondisk;
     bytes_read += s.bytes_read;
+    tiles_mapped += s.tiles_mapped;
+    tiles_compressed += s.tiles_compressed;
+    tiles_decompressed += s.tiles_decompressed;
     //    open_files_created += s.open_files_created;
     //    open_files_current += s.open_files_current;
     //    open_files_peak += s.open_files_peak;
@@ -251,6 +298,7 @@ ImageCacheFile::LevelInfo::LevelInfo(const LevelInfo& src)
     , nxtiles(src.nxtiles)
     , nytiles(src.nytiles)
     , nztiles(src.nztiles)
+    , mapped_offsets(std::atomic_load(&src.mapped_offsets))
 {
     int nwords = round_to_multiple(nxtiles * nytiles * nztiles, 64) / 64;
     tiles_read = new atomic_ll[nwords];
@@ -263,7 +311,8 @@ ImageCacheFile::LevelInfo::LevelInfo(const LevelInfo& src)
 ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
                                ImageCachePerThreadInfo* /*thread_info*/,
                                ustring filename, ImageInput::Creator creator,
-                               const ImageSpec* config)
+                               const ImageSpec* config,
+                               ustring resolved_filename)
     : m_filename(filename)
     , m_used(true)
     , m_broken(false)
@@ -293,7 +342,10 @@ ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
     , m_configspec(config ? new ImageSpec(*config) : NULL)
 {
     m_filename_original = m_filename;
-    m_filename = imagecache.resolve_filename(m_filename_original.string());
+    if (resolved_filename.empty())
+        m_filename = imagecache.resolve_filename(m_filename_original.string());
+    else
+        m_filename = resolved_filename;
     // N.B. the file is not opened, the ImageInput is NULL.  This is
     // reflected by the fact that m_validspec is false.
 
@@ -482,6 +534,8 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         configspec = *m_configspec;
     if (imagecache().unassociatedalpha())
         configspec.attribute("oiio:UnassociatedAlpha", 1);
+    if (imagecache().mmap_tiles())
+        configspec.attribute("tiff:tile_offsets", 1);
 
     if (m_inputcreator)
         inp.reset(m_inputcreator());
@@ -554,6 +608,9 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         int max_mip_res = imagecache().max_mip_res();
         int nmip        = 0;
         do {
+            // Tile offsets are looked up only when mapping tiles (see
+            // find_mapped_offsets), so don't keep them in every spec.
+            nativespec.erase_attribute("tiff:tile_offsets");
             tempspec = nativespec;
             if (nmip == 0) {
                 // Things to do on MIP level 0, i.e. once per subimage
@@ -762,6 +819,8 @@ ImageCacheFile::init_from_spec()
         m_fingerprint = ustring(fing);
 
     m_mod_time = Filesystem::last_write_time(m_filename);
+    if (!file_stamp(m_filename.string(), m_mod_time_ns, m_file_size))
+        m_mod_time_ns = m_file_size = 0;
 
     // Set all mipmap level read counts to zero
     int maxmip = 1;
@@ -842,6 +901,204 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info, int subimage,
 
 
 
+/// A read-only memory mapping of a whole file. If the file can't be
+/// mapped, data() is nullptr.
+class MappedFile {
+public:
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size      = 0;
+};
+
+
+
+MappedFile::MappedFile(const std::string& filename)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Strutil::utf8_to_utf16(filename).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0,
+                                            NULL);
+        if (mapping) {
+            m_data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0,
+                                                0);
+            if (m_data)
+                m_size = size_t(size.QuadPart);
+            CloseHandle(mapping);  // the view keeps the mapping alive
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd,
+                       0);
+        if (p != MAP_FAILED) {
+            m_data = (const char*)p;
+            m_size = size_t(st.st_size);
+        }
+    }
+    ::close(fd);  // the mapping stays valid after the descriptor is closed
+#endif
+}
+
+
+
+MappedFile::~MappedFile()
+{
+    if (!m_data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap((void*)m_data, m_size);
+#endif
+}
+
+
+
+const char*
+ImageCacheFile::mapped_tile(ImageCachePerThreadInfo* thread_info,
+                            int subimage, int miplevel, int x, int y, int z,
+                            int chbegin, int chend,
+                            std::shared_ptr<MappedFile>& mapping)
+{
+    if (!imagecache().mmap_tiles())
+        return nullptr;
+    // Only tiles that really are tiles of the file, with all the channels,
+    // cached in the file's own data format.
+    const SubimageInfo& subinfo(subimageinfo(subimage));
+    const ImageSpec& nativespec(this->nativespec(subimage, miplevel));
+    if (subinfo.untiled || (subinfo.unmipped && miplevel != 0) || chbegin != 0
+        || chend != nativespec.nchannels || nativespec.channelformats.size()
+        || nativespec.format != subinfo.datatype)
+        return nullptr;
+
+    // Asking the reader where each tile is, and checking that it's safe
+    // to use in place, is done once per level, not once per tile read.
+    LevelInfo& lev(levelinfo(subimage, miplevel));
+    std::shared_ptr<const std::vector<imagesize_t>> offsets
+        = std::atomic_load(&lev.mapped_offsets);
+    if (!offsets) {
+        recursive_lock_guard guard(m_input_mutex);
+        offsets = std::atomic_load(&lev.mapped_offsets);
+        if (!offsets) {
+            offsets = find_mapped_offsets(thread_info, subimage, miplevel);
+            std::atomic_store(&lev.mapped_offsets, offsets);
+        }
+    }
+    if (offsets->empty())
+        return nullptr;
+    const ImageSpec& spec(lev.spec);
+    int whichtile = ((x - spec.x) / spec.tile_width)
+                    + ((y - spec.y) / spec.tile_height) * lev.nxtiles
+                    + ((z - spec.z) / spec.tile_depth)
+                          * (lev.nxtiles * lev.nytiles);
+    imagesize_t offset = (*offsets)[whichtile];
+    if (offset == LevelInfo::no_offset)
+        return nullptr;
+    mapping = std::atomic_load(&m_mapped);
+    if (!mapping || !mapping->data()) {  // invalidated since
+        mapping.reset();
+        return nullptr;
+    }
+    return mapping->data() + offset;
+}
+
+
+
+std::shared_ptr<const std::vector<imagesize_t>>
+ImageCacheFile::find_mapped_offsets(ImageCachePerThreadInfo* thread_info,
+                                    int subimage, int miplevel)
+{
+    auto offsets = std::make_shared<std::vector<imagesize_t>>();
+    std::shared_ptr<ImageInput> inp = open(thread_info);
+    if (!inp)
+        return offsets;
+    std::shared_ptr<MappedFile> mapping = std::atomic_load(&m_mapped);
+    if (!mapping) {
+        // N.B. If the mapping fails, we still remember it, so we don't
+        // keep trying.
+        mapping = std::make_shared<MappedFile>(m_filename.string());
+        std::atomic_store(&m_mapped, mapping);
+    }
+    if (!mapping->data())
+        return offsets;
+
+    // A reader that knows its tiles may be used in place lists where they
+    // are in the "tiff:tile_offsets" attribute of the level's spec, when
+    // asked to by the configuration hint of the same name.
+    const SubimageInfo& subinfo(subimageinfo(subimage));
+    const LevelInfo& lev(levelinfo(subimage, miplevel));
+    const imagesize_t tilebytes = lev.nativespec.tile_bytes(true);
+    const int ntiles            = lev.nxtiles * lev.nytiles * lev.nztiles;
+    ImageSpec inspec            = inp->spec(subimage, miplevel);
+    const ParamValue* p         = inspec.find_attribute("tiff:tile_offsets");
+    if (!p || p->type().basetype != TypeDesc::UINT64
+        || p->type().basevalues() != size_t(ntiles))
+        return offsets;
+    const uint64_t* tileoffsets = (const uint64_t*)p->data();
+    offsets->resize(ntiles, LevelInfo::no_offset);
+    bool any = false;
+    for (int t = 0; t < ntiles; ++t) {
+        imagesize_t offset = imagesize_t(tileoffsets[t]);
+        if (offset % subinfo.channelsize == 0
+            && offset + tilebytes <= mapping->size()) {
+            (*offsets)[t] = offset;
+            any           = true;
+        }
+    }
+    if (!any) {
+        offsets->clear();
+        return offsets;
+    }
+
+    // SIMD loads may read up to OIIO_SIMD_MAX_SIZE_BYTES past the end of
+    // the last pixel, where a tile we allocate has zeroes. A mapped tile
+    // may only be used in place if those bytes are just as harmless:
+    // either the start of another tile of the same level (so they're
+    // pixels like any a load past an interior pixel would see), or zeroes.
+    // Otherwise they could be anything, even NaNs, and the tile is read
+    // as usual instead.
+    std::vector<imagesize_t> starts;
+    for (auto o : *offsets)
+        if (o != LevelInfo::no_offset)
+            starts.push_back(o);
+    std::sort(starts.begin(), starts.end());
+    for (auto& o : *offsets) {
+        if (o == LevelInfo::no_offset)
+            continue;
+        imagesize_t end = o + tilebytes;
+        if (std::binary_search(starts.begin(), starts.end(), end)
+            && end + OIIO_SIMD_MAX_SIZE_BYTES <= mapping->size())
+            continue;
+        bool zeroes = end + OIIO_SIMD_MAX_SIZE_BYTES <= mapping->size();
+        for (imagesize_t i = 0; zeroes && i < OIIO_SIMD_MAX_SIZE_BYTES; ++i)
+            zeroes = (mapping->data()[end + i] == 0);
+        if (!zeroes)
+            o = LevelInfo::no_offset;
+    }
+    return offsets;
+}
+
+
+
 bool
 ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
                               int subimage, int miplevel, int x, int y, int z,
@@ -888,8 +1145,9 @@ ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
     // tile after the pixels are read.  Well, except that below our call
     // to get_pixels may recursively trigger more tiles to be read, and
     // totally change the microcache.  Simple solution: save & restore it.
-    ImageCacheTileRef oldtile     = thread_info->tile;
-    ImageCacheTileRef oldlasttile = thread_info->lasttile;
+    ImageCacheTileRef oldtile = thread_info->tile;
+    ImageCachePerThreadInfo::TileMicrocache oldmicrocache
+        = thread_info->microcache;
 
     // Auto-mipping will totally thrash the cache if the user unwisely
     // sets it to be too small compared to the image file that needs to
@@ -928,8 +1186,8 @@ ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
     lores.get_pixels(ROI(0, tw, 0, th, 0, 1, chbegin, chend), format, data);
 
     // Restore the microcache to the way it was before.
-    thread_info->tile     = oldtile;
-    thread_info->lasttile = oldlasttile;
+    thread_info->tile       = oldtile;
+    thread_info->microcache = oldmicrocache;
 
     return ok;
 }
@@ -1012,6 +1270,11 @@ ImageCacheFile::read_untiled(ImageCachePerThreadInfo* thread_info,
                                               pixelsize, scanlinesize,
                                               scanlinesize * th);
                     ok &= tile->valid();
+                    TileDiskCache& diskcache(imagecache().diskcache());
+                    if (tile->valid() && diskcache.enabled())
+                        diskcache.write(id, tile->data(),
+                                        tile->memsize()
+                                            - OIIO_SIMD_MAX_SIZE_BYTES);
                     imagecache().add_tile_to_cache(tile, thread_info);
                 }
             }
@@ -1073,6 +1336,7 @@ ImageCacheFile::invalidate()
     recursive_lock_guard guard(m_input_mutex);
     m_mutex_wait_time += input_mutex_timer();
     close();
+    std::atomic_store(&m_mapped, std::shared_ptr<MappedFile>());
     invalidate_spec();
     mark_not_broken();
     m_fingerprint.clear();
@@ -1161,7 +1425,7 @@ ImageCacheFile*
 ImageCacheImpl::find_file(ustring filename,
                           ImageCachePerThreadInfo* thread_info,
                           ImageInput::Creator creator, const ImageSpec* config,
-                          bool replace)
+                          bool replace, ustring resolved_filename)
 {
     // Debugging aid: attribute "substitute_image" forces all image
     // references to be to one named file.
@@ -1186,7 +1450,7 @@ ImageCacheImpl::find_file(ustring filename,
         } else {
             // No such entry in the file cache.  Add it, but don't open yet.
             tf = new ImageCacheFile(*this, thread_info, filename, creator,
-                                    config);
+                                    config, resolved_filename);
             m_files.insert(filename, tf, false);
             newfile = true;
         }
@@ -1214,6 +1478,55 @@ ImageCacheImpl::find_file(ustring filename,
 
 
 
+void
+ImageCacheImpl::find_files(cspan<ustring> filenames,
+                           span<ImageCacheFile*> files,
+                           ImageCachePerThreadInfo* thread_info)
+{
+    OIIO_DASSERT(files.size() >= filenames.size());
+    // Resolving the name of a file we haven't seen before (searchpath
+    // lookups, and asking whether its format is procedural) is the costly
+    // part of adding it to the file cache, and is independent of the other
+    // files, so do that for all the new names in parallel first. With a
+    // substitute image, find_file() ignores the names anyway.
+    std::vector<ustring> resolved(filenames.size());
+    if (m_substitute_image.empty()) {
+        std::vector<int64_t> unseen;
+        for (size_t i = 0, e = filenames.size(); i < e; ++i) {
+            ImageCacheFileRef ref;
+            if (!thread_info->find_file(filenames[i])
+                && !m_files.retrieve(filenames[i], ref))
+                unseen.push_back(int64_t(i));
+        }
+        parallel_for(0, int64_t(unseen.size()), [&](int64_t u) {
+            int64_t i   = unseen[u];
+            resolved[i] = ustring(resolve_filename(filenames[i].string()));
+        });
+    }
+    for (size_t i = 0, e = filenames.size(); i < e; ++i)
+        files[i] = find_file(filenames[i], thread_info, nullptr, nullptr,
+                             false, resolved[i]);
+}
+
+
+
+void
+ImageCacheImpl::get_image_handles(cspan<ustring> filenames,
+                                  span<ImageCacheFile*> handles,
+                                  ImageCachePerThreadInfo* thread_info)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    find_files(filenames, handles, thread_info);
+    // Opening the files is also independent per file. Each worker uses
+    // its own per-thread info for the statistics it gathers.
+    parallel_for(0, int64_t(filenames.size()), [&](int64_t i) {
+        handles[i] = verify_file(handles[i], get_perthread_info());
+    });
+}
+
+
+
 ImageCacheFile*
 ImageCacheImpl::verify_file(ImageCacheFile* tf,
                             ImageCachePerThreadInfo* thread_info,
@@ -1413,6 +1726,681 @@ ImageCacheImpl::set_min_cache_size(long long newsize)
 
 
 
+namespace {
+
+// Header at the start of each disk cache entry, so that we never mistake a
+// truncated, foreign, or older-format file for tile pixels.
+struct DiskCacheHeader {
+    char magic[8];     // "OIIOTILE"
+    uint32_t version;  // disk_cache_version
+    uint32_t pad;
+    uint64_t size;  // bytes of pixel data that follow
+};
+
+static const char disk_cache_magic[8] = { 'O', 'I', 'I', 'O',
+                                          'T', 'I', 'L', 'E' };
+static const uint32_t disk_cache_version = 1;
+
+
+
+// Digest of everything that determines a tile's decoded contents, which
+// keys the tile in the disk and shared memory caches. Return the empty
+// string if the tile should not be cached that way.
+static std::string
+tile_cache_key(const TileID& id)
+{
+    const ImageCacheFile& file(id.file());
+    std::string source;
+    if (!file.fingerprint().empty())
+        source = file.fingerprint().string();
+    else if (file.mod_time_ns())
+        source = Strutil::sprintf("%s@%lld:%lld", file.filename(),
+                                  (long long)file.mod_time_ns(),
+                                  (long long)file.file_size());
+    else if (file.mod_time())
+        source = Strutil::sprintf("%s@%lld", file.filename(),
+                                  (long long)file.mod_time());
+    else
+        return std::string();  // e.g., procedural images: nothing to gain
+
+    // Everything that determines the decoded tile contents goes into the
+    // key: the image itself, which tile, the resolution of its MIP level
+    // (which changes with automip or max_mip_res), the tile size (which
+    // changes with autotile), and the data type and alpha handling of
+    // the cached pixels.
+    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
+    std::string key = Strutil::sprintf(
+        "%d|%s|%d|%d|%d,%d,%d|%d-%d|%dx%dx%d|%dx%dx%d|%s|%d",
+        disk_cache_version, source, id.subimage(), id.miplevel(), id.x(),
+        id.y(), id.z(), id.chbegin(), id.chend(), spec.width, spec.height,
+        spec.depth, spec.tile_width, spec.tile_height, spec.tile_depth,
+        file.datatype(id.subimage()),
+        int(file.imagecache().unassociatedalpha()));
+    return SHA1::digest(key.data(), key.size());
+}
+
+}  // namespace
+
+
+
+void
+TileDiskCache::directory(string_view dir)
+{
+    std::string d = dir;
+    if (d.size() && !Filesystem::is_directory(d)) {
+        std::string err;
+        if (!Filesystem::create_directory(d, err)) {
+            d.clear();  // Can't use it, so disable the disk cache
+        }
+    }
+    {
+        spin_lock lock(m_mutex);
+        if (d == m_dir)
+            return;
+        m_dir     = d;
+        m_enabled = !d.empty();
+    }
+    // Estimate the size of what's already there from earlier processes.
+    long long total = 0;
+    std::vector<std::string> entries;
+    if (d.size() && Filesystem::get_directory_entries(d, entries, true)) {
+        for (auto& e : entries)
+            if (Filesystem::is_regular(e))
+                total += (long long)Filesystem::file_size(e);
+    }
+    m_bytes = total;
+}
+
+
+
+std::string
+TileDiskCache::directory() const
+{
+    spin_lock lock(m_mutex);
+    return m_dir;
+}
+
+
+
+std::string
+TileDiskCache::entry_path(const TileID& id) const
+{
+    std::string digest = tile_cache_key(id);
+    if (digest.empty())
+        return std::string();
+    // Fan out into subdirectories so no single directory gets too big.
+    std::string dir = directory();
+    if (dir.empty())
+        return std::string();
+    return Strutil::sprintf("%s/%s/%s.tile", dir, digest.substr(0, 2),
+                            digest);
+}
+
+
+
+bool
+TileDiskCache::read(const TileID& id, void* data, size_t size)
+{
+    std::string path = entry_path(id);
+    if (path.empty())
+        return false;
+    FILE* fd = Filesystem::fopen(path, "rb");
+    if (!fd) {
+        ++m_misses;
+        return false;
+    }
+    DiskCacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, fd) == 1
+              && !memcmp(header.magic, disk_cache_magic, 8)
+              && header.version == disk_cache_version && header.size == size
+              && fread(data, 1, size, fd) == size;
+    fclose(fd);
+    if (ok) {
+        ++m_hits;
+        m_bytes_read += size;
+        // Mark it as recently used, so trim() deletes it last.
+#ifdef _WIN32
+        Filesystem::last_write_time(path, std::time(nullptr));
+#else
+        utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+#endif
+    } else {
+        ++m_misses;
+    }
+    return ok;
+}
+
+
+
+void
+TileDiskCache::write(const TileID& id, const void* data, size_t size)
+{
+    std::string path = entry_path(id);
+    if (path.empty())
+        return;
+    std::string subdir = Filesystem::parent_path(path);
+    if (!Filesystem::is_directory(subdir))
+        Filesystem::create_directory(subdir);
+    // Write to a uniquely named temporary and then rename it into place,
+    // so that other threads and processes never see a partial entry.
+    std::string tmppath = path + "." + Filesystem::unique_path() + ".tmp";
+    FILE* fd            = Filesystem::fopen(tmppath, "wb");
+    if (!fd)
+        return;
+    DiskCacheHeader header;
+    memcpy(header.magic, disk_cache_magic, 8);
+    header.version = disk_cache_version;
+    header.pad     = 0;
+    header.size    = size;
+    bool ok        = fwrite(&header, sizeof(header), 1, fd) == 1
+              && fwrite(data, 1, size, fd) == size;
+    ok &= (fclose(fd) == 0);
+    if (!ok || !Filesystem::rename(tmppath, path)) {
+        Filesystem::remove(tmppath);
+        return;
+    }
+    ++m_writes;
+    m_bytes_written += size;
+    if ((m_bytes += (long long)(size + sizeof(header))) > m_max_bytes)
+        request_trim();
+}
+
+
+
+TileDiskCache::~TileDiskCache()
+{
+    std::lock_guard<std::mutex> lock(m_trim_mutex);
+    if (m_trim_done.valid())
+        m_trim_done.wait();
+}
+
+
+
+void
+TileDiskCache::request_trim()
+{
+    // Trimming walks the whole directory, which is far too slow to do on
+    // a thread that's looking up a tile, so hand it to the thread pool
+    // (unless one is already under way).
+    if (m_trim_pending.exchange(true))
+        return;
+    // Hold the lock from before the task exists until its future is
+    // stored, so the destructor can't miss a trim that's about to start.
+    std::lock_guard<std::mutex> lock(m_trim_mutex);
+    m_trim_done = default_thread_pool()->push([this](int /*thread_id*/) {
+        trim();
+        m_trim_pending = false;
+    });
+}
+
+
+
+void
+TileDiskCache::trim()
+{
+    std::string dir = directory();
+    std::vector<std::string> entries;
+    if (dir.empty() || !Filesystem::get_directory_entries(dir, entries, true))
+        return;
+
+    // Gather the size and last use time of every entry, and delete the
+    // least recently used ones until we're comfortably below the cap
+    // (so we don't need to do this again right away).
+    struct Entry {
+        int64_t time;
+        int64_t size;
+        std::string path;
+    };
+    std::vector<Entry> all;
+    long long total = 0;
+    for (auto& e : entries) {
+        int64_t time, size;
+        if (!Strutil::ends_with(e, ".tile") || !file_stamp(e, time, size))
+            continue;
+        all.push_back({ time, size, e });
+        total += size;
+    }
+    std::sort(all.begin(), all.end(), [](const Entry& a, const Entry& b) {
+        return a.time < b.time;
+    });
+    long long target = m_max_bytes - m_max_bytes / 10;
+    for (size_t i = 0; i < all.size() && total > target; ++i) {
+        if (Filesystem::remove(all[i].path))
+            total -= all[i].size;
+    }
+    m_bytes = total;
+}
+
+
+
+/// A named shared memory segment holding a fixed number of equally sized
+/// tile slots, which any number of processes may map at once. Everything
+/// in it is guarded by a spin lock in the segment's header, which is only
+/// ever held for a few instructions. The header also lists the processes
+/// attached, and the last one to detach removes the segment's name.
+///
+/// Any process may die at any time, so nothing waits on another process
+/// indefinitely: the lock records the pid of its holder, and a slot being
+/// filled the pid of its filler, and either is taken over if that process
+/// no longer exists.
+class TileSharedSegment {
+public:
+    /// Map the named segment, first creating it with room for about
+    /// `max_bytes` of tiles if it doesn't exist yet. Return an empty
+    /// pointer if it can't be used.
+    static std::shared_ptr<TileSharedSegment> open(const std::string& name,
+                                                   long long max_bytes);
+    ~TileSharedSegment();
+    TileSharedSegment(const TileSharedSegment&) = delete;
+    TileSharedSegment& operator=(const TileSharedSegment&) = delete;
+
+    /// Find or claim the slot for `key` (see TileSharedCache::find).
+    char* find(const std::string& key, size_t size, int& slot, bool& fill);
+    /// The pixels of a claimed slot have been stored (or not, if !ok).
+    void filled(int slot, bool ok);
+    /// Unpin a slot returned by find.
+    void release(int slot);
+
+private:
+    static const uint32_t magic   = 0x4f494953;  // 'OIIS'
+    static const uint32_t version = 2;
+    static const int probes       = 16;  ///< Slots that may hold a key
+    static const int max_procs    = 256;  ///< Attachments we keep track of
+    enum SlotState : uint32_t { Empty, Filling, Ready };
+
+    struct Header {
+        std::atomic<uint32_t> magic;
+        std::atomic<int32_t> lock;  // pid of the process holding it, or 0
+        uint32_t version;
+        uint32_t nslots;
+        uint64_t slot_bytes;
+        int32_t procs[max_procs];  // pid of each attachment, or 0
+    };
+    struct Slot {
+        char key[40];  // hex SHA-1 of the tile key
+        uint32_t size;
+        int32_t refs;  // tiles (in any process) using the pixels
+        uint32_t state;
+        uint32_t used;   // touched since last considered for eviction
+        int32_t filler;  // pid of the process filling it
+    };
+
+    TileSharedSegment() {}
+    static size_t stride()
+    {
+        return round_to_multiple(TileSharedCache::tile_bytes
+                                     + OIIO_SIMD_MAX_SIZE_BYTES,
+                                 size_t(64));
+    }
+    static size_t slots_offset()
+    {
+        return round_to_multiple(sizeof(Header), size_t(64));
+    }
+    static size_t data_offset(uint32_t nslots)
+    {
+        return round_to_multiple(slots_offset() + nslots * sizeof(Slot),
+                                 size_t(4096));
+    }
+    static size_t total_size(uint32_t nslots)
+    {
+        return data_offset(nslots) + nslots * stride();
+    }
+
+    static bool alive(int32_t pid);
+    void lock();
+    void unlock() { m_header->lock.store(0, std::memory_order_release); }
+    char* pixels(int slot) const
+    {
+        return m_base + data_offset(m_header->nslots) + slot * stride();
+    }
+
+    std::string m_name;    ///< Name of the segment
+    int32_t m_pid    = 0;  ///< Our own process id
+    char* m_base     = nullptr;
+    size_t m_size    = 0;
+    Header* m_header = nullptr;
+    Slot* m_slots    = nullptr;
+};
+
+
+
+bool
+TileSharedSegment::alive(int32_t pid)
+{
+#ifdef _WIN32
+    (void)pid;
+    return true;
+#else
+    return kill(pid_t(pid), 0) == 0 || errno != ESRCH;
+#endif
+}
+
+
+
+void
+TileSharedSegment::lock()
+{
+    atomic_backoff backoff;
+    Timer timer(false);
+    double check  = 0.01;
+    int32_t owner = 0;
+    while (!m_header->lock.compare_exchange_weak(owner, m_pid,
+                                                 std::memory_order_acquire)) {
+        // The lock is never held for long, so if we've waited a while,
+        // make sure its holder didn't die holding it, and if so, take it.
+        if (owner && owner != m_pid) {
+            if (!timer.ticking()) {
+                timer.start();
+            } else if (timer() > check) {
+                check += 0.01;
+                if (!alive(owner)
+                    && m_header->lock.compare_exchange_strong(
+                        owner, m_pid, std::memory_order_acquire))
+                    return;
+            }
+        }
+        owner = 0;
+        backoff();
+    }
+}
+
+
+
+std::shared_ptr<TileSharedSegment>
+TileSharedSegment::open(const std::string& name, long long max_bytes)
+{
+    std::shared_ptr<TileSharedSegment> seg;
+#ifdef _WIN32
+    // Not yet supported on Windows
+    (void)name;
+    (void)max_bytes;
+#else
+    std::string shmname = Strutil::starts_with(name, "/") ? name : "/" + name;
+    bool creator        = true;
+    int fd = shm_open(shmname.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd      = shm_open(shmname.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0)
+        return seg;
+
+    // The creator sizes the segment and then initializes its header,
+    // setting the magic number last. Anybody else waits (briefly) for
+    // that to happen.
+    uint32_t nslots = uint32_t(
+        clamp(max_bytes / (long long)stride(), 16LL, 1LL << 30));
+    size_t size = total_size(nslots);
+    bool ok     = true;
+    if (creator) {
+        ok = (ftruncate(fd, off_t(size)) == 0);
+    } else {
+        Timer timer;
+        struct stat st;
+        while ((ok = (fstat(fd, &st) == 0)) && st.st_size == 0
+               && timer() < 1.0)
+            Sysutil::usleep(1000);
+        size = ok ? size_t(st.st_size) : 0;
+        ok &= (size > sizeof(Header));
+    }
+    void* p = ok ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                        0)
+                 : MAP_FAILED;
+    ::close(fd);  // the mapping stays valid after the descriptor is closed
+    if (p == MAP_FAILED) {
+        if (creator)
+            shm_unlink(shmname.c_str());
+        return seg;
+    }
+    seg.reset(new TileSharedSegment);
+    seg->m_name   = shmname;
+    seg->m_pid    = int32_t(getpid());
+    seg->m_base   = (char*)p;
+    seg->m_size   = size;
+    seg->m_header = (Header*)p;
+    seg->m_slots  = (Slot*)(seg->m_base + slots_offset());
+    Header& header(*seg->m_header);
+    if (creator) {
+        // N.B. The new segment is all zero: every slot is already Empty,
+        // and there are no attachments yet.
+        header.lock.store(0);
+        header.version    = version;
+        header.nslots     = nslots;
+        header.slot_bytes = TileSharedCache::tile_bytes;
+        header.magic.store(magic, std::memory_order_release);
+    } else {
+        Timer timer;
+        while (header.magic.load(std::memory_order_acquire) != magic
+               && timer() < 1.0)
+            Sysutil::usleep(1000);
+        if (header.magic.load(std::memory_order_acquire) != magic
+            || header.version != version
+            || header.slot_bytes != TileSharedCache::tile_bytes
+            || total_size(header.nslots) != size) {
+            // Not one of ours, or incompatible: leave it be
+            seg->m_name.clear();
+            seg.reset();
+            return seg;
+        }
+    }
+
+    // Record our attachment, reusing the entry of one that was never
+    // detached because its process died. If there's no room, we still
+    // share the segment, we just don't keep it from being removed.
+    seg->lock();
+    for (int i = 0; i < max_procs; ++i) {
+        if (!header.procs[i] || !alive(header.procs[i])) {
+            header.procs[i] = seg->m_pid;
+            break;
+        }
+    }
+    seg->unlock();
+#endif
+    return seg;
+}
+
+
+
+TileSharedSegment::~TileSharedSegment()
+{
+#ifndef _WIN32
+    if (!m_base)
+        return;
+    // Forget our attachment (and any whose process died without
+    // detaching). If no other process is attached, remove the segment's
+    // name, so it's freed once the last mapping goes away. (A process
+    // that is just now attaching keeps using what it mapped, and the next
+    // one to attach creates a fresh segment.)
+    if (m_name.size()) {
+        bool others = false, forgotten = false;
+        lock();
+        for (int i = 0; i < max_procs; ++i) {
+            int32_t& pid(m_header->procs[i]);
+            if (pid == m_pid && !forgotten) {
+                pid       = 0;
+                forgotten = true;
+            } else if (pid && pid != m_pid && !alive(pid)) {
+                pid = 0;
+            } else if (pid) {
+                others = true;
+            }
+        }
+        unlock();
+        if (!others)
+            shm_unlink(m_name.c_str());
+    }
+    munmap(m_base, m_size);
+#endif
+}
+
+
+
+char*
+TileSharedSegment::find(const std::string& key, size_t size, int& slot,
+                        bool& fill)
+{
+    OIIO_DASSERT(key.size() == sizeof(Slot::key));
+    // The key is a hex digest, so its leading digits are a fine hash, and
+    // one that every process computes the same way.
+    uint32_t nslots = m_header->nslots;
+    uint32_t first  = uint32_t(strtoul(key.substr(0, 8).c_str(), nullptr, 16))
+                     % nslots;
+    fill = false;
+    Timer timer(false);
+    atomic_backoff backoff;
+    for (;;) {
+        lock();
+        int empty = -1, victim = -1, unused = -1;
+        bool busy = false;  // Is somebody else filling it?
+        for (int i = 0; i < probes && !busy; ++i) {
+            int s = int((first + i) % nslots);
+            Slot& sl(m_slots[s]);
+            if (sl.state == Empty) {
+                if (empty < 0)
+                    empty = s;
+            } else if (memcmp(sl.key, key.data(), sizeof(sl.key)) == 0
+                       && sl.size == size) {
+                if (sl.state == Filling) {
+                    // If its filler died before finishing, it would never
+                    // be ready, so we fill it instead.
+                    if (sl.filler == m_pid || alive(sl.filler)) {
+                        busy = true;
+                        break;
+                    }
+                    sl.state = Empty;
+                    sl.refs  = 0;
+                    empty    = s;
+                    break;
+                }
+                ++sl.refs;
+                sl.used = 1;
+                unlock();
+                slot = s;
+                return pixels(s);
+            } else if (sl.state == Ready && sl.refs == 0) {
+                // Second chance: a slot nobody is using may be evicted
+                // only if it hasn't been used since we last looked.
+                if (sl.used) {
+                    sl.used = 0;
+                    if (unused < 0)
+                        unused = s;
+                } else if (victim < 0) {
+                    victim = s;
+                }
+            }
+        }
+        int s = busy ? -1 : empty >= 0 ? empty : victim >= 0 ? victim : unused;
+        if (s >= 0) {
+            // Not present: claim a slot for it
+            Slot& sl(m_slots[s]);
+            memcpy(sl.key, key.data(), sizeof(sl.key));
+            sl.size   = uint32_t(size);
+            sl.refs   = 1;
+            sl.state  = Filling;
+            sl.used   = 1;
+            sl.filler = m_pid;
+            unlock();
+            memset(pixels(s) + size, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+            slot = s;
+            fill = true;
+            return pixels(s);
+        }
+        unlock();
+        // If all the slots it could go in are pinned, the caller will
+        // have to read it privately. If somebody else is filling it, give
+        // them a little while to finish before doing the same.
+        if (!busy)
+            return nullptr;
+        if (!timer.ticking())
+            timer.start();
+        if (timer() > 1.0)
+            return nullptr;
+        backoff();
+    }
+}
+
+
+
+void
+TileSharedSegment::filled(int slot, bool ok)
+{
+    lock();
+    Slot& sl(m_slots[slot]);
+    if (ok) {
+        sl.state = Ready;
+    } else {
+        sl.state = Empty;
+        sl.refs  = 0;
+    }
+    unlock();
+}
+
+
+
+void
+TileSharedSegment::release(int slot)
+{
+    lock();
+    OIIO_DASSERT(m_slots[slot].refs > 0);
+    --m_slots[slot].refs;
+    unlock();
+}
+
+
+
+bool
+TileSharedCache::attach(string_view name)
+{
+    std::shared_ptr<TileSharedSegment> segment;
+    if (name.size()) {
+        segment = TileSharedSegment::open(name, m_max_bytes);
+        if (!segment)
+            return false;
+    }
+    spin_lock lock(m_mutex);
+    m_name    = name;
+    m_segment = segment;
+    m_enabled = (segment != nullptr);
+    return true;
+}
+
+
+
+std::string
+TileSharedCache::name() const
+{
+    spin_lock lock(m_mutex);
+    return m_name;
+}
+
+
+
+char*
+TileSharedCache::find(const TileID& id, size_t size,
+                      std::shared_ptr<TileSharedSegment>& segment, int& slot,
+                      bool& fill)
+{
+    if (size > tile_bytes)
+        return nullptr;
+    std::string key = tile_cache_key(id);
+    if (key.empty())
+        return nullptr;
+    {
+        spin_lock lock(m_mutex);
+        segment = m_segment;
+    }
+    char* pixels = segment ? segment->find(key, size, slot, fill) : nullptr;
+    if (!pixels)
+        segment.reset();
+    else if (fill)
+        ++m_adds;
+    else
+        ++m_hits;
+    return pixels;
+}
+
+
+
 ImageCacheTile::ImageCacheTile(const TileID& id)
     : m_id(id)
     , m_valid(true)
@@ -1463,6 +2451,8 @@ ImageCacheTile::~ImageCacheTile()
     m_id.file().imagecache().decr_tiles(memsize());
     if (m_nofree)
         m_pixels.release();  // release without freeing
+    if (m_shared)
+        m_shared->release(m_shared_slot);
 }
 
 
@@ -1486,18 +2476,75 @@ ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
     ImageCacheFile& file(m_id.file());
     m_channelsize = file.datatype(id().subimage()).size();
     m_pixelsize   = m_id.nchannels() * m_channelsize;
-    size_t size   = memsize_needed();
+    // A tile that the file holds exactly as we need it can be used right
+    // where it sits in the memory-mapped file, with no allocation or copy.
+    if (const char* pels = file.mapped_tile(
+            thread_info, m_id.subimage(), m_id.miplevel(), m_id.x(), m_id.y(),
+            m_id.z(), m_id.chbegin(), m_id.chend(), m_mapping)) {
+        m_nofree = true;  // Don't free the pointer!
+        m_pixels.reset((char*)pels);
+        m_valid = true;
+        ++thread_info->m_stats.tiles_mapped;
+        m_pixels_ready = true;
+        return;
+    }
+    size_t size = memsize_needed();
     OIIO_ASSERT(memsize() == 0 && size > OIIO_SIMD_MAX_SIZE_BYTES);
-    m_pixels.reset(new char[m_pixels_size = size]);
-    // Clear the end pad values so there aren't NaNs sucked up by simd loads
-    memset(m_pixels.get() + size - OIIO_SIMD_MAX_SIZE_BYTES, 0,
-           OIIO_SIMD_MAX_SIZE_BYTES);
-    m_valid = file.read_tile(thread_info, m_id.subimage(), m_id.miplevel(),
-                             m_id.x(), m_id.y(), m_id.z(), m_id.chbegin(),
-                             m_id.chend(), file.datatype(m_id.subimage()),
-                             &m_pixels[0]);
+    size_t tilebytes = size - OIIO_SIMD_MAX_SIZE_BYTES;
+    // If processes share tiles, another may already have read this one,
+    // or else we read it right into the shared store for the others.
+    // Either way, it still counts against our own cache size, so that
+    // our evicting it eventually unpins it.
+    TileSharedCache& sharedcache(file.imagecache().sharedcache());
+    bool fill_shared = false;
+    char* shared     = sharedcache.enabled()
+                       ? sharedcache.find(m_id, tilebytes, m_shared,
+                                          m_shared_slot, fill_shared)
+                       : nullptr;
+    if (shared) {
+        m_nofree = true;  // Don't free the pointer!
+        m_pixels.reset(shared);
+        m_pixels_size = size;
+        if (!fill_shared) {
+            m_valid = true;
+            m_id.file().imagecache().incr_mem(size);
+            m_pixels_ready = true;
+            return;
+        }
+    } else {
+        m_pixels.reset(new char[m_pixels_size = size]);
+        // Clear the end pad values so there aren't NaNs sucked up by simd
+        // loads (the shared store has already done so).
+        memset(m_pixels.get() + tilebytes, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+    }
+    // If there's an on-disk second level cache, try it before going to
+    // the file, and remember what we read from the file in it.
+    TileDiskCache& diskcache(file.imagecache().diskcache());
+    bool from_disk   = diskcache.enabled()
+                     && diskcache.read(m_id, &m_pixels[0], tilebytes);
+    if (from_disk) {
+        m_valid = true;
+    } else {
+        m_valid = file.read_tile(thread_info, m_id.subimage(),
+                                 m_id.miplevel(), m_id.x(), m_id.y(),
+                                 m_id.z(), m_id.chbegin(), m_id.chend(),
+                                 file.datatype(m_id.subimage()), &m_pixels[0]);
+        if (m_valid && diskcache.enabled())
+            diskcache.write(m_id, &m_pixels[0], tilebytes);
+    }
+    if (fill_shared) {
+        m_shared->filled(m_shared_slot, m_valid);
+        if (!m_valid) {
+            // The failed slot has been given back, so don't point into it.
+            m_pixels.release();
+            m_nofree = false;
+            m_shared.reset();
+            m_shared_slot = -1;
+            m_pixels.reset(new char[size]);
+        }
+    }
     m_id.file().imagecache().incr_mem(size);
-    if (m_valid) {
+    if (m_valid && !from_disk) {
         // Figure out if
         ImageCacheFile::LevelInfo& lev(
             file.levelinfo(m_id.subimage(), m_id.miplevel()));
@@ -1511,8 +2558,7 @@ ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
         int64_t oldval  = lev.tiles_read[index].fetch_or(bitmask);
         if (oldval & bitmask)  // Was it previously read?
             file.register_redundant_tile(lev.spec.tile_bytes());
-    } else {
-        // (! m_valid)
+    } else if (!m_valid) {
         m_used = false;  // Don't let it hold mem if invalid
         if (file.mod_time() != Filesystem::last_write_time(file.filename()))
             file.imagecache().errorf(
@@ -1564,6 +2610,173 @@ ImageCacheTile::data(int x, int y, int z, int c) const
 
 
 
+// Rearrange n values of `valsize` bytes each into byte planes (all the
+// first bytes, then all the second bytes, etc.), each stored as the
+// differences between successive bytes. The high bytes of nearby values
+// (such as the sign and exponent of a float or half) tend to be alike,
+// and the low bytes of values that came from lower precision are zero, so
+// the planes have long runs of zeroes that run_length_encode() squeezes.
+static void
+shuffle_bytes(const unsigned char* src, unsigned char* dst, size_t n,
+              int valsize)
+{
+    for (int b = 0; b < valsize; ++b, dst += n) {
+        unsigned char prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char v = src[i * valsize + b];
+            dst[i]          = v - prev;
+            prev            = v;
+        }
+    }
+}
+
+
+
+// The inverse of shuffle_bytes.
+static void
+unshuffle_bytes(const unsigned char* src, unsigned char* dst, size_t n,
+                int valsize)
+{
+    for (int b = 0; b < valsize; ++b, src += n) {
+        unsigned char v = 0;
+        for (size_t i = 0; i < n; ++i) {
+            v += src[i];
+            dst[i * valsize + b] = v;
+        }
+    }
+}
+
+
+
+// Run-length encode n bytes into dst (which must have room for at least
+// n + n / 128 + 1 bytes), returning the encoded size. A control byte c
+// below 128 is followed by one byte to be repeated c + 3 times; otherwise
+// it is followed by c - 127 bytes to be copied. This is much faster to
+// encode and decode than general purpose compression, and gets most of
+// its benefit on shuffled pixels.
+static size_t
+run_length_encode(const unsigned char* src, size_t n, unsigned char* dst)
+{
+    unsigned char* out = dst;
+    for (size_t i = 0; i < n;) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && src[i + run] == src[i])
+            ++run;
+        if (run >= 3) {
+            *out++ = (unsigned char)(run - 3);
+            *out++ = src[i];
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        while (i < n && i - start < 128
+               && !(i + 2 < n && src[i] == src[i + 1]
+                    && src[i] == src[i + 2]))
+            ++i;
+        *out++ = (unsigned char)(127 + (i - start));
+        memcpy(out, src + start, i - start);
+        out += i - start;
+    }
+    return size_t(out - dst);
+}
+
+
+
+// Decode the output of run_length_encode, which must expand to exactly n
+// bytes.
+static bool
+run_length_decode(const unsigned char* src, size_t size, unsigned char* dst,
+                  size_t n)
+{
+    const unsigned char* end = src + size;
+    size_t i                 = 0;
+    while (src < end) {
+        size_t c = *src++;
+        if (c < 128) {
+            if (src == end || i + c + 3 > n)
+                return false;
+            memset(dst + i, *src++, c + 3);
+            i += c + 3;
+        } else {
+            c -= 127;
+            if (size_t(end - src) < c || i + c > n)
+                return false;
+            memcpy(dst + i, src, c);
+            src += c;
+            i += c;
+        }
+    }
+    return i == n;
+}
+
+
+
+ImageCacheTile*
+ImageCacheTile::compress() const
+{
+    if (!compressible())
+        return nullptr;
+    // Reuse scratch space, since we'll be compressing lots of tiles.
+    static thread_local std::vector<unsigned char> planes, buf;
+    size_t rawbytes = m_pixels_size - OIIO_SIMD_MAX_SIZE_BYTES;
+    planes.resize(rawbytes);
+    buf.resize(rawbytes + rawbytes / 128 + 1);
+    shuffle_bytes((const unsigned char*)m_pixels.get(), planes.data(),
+                  rawbytes / m_channelsize, m_channelsize);
+    size_t size = run_length_encode(planes.data(), rawbytes, buf.data());
+    if (size > rawbytes - rawbytes / 8)
+        return nullptr;  // Not worth it
+
+    ImageCacheTile* tile    = new ImageCacheTile(m_id);
+    tile->m_channelsize     = m_channelsize;
+    tile->m_pixelsize       = m_pixelsize;
+    tile->m_sweeps_survived = m_sweeps_survived;  // It has proven useful
+    tile->m_pixels.reset(new char[size]);
+    memcpy(tile->m_pixels.get(), buf.data(), size);
+    tile->m_pixels_size  = size;
+    tile->m_compressed   = 1;
+    tile->m_pixels_ready = true;
+    m_id.file().imagecache().incr_mem(size);
+    return tile;
+}
+
+
+
+bool
+ImageCacheTile::expand()
+{
+    int state = 1;
+    if (!m_compressed.compare_exchange_strong(state, 2)) {
+        // Somebody else is expanding it; wait until they're done.
+        atomic_backoff backoff;
+        while (m_compressed)
+            backoff();
+        return false;
+    }
+    size_t size     = memsize_needed();
+    size_t rawbytes = size - OIIO_SIMD_MAX_SIZE_BYTES;
+    static thread_local std::vector<unsigned char> planes;
+    planes.resize(rawbytes);
+    std::unique_ptr<char[]> pixels(new char[size]);
+    if (run_length_decode((const unsigned char*)m_pixels.get(), m_pixels_size,
+                          planes.data(), rawbytes)) {
+        unshuffle_bytes(planes.data(), (unsigned char*)pixels.get(),
+                        rawbytes / m_channelsize, m_channelsize);
+    } else {
+        m_valid = false;  // Should never happen
+        memset(pixels.get(), 0, rawbytes);
+    }
+    memset(pixels.get() + rawbytes, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+    // N.B. compress() made sure the compressed pixels are smaller.
+    m_id.file().imagecache().incr_mem(size - m_pixels_size);
+    m_pixels.swap(pixels);
+    m_pixels_size = size;
+    m_compressed  = 0;
+    return true;
+}
+
+
+
 ImageCacheImpl::ImageCacheImpl()
     : m_perthread_info(&cleanup_perthread_info)
 {
@@ -1622,6 +2835,7 @@ ImageCacheImpl::init()
 
 ImageCacheImpl::~ImageCacheImpl()
 {
+    set_prefetch_threads(0);
     printstats();
     erase_perthread_info();
 }
@@ -1807,6 +3021,10 @@ ImageCacheImpl::getstats(int level) const
         INTOPT(deduplicate);
         INTOPT(unassociatedalpha);
         INTOPT(failure_retries);
+        if (m_prefetch_threads)
+            INTOPT(prefetch_threads);
+        BOOLOPT(mmap_tiles);
+        BOOLOPT(compress_tiles);
 #undef BOOLOPT
 #undef INTOPT
 #undef STROPT
@@ -1864,6 +3082,13 @@ ImageCacheImpl::getstats(int level) const
                 << 100.0 * (double)stats.find_tile_microcache_misses
                        / (double)stats.find_tile_calls
                 << "%)\n";
+            if (stats.find_tile_microcache_set_hits)
+                out << "    micro-cache set hits : "
+                    << stats.find_tile_microcache_set_hits << " ("
+                    << 100.0 * (double)stats.find_tile_microcache_set_hits
+                           / (double)(stats.find_tile_microcache_set_hits
+                                      + stats.find_tile_microcache_misses)
+                    << "% of lookups past the last tile)\n";
             out << "    main cache misses : " << stats.find_tile_cache_misses
                 << " ("
                 << 100.0 * (double)stats.find_tile_cache_misses
@@ -1872,6 +3097,38 @@ ImageCacheImpl::getstats(int level) const
             out << "    redundant reads: "
                 << (unsigned long long)total_redundant_tiles << " tiles, "
                 << Strutil::memformat(total_redundant_bytes) << "\n";
+            long long evictions = tile_evictions();
+            if (m_diskcache.m_hits || m_diskcache.m_writes)
+                out << "    disk cache : " << m_diskcache.m_hits << " hits, "
+                    << m_diskcache.m_misses << " misses, "
+                    << m_diskcache.m_writes << " tiles written ("
+                    << Strutil::memformat(m_diskcache.m_bytes_read)
+                    << " read, "
+                    << Strutil::memformat(m_diskcache.m_bytes_written)
+                    << " written)\n";
+            if (m_sharedcache.m_hits || m_sharedcache.m_adds)
+                out << "    shared cache : " << m_sharedcache.m_hits
+                    << " hits, " << m_sharedcache.m_adds << " tiles added\n";
+            if (m_stat_tiles_prefetched)
+                out << "    prefetched tiles : " << m_stat_tiles_prefetched
+                    << "\n";
+            if (stats.tiles_mapped)
+                out << "    memory-mapped tiles : " << stats.tiles_mapped
+                    << "\n";
+            if (stats.tiles_compressed)
+                out << "    compressed tiles : " << stats.tiles_compressed
+                    << " compressed, " << stats.tiles_decompressed
+                    << " decompressed\n";
+            if (evictions) {
+                long long lo = m_tile_sweep[0].evictions, hi = lo;
+                for (const auto& shard : m_tile_sweep) {
+                    lo = std::min(lo, (long long)shard.evictions);
+                    hi = std::max(hi, (long long)shard.evictions);
+                }
+                out << "    tile evictions : " << evictions << " (per shard: "
+                    << lo << " min, " << hi << " max, "
+                    << TileCache::nbins() << " shards)\n";
+            }
         }
         out << "    Peak cache memory : " << Strutil::memformat(m_mem_used)
             << "\n";
@@ -2162,6 +3419,10 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         m_failure_retries = *(const int*)val;
     } else if (name == "trust_file_extensions" && type == TypeDesc::INT) {
         m_trust_file_extensions = *(const int*)val;
+    } else if (name == "mmap_tiles" && type == TypeDesc::INT) {
+        m_mmap_tiles = *(const int*)val;
+    } else if (name == "compress_tiles" && type == TypeDesc::INT) {
+        m_compress_tiles = *(const int*)val;
     } else if (name == "latlong_up" && type == TypeDesc::STRING) {
         bool y_up = !strcmp("y", *(const char**)val);
         if (y_up != m_latlong_y_up_default) {
@@ -2171,6 +3432,26 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
     } else if (name == "substitute_image" && type == TypeDesc::STRING) {
         m_substitute_image = ustring(*(const char**)val);
         do_invalidate      = true;
+    } else if (name == "disk_cache_dir" && type == TypeDesc::STRING) {
+        m_diskcache.directory(*(const char**)val);
+    } else if (name == "disk_cache_max_MB" && type == TypeDesc::FLOAT) {
+        m_diskcache.max_bytes(
+            (long long)(*(const float*)val * (long long)(1024 * 1024)));
+    } else if (name == "disk_cache_max_MB" && type == TypeDesc::INT) {
+        m_diskcache.max_bytes((long long)(*(const int*)val)
+                              * (long long)(1024 * 1024));
+    } else if (name == "shared_cache_name" && type == TypeDesc::STRING) {
+        const char* shmname = *(const char**)val;
+        if (!m_sharedcache.attach(shmname))
+            errorf("Could not attach to shared tile cache \"%s\"", shmname);
+    } else if (name == "shared_cache_max_MB" && type == TypeDesc::FLOAT) {
+        m_sharedcache.max_bytes(
+            (long long)(*(const float*)val * (long long)(1024 * 1024)));
+    } else if (name == "shared_cache_max_MB" && type == TypeDesc::INT) {
+        m_sharedcache.max_bytes((long long)(*(const int*)val)
+                                * (long long)(1024 * 1024));
+    } else if (name == "prefetch_threads" && type == TypeInt) {
+        set_prefetch_threads(*(const int*)val);
     } else if (name == "max_mip_res" && type == TypeInt) {
         m_max_mip_res = *(const int*)val;
         do_invalidate = true;
@@ -2200,6 +3481,15 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("max_memory_MB", int, m_max_memory_bytes / (1024 * 1024));
     ATTR_DECODE("statistics:level", int, m_statslevel);
     ATTR_DECODE("max_errors_per_file", int, m_max_errors_per_file);
+    ATTR_DECODE("prefetch_threads", int, m_prefetch_threads);
+    ATTR_DECODE("disk_cache_max_MB", float,
+                m_diskcache.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("disk_cache_max_MB", int,
+                m_diskcache.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("shared_cache_max_MB", float,
+                m_sharedcache.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("shared_cache_max_MB", int,
+                m_sharedcache.max_bytes() / (1024 * 1024));
     ATTR_DECODE("autotile", int, m_autotile);
     ATTR_DECODE("autoscanline", int, m_autoscanline);
     ATTR_DECODE("automip", int, m_automip);
@@ -2209,6 +3499,8 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("deduplicate", int, m_deduplicate);
     ATTR_DECODE("unassociatedalpha", int, m_unassociatedalpha);
     ATTR_DECODE("trust_file_extensions", int, m_trust_file_extensions);
+    ATTR_DECODE("mmap_tiles", int, m_mmap_tiles);
+    ATTR_DECODE("compress_tiles", int, m_compress_tiles);
     ATTR_DECODE("failure_retries", int, m_failure_retries);
     ATTR_DECODE("total_files", int, m_files.size());
     ATTR_DECODE("max_mip_res", int, m_max_mip_res);
@@ -2222,6 +3514,14 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         *(ustring*)val = m_plugin_searchpath;
         return true;
     }
+    if (name == "disk_cache_dir" && type == TypeDesc::STRING) {
+        *(ustring*)val = ustring(m_diskcache.directory());
+        return true;
+    }
+    if (name == "shared_cache_name" && type == TypeDesc::STRING) {
+        *(ustring*)val = ustring(m_sharedcache.name());
+        return true;
+    }
     if (name == "worldtocommon"
         && (type == TypeMatrix || type == TypeDesc(TypeDesc::FLOAT, 16))) {
         *(Imath::M44f*)val = m_Mw2c;
@@ -2251,12 +3551,33 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         return true;
     }
 
+    if (name == "stat:tile_evictions_per_shard"
+        && type.basetype == TypeDesc::INT64 && type.is_sized_array()) {
+        long long* counts = (long long*)val;
+        int n = std::min(type.arraylen, (int)TileCache::nbins());
+        for (int i = 0; i < n; ++i)
+            counts[i] = m_tile_sweep[i].evictions;
+        return true;
+    }
+
     if (Strutil::starts_with(name, "stat:")) {
         // Stats we can just grab
         ATTR_DECODE("stat:cache_memory_used", long long, m_mem_used);
         ATTR_DECODE("stat:tiles_created", int, m_stat_tiles_created);
         ATTR_DECODE("stat:tiles_current", int, m_stat_tiles_current);
         ATTR_DECODE("stat:tiles_peak", int, m_stat_tiles_peak);
+        ATTR_DECODE("stat:tile_evictions", long long, tile_evictions());
+        ATTR_DECODE("stat:tiles_prefetched", long long,
+                    m_stat_tiles_prefetched);
+        ATTR_DECODE("stat:disk_cache_hits", long long, m_diskcache.m_hits);
+        ATTR_DECODE("stat:disk_cache_misses", long long,
+                    m_diskcache.m_misses);
+        ATTR_DECODE("stat:disk_cache_writes", long long,
+                    m_diskcache.m_writes);
+        ATTR_DECODE("stat:shared_cache_hits", long long,
+                    m_sharedcache.m_hits);
+        ATTR_DECODE("stat:shared_cache_adds", long long,
+                    m_sharedcache.m_adds);
         ATTR_DECODE("stat:open_files_created", int, m_stat_open_files_created);
         ATTR_DECODE("stat:open_files_current", int, m_stat_open_files_current);
         ATTR_DECODE("stat:open_files_peak", int, m_stat_open_files_peak);
@@ -2268,6 +3589,8 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:find_tile_calls", long long, stats.find_tile_calls);
         ATTR_DECODE("stat:find_tile_microcache_misses", long long,
                     stats.find_tile_microcache_misses);
+        ATTR_DECODE("stat:find_tile_microcache_set_hits", long long,
+                    stats.find_tile_microcache_set_hits);
         ATTR_DECODE("stat:find_tile_cache_misses", int,
                     stats.find_tile_cache_misses);
         ATTR_DECODE("stat:files_totalsize", long long,
@@ -2275,6 +3598,11 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:image_size", long long, stats.files_totalsize);
         ATTR_DECODE("stat:file_size", long long, stats.files_totalsize_ondisk);
         ATTR_DECODE("stat:bytes_read", long long, stats.bytes_read);
+        ATTR_DECODE("stat:tiles_mapped", long long, stats.tiles_mapped);
+        ATTR_DECODE("stat:tiles_compressed", long long,
+                    stats.tiles_compressed);
+        ATTR_DECODE("stat:tiles_decompressed", long long,
+                    stats.tiles_decompressed);
         ATTR_DECODE("stat:unique_files", int, stats.unique_files);
         ATTR_DECODE("stat:fileio_time", float, stats.fileio_time);
         ATTR_DECODE("stat:fileopen_time", float, stats.fileopen_time);
@@ -2323,6 +3651,8 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
             // otherwise we could deadlock if another thread reading the
             // pixels needs to lock the cache because it's doing automip.
             tile->wait_pixels_ready();
+            if (tile->decompress())
+                ++stats.tiles_decompressed;
             tile->use();
             OIIO_DASSERT(id == tile->id());
             OIIO_DASSERT(tile);
@@ -2388,6 +3718,8 @@ ImageCacheImpl::add_tile_to_cache(ImageCacheTileRef& tile,
         // could, so we'll use their reference, but we need to wait until it
         // has read in the pixels.
         tile->wait_pixels_ready();
+        if (tile->decompress())
+            ++thread_info->m_stats.tiles_decompressed;
     }
 }
 
@@ -2409,83 +3741,117 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
     if (m_mem_used < (long long)m_max_memory_bytes)
         return;
 
-    // Try to grab the tile_sweep_mutex lock. If somebody else holds it,
-    // just return -- leave the memory limit enforcement to whomever is
-    // already in this function, no need for two threads to do it at
-    // once.  If this means we may ephemerally be over the memory limit
-    // (because another thread adds a tile before we have freed enough
-    // here), so be it.
-    if (!m_tile_sweep_mutex.try_lock())
-        return;
-
-    // Now, what we want to do is have a "clock hand" that sweeps across
-    // the cache, releasing tiles that haven't been used for a long
-    // time.  Because of multi-thread, rather than keep an iterator
-    // around for this (which could be invalidated since the last time
-    // we used it), we just remember the tileID of the next tile to
-    // check, then look it up fresh.  That is m_tile_sweep_id.
-
-    // Get a (locked) iterator for the next tile to be examined.
-    TileCache::iterator sweep;
-    if (!m_tile_sweep_id.empty()) {
-        // We saved the sweep_id. Find the iterator corresponding to it.
-        sweep = m_tilecache.find(m_tile_sweep_id);
-        // Note: if the sweep_id is no longer in the table, sweep will be an
-        // empty iterator. That's ok, it will be fixed early in the main
-        // loop below.
+    // Each shard of the tile cache has its own "clock hand" that sweeps
+    // across the tiles of that shard, releasing tiles that haven't been
+    // used since the hand last passed them. A thread that finds us over
+    // the limit takes the next shard in round-robin order, sweeps a
+    // bounded number of its tiles while holding only that shard's lock,
+    // and moves on to the next shard until enough memory is freed. So
+    // any number of threads may enforce the limit concurrently (on
+    // different shards) without serializing on one global lock. If this
+    // means we may ephemerally be over the memory limit (because another
+    // thread adds a tile before we have freed enough here), so be it.
+    //
+    // If we're compressing tiles, a tile that would be released is
+    // instead replaced by a compressed copy of itself, which is released
+    // in turn if the hand comes around again before anybody uses it. The
+    // copy is made in the background (see compress_in_background), so the
+    // thread that merely wanted a tile doesn't pay for it. Threads still
+    // using the original hold references to it, so it's never altered in
+    // place.
+    const size_t nshards = TileCache::nbins();
+    const size_t quantum = 64;  // max tiles examined per shard visit
+    std::vector<ImageCacheTileRef> tocompress;
+    long long pending = 0;  // Memory to be freed by compressing tocompress
+    auto under_limit  = [&]() {
+        return m_mem_used - m_compress_pending_bytes - pending
+               < (long long)m_max_memory_bytes;
+    };
+
+    // Don't spin uncontrollably: two full revolutions of the clock are
+    // enough to release every tile that isn't being used. Also stop if
+    // we keep finding nothing to examine (the cache emptied under us).
+    size_t examined = 0, maxexamine = 2 * m_tilecache.size();
+    for (size_t idle = 0; !under_limit() && examined < maxexamine
+                          && idle < nshards;) {
+        size_t shard  = size_t(m_tile_sweep_next++) % nshards;
+        size_t before = examined;
+        size_t nerased
+            = m_tilecache.sweep_bin(shard, m_tile_sweep[shard].hand, quantum,
+                                    [&](const ImageCacheTileRef& tile) {
+                                        ++examined;
+                                        OIIO_DASSERT(tile);
+                                        if (tile->release())
+                                            return false;
+                                        if (m_compress_tiles
+                                            && tile->compressible()) {
+                                            tocompress.push_back(tile);
+                                            pending += tile->memsize();
+                                        }
+                                        tile->evict();
+                                        return true;
+                                    },
+                                    under_limit);
+        // Tell threads whose microcaches still hold the tiles we let go
+        // of (or replaced by compressed copies) to drop them too, so they
+        // can actually be freed.
+        if (nerased)
+            ++m_evict_epoch;
+        if (tocompress.size())
+            compress_in_background(tocompress, pending, shard);
+        tocompress.clear();
+        pending = 0;
+        if (nerased)
+            m_tile_sweep[shard].evictions += nerased;
+        idle = (examined == before) ? idle + 1 : 0;
     }
+}
 
-    // Loop while we still use too much tile memory.  Also, be careful
-    // of looping for too long, exit the loop if we just keep spinning
-    // uncontrollably.
-    int full_loops = 0;
-    while (m_mem_used >= (long long)m_max_memory_bytes && full_loops < 100) {
-        // If we have fallen off the end of the cache, loop back to the
-        // beginning and increment our full_loops count.
-        if (!sweep) {
-            sweep = m_tilecache.begin();
-            ++full_loops;
-        }
-        // If we're STILL at the end, it must be that somehow the entire
-        // cache is empty.  So just declare ourselves done.
-        if (!sweep)
-            break;
-        OIIO_DASSERT(sweep->second);
 
-        if (!sweep->second->release()) {
-            // This is a tile we should delete.  To keep iterating
-            // safely, we have a good trick:
-            // 1. remember the TileID of the tile to delete
-            TileID todelete = sweep->first;
-            size_t size     = sweep->second->memsize();
-            OIIO_DASSERT(m_mem_used >= (long long)size);
-            // 2. Find the TileID of the NEXT item. We do this by
-            // incrementing the sweep iterator and grabbing its id.
-            ++sweep;
-            m_tile_sweep_id = (sweep ? sweep->first : TileID());
-            // 3. Release the bin lock and erase the tile we wish to delete.
-            sweep.unlock();
-            m_tilecache.erase(todelete);
-            // 4. Re-establish a locked iterator for the next item, since
-            // the old iterator may have been invalidated by the erasure.
-            if (!m_tile_sweep_id.empty())
-                sweep = m_tilecache.find(m_tile_sweep_id);
-        } else {
-            ++sweep;
+
+void
+ImageCacheImpl::compress_in_background(std::vector<ImageCacheTileRef> tiles,
+                                       long long bytes, size_t shard)
+{
+    // Compressing is left to a background job, which replaces each tile in
+    // the cache with a compressed copy of it. Until then their memory
+    // counts as already freed, so that other threads don't evict more
+    // tiles to make up for it. While prefetches are blocked (files are
+    // being invalidated or closed), the tiles are just let go, since the
+    // job could otherwise put stale tiles back after the invalidation.
+    std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    if (m_prefetch_blocked)
+        return;
+    ++m_compress_pending;
+    m_compress_pending_bytes += bytes;
+    default_thread_pool()->push([this, tiles, bytes,
+                                 shard](int /*thread_id*/) mutable {
+        ImageCachePerThreadInfo* thread_info = get_perthread_info();
+        for (auto& tile : tiles) {
+            ImageCacheTileRef compressed(tile->compress());
+            tile.reset();  // Free the original if nobody else is using it
+            if (compressed
+                && m_tilecache.insert(compressed->id(), compressed)) {
+                ++thread_info->m_stats.tiles_compressed;
+                --m_tile_sweep[shard].evictions;
+            }
         }
-    }
+        m_compress_pending_bytes -= bytes;
+        std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+        if (--m_compress_pending == 0)
+            m_prefetch_idle.notify_all();
+    });
+}
 
-    // OK, by this point we have either freed enough tiles to be below
-    // the limit again, or the cache is empty, or we've looped over the
-    // cache too many times and are giving up.
 
-    // Now we must save the tileid for next time.  Just set it to an
-    // empty ID if we don't have a valid iterator at this point.
-    m_tile_sweep_id = (sweep ? sweep->first : TileID());
-    m_tile_sweep_mutex.unlock();
 
-    // N.B. As we exit, the iterators will go out of scope and we will
-    // retain no locks on the cache.
+long long
+ImageCacheImpl::tile_evictions() const
+{
+    long long total = 0;
+    for (const auto& shard : m_tile_sweep)
+        total += shard.evictions;
+    return total;
 }
 
 
@@ -2494,10 +3860,9 @@ std::string
 ImageCacheImpl::resolve_filename(const std::string& filename) const
 {
     // Ask if the format can generate imagery procedurally. If so, don't
-    // go looking for a file.
-    auto input      = ImageInput::create(filename);
-    bool procedural = input ? input->supports("procedural") : false;
-    if (procedural)
+    // go looking for a file. The answer is cached per format, so this
+    // doesn't need to instantiate a reader for every new filename.
+    if (pvt::input_format_supports(filename, "procedural"))
         return filename;
     // don't bother with the searchpath_find call since it will do an existence
     // check that we don't need
@@ -3185,6 +4550,133 @@ ImageCacheImpl::tile_pixels(ImageCache::Tile* tile, TypeDesc& format) const
 
 
 
+bool
+ImageCacheImpl::prefetch(ustring filename, int subimage, int miplevel,
+                         int xbegin, int xend, int ybegin, int yend,
+                         int zbegin, int zend, int chbegin, int chend)
+{
+    if (!m_prefetch_threads)
+        return false;
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file                 = find_file(filename, thread_info);
+    return prefetch(file, thread_info, subimage, miplevel, xbegin, xend,
+                    ybegin, yend, zbegin, zend, chbegin, chend);
+}
+
+
+
+bool
+ImageCacheImpl::prefetch(ImageHandle* file, Perthread* thread_info,
+                         int subimage, int miplevel, int xbegin, int xend,
+                         int ybegin, int yend, int zbegin, int zend,
+                         int chbegin, int chend)
+{
+    if (!m_prefetch_threads)
+        return false;
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (!file || file->broken() || file->is_udim())
+        return false;
+    if (subimage < 0 || subimage >= file->subimages() || miplevel < 0
+        || miplevel >= file->miplevels(subimage))
+        return false;
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    if (chend < chbegin)
+        chend = spec.nchannels;
+
+    // Clamp the region to the data window and snap it to tile corners.
+    int tw = std::max(spec.tile_width, 1);
+    int th = std::max(spec.tile_height, 1);
+    int td = std::max(spec.tile_depth, 1);
+    xbegin = std::max(xbegin, spec.x);
+    ybegin = std::max(ybegin, spec.y);
+    zbegin = std::max(zbegin, spec.z);
+    xend   = std::min(xend, spec.x + spec.width);
+    yend   = std::min(yend, spec.y + spec.height);
+    zend   = std::min(zend, spec.z + spec.depth);
+    xbegin = spec.x + ((xbegin - spec.x) / tw) * tw;
+    ybegin = spec.y + ((ybegin - spec.y) / th) * th;
+    zbegin = spec.z + ((zbegin - spec.z) / td) * td;
+
+    // These are only hints, so rather than letting the queue grow without
+    // bound when we're asked for far more than the I/O threads can keep
+    // up with, drop the ones that don't fit. The lock is only held to
+    // queue each tile, so invalidate() and friends never wait behind a
+    // long region.
+    const int max_pending = 256 * m_prefetch_threads;
+    for (int z = zbegin; z < zend; z += td) {
+        for (int y = ybegin; y < yend; y += th) {
+            for (int x = xbegin; x < xend; x += tw) {
+                TileID id(*file, subimage, miplevel, x, y, z, chbegin, chend);
+                if (tile_in_cache(id, thread_info))
+                    continue;
+                std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+                if (!m_prefetch_pool || m_prefetch_blocked)
+                    return false;
+                if (m_prefetch_pending >= max_pending)
+                    return true;
+                ++m_prefetch_pending;
+                m_prefetch_pool->push([this, id](int /*thread_id*/) {
+                    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+                    if (!tile_in_cache(id, thread_info)) {
+                        ImageCacheTileRef tile = new ImageCacheTile(id);
+                        add_tile_to_cache(tile, thread_info);
+                        ++m_stat_tiles_prefetched;
+                    }
+                    std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+                    if (--m_prefetch_pending == 0)
+                        m_prefetch_idle.notify_all();
+                });
+            }
+        }
+    }
+    return true;
+}
+
+
+
+void
+ImageCacheImpl::set_prefetch_threads(int n)
+{
+    n = std::max(n, 0);
+    // Resizing a thread_pool is not safe while its jobs are running, so
+    // let everything queued finish first.
+    PrefetchBlocker blocker(*this);
+    std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    if (n == 0)
+        m_prefetch_pool.reset();
+    else if (!m_prefetch_pool)
+        m_prefetch_pool.reset(new thread_pool(n));
+    else if (m_prefetch_pool->size() != n)
+        m_prefetch_pool->resize(n);
+    m_prefetch_threads = n;
+}
+
+
+
+void
+ImageCacheImpl::block_prefetch()
+{
+    std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+    ++m_prefetch_blocked;
+    m_prefetch_idle.wait(lock, [&]() {
+        return m_prefetch_pending == 0 && m_compress_pending == 0;
+    });
+}
+
+
+
+void
+ImageCacheImpl::unblock_prefetch()
+{
+    std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+    OIIO_DASSERT(m_prefetch_blocked > 0);
+    --m_prefetch_blocked;
+}
+
+
+
 bool
 ImageCacheImpl::add_file(ustring filename, ImageInput::Creator creator,
                          const ImageSpec* config, bool replace)
@@ -3238,6 +4730,7 @@ ImageCacheImpl::add_tile(ustring filename, int subimage, int miplevel, int x,
 void
 ImageCacheImpl::invalidate(ustring filename, bool force)
 {
+    PrefetchBlocker blocker(*this);
     ImageCacheFileRef file;
     {
         bool found = m_files.retrieve(filename, file);
@@ -3287,6 +4780,7 @@ ImageCacheImpl::invalidate(ustring filename, bool force)
 void
 ImageCacheImpl::invalidate_all(bool force)
 {
+    PrefetchBlocker blocker(*this);
     // Special case: invalidate EVERYTHING -- we can take some shortcuts
     // to do it all in one shot.
     if (force) {
@@ -3375,6 +4869,7 @@ ImageCacheImpl::invalidate_all(bool force)
 void
 ImageCacheImpl::close(ustring filename)
 {
+    PrefetchBlocker blocker(*this);
     auto f = m_files.find(filename);
     if (f != m_files.end())
         f->second->close();
@@ -3385,6 +4880,7 @@ ImageCacheImpl::close(ustring filename)
 void
 ImageCacheImpl::close_all()
 {
+    PrefetchBlocker blocker(*this);
     for (auto& f : m_files)
         f.second->close();
 }
@@ -3498,12 +4994,12 @@ ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
         m_all_perthread_info.push_back(p);
         p->shared = true;  // both the IC and the thread point to it
     }
-    if (p->purge) {  // has somebody requested a tile purge?
+    int epoch = m_microcache_epoch;
+    if (p->epoch != epoch) {  // has somebody requested a tile purge?
         // This is safe, because it's our thread.
         spin_lock lock(m_perthread_info_mutex);
-        p->tile     = NULL;
-        p->lasttile = NULL;
-        p->purge    = 0;
+        p->clear_microcache();
+        p->epoch = epoch;
         p->m_thread_files.clear();
     }
     return p;
@@ -3519,8 +5015,7 @@ ImageCacheImpl::erase_perthread_info()
         ImageCachePerThreadInfo* p = m_all_perthread_info[i];
         if (p) {
             // Clear the microcache.
-            p->tile     = NULL;
-            p->lasttile = NULL;
+            p->clear_microcache();
             if (p->shared) {
                 // Pointed to by both thread-specific-ptr and our list.
                 // Just remove from out list, then ownership is only
@@ -3543,8 +5038,7 @@ ImageCacheImpl::cleanup_perthread_info(ImageCachePerThreadInfo* p)
     spin_lock lock(m_perthread_info_mutex);
     if (p) {
         // Clear the microcache.
-        p->tile     = NULL;
-        p->lasttile = NULL;
+        p->clear_microcache();
         if (!p->shared)  // If we own it, delete it
             delete p;
         else
@@ -3554,18 +5048,6 @@ ImageCacheImpl::cleanup_perthread_info(ImageCachePerThreadInfo* p)
 
 
 
-void
-ImageCacheImpl::purge_perthread_microcaches()
-{
-    // Mark the per-thread microcaches as invalid
-    spin_lock lock(m_perthread_info_mutex);
-    for (size_t i = 0, e = m_all_perthread_info.size(); i < e; ++i)
-        if (m_all_perthread_info[i])
-            m_all_perthread_info[i]->purge = 1;
-}
-
-
-
 std::string
 ImageCacheImpl::geterror() const
 {
@@ -3631,6 +5113,41 @@ ImageCache::create(bool shared)
 
 
 
+void
+ImageCache::get_image_handles(cspan<ustring> filenames,
+                              span<ImageHandle*> handles,
+                              Perthread* thread_info)
+{
+    ((ImageCacheImpl*)this)->get_image_handles(filenames, handles,
+                                               thread_info);
+}
+
+
+
+bool
+ImageCache::prefetch(ustring filename, int subimage, int miplevel, int xbegin,
+                     int xend, int ybegin, int yend, int zbegin, int zend,
+                     int chbegin, int chend)
+{
+    return ((ImageCacheImpl*)this)
+        ->prefetch(filename, subimage, miplevel, xbegin, xend, ybegin, yend,
+                   zbegin, zend, chbegin, chend);
+}
+
+
+
+bool
+ImageCache::prefetch(ImageHandle* file, Perthread* thread_info, int subimage,
+                     int miplevel, int xbegin, int xend, int ybegin, int yend,
+                     int zbegin, int zend, int chbegin, int chend)
+{
+    return ((ImageCacheImpl*)this)
+        ->prefetch(file, thread_info, subimage, miplevel, xbegin, xend, ybegin,
+                   yend, zbegin, zend, chbegin, chend);
+}
+
+
+
 void
 ImageCache::destroy(ImageCache* x, bool teardown)
 {
@@ -10,6 +10,10 @@
 #ifndef OPENIMAGEIO_IMAGECACHE_PVT_H
 #define OPENIMAGEIO_IMAGECACHE_PVT_H
 
+#include <array>
+#include <condition_variable>
+#include <future>
+
 #include <tsl/robin_map.h>
 
 #include <boost/container/flat_map.hpp>
@@ -22,6 +26,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/refcnt.h>
 #include <OpenImageIO/texture.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unordered_map_concurrent.h>
 
@@ -47,6 +52,8 @@ using boost::thread_specific_ptr;
 
 class ImageCacheImpl;
 class ImageCachePerThreadInfo;
+class MappedFile;
+class TileSharedSegment;
 
 const char*
 texture_format_name(TexFormat f);
@@ -70,10 +77,14 @@ struct ImageCacheStatistics {
     // First, the ImageCache-specific fields:
     long long find_tile_calls;
     long long find_tile_microcache_misses;
+    long long find_tile_microcache_set_hits;
     int find_tile_cache_misses;
     long long files_totalsize;
     long long files_totalsize_ondisk;
     long long bytes_read;
+    long long tiles_mapped;
+    long long tiles_compressed;
+    long long tiles_decompressed;
     // These stats are hard to deal with on a per-thread basis, so for
     // now, they are still atomics shared by the whole IC.
     // int tiles_created;
@@ -131,7 +142,8 @@ public:
     ImageCacheFile(ImageCacheImpl& imagecache,
                    ImageCachePerThreadInfo* thread_info, ustring filename,
                    ImageInput::Creator creator = nullptr,
-                   const ImageSpec* config     = nullptr);
+                   const ImageSpec* config     = nullptr,
+                   ustring resolved_filename   = ustring());
     ~ImageCacheFile();
 
     void reset(ImageInput::Creator creator, const ImageSpec* config);
@@ -172,6 +184,22 @@ public:
                    int miplevel, int x, int y, int z, int chbegin, int chend,
                    TypeDesc format, void* data);
 
+    /// If the cache memory-maps tiles, and the file stores this tile
+    /// exactly as the cache would hold it in memory, return a pointer to
+    /// its pixels within the memory-mapped file, and set `mapping` to a
+    /// reference that keeps the mapping alive. Otherwise return nullptr.
+    const char* mapped_tile(ImageCachePerThreadInfo* thread_info,
+                            int subimage, int miplevel, int x, int y, int z,
+                            int chbegin, int chend,
+                            std::shared_ptr<MappedFile>& mapping);
+
+    /// Find the offsets of all the tiles of a level that can be used in
+    /// place in the memory-mapped file, mapping it if need be. Call with
+    /// m_input_mutex held.
+    std::shared_ptr<const std::vector<imagesize_t>>
+    find_mapped_offsets(ImageCachePerThreadInfo* thread_info, int subimage,
+                        int miplevel);
+
     /// Mark the file as recently used.
     ///
     void use(void) { m_used = true; }
@@ -219,6 +247,10 @@ public:
     }
 
     std::time_t mod_time() const { return m_mod_time; }
+    /// Modification time in nanoseconds and size of the file, or 0 if
+    /// they couldn't be determined.
+    int64_t mod_time_ns() const { return m_mod_time_ns; }
+    int64_t file_size() const { return m_file_size; }
     ustring fingerprint() const { return m_fingerprint; }
     void duplicate(ImageCacheFile* dup) { m_duplicate = dup; }
     ImageCacheFile* duplicate() const { return m_duplicate; }
@@ -238,6 +270,12 @@ public:
         mutable std::vector<float> polecolor;  ///< Pole colors
         int nxtiles, nytiles, nztiles;  ///< Number of tiles in each dimension
         atomic_ll* tiles_read;  ///< Bitfield for tiles read at least once
+        /// Where each tile sits in the memory-mapped file, or no_offset
+        /// for tiles that can't be used in place. Found the first time a
+        /// tile of the level is wanted (only access with atomic_load and
+        /// atomic_store); empty if the level can't be mapped at all.
+        std::shared_ptr<const std::vector<imagesize_t>> mapped_offsets;
+        static const imagesize_t no_offset = ~imagesize_t(0);
         LevelInfo(const ImageSpec& spec,
                   const ImageSpec& nativespec);  ///< Initialize based on spec
         LevelInfo(const LevelInfo& src);         // needed for vector<LevelInfo>
@@ -366,6 +404,8 @@ private:
     ImageCacheImpl& m_imagecache;        ///< Back pointer for ImageCache
     mutable recursive_mutex m_input_mutex;  ///< Mutex protecting the ImageInput
     std::time_t m_mod_time;                 ///< Time file was last updated
+    int64_t m_mod_time_ns = 0;              ///< ... in nanoseconds
+    int64_t m_file_size   = 0;              ///< Size of the file on disk
     ustring m_fingerprint;          ///< Optional cryptographic fingerprint
     ImageCacheFile* m_duplicate;    ///< Is this a duplicate?
     imagesize_t m_total_imagesize;  ///< Total size, uncompressed
@@ -374,6 +414,8 @@ private:
     std::unique_ptr<ImageSpec> m_configspec;  // Optional configuration hints
     UdimLookupMap m_udim_lookup;              ///< Used for decoding udim tiles
                                               // protected by mutex elsewhere!
+    std::shared_ptr<MappedFile> m_mapped;  ///< Memory-mapped file, if used
+        // Like m_input, only access m_mapped with atomic_load/atomic_store.
 
     /// Thread-safe retrieve a shared pointer to the ImageInput. The one
     /// returned is safe to use as long as the caller is holding the
@@ -446,7 +488,14 @@ struct TileID {
     /// Default constructor
     ///
     TileID()
-        : m_file(nullptr)
+        : m_x(0)
+        , m_y(0)
+        , m_z(0)
+        , m_subimage(0)
+        , m_miplevel(0)
+        , m_chbegin(0)
+        , m_chend(0)
+        , m_file(nullptr)
     {
     }
 
@@ -598,6 +647,33 @@ public:
     /// Return a pointer to half data
     const half* halfdata(void) const { return (half*)&m_pixels[0]; }
 
+    /// Should the pixels be kept compressed when the tile goes cold? Only
+    /// tiles that own their pixels qualify, and only if they were used
+    /// again after the paging clock first passed them, since tiles that
+    /// are used just once are the bulk of what's paged out and aren't
+    /// worth compressing.
+    bool compressible() const
+    {
+        return m_valid && m_pixels_ready && !m_nofree && !m_compressed
+               && m_pixels_size > OIIO_SIMD_MAX_SIZE_BYTES
+               && m_sweeps_survived > 1;
+    }
+
+    /// Return a new tile holding a losslessly compressed copy of this
+    /// tile's pixels, or nullptr if they don't compress enough to be
+    /// worth the trouble. The new tile must be decompress()'ed before
+    /// its pixels are used.
+    ImageCacheTile* compress() const;
+
+    /// Are the pixels held compressed (see compress())?
+    bool compressed() const { return m_compressed != 0; }
+
+    /// If the pixels are compressed, expand them in place, or wait for
+    /// the thread already doing so. Return true if this call expanded
+    /// them. This is thread-safe, and must be called before using the
+    /// pixels of any tile found in the main cache.
+    bool decompress() { return m_compressed ? expand() : false; }
+
     /// Return the id for this tile.
     ///
     const TileID& id(void) const { return m_id; }
@@ -625,13 +701,23 @@ public:
         // If m_used is 1, set it to zero and return true.  If it was already
         // zero, it's fine and return false.
         int one = 1;
-        return m_used.compare_exchange_strong(one, 0);
+        if (!m_used.compare_exchange_strong(one, 0))
+            return false;
+        ++m_sweeps_survived;
+        return true;
     }
 
     /// Has this tile been recently used?
     ///
     int used(void) const { return m_used; }
 
+    /// Note that the main cache has let go of this tile, so that threads
+    /// whose microcaches still hold it know to let go of it too.
+    void evict() { m_evicted = 1; }
+
+    /// Has the main cache let go of this tile?
+    bool evicted() const { return m_evicted; }
+
     bool valid(void) const { return m_valid; }
 
     /// Are the pixels ready for use?  If false, they're still being
@@ -653,10 +739,18 @@ private:
     int m_pixelsize { 0 };             ///< How big is each pixel (bytes)
     bool m_valid { false };            ///< Valid pixels
     bool m_nofree { false };  ///< We do NOT own the pixels, do not free!
+    std::shared_ptr<MappedFile> m_mapping;  ///< Holds mapped pixels, if any
+    std::shared_ptr<TileSharedSegment> m_shared;  ///< Holds shared pixels
+    int m_shared_slot { -1 };  ///< Slot of m_shared holding our pixels
     volatile bool m_pixels_ready {
         false
     };                        ///< The pixels have been read from disk
-    atomic_int m_used { 1 };  ///< Used recently
+    atomic_int m_used { 1 };        ///< Used recently
+    atomic_int m_evicted { 0 };     ///< The main cache let go of it
+    int m_sweeps_survived { 0 };    ///< Times release() found it used
+    atomic_int m_compressed { 0 };  ///< 1 = compressed, 2 = being expanded
+
+    bool expand();
 };
 
 
@@ -675,6 +769,123 @@ typedef unordered_map_concurrent<
     TileCache;
 
 
+/// Optional persistent, on-disk "second level" cache of decoded tiles. It
+/// is consulted when a tile is not in memory, before reading the tile
+/// from its image file, and tiles read from image files are added to it.
+/// Entries are keyed by the file's fingerprint (or its name and
+/// modification time, if it has no fingerprint) and everything that
+/// determines the tile's decoded contents, so a file that changes on disk
+/// simply stops matching its old entries. The total size of the directory
+/// is held under a cap by deleting the least recently used entries, and
+/// the entries persist across processes.
+class TileDiskCache {
+public:
+    TileDiskCache() {}
+    ~TileDiskCache();
+    TileDiskCache(const TileDiskCache&) = delete;
+    TileDiskCache& operator=(const TileDiskCache&) = delete;
+
+    /// Set the directory to use (empty disables the disk cache).
+    void directory(string_view dir);
+    std::string directory() const;
+
+    /// Set/get the size cap, in bytes.
+    void max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    bool enabled() const { return m_enabled; }
+
+    /// Try to retrieve the pixels of the tile `id` (exactly `size`
+    /// bytes, in the cache's native data layout for the tile) into
+    /// `data`.  Return true if found.
+    bool read(const TileID& id, void* data, size_t size);
+
+    /// Store the `size` bytes of tile pixels for `id`.
+    void write(const TileID& id, const void* data, size_t size);
+
+    // Statistics
+    atomic_ll m_hits { 0 };
+    atomic_ll m_misses { 0 };
+    atomic_ll m_writes { 0 };
+    atomic_ll m_bytes_read { 0 };
+    atomic_ll m_bytes_written { 0 };
+
+private:
+    /// Compute the path of the entry for a tile, or return the empty
+    /// string if the tile should not be cached.
+    std::string entry_path(const TileID& id) const;
+    /// Start a trim() on a pool thread, unless one is already running.
+    void request_trim();
+    /// Delete the least recently used entries until we're under the cap.
+    void trim();
+
+    mutable spin_mutex m_mutex;  ///< Protect m_dir
+    std::string m_dir;           ///< Directory holding the entries
+    std::atomic<bool> m_enabled { false };
+    atomic_ll m_max_bytes { 4LL * 1024 * 1024 * 1024 };
+    atomic_ll m_bytes { 0 };  ///< Estimated size of the directory
+    std::atomic<bool> m_trim_pending { false };  ///< Trim is under way
+    std::future<void> m_trim_done;  ///< Completion of the latest trim
+    std::mutex m_trim_mutex;        ///< Protect m_trim_done
+};
+
+
+
+/// Optional store of decoded tiles in a named shared memory segment,
+/// shared by all the processes on the host that attach to the same name,
+/// so that the host holds just one copy of each tile. It is consulted
+/// when a tile is not in memory, before the disk cache or the image file,
+/// and tiles read by any process are put there for the others. Tiles are
+/// used in place, pinned by a count of the tiles (in any process) that
+/// point to them, and only unpinned tiles are evicted. Entries are keyed
+/// like those of the TileDiskCache. Tiles larger than tile_bytes are not
+/// shared.
+class TileSharedCache {
+public:
+    TileSharedCache() {}
+    TileSharedCache(const TileSharedCache&) = delete;
+    TileSharedCache& operator=(const TileSharedCache&) = delete;
+
+    /// The largest tile that can be shared, in bytes.
+    static const size_t tile_bytes = 64 * 1024;
+
+    /// Attach to the named segment, creating it (with room for about
+    /// max_bytes() of tiles) if no process has yet. An empty name
+    /// detaches. Return false if the segment can't be used.
+    bool attach(string_view name);
+    std::string name() const;
+
+    /// Set/get the size of a segment that we create, in bytes.
+    void max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    bool enabled() const { return m_enabled; }
+
+    /// Look up the pixels of tile `id` (exactly `size` bytes, in the
+    /// cache's native data layout for the tile). If found, pin them and
+    /// return a pointer to them, and set `segment` and `slot` for the
+    /// eventual segment->release(slot). If not found, but there's room to
+    /// add it, do the same but also set `fill` to true: the caller must
+    /// then store the pixels there and call segment->filled(slot, ok).
+    /// Return nullptr if the tile can't be shared.
+    char* find(const TileID& id, size_t size,
+               std::shared_ptr<TileSharedSegment>& segment, int& slot,
+               bool& fill);
+
+    // Statistics
+    atomic_ll m_hits { 0 };
+    atomic_ll m_adds { 0 };
+
+private:
+    mutable spin_mutex m_mutex;  ///< Protect m_name and m_segment
+    std::string m_name;          ///< Name of the segment
+    std::shared_ptr<TileSharedSegment> m_segment;  ///< Attached segment
+    std::atomic<bool> m_enabled { false };
+    atomic_ll m_max_bytes { 1024LL * 1024 * 1024 };
+};
+
+
+
 /// A very small amount of per-thread data that saves us from locking
 /// the mutex quite as often.  We store things here used by both
 /// ImageCache and TextureSystem, so they don't each need a costly
@@ -690,16 +901,23 @@ public:
         = tsl::robin_map<ustring, ImageCacheFile*, ustringHash>;
     ThreadFilenameMap m_thread_files;
 
-    // We have a two-tile "microcache", storing the last two tiles needed.
-    ImageCacheTileRef tile, lasttile;
-    atomic_int purge;  // If set, tile ptrs need purging!
+    // The tile "microcache": `tile` is the last tile found, and
+    // `microcache` is a small set-associative cache of the tiles used
+    // recently by this thread, each set ordered from most to least
+    // recently used. Both are consulted before the locked main cache.
+    enum { microcache_sets = 16, microcache_ways = 2 };
+    typedef std::array<ImageCacheTileRef, microcache_sets * microcache_ways>
+        TileMicrocache;
+    ImageCacheTileRef tile;
+    TileMicrocache microcache;
+    int epoch = 0;  // The IC's microcache epoch when we last purged
+    int evict_epoch = 0;  // The IC's eviction epoch when we last checked
     ImageCacheStatistics m_stats;
     bool shared = false;  // Pointed to by the IC and thread_specific_ptr
 
     ImageCachePerThreadInfo()
     {
         // std::cout << "Creating PerThreadInfo " << (void*)this << "\n";
-        purge = 0;
     }
 
     ~ImageCachePerThreadInfo()
@@ -719,6 +937,32 @@ public:
         auto f = m_thread_files.find(n);
         return f == m_thread_files.end() ? nullptr : f->second;
     }
+
+    // Return the first way of the microcache set that id maps to.
+    ImageCacheTileRef* microcache_set(const TileID& id)
+    {
+        size_t set = id.hash() & (microcache_sets - 1);
+        return &microcache[set * microcache_ways];
+    }
+
+    // Drop all the tile references held by the microcache.
+    void clear_microcache()
+    {
+        tile.reset();
+        for (auto& t : microcache)
+            t.reset();
+    }
+
+    // Drop the references to tiles that the main cache has evicted, so
+    // that their memory is freed rather than pinned by this thread.
+    void drop_evicted_tiles()
+    {
+        if (tile && tile->evicted())
+            tile.reset();
+        for (auto& t : microcache)
+            if (t && t->evicted())
+                t.reset();
+    }
 };
 
 
@@ -796,6 +1040,8 @@ public:
     bool accept_unmipped() const { return m_accept_unmipped; }
     bool unassociatedalpha() const { return m_unassociatedalpha; }
     bool trust_file_extensions() const { return m_trust_file_extensions; }
+    bool mmap_tiles() const { return m_mmap_tiles; }
+    bool compress_tiles() const { return m_compress_tiles; }
     int failure_retries() const { return m_failure_retries; }
     bool latlong_y_up_default() const { return m_latlong_y_up_default; }
     void get_commontoworld(Imath::M44f& result) const { result = m_Mc2w; }
@@ -868,11 +1114,20 @@ public:
     /// If header_only is true, we are finding the file only for the sake
     /// of header information (e.g., called by get_image_info).
     /// A call to verify_file() is still needed after find_file().
+    /// If resolved_filename is not empty, it's what resolve_filename()
+    /// already returned for filename, used if the file is new.
     ImageCacheFile* find_file(ustring filename,
                               ImageCachePerThreadInfo* thread_info,
                               ImageInput::Creator creator = nullptr,
                               const ImageSpec* config     = nullptr,
-                              bool replace                = false);
+                              bool replace                = false,
+                              ustring resolved_filename   = ustring());
+
+    /// Find the ImageCacheFile records for many images at once, like
+    /// calling find_file() for each, but resolving the names of files not
+    /// yet in the cache in parallel.
+    void find_files(cspan<ustring> filenames, span<ImageCacheFile*> files,
+                    ImageCachePerThreadInfo* thread_info);
 
     /// Verify & prep the ImageCacheFile record for the named image,
     /// return the pointer (which may have changed for deduplication),
@@ -896,11 +1151,21 @@ public:
         return verify_file(file, thread_info);
     }
 
+    void get_image_handles(cspan<ustring> filenames,
+                           span<ImageCacheFile*> handles,
+                           ImageCachePerThreadInfo* thread_info = NULL);
+
     virtual bool good(ImageCacheFile* handle)
     {
         return handle && !handle->broken();
     }
 
+    /// The on-disk second level tile cache.
+    TileDiskCache& diskcache() { return m_diskcache; }
+
+    /// The cross-process shared memory tile store.
+    TileSharedCache& sharedcache() { return m_sharedcache; }
+
     /// Is the tile specified by the TileID already in the cache?
     bool tile_in_cache(const TileID& id,
                        ImageCachePerThreadInfo* /*thread_info*/)
@@ -927,23 +1192,39 @@ public:
     {
         ++thread_info->m_stats.find_tile_calls;
         ImageCacheTileRef& tile(thread_info->tile);
-        if (tile) {
-            if (tile->id() == id) {
-                if (mark_same_tile_used)
-                    tile->use();
-                return true;  // already have the tile we want
-            }
-            // Tile didn't match, maybe lasttile will?  Swap tile
-            // and last tile.  Then the new one will either match,
-            // or we'll fall through and replace tile.
-            tile.swap(thread_info->lasttile);
-            if (tile && tile->id() == id) {
+        if (tile && tile->id() == id) {
+            if (mark_same_tile_used)
                 tile->use();
+            return true;  // already have the tile we want
+        }
+        // If the main cache has evicted tiles since we last looked, let
+        // go of any we're still holding so check_max_mem can free them.
+        int evict_epoch = m_evict_epoch.load(std::memory_order_relaxed);
+        if (thread_info->evict_epoch != evict_epoch) {
+            thread_info->evict_epoch = evict_epoch;
+            thread_info->drop_evicted_tiles();
+        }
+        // Not the last tile, maybe it's in its microcache set?  A hit
+        // moves to the front of the set, so the set stays in LRU order.
+        ImageCacheTileRef* set = thread_info->microcache_set(id);
+        for (int w = 0; w < ImageCachePerThreadInfo::microcache_ways; ++w) {
+            if (set[w] && set[w]->id() == id) {
+                for (; w > 0; --w)
+                    set[w].swap(set[w - 1]);
+                tile = set[0];
+                tile->use();
+                ++thread_info->m_stats.find_tile_microcache_set_hits;
                 return true;
             }
         }
-        return find_tile_main_cache(id, tile, thread_info);
         // N.B. find_tile_main_cache marks the tile as used
+        if (!find_tile_main_cache(id, tile, thread_info))
+            return false;
+        // Remember it in the set, evicting the least recently used
+        for (int w = ImageCachePerThreadInfo::microcache_ways - 1; w > 0; --w)
+            set[w].swap(set[w - 1]);
+        set[0] = tile;
+        return true;
     }
 
     virtual Tile* get_tile(ustring filename, int subimage, int miplevel, int x,
@@ -955,6 +1236,12 @@ public:
     virtual TypeDesc tile_format(const Tile* tile) const;
     virtual ROI tile_roi(const Tile* tile) const;
     virtual const void* tile_pixels(Tile* tile, TypeDesc& format) const;
+    bool prefetch(ustring filename, int subimage, int miplevel, int xbegin,
+                  int xend, int ybegin, int yend, int zbegin, int zend,
+                  int chbegin, int chend);
+    bool prefetch(ImageHandle* file, Perthread* thread_info, int subimage,
+                  int miplevel, int xbegin, int xend, int ybegin, int yend,
+                  int zbegin, int zend, int chbegin, int chend);
     virtual bool add_file(ustring filename, ImageInput::Creator creator,
                           const ImageSpec* config, bool replace);
     virtual bool add_tile(ustring filename, int subimage, int miplevel, int x,
@@ -1069,6 +1356,42 @@ private:
     /// Enforce the max memory for tile data.
     void check_max_mem(ImageCachePerThreadInfo* thread_info);
 
+    /// Total number of tiles evicted by check_max_mem, over all shards.
+    long long tile_evictions() const;
+
+    /// Set the number of background prefetch threads, starting or
+    /// stopping the prefetch pool as needed.
+    void set_prefetch_threads(int n);
+
+    /// Compress the given tiles, just evicted from cache shard `shard`
+    /// and holding `bytes` of memory, in the background, replacing each
+    /// in the cache by its compressed copy.
+    void compress_in_background(std::vector<ImageCacheTileRef> tiles,
+                                long long bytes, size_t shard);
+
+    /// Wait until all queued prefetches (and tile compressions) have
+    /// finished, and turn away new ones until the matching
+    /// unblock_prefetch(). Must bracket anything that could invalidate
+    /// the files or tiles they refer to. Calls may nest.
+    void block_prefetch();
+    void unblock_prefetch();
+
+    /// Blocks prefetching for as long as it lives.
+    class PrefetchBlocker {
+    public:
+        PrefetchBlocker(ImageCacheImpl& ic)
+            : m_ic(ic)
+        {
+            m_ic.block_prefetch();
+        }
+        ~PrefetchBlocker() { m_ic.unblock_prefetch(); }
+        PrefetchBlocker(const PrefetchBlocker&) = delete;
+        PrefetchBlocker& operator=(const PrefetchBlocker&) = delete;
+
+    private:
+        ImageCacheImpl& m_ic;
+    };
+
     /// Internal statistics printing routine
     ///
     void printstats() const;
@@ -1086,8 +1409,10 @@ private:
     /// fingerprint table.
     ImageCacheFile* find_fingerprint(ustring finger, ImageCacheFile* file);
 
-    /// Clear all the per-thread microcaches.
-    void purge_perthread_microcaches();
+    /// Clear all the per-thread microcaches. This just bumps the
+    /// microcache epoch; each thread notices the next time it retrieves
+    /// its per-thread info, and clears its own microcache.
+    void purge_perthread_microcaches() { ++m_microcache_epoch; }
 
     /// Clear the fingerprint list, thread-safe.
     void clear_fingerprints();
@@ -1095,6 +1420,8 @@ private:
     thread_specific_ptr<ImageCachePerThreadInfo> m_perthread_info;
     std::vector<ImageCachePerThreadInfo*> m_all_perthread_info;
     static spin_mutex m_perthread_info_mutex;  ///< Thread safety for perthread
+    atomic_int m_microcache_epoch { 0 };  ///< Bumped to purge microcaches
+    atomic_int m_evict_epoch { 0 };       ///< Bumped when tiles are evicted
     int m_max_open_files;
     atomic_ll m_max_memory_bytes;
     std::string m_searchpath;  ///< Colon-separated image directory list
@@ -1110,6 +1437,8 @@ private:
     bool m_unassociatedalpha;  ///< Keep unassociated alpha files as they are?
     bool m_latlong_y_up_default;  ///< Is +y the default "up" for latlong?
     bool m_trust_file_extensions = false;  ///< Assume file extensions don't lie?
+    bool m_mmap_tiles = false;  ///< Memory-map uncompressed tiles if we can
+    bool m_compress_tiles = false;  ///< Compress cold tiles before evicting
     int m_failure_retries;                 ///< Times to re-try disk failures
     int m_max_mip_res = 1 << 30;  ///< Don't use MIP levels higher than this
     Imath::M44f m_Mw2c;           ///< world-to-"common" matrix
@@ -1123,9 +1452,30 @@ private:
     spin_mutex m_fingerprints_mutex;  ///< Protect m_fingerprints
     FingerprintMap m_fingerprints;    ///< Map fingerprints to files
 
-    TileCache m_tilecache;          ///< Our in-memory tile cache
-    TileID m_tile_sweep_id;         ///< Sweeper for "clock" paging algorithm
-    spin_mutex m_tile_sweep_mutex;  ///< Ensure only one in check_max_mem
+    TileCache m_tilecache;  ///< Our in-memory tile cache
+
+    /// Per-shard state for the "clock" tile paging algorithm. Each shard
+    /// of m_tilecache has its own clock hand (only touched while holding
+    /// that shard's lock), so several threads may enforce the memory
+    /// limit at once, each sweeping a different shard.
+    struct TileSweepShard {
+        OIIO_CACHE_ALIGN TileID hand;  ///< Next tile to examine
+        atomic_ll evictions { 0 };     ///< Tiles evicted from this shard
+    };
+    TileSweepShard m_tile_sweep[TILE_CACHE_SHARDS];
+    atomic_int m_tile_sweep_next { 0 };  ///< Next shard to sweep
+
+    TileDiskCache m_diskcache;      ///< Optional on-disk second level cache
+    TileSharedCache m_sharedcache;  ///< Optional cross-process tile store
+
+    int m_prefetch_threads = 0;                    ///< Prefetch pool size
+    std::unique_ptr<thread_pool> m_prefetch_pool;  ///< Prefetch I/O threads
+    std::mutex m_prefetch_mutex;  ///< Guard the pool and counts below
+    std::condition_variable m_prefetch_idle;  ///< Signal pending reached 0
+    int m_prefetch_pending = 0;               ///< Queued or running
+    int m_prefetch_blocked = 0;               ///< Nesting of block_prefetch
+    int m_compress_pending = 0;  ///< Queued or running compressions
+    atomic_ll m_compress_pending_bytes { 0 };  ///< Memory they will free
 
     atomic_ll m_mem_used;       ///< Memory being used for tiles
     int m_statslevel;           ///< Statistics level
@@ -1145,6 +1495,7 @@ private:
     atomic_int m_stat_open_files_created;
     atomic_int m_stat_open_files_current;
     atomic_int m_stat_open_files_peak;
+    atomic_ll m_stat_tiles_prefetched { 0 };
 
     // Simulate an atomic double with a long long!
     void incr_time_stat(double& stat, double incr)
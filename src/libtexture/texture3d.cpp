@@ -52,6 +52,227 @@ half2float(half val)
 }
 
 
+
+// Trilinearly interpolate the 2x2x2 texels of a bilinear 3D lookup, add the
+// result times weight into accum and, if asked for, the derivatives into
+// daccumds, daccumdt and daccumdr.
+static void
+accum3d_trilerp_texels(const unsigned char* texel[2][2][2],
+                       TypeDesc::BASETYPE pixeltype, const ImageSpec& spec,
+                       float sfrac, float tfrac, float rfrac, float weight,
+                       int actualchannels, float* accum, float* daccumds,
+                       float* daccumdt, float* daccumdr)
+{
+    // clang-format off
+    if (pixeltype == TypeDesc::UINT8) {
+        for (int c = 0; c < actualchannels; ++c)
+            accum[c] += weight
+                        * trilerp(uchar2float(texel[0][0][0][c]),
+                                  uchar2float(texel[0][0][1][c]),
+                                  uchar2float(texel[0][1][0][c]),
+                                  uchar2float(texel[0][1][1][c]),
+                                  uchar2float(texel[1][0][0][c]),
+                                  uchar2float(texel[1][0][1][c]),
+                                  uchar2float(texel[1][1][0][c]),
+                                  uchar2float(texel[1][1][1][c]), sfrac, tfrac,
+                                  rfrac);
+        if (daccumds) {
+            float scalex = weight * spec.full_width;
+            float scaley = weight * spec.full_height;
+            float scalez = weight * spec.full_depth;
+            for (int c = 0; c < actualchannels; ++c) {
+                daccumds[c] += scalex
+                               * bilerp(uchar2float(texel[0][0][1][c])
+                                            - uchar2float(texel[0][0][0][c]),
+                                        uchar2float(texel[0][1][1][c])
+                                            - uchar2float(texel[0][1][0][c]),
+                                        uchar2float(texel[1][0][1][c])
+                                            - uchar2float(texel[1][0][0][c]),
+                                        uchar2float(texel[1][1][1][c])
+                                            - uchar2float(texel[1][1][0][c]),
+                                        tfrac, rfrac);
+                daccumdt[c] += scaley
+                               * bilerp(uchar2float(texel[0][1][0][c])
+                                            - uchar2float(texel[0][0][0][c]),
+                                        uchar2float(texel[0][1][1][c])
+                                            - uchar2float(texel[0][0][1][c]),
+                                        uchar2float(texel[1][1][0][c])
+                                            - uchar2float(texel[1][0][0][c]),
+                                        uchar2float(texel[1][1][1][c])
+                                            - uchar2float(texel[1][0][1][c]),
+                                        sfrac, rfrac);
+                daccumdr[c] += scalez
+                               * bilerp(uchar2float(texel[0][1][0][c])
+                                            - uchar2float(texel[1][1][0][c]),
+                                        uchar2float(texel[0][1][1][c])
+                                            - uchar2float(texel[1][1][1][c]),
+                                        uchar2float(texel[0][0][1][c])
+                                            - uchar2float(texel[1][0][0][c]),
+                                        uchar2float(texel[0][1][1][c])
+                                            - uchar2float(texel[1][1][1][c]),
+                                        sfrac, tfrac);
+            }
+        }
+    } else if (pixeltype == TypeDesc::UINT16) {
+        for (int c = 0; c < actualchannels; ++c)
+            accum[c]
+                += weight
+                   * trilerp(ushort2float(((const uint16_t*)texel[0][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][0][1])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][1])[c]),
+                             ushort2float(((const uint16_t*)texel[1][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[1][0][1])[c]),
+                             ushort2float(((const uint16_t*)texel[1][1][0])[c]),
+                             ushort2float(((const uint16_t*)texel[1][1][1])[c]),
+                             sfrac, tfrac, rfrac);
+        if (daccumds) {
+            float scalex = weight * spec.full_width;
+            float scaley = weight * spec.full_height;
+            float scalez = weight * spec.full_depth;
+            for (int c = 0; c < actualchannels; ++c) {
+                daccumds[c] += scalex * bilerp(
+                             ushort2float(((const uint16_t*)texel[0][0][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[0][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[0][1][0])[c]),
+                             ushort2float(((const uint16_t*)texel[1][0][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[1][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][1][0])[c]),
+                             tfrac, rfrac);
+                daccumdt[c] += scaley * bilerp(
+                             ushort2float(((const uint16_t*)texel[0][1][0])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[0][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[0][0][1])[c]),
+                             ushort2float(((const uint16_t*)texel[1][1][0])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[1][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][0][1])[c]),
+                             sfrac, rfrac);
+                daccumdr[c] += scalez * bilerp(
+                             ushort2float(((const uint16_t*)texel[0][1][0])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][1][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][1][1])[c]),
+                             ushort2float(((const uint16_t*)texel[0][0][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][0][0])[c]),
+                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
+                                 - ushort2float(
+                                       ((const uint16_t*)texel[1][1][1])[c]),
+                             sfrac, tfrac);
+            }
+        }
+    } else if (pixeltype == TypeDesc::HALF) {
+        for (int c = 0; c < actualchannels; ++c)
+            accum[c] += weight
+                        * trilerp(half2float(((const half*)texel[0][0][0])[c]),
+                                  half2float(((const half*)texel[0][0][1])[c]),
+                                  half2float(((const half*)texel[0][1][0])[c]),
+                                  half2float(((const half*)texel[0][1][1])[c]),
+                                  half2float(((const half*)texel[1][0][0])[c]),
+                                  half2float(((const half*)texel[1][0][1])[c]),
+                                  half2float(((const half*)texel[1][1][0])[c]),
+                                  half2float(((const half*)texel[1][1][1])[c]),
+                                  sfrac, tfrac, rfrac);
+        if (daccumds) {
+            float scalex = weight * spec.full_width;
+            float scaley = weight * spec.full_height;
+            float scalez = weight * spec.full_depth;
+            for (int c = 0; c < actualchannels; ++c) {
+                daccumds[c] += scalex * bilerp(
+                             half2float(((const half*)texel[0][0][1])[c])
+                                 - half2float(((const half*)texel[0][0][0])[c]),
+                             half2float(((const half*)texel[0][1][1])[c])
+                                 - half2float(((const half*)texel[0][1][0])[c]),
+                             half2float(((const half*)texel[1][0][1])[c])
+                                 - half2float(((const half*)texel[1][0][0])[c]),
+                             half2float(((const half*)texel[1][1][1])[c])
+                                 - half2float(((const half*)texel[1][1][0])[c]),
+                             tfrac, rfrac);
+                daccumdt[c] += scaley * bilerp(
+                             half2float(((const half*)texel[0][1][0])[c])
+                                 - half2float(((const half*)texel[0][0][0])[c]),
+                             half2float(((const half*)texel[0][1][1])[c])
+                                 - half2float(((const half*)texel[0][0][1])[c]),
+                             half2float(((const half*)texel[1][1][0])[c])
+                                 - half2float(((const half*)texel[1][0][0])[c]),
+                             half2float(((const half*)texel[1][1][1])[c])
+                                 - half2float(((const half*)texel[1][0][1])[c]),
+                             sfrac, rfrac);
+                daccumdr[c] += scalez * bilerp(
+                             half2float(((const half*)texel[0][1][0])[c])
+                                 - half2float(((const half*)texel[1][1][0])[c]),
+                             half2float(((const half*)texel[0][1][1])[c])
+                                 - half2float(((const half*)texel[1][1][1])[c]),
+                             half2float(((const half*)texel[0][0][1])[c])
+                                 - half2float(((const half*)texel[1][0][0])[c]),
+                             half2float(((const half*)texel[0][1][1])[c])
+                                 - half2float(((const half*)texel[1][1][1])[c]),
+                             sfrac, tfrac);
+            }
+        }
+    } else {
+        // General case for float tiles
+        trilerp_mad((const float*)texel[0][0][0], (const float*)texel[0][0][1],
+                    (const float*)texel[0][1][0], (const float*)texel[0][1][1],
+                    (const float*)texel[1][0][0], (const float*)texel[1][0][1],
+                    (const float*)texel[1][1][0], (const float*)texel[1][1][1],
+                    sfrac, tfrac, rfrac, weight, actualchannels, accum);
+        if (daccumds) {
+            float scalex = weight * spec.full_width;
+            float scaley = weight * spec.full_height;
+            float scalez = weight * spec.full_depth;
+            for (int c = 0; c < actualchannels; ++c) {
+                daccumds[c] += scalex
+                               * bilerp(((const float*)texel[0][0][1])[c]
+                                            - ((const float*)texel[0][0][0])[c],
+                                        ((const float*)texel[0][1][1])[c]
+                                            - ((const float*)texel[0][1][0])[c],
+                                        ((const float*)texel[1][0][1])[c]
+                                            - ((const float*)texel[1][0][0])[c],
+                                        ((const float*)texel[1][1][1])[c]
+                                            - ((const float*)texel[1][1][0])[c],
+                                        tfrac, rfrac);
+                daccumdt[c] += scaley
+                               * bilerp(((const float*)texel[0][1][0])[c]
+                                            - ((const float*)texel[0][0][0])[c],
+                                        ((const float*)texel[0][1][1])[c]
+                                            - ((const float*)texel[0][0][1])[c],
+                                        ((const float*)texel[1][1][0])[c]
+                                            - ((const float*)texel[1][0][0])[c],
+                                        ((const float*)texel[1][1][1])[c]
+                                            - ((const float*)texel[1][0][1])[c],
+                                        sfrac, rfrac);
+                daccumdr[c] += scalez
+                               * bilerp(((const float*)texel[0][1][0])[c]
+                                            - ((const float*)texel[1][1][0])[c],
+                                        ((const float*)texel[0][1][1])[c]
+                                            - ((const float*)texel[1][1][1])[c],
+                                        ((const float*)texel[0][0][1])[c]
+                                            - ((const float*)texel[1][0][0])[c],
+                                        ((const float*)texel[0][1][1])[c]
+                                            - ((const float*)texel[1][1][1])[c],
+                                        sfrac, tfrac);
+            }
+        }
+    }
+    // clang-format on
+}
+
+
 }  // end anonymous namespace
 
 namespace pvt {  // namespace pvt
@@ -588,213 +809,9 @@ TextureSystemImpl::accum3d_sample_bilinear(
     }
     // FIXME -- optimize the above loop by unrolling
 
-    // clang-format off
-    if (pixeltype == TypeDesc::UINT8) {
-        for (int c = 0; c < actualchannels; ++c)
-            accum[c] += weight
-                        * trilerp(uchar2float(texel[0][0][0][c]),
-                                  uchar2float(texel[0][0][1][c]),
-                                  uchar2float(texel[0][1][0][c]),
-                                  uchar2float(texel[0][1][1][c]),
-                                  uchar2float(texel[1][0][0][c]),
-                                  uchar2float(texel[1][0][1][c]),
-                                  uchar2float(texel[1][1][0][c]),
-                                  uchar2float(texel[1][1][1][c]), sfrac, tfrac,
-                                  rfrac);
-        if (daccumds) {
-            float scalex = weight * spec.full_width;
-            float scaley = weight * spec.full_height;
-            float scalez = weight * spec.full_depth;
-            for (int c = 0; c < actualchannels; ++c) {
-                daccumds[c] += scalex
-                               * bilerp(uchar2float(texel[0][0][1][c])
-                                            - uchar2float(texel[0][0][0][c]),
-                                        uchar2float(texel[0][1][1][c])
-                                            - uchar2float(texel[0][1][0][c]),
-                                        uchar2float(texel[1][0][1][c])
-                                            - uchar2float(texel[1][0][0][c]),
-                                        uchar2float(texel[1][1][1][c])
-                                            - uchar2float(texel[1][1][0][c]),
-                                        tfrac, rfrac);
-                daccumdt[c] += scaley
-                               * bilerp(uchar2float(texel[0][1][0][c])
-                                            - uchar2float(texel[0][0][0][c]),
-                                        uchar2float(texel[0][1][1][c])
-                                            - uchar2float(texel[0][0][1][c]),
-                                        uchar2float(texel[1][1][0][c])
-                                            - uchar2float(texel[1][0][0][c]),
-                                        uchar2float(texel[1][1][1][c])
-                                            - uchar2float(texel[1][0][1][c]),
-                                        sfrac, rfrac);
-                daccumdr[c] += scalez
-                               * bilerp(uchar2float(texel[0][1][0][c])
-                                            - uchar2float(texel[1][1][0][c]),
-                                        uchar2float(texel[0][1][1][c])
-                                            - uchar2float(texel[1][1][1][c]),
-                                        uchar2float(texel[0][0][1][c])
-                                            - uchar2float(texel[1][0][0][c]),
-                                        uchar2float(texel[0][1][1][c])
-                                            - uchar2float(texel[1][1][1][c]),
-                                        sfrac, tfrac);
-            }
-        }
-    } else if (pixeltype == TypeDesc::UINT16) {
-        for (int c = 0; c < actualchannels; ++c)
-            accum[c]
-                += weight
-                   * trilerp(ushort2float(((const uint16_t*)texel[0][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][0][1])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][1])[c]),
-                             ushort2float(((const uint16_t*)texel[1][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[1][0][1])[c]),
-                             ushort2float(((const uint16_t*)texel[1][1][0])[c]),
-                             ushort2float(((const uint16_t*)texel[1][1][1])[c]),
-                             sfrac, tfrac, rfrac);
-        if (daccumds) {
-            float scalex = weight * spec.full_width;
-            float scaley = weight * spec.full_height;
-            float scalez = weight * spec.full_depth;
-            for (int c = 0; c < actualchannels; ++c) {
-                daccumds[c] += scalex * bilerp(
-                             ushort2float(((const uint16_t*)texel[0][0][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[0][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[0][1][0])[c]),
-                             ushort2float(((const uint16_t*)texel[1][0][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[1][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][1][0])[c]),
-                             tfrac, rfrac);
-                daccumdt[c] += scaley * bilerp(
-                             ushort2float(((const uint16_t*)texel[0][1][0])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[0][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[0][0][1])[c]),
-                             ushort2float(((const uint16_t*)texel[1][1][0])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[1][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][0][1])[c]),
-                             sfrac, rfrac);
-                daccumdr[c] += scalez * bilerp(
-                             ushort2float(((const uint16_t*)texel[0][1][0])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][1][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][1][1])[c]),
-                             ushort2float(((const uint16_t*)texel[0][0][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][0][0])[c]),
-                             ushort2float(((const uint16_t*)texel[0][1][1])[c])
-                                 - ushort2float(
-                                       ((const uint16_t*)texel[1][1][1])[c]),
-                             sfrac, tfrac);
-            }
-        }
-    } else if (pixeltype == TypeDesc::HALF) {
-        for (int c = 0; c < actualchannels; ++c)
-            accum[c] += weight
-                        * trilerp(half2float(((const half*)texel[0][0][0])[c]),
-                                  half2float(((const half*)texel[0][0][1])[c]),
-                                  half2float(((const half*)texel[0][1][0])[c]),
-                                  half2float(((const half*)texel[0][1][1])[c]),
-                                  half2float(((const half*)texel[1][0][0])[c]),
-                                  half2float(((const half*)texel[1][0][1])[c]),
-                                  half2float(((const half*)texel[1][1][0])[c]),
-                                  half2float(((const half*)texel[1][1][1])[c]),
-                                  sfrac, tfrac, rfrac);
-        if (daccumds) {
-            float scalex = weight * spec.full_width;
-            float scaley = weight * spec.full_height;
-            float scalez = weight * spec.full_depth;
-            for (int c = 0; c < actualchannels; ++c) {
-                daccumds[c] += scalex * bilerp(
-                             half2float(((const half*)texel[0][0][1])[c])
-                                 - half2float(((const half*)texel[0][0][0])[c]),
-                             half2float(((const half*)texel[0][1][1])[c])
-                                 - half2float(((const half*)texel[0][1][0])[c]),
-                             half2float(((const half*)texel[1][0][1])[c])
-                                 - half2float(((const half*)texel[1][0][0])[c]),
-                             half2float(((const half*)texel[1][1][1])[c])
-                                 - half2float(((const half*)texel[1][1][0])[c]),
-                             tfrac, rfrac);
-                daccumdt[c] += scaley * bilerp(
-                             half2float(((const half*)texel[0][1][0])[c])
-                                 - half2float(((const half*)texel[0][0][0])[c]),
-                             half2float(((const half*)texel[0][1][1])[c])
-                                 - half2float(((const half*)texel[0][0][1])[c]),
-                             half2float(((const half*)texel[1][1][0])[c])
-                                 - half2float(((const half*)texel[1][0][0])[c]),
-                             half2float(((const half*)texel[1][1][1])[c])
-                                 - half2float(((const half*)texel[1][0][1])[c]),
-                             sfrac, rfrac);
-                daccumdr[c] += scalez * bilerp(
-                             half2float(((const half*)texel[0][1][0])[c])
-                                 - half2float(((const half*)texel[1][1][0])[c]),
-                             half2float(((const half*)texel[0][1][1])[c])
-                                 - half2float(((const half*)texel[1][1][1])[c]),
-                             half2float(((const half*)texel[0][0][1])[c])
-                                 - half2float(((const half*)texel[1][0][0])[c]),
-                             half2float(((const half*)texel[0][1][1])[c])
-                                 - half2float(((const half*)texel[1][1][1])[c]),
-                             sfrac, tfrac);
-            }
-        }
-    } else {
-        // General case for float tiles
-        trilerp_mad((const float*)texel[0][0][0], (const float*)texel[0][0][1],
-                    (const float*)texel[0][1][0], (const float*)texel[0][1][1],
-                    (const float*)texel[1][0][0], (const float*)texel[1][0][1],
-                    (const float*)texel[1][1][0], (const float*)texel[1][1][1],
-                    sfrac, tfrac, rfrac, weight, actualchannels, accum);
-        if (daccumds) {
-            float scalex = weight * spec.full_width;
-            float scaley = weight * spec.full_height;
-            float scalez = weight * spec.full_depth;
-            for (int c = 0; c < actualchannels; ++c) {
-                daccumds[c] += scalex
-                               * bilerp(((const float*)texel[0][0][1])[c]
-                                            - ((const float*)texel[0][0][0])[c],
-                                        ((const float*)texel[0][1][1])[c]
-                                            - ((const float*)texel[0][1][0])[c],
-                                        ((const float*)texel[1][0][1])[c]
-                                            - ((const float*)texel[1][0][0])[c],
-                                        ((const float*)texel[1][1][1])[c]
-                                            - ((const float*)texel[1][1][0])[c],
-                                        tfrac, rfrac);
-                daccumdt[c] += scaley
-                               * bilerp(((const float*)texel[0][1][0])[c]
-                                            - ((const float*)texel[0][0][0])[c],
-                                        ((const float*)texel[0][1][1])[c]
-                                            - ((const float*)texel[0][0][1])[c],
-                                        ((const float*)texel[1][1][0])[c]
-                                            - ((const float*)texel[1][0][0])[c],
-                                        ((const float*)texel[1][1][1])[c]
-                                            - ((const float*)texel[1][0][1])[c],
-                                        sfrac, rfrac);
-                daccumdr[c] += scalez
-                               * bilerp(((const float*)texel[0][1][0])[c]
-                                            - ((const float*)texel[1][1][0])[c],
-                                        ((const float*)texel[0][1][1])[c]
-                                            - ((const float*)texel[1][1][1])[c],
-                                        ((const float*)texel[0][0][1])[c]
-                                            - ((const float*)texel[1][0][0])[c],
-                                        ((const float*)texel[0][1][1])[c]
-                                            - ((const float*)texel[1][1][1])[c],
-                                        sfrac, tfrac);
-            }
-        }
-    }
-    // clang-format on
+    accum3d_trilerp_texels(texel, pixeltype, spec, sfrac, tfrac, rfrac,
+                           weight, actualchannels, accum, daccumds, daccumdt,
+                           daccumdr);
 
     // Add appropriate amount of "fill" color to extra channels in
     // non-"black"-wrapped regions.
@@ -826,58 +843,282 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle,
                              float* dresultds, float* dresultdt,
                              float* dresultdr)
 {
-    // (FIXME) CHEAT! Texture points individually
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    // Handle >4 channel lookups by recursion, 4 channels at a time.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= texture3d(texture_handle, thread_info, options, mask, P,
+                            dPdx, dPdy, dPdz, n, result, dresultds, dresultdt,
+                            dresultdr);
+            result += n * Tex::BatchWidth;
+            if (dresultds)
+                dresultds += n * Tex::BatchWidth;
+            if (dresultdt)
+                dresultdt += n * Tex::BatchWidth;
+            if (dresultdr)
+                dresultdr += n * Tex::BatchWidth;
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
+    PerThreadInfo* threadinfo = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle,
+                                                  threadinfo);
+    ImageCacheStatistics& stats(threadinfo->m_stats);
+    ++stats.texture3d_batches;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++stats.texture3d_queries;
+
     TextureOpt opt;
-    opt.firstchannel        = options.firstchannel;
-    opt.subimage            = options.subimage;
-    opt.subimagename        = options.subimagename;
-    opt.swrap               = (TextureOpt::Wrap)options.swrap;
-    opt.twrap               = (TextureOpt::Wrap)options.twrap;
-    opt.mipmode             = (TextureOpt::MipMode)options.mipmode;
-    opt.interpmode          = (TextureOpt::InterpMode)options.interpmode;
-    opt.anisotropic         = options.anisotropic;
-    opt.conservative_filter = options.conservative_filter;
-    opt.fill                = options.fill;
-    opt.missingcolor        = options.missingcolor;
-    opt.rwrap               = (TextureOpt::Wrap)options.rwrap;
-
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4], drdr[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.rblur  = options.rblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rwidth = options.rwidth[i];
-            Imath::V3f P_(P[i], P[i + Tex::BatchWidth],
-                          P[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdx_(dPdx[i], dPdx[i + Tex::BatchWidth],
-                             dPdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdy_(dPdy[i], dPdy[i + Tex::BatchWidth],
-                             dPdy[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdz_(dPdz[i], dPdz[i + Tex::BatchWidth],
-                             dPdz[i + 2 * Tex::BatchWidth]);
-            if (dresultds) {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r, drds, drdt, drdr);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                    dresultdr[c * Tex::BatchWidth + i] = drdr[c];
-                }
-            } else {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
+    batch_uniform_options(options, opt);
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture_batch(opt, mask, nchannels, result, dresultds,
+                                     dresultdt, dresultdr);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int s = m_imagecache->subimage_from_name(texturefile,
+                                                 opt.subimagename);
+        if (s < 0) {
+            errorf("Unknown subimage \"%s\" in texture \"%s\"",
+                   opt.subimagename, texturefile->filename());
+            return missing_texture_batch(opt, mask, nchannels, result,
+                                         dresultds, dresultdt, dresultdr);
+        }
+        opt.subimage = s;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        errorf("Unknown subimage \"%s\" in texture \"%s\"",
+               opt.subimagename, texturefile->filename());
+        return missing_texture_batch(opt, mask, nchannels, result, dresultds,
+                                     dresultdt, dresultdr);
+    }
+
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.rwrap == TextureOpt::WrapDefault)
+        opt.rwrap = (TextureOpt::Wrap)texturefile->rwrap();
+    if (opt.rwrap == TextureOpt::WrapPeriodic && ispow2(spec.depth))
+        opt.rwrap = TextureOpt::WrapPeriodicPow2;
+
+    int actualchannels = Imath::clamp(spec.nchannels - opt.firstchannel, 0,
+                                      nchannels);
+
+    // Do the volume lookup in local space. When there is a world-to-local
+    // matrix, transform the points of all lanes at once.
+    using Tex::FloatWide;
+    const int BW = Tex::BatchWidth;
+    alignas(Tex::BatchAlign) float Plocal[3][Tex::BatchWidth];
+    const auto& si(texturefile->subimageinfo(opt.subimage));
+    if (si.Mlocal) {
+        const Imath::M44f& M(*si.Mlocal);
+        FloatWide x(P), y(P + BW), z(P + 2 * BW);
+        FloatWide a = x * M[0][0] + y * M[1][0] + z * M[2][0] + M[3][0];
+        FloatWide b = x * M[0][1] + y * M[1][1] + z * M[2][1] + M[3][1];
+        FloatWide c = x * M[0][2] + y * M[1][2] + z * M[2][2] + M[3][2];
+        FloatWide w = x * M[0][3] + y * M[1][3] + z * M[2][3] + M[3][3];
+        (a / w).store(Plocal[0]);
+        (b / w).store(Plocal[1]);
+        (c / w).store(Plocal[2]);
+    } else if (texturefile->fileformat() == s_field3d) {
+        // Field3d is special -- it allows nonlinear or time-varying
+        // transforms procedurally, but we have to use a back door.
+        auto input                   = texturefile->open(threadinfo);
+        Field3DInput_Interface* f3di = (Field3DInput_Interface*)input.get();
+        if (!f3di) {
+            errorf("Unable to open texture \"%s\"", texturefile->filename());
+            return false;
+        }
+        for (int i = 0; i < BW; ++i) {
+            Imath::V3f Pl(0.0f);
+            if (mask & (Tex::RunMask(1) << i))
+                f3di->worldToLocal(Imath::V3f(P[i], P[i + BW], P[i + 2 * BW]),
+                                   Pl, opt.time);
+            Plocal[0][i] = Pl.x;
+            Plocal[1][i] = Pl.y;
+            Plocal[2][i] = Pl.z;
+        }
+    } else {
+        // If no world-to-local matrix could be discerned, just use the
+        // input point directly.
+        for (int c = 0; c < 3; ++c)
+            FloatWide(P + c * BW).store(Plocal[c]);
+    }
+
+    // As with the single point lookup, the derivatives of the result are
+    // only computed when all three are asked for. Any that were asked for
+    // on their own are zeroed.
+    float* dresult[3]    = { dresultds, dresultdt, dresultdr };
+    const bool derivs    = dresultds && dresultdt && dresultdr;
+    const bool fill_gray = (actualchannels < nchannels && opt.firstchannel == 0
+                            && m_gray_to_rgb);
+    bool ok              = true;
+    simd::vfloat4 r[Tex::BatchWidth], dr[3][Tex::BatchWidth];
+    for (int i = 0; i < BW; ++i)
+        r[i] = dr[0][i] = dr[1][i] = dr[2][i] = simd::vfloat4::Zero();
+
+    // Lanes whose 2x2x2 texel footprint lies all within one tile are
+    // gathered together, so that a tile shared by several of them is found
+    // just once. The rest, and closest lookups, are done one by one. As for
+    // single point lookups, volumes are not MIP-mapped yet, so all of them
+    // are of level 0.
+    TileProbe probes[Tex::BatchWidth];
+    int nprobes = 0;
+    alignas(Tex::BatchAlign) float frac[3][Tex::BatchWidth];
+    alignas(Tex::BatchAlign) int texint[3][Tex::BatchWidth];
+    const bool bilinear = (opt.interpmode != TextureOpt::InterpClosest);
+    if (bilinear) {
+        // Remap to texel coords and subtract 0.5 because samples are at
+        // texel centers, as accum3d_sample_bilinear() does.
+        const int full_res[3]    = { spec.full_width, spec.full_height,
+                                  spec.full_depth };
+        const int full_origin[3] = { spec.full_x, spec.full_y, spec.full_z };
+        for (int c = 0; c < 3; ++c) {
+            FloatWide x = FloatWide(Plocal[c]) * float(full_res[c])
+                          + float(full_origin[c]) - 0.5f;
+            Tex::IntWide xint;
+            floorfrac(x, &xint).store(frac[c]);
+            xint.store(texint[c]);
+        }
+    }
+    wrap_impl wrap_func[3] = { wrap_functions[(int)opt.swrap],
+                               wrap_functions[(int)opt.twrap],
+                               wrap_functions[(int)opt.rwrap] };
+    const ImageCacheFile::LevelInfo& levelinfo(
+        texturefile->levelinfo(opt.subimage, 0));
+    const int origin[3] = { spec.x, spec.y, spec.z };
+    const int res[3]    = { spec.width, spec.height, spec.depth };
+    const int tile[3]   = { spec.tile_width, spec.tile_height,
+                          spec.tile_depth };
+    Tex::RunMask bit    = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        ++stats.aniso_queries;
+        ++stats.aniso_probes;
+        switch (opt.interpmode) {
+        case TextureOpt::InterpClosest: ++stats.closest_interps; break;
+        case TextureOpt::InterpBilinear: ++stats.bilinear_interps; break;
+        case TextureOpt::InterpBicubic: ++stats.cubic_interps; break;
+        case TextureOpt::InterpSmartBicubic: ++stats.bilinear_interps; break;
+        }
+        Imath::V3f Pl(Plocal[0][i], Plocal[1][i], Plocal[2][i]);
+        if (bilinear) {
+            // Wrap the texel coords and see whether the footprint is on
+            // one tile, all of it valid, or none of it.
+            bool anyvalid = false, onetile = true;
+            int tex0[3], tilepos[3];
+            for (int c = 0; c < 3; ++c) {
+                int tex[2] = { texint[c][i], texint[c][i] + 1 };
+                bool valid[2];
+                for (int j = 0; j < 2; ++j) {
+                    valid[j] = wrap_func[c](tex[j], origin[c], res[c]);
+                    if (!levelinfo.full_pixel_range)
+                        valid[j] &= (tex[j] >= origin[c]
+                                     && tex[j] < origin[c] + res[c]);
+                    anyvalid |= valid[j];
+                    onetile &= valid[j];
                 }
+                tex0[c]    = tex[0];
+                tilepos[c] = (tex[0] - origin[c]) % tile[c];
+                onetile &= (tilepos[c] != tile[c] - 1)
+                           & (tex[0] + 1 == tex[1]);
             }
+            if (!anyvalid)
+                continue;  // all out of range and using 'black' wrap
+            if (onetile) {
+                TileProbe& probe(probes[nprobes++]);
+                probe.level   = 0;
+                probe.x       = tex0[0] - tilepos[0];
+                probe.y       = tex0[1] - tilepos[1];
+                probe.z       = tex0[2] - tilepos[2];
+                probe.tilepel = (tilepos[2] * spec.tile_height + tilepos[1])
+                                    * spec.tile_width
+                                + tilepos[0];
+                probe.index   = i;
+                continue;
+            }
+            ok &= accum3d_sample_bilinear(Pl, 0, *texturefile, threadinfo,
+                                          opt, nchannels, actualchannels, 1.0f,
+                                          (float*)&r[i],
+                                          derivs ? (float*)&dr[0][i] : NULL,
+                                          derivs ? (float*)&dr[1][i] : NULL,
+                                          derivs ? (float*)&dr[2][i] : NULL);
+        } else {
+            ok &= accum3d_sample_closest(Pl, 0, *texturefile, threadinfo, opt,
+                                         nchannels, actualchannels, 1.0f,
+                                         (float*)&r[i],
+                                         derivs ? (float*)&dr[0][i] : NULL,
+                                         derivs ? (float*)&dr[1][i] : NULL,
+                                         derivs ? (float*)&dr[2][i] : NULL);
         }
     }
+
+    TypeDesc::BASETYPE pixeltype = texturefile->pixeltype(opt.subimage);
+    auto gather = [&](const TileProbe& probe, const unsigned char* b,
+                      int pixelsize) {
+        int i               = probe.index;
+        size_t rowbytes     = size_t(pixelsize) * spec.tile_width;
+        size_t planebytes   = rowbytes * spec.tile_height;
+        const unsigned char* texel[2][2][2];
+        for (int k = 0; k < 2; ++k)
+            for (int j = 0; j < 2; ++j)
+                for (int l = 0; l < 2; ++l)
+                    texel[k][j][l] = b + k * planebytes + j * rowbytes
+                                     + l * pixelsize;
+        accum3d_trilerp_texels(texel, pixeltype, spec, frac[0][i], frac[1][i],
+                               frac[2][i], 1.0f, actualchannels, (float*)&r[i],
+                               derivs ? (float*)&dr[0][i] : NULL,
+                               derivs ? (float*)&dr[1][i] : NULL,
+                               derivs ? (float*)&dr[2][i] : NULL);
+        if (nchannels > actualchannels && opt.fill) {
+            float f = trilerp(1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+                              frac[0][i], frac[1][i], frac[2][i]);
+            f *= opt.fill;
+            for (int c = actualchannels; c < nchannels; ++c)
+                r[i][c] += f;
+        }
+    };
+    ok &= gather_tile_probes(*texturefile, threadinfo, opt, actualchannels,
+                             probes, nprobes, gather);
+
+    bit = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        if (fill_gray)
+            fill_gray_channels(spec, nchannels, (float*)&r[i],
+                               derivs ? (float*)&dr[0][i] : NULL,
+                               derivs ? (float*)&dr[1][i] : NULL,
+                               derivs ? (float*)&dr[2][i] : NULL);
+        for (int c = 0; c < nchannels; ++c)
+            result[c * BW + i] = r[i][c];
+        for (int d = 0; d < 3; ++d)
+            if (dresult[d])
+                for (int c = 0; c < nchannels; ++c)
+                    dresult[d][c * BW + i] = dr[d][i][c];
+    }
     return ok;
 }
 
@@ -10,6 +10,7 @@
 #ifndef OPENIMAGEIO_TEXTURE_PVT_H
 #define OPENIMAGEIO_TEXTURE_PVT_H
 
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/texture.h>
 
@@ -119,6 +120,17 @@ public:
         return (TextureHandle*)find_texturefile(filename, thread_info);
     }
 
+    void get_texture_handles(cspan<ustring> filenames,
+                             span<TextureHandle*> handles, Perthread* thread)
+    {
+        PerThreadInfo* thread_info = thread
+                                         ? ((PerThreadInfo*)thread)
+                                         : m_imagecache->get_perthread_info();
+        span<TextureFile*> files((TextureFile**)handles.data(),
+                                 handles.size());
+        m_imagecache->find_files(filenames, files, thread_info);
+    }
+
     virtual bool good(TextureHandle* texture_handle)
     {
         return texture_handle && !((TextureFile*)texture_handle)->broken();
@@ -450,6 +462,61 @@ private:
                         simd::vfloat4* accum, simd::vfloat4* daccumds,
                         simd::vfloat4* daccumdt);
 
+    /// One probe of a batched lookup whose texel footprint lies entirely
+    /// within one tile: the MIP level and origin of that tile, the offset
+    /// (in pixels) of the footprint's first texel within the tile, and an
+    /// index for the caller to know which probe this is.
+    struct TileProbe {
+        int level, x, y, z;
+        int tilepel;
+        int index;
+    };
+    typedef function_view<void(const TileProbe& probe,
+                               const unsigned char* texel, int pixelsize)>
+        tile_gather_func;
+
+    /// The core shared by the batched lookups: sort the probes by tile,
+    /// find each distinct tile only once, and call gather() for every
+    /// probe with a pointer to the first channel of its first texel. The
+    /// probes are reordered. Return false if a tile could not be read.
+    bool gather_tile_probes(TextureFile& texturefile,
+                            PerThreadInfo* thread_info, TextureOpt& options,
+                            int actualchannels, TileProbe* probes, int nprobes,
+                            tile_gather_func gather);
+
+    /// One sample_bilinear() call's worth of work for a batched lookup.
+    /// As for the samplers, s, t and weight are padded to a multiple of 4.
+    struct BilinearJob {
+        int miplevel;
+        int nsamples;
+        const float *s, *t, *weight;
+        simd::vfloat4 *accum, *daccumds, *daccumdt;
+    };
+
+    /// Do all the jobs, giving each exactly the result that
+    /// sample_bilinear() would. The jobs whose samples all have their 2x2
+    /// texel footprint within one tile go through gather_tile_probes()
+    /// together, so a tile shared by many lanes is only looked up once;
+    /// the rest are handed to sample_bilinear().
+    bool sample_bilinear_batch(BilinearJob* jobs, int njobs,
+                               TextureFile& texturefile,
+                               PerThreadInfo* thread_info, TextureOpt& options,
+                               int nchannels_result, int actualchannels);
+
+    /// Choose the MIP levels and their weights for all lanes of a batch at
+    /// once, like compute_miplevels() does for one lookup. The filter
+    /// width is measured against min(width,height) of each level, or for
+    /// a lat-long environment map, against its height of PI radians. If
+    /// aspect is not NULL, it is clamped for filters thinner than the
+    /// finest level. The MipModeOneLevel adjustment is left to the caller.
+    static void compute_miplevels_batch(TextureFile& texturefile,
+                                        TextureOpt& options, bool latlong,
+                                        const Tex::FloatWide& majorlength,
+                                        const Tex::FloatWide& minorlength,
+                                        Tex::FloatWide* aspect,
+                                        Tex::IntWide* miplevel,
+                                        Tex::FloatWide* levelweight);
+
     // Define a prototype of a member function pointer for texture3d
     // lookups.
     typedef bool (TextureSystemImpl::*texture3d_lookup_prototype)(
@@ -483,6 +550,18 @@ private:
                                  float* daccumds, float* daccumdt,
                                  float* daccumdr);
 
+    /// Environment lookup of ONE point whose filter ellipse -- the unit
+    /// center direction R, the major axis direction Rmajor, and the axis
+    /// lengths (in radians) -- has already been computed. Results are
+    /// accumulated into the (zero-initialized) result arrays.
+    bool environment_lookup(TextureFile& texturefile,
+                            PerThreadInfo* thread_info, TextureOpt& options,
+                            int nchannels, int actualchannels,
+                            const Imath::V3f& R, const Imath::V3f& Rmajor,
+                            float majorlength, float minorlength,
+                            int naturalres, float* result, float* dresultds,
+                            float* dresultdt);
+
     /// Helper function to calculate the anisotropic aspect ratio from
     /// the major and minor ellipse axis lengths.  The "clamped" aspect
     /// ratio is returned (possibly adjusting major and minorlength to
@@ -507,6 +586,16 @@ private:
                          float* dresultds, float* dresultdt,
                          float* dresultdr = NULL);
 
+    /// Called when the requested texture is missing for a batch of
+    /// points, fills in the results for the lanes enabled by mask.
+    bool missing_texture_batch(TextureOpt& options, Tex::RunMask mask,
+                               int nchannels, float* result, float* dresultds,
+                               float* dresultdt, float* dresultdr = NULL);
+
+    /// Copy the options that are uniform across a batch into a TextureOpt.
+    static void batch_uniform_options(const TextureOptBatch& options,
+                                      TextureOpt& opt);
+
     /// Handle gray-to-RGB promotion.
     void fill_gray_channels(const ImageSpec& spec, int nchannels, float* result,
                             float* dresultds, float* dresultdt,
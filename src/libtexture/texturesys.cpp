@@ -3,6 +3,7 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <list>
@@ -79,6 +80,41 @@ half2float4(const half* h)
 }
 
 
+// Load the 2x2 texels of a bilinear footprint whose first texel is at p
+// and whose two rows are rowbytes apart, converting them to float.
+OIIO_FORCEINLINE void
+load_bilinear_texels(const unsigned char* p, int pixelsize, int rowbytes,
+                     TypeDesc::BASETYPE pixeltype, vfloat4 texel[2][2])
+{
+    if (pixeltype == TypeDesc::UINT8) {
+        texel[0][0] = uchar2float4(p);
+        texel[0][1] = uchar2float4(p + pixelsize);
+        p += rowbytes;
+        texel[1][0] = uchar2float4(p);
+        texel[1][1] = uchar2float4(p + pixelsize);
+    } else if (pixeltype == TypeDesc::UINT16) {
+        texel[0][0] = ushort2float4((uint16_t*)p);
+        texel[0][1] = ushort2float4((uint16_t*)(p + pixelsize));
+        p += rowbytes;
+        texel[1][0] = ushort2float4((uint16_t*)p);
+        texel[1][1] = ushort2float4((uint16_t*)(p + pixelsize));
+    } else if (pixeltype == TypeDesc::HALF) {
+        texel[0][0] = half2float4((half*)p);
+        texel[0][1] = half2float4((half*)(p + pixelsize));
+        p += rowbytes;
+        texel[1][0] = half2float4((half*)p);
+        texel[1][1] = half2float4((half*)(p + pixelsize));
+    } else {
+        OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+        texel[0][0].load((const float*)p);
+        texel[0][1].load((const float*)(p + pixelsize));
+        p += rowbytes;
+        texel[1][0].load((const float*)p);
+        texel[1][1].load((const float*)(p + pixelsize));
+    }
+}
+
+
 static const OIIO_SIMD4_ALIGN vbool4 channel_masks[5] = {
     vbool4(false, false, false, false), vbool4(true, false, false, false),
     vbool4(true, true, false, false),   vbool4(true, true, true, false),
@@ -121,6 +157,17 @@ TextureSystem::create(bool shared, ImageCache* imagecache)
 
 
 
+void
+TextureSystem::get_texture_handles(cspan<ustring> filenames,
+                                   span<TextureHandle*> handles,
+                                   Perthread* thread_info)
+{
+    ((TextureSystemImpl*)this)->get_texture_handles(filenames, handles,
+                                                    thread_info);
+}
+
+
+
 void
 TextureSystem::destroy(TextureSystem* x, bool teardown_imagecache)
 {
@@ -1150,58 +1197,52 @@ TextureSystemImpl::texture(ustring filename, TextureOptBatch& options,
 }
 
 
-bool
-TextureSystemImpl::texture(TextureHandle* texture_handle,
-                           Perthread* thread_info, TextureOptBatch& options,
-                           Tex::RunMask mask, const float* s, const float* t,
-                           const float* dsdx, const float* dtdx,
-                           const float* dsdy, const float* dtdy, int nchannels,
-                           float* result, float* dresultds, float* dresultdt)
+void
+TextureSystemImpl::batch_uniform_options(const TextureOptBatch& options,
+                                         TextureOpt& opt)
 {
-    // (FIXME) CHEAT! Texture points individually
-    TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
     opt.subimagename        = options.subimagename;
     opt.swrap               = (TextureOpt::Wrap)options.swrap;
     opt.twrap               = (TextureOpt::Wrap)options.twrap;
+    opt.rwrap               = (TextureOpt::Wrap)options.rwrap;
     opt.mipmode             = (TextureOpt::MipMode)options.mipmode;
     opt.interpmode          = (TextureOpt::InterpMode)options.interpmode;
     opt.anisotropic         = options.anisotropic;
     opt.conservative_filter = options.conservative_filter;
     opt.fill                = options.fill;
     opt.missingcolor        = options.missingcolor;
-    // rwrap not needed for 2D texture
-
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            // rblur, rwidth not needed for 2D texture
-            if (dresultds) {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
-                              drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
-            }
-        }
+    opt.envlayout           = options.envlayout;
+}
+
+
+
+bool
+TextureSystemImpl::missing_texture_batch(TextureOpt& options,
+                                         Tex::RunMask mask, int nchannels,
+                                         float* result, float* dresultds,
+                                         float* dresultdt, float* dresultdr)
+{
+    Tex::FloatWide zero = Tex::FloatWide::Zero();
+    for (int c = 0; c < nchannels; ++c) {
+        float val = options.missingcolor ? options.missingcolor[c]
+                                         : options.fill;
+        Tex::FloatWide(val).store_mask(int(mask), result + c * Tex::BatchWidth);
+        if (dresultds)
+            zero.store_mask(int(mask), dresultds + c * Tex::BatchWidth);
+        if (dresultdt)
+            zero.store_mask(int(mask), dresultdt + c * Tex::BatchWidth);
+        if (dresultdr)
+            zero.store_mask(int(mask), dresultdr + c * Tex::BatchWidth);
+    }
+    if (options.missingcolor) {
+        // don't treat it as an error if missingcolor was supplied
+        (void)geterror();  // eat the error
+        return true;
+    } else {
+        return false;
     }
-    return ok;
 }
 
 
@@ -1313,6 +1354,43 @@ adjust_width(float& dsdx, float& dtdx, float& dsdy, float& dtdy, float swidth,
 
 
 
+// The batched adjust_width(): scale and clamp the derivatives of all the
+// lanes of a batch at once.
+inline void
+adjust_width(Tex::FloatWide& dsdx, Tex::FloatWide& dtdx, Tex::FloatWide& dsdy,
+             Tex::FloatWide& dtdy, const Tex::FloatWide& swidth,
+             const Tex::FloatWide& twidth)
+{
+    using Tex::FloatWide;
+    dsdx *= swidth;
+    dtdx *= twidth;
+    dsdy *= swidth;
+    dtdy *= twidth;
+
+    // Clamp degenerate derivatives, making the same choices as the single
+    // point version, lane by lane.
+    static const float eps = 1.0e-8f, eps2 = eps * eps;
+    FloatWide dxlen2 = dsdx * dsdx + dtdx * dtdx;
+    FloatWide dylen2 = dsdy * dsdy + dtdy * dtdy;
+    auto tinydx      = dxlen2 < eps2;
+    auto tinydy      = dylen2 < eps2;
+    auto tinyboth    = tinydx & tinydy;
+    auto onlydx      = tinydx & !tinydy;
+    auto onlydy      = tinydy & !tinydx;
+    FloatWide xscale = FloatWide(eps) / sqrt(dylen2);
+    FloatWide yscale = FloatWide(eps) / sqrt(dxlen2);
+    FloatWide sdx    = select(onlydx, dtdy * xscale, dsdx);
+    FloatWide tdx    = select(onlydx, -dsdy * xscale, dtdx);
+    FloatWide sdy    = select(onlydy, -dtdx * yscale, dsdy);
+    FloatWide tdy    = select(onlydy, dsdx * yscale, dtdy);
+    dsdx             = select(tinyboth, FloatWide(eps), sdx);
+    dtdx             = select(tinyboth, FloatWide::Zero(), tdx);
+    dsdy             = select(tinyboth, FloatWide::Zero(), sdy);
+    dtdy             = select(tinyboth, FloatWide(eps), tdy);
+}
+
+
+
 // Adjust the ellipse major and minor axes based on the blur, if nonzero.
 // Trust user not to use nonsensical blur<0
 //
@@ -1436,6 +1514,69 @@ compute_miplevels(TextureSystemImpl::TextureFile& texturefile,
 
 
 
+void
+TextureSystemImpl::compute_miplevels_batch(TextureFile& texturefile,
+                                           TextureOpt& options, bool latlong,
+                                           const Tex::FloatWide& majorlength,
+                                           const Tex::FloatWide& minorlength,
+                                           Tex::FloatWide* aspect,
+                                           Tex::IntWide* miplevel,
+                                           Tex::FloatWide* levelweight)
+{
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    ImageCacheFile::SubimageInfo& subinfo(
+        texturefile.subimageinfo(options.subimage));
+    int nmiplevels       = (int)subinfo.levels.size();
+    int min_mip_level    = subinfo.min_mip_level;
+    IntWide lev0         = IntWide(-1);
+    IntWide lev1         = IntWide(-1);
+    FloatWide levelblend = FloatWide::Zero();
+    for (int m = min_mip_level; m < nmiplevels; ++m) {
+        // Each lane stops at the first level where its filter is smaller
+        // than one texel, as in compute_miplevels().
+        const ImageSpec& spec(subinfo.spec(m));
+        float res = latlong ? float(spec.full_height * M_1_PI)
+                            : float(std::min(spec.width, spec.height));
+        FloatWide filtwidth_ras = minorlength * res;
+        auto stop  = (filtwidth_ras <= 1.0f) & (lev1 < IntWide::Zero());
+        lev0       = select(stop, IntWide(m - 1), lev0);
+        lev1       = select(stop, IntWide(m), lev1);
+        levelblend = select(stop,
+                            min(max(2.0f * filtwidth_ras - 1.0f,
+                                    FloatWide::Zero()),
+                                FloatWide(1.0f)),
+                            levelblend);
+        if (all(lev1 >= IntWide::Zero()))
+            break;
+    }
+
+    // Lanes that want to blur more than the coarsest level allows, or
+    // that want more resolution than the finest level has, get just that
+    // one level.
+    auto coarsest = lev1 < IntWide::Zero();
+    auto finest   = !coarsest & (lev0 < IntWide(min_mip_level));
+    auto onelevel = coarsest | finest;
+    IntWide lev   = select(coarsest, IntWide(nmiplevels - 1),
+                         IntWide(min_mip_level));
+    miplevel[0]   = select(onelevel, lev, lev0);
+    miplevel[1]   = select(onelevel, lev, lev1);
+    levelblend    = select(onelevel, FloatWide::Zero(), levelblend);
+    if (aspect) {
+        // Clamp the aspect of a degenerate minor axis, as in
+        // compute_miplevels().
+        const ImageSpec& spec(subinfo.spec(0));
+        float r = float(std::max(spec.full_width, spec.full_height));
+        FloatWide clamped = min(max(majorlength * r * 2.0f, FloatWide(1.0f)),
+                                FloatWide(float(options.anisotropic)));
+        *aspect = select(finest & (minorlength * r < 0.5f), clamped, *aspect);
+    }
+    levelweight[0] = 1.0f - levelblend;
+    levelweight[1] = levelblend;
+}
+
+
+
 bool
 TextureSystemImpl::texture_lookup_trilinear_mipmap(
     TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
@@ -1641,6 +1782,38 @@ compute_ellipse_sampling(float aspect, float theta, float majorlength,
 
 
 
+// Compute the s and t positions of the nsamples samples along the major
+// axis, as given by compute_ellipse_sampling(), into sval[] and tval[],
+// which must be padded to a multiple of 4.
+inline void
+ellipse_sample_positions(float s, float t, float smajor, float tmajor,
+                         int nsamples, float invsamples, float* sval,
+                         float* tval)
+{
+#if OIIO_SIMD
+    // Do the computations in batches of 4, with SIMD ops.
+    static OIIO_SIMD4_ALIGN float iota_start[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+    vfloat4 iota                                = *(const vfloat4*)iota_start;
+    for (int sample = 0; sample < nsamples; sample += 4) {
+        vfloat4 pos = 2.0f * (iota * invsamples - 0.5f);
+        vfloat4 ss  = s + pos * smajor;
+        vfloat4 tt  = t + pos * tmajor;
+        ss.store(sval + sample);
+        tt.store(tval + sample);
+        iota += 4.0f;
+    }
+#else
+    // Non-SIMD, reference code
+    for (int sample = 0; sample < nsamples; ++sample) {
+        float pos = 2.0f * ((sample + 0.5f) * invsamples - 0.5f);
+        sval[sample] = s + pos * smajor;
+        tval[sample] = t + pos * tmajor;
+    }
+#endif
+}
+
+
+
 bool
 TextureSystemImpl::texture_lookup(TextureFile& texturefile,
                                   PerThreadInfo* thread_info,
@@ -1707,27 +1880,8 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     float* sval         = OIIO_ALLOCA(float, nsamples_padded);
     float* tval         = OIIO_ALLOCA(float, nsamples_padded);
 
-    // Compute the s and t positions of the samples along the major axis.
-#if OIIO_SIMD
-    // Do the computations in batches of 4, with SIMD ops.
-    static OIIO_SIMD4_ALIGN float iota_start[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
-    vfloat4 iota                                = *(const vfloat4*)iota_start;
-    for (int sample = 0; sample < nsamples; sample += 4) {
-        vfloat4 pos = 2.0f * (iota * invsamples - 0.5f);
-        vfloat4 ss  = s + pos * smajor;
-        vfloat4 tt  = t + pos * tmajor;
-        ss.store(sval + sample);
-        tt.store(tval + sample);
-        iota += 4.0f;
-    }
-#else
-    // Non-SIMD, reference code
-    for (int sample = 0; sample < nsamples; ++sample) {
-        float pos = 2.0f * ((sample + 0.5f) * invsamples - 0.5f);
-        sval[sample] = s + pos * smajor;
-        tval[sample] = t + pos * tmajor;
-    }
-#endif
+    ellipse_sample_positions(s, t, smajor, tmajor, nsamples, invsamples,
+                             sval, tval);
 
     vfloat4 r_sum, drds_sum, drdt_sum;
     r_sum.clear();
@@ -1745,7 +1899,9 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
         case TextureOpt::InterpClosest:
             ok &= sample_closest(nsamples, sval, tval, lev, texturefile,
                                  thread_info, options, nchannels_result,
-                                 actualchannels, lineweight, &r, NULL, NULL);
+                                 actualchannels, lineweight, &r,
+                                 dresultds ? &drds : NULL,
+                                 dresultds ? &drdt : NULL);
             ++closestprobes;
             break;
         case TextureOpt::InterpBilinear:
@@ -1816,6 +1972,423 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
 
 
 
+bool
+TextureSystemImpl::texture(TextureHandle* texture_handle_,
+                           Perthread* thread_info_, TextureOptBatch& options,
+                           Tex::RunMask mask, const float* s, const float* t,
+                           const float* dsdx, const float* dtdx,
+                           const float* dsdy, const float* dtdy, int nchannels,
+                           float* result, float* dresultds, float* dresultdt)
+{
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    // Handle >4 channel lookups by recursion, 4 channels at a time. The
+    // result arrays are [nchannels][BatchWidth], so each group of channels
+    // is a contiguous slab.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= texture(texture_handle_, thread_info_, options, mask, s, t,
+                          dsdx, dtdx, dsdy, dtdy, n, result, dresultds,
+                          dresultdt);
+            result += n * Tex::BatchWidth;
+            if (dresultds) {
+                dresultds += n * Tex::BatchWidth;
+                dresultdt += n * Tex::BatchWidth;
+            }
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+
+    TextureOpt opt;
+    batch_uniform_options(options, opt);
+
+    if (texturefile && texturefile->is_udim()) {
+        // Each lane may land in a different UDIM tile. Resolve them all,
+        // then issue one batched lookup per distinct concrete file, so
+        // that lanes sharing a tile still get the batched path.
+        alignas(Tex::BatchAlign) float sval[Tex::BatchWidth];
+        alignas(Tex::BatchAlign) float tval[Tex::BatchWidth];
+        TextureFile* lanefile[Tex::BatchWidth];
+        Tex::RunMask bit = 1;
+        for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
+            sval[i]     = s[i];
+            tval[i]     = t[i];
+            lanefile[i] = (mask & bit)
+                              ? m_imagecache->resolve_udim(texturefile,
+                                                           thread_info,
+                                                           sval[i], tval[i])
+                              : nullptr;
+        }
+        bool ok = true;
+        while (mask) {
+            int first = 0;
+            while (!(mask & (Tex::RunMask(1) << first)))
+                ++first;
+            TextureFile* file    = lanefile[first];
+            Tex::RunMask submask = 0;
+            for (int i = first; i < Tex::BatchWidth; ++i) {
+                bit = Tex::RunMask(1) << i;
+                if ((mask & bit) && lanefile[i] == file)
+                    submask |= bit;
+            }
+            if (file)
+                ok &= texture((TextureHandle*)file, (Perthread*)thread_info,
+                              options, submask, sval, tval, dsdx, dtdx, dsdy,
+                              dtdy, nchannels, result, dresultds, dresultdt);
+            else
+                ok &= missing_texture_batch(opt, submask, nchannels, result,
+                                            dresultds, dresultdt);
+            mask &= ~submask;
+        }
+        return ok;
+    }
+
+    texturefile = texturefile ? verify_texturefile(texturefile, thread_info)
+                              : nullptr;
+
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture_batches;
+    int nactive = 0;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++nactive;
+    stats.texture_queries += nactive;
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture_batch(opt, mask, nchannels, result, dresultds,
+                                     dresultdt);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int si = m_imagecache->subimage_from_name(texturefile,
+                                                  opt.subimagename);
+        if (si < 0) {
+            errorf("Unknown subimage \"%s\" in texture \"%s\"",
+                   opt.subimagename, texturefile->filename());
+            return missing_texture_batch(opt, mask, nchannels, result,
+                                         dresultds, dresultdt);
+        }
+        opt.subimage = si;
+        opt.subimagename.clear();
+    }
+
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(opt.subimage));
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    int actualchannels = Imath::clamp(spec.nchannels - opt.firstchannel, 0,
+                                      nchannels);
+    bool fill_gray = (actualchannels < nchannels && opt.firstchannel == 0
+                      && m_gray_to_rgb);
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+
+    if (subinfo.is_constant_image && opt.swrap != TextureOpt::WrapBlack
+        && opt.twrap != TextureOpt::WrapBlack) {
+        // Lookup of constant color texture, non-black wrap -- every lane
+        // gets the same answer, so broadcast it to all active lanes.
+        OIIO_SIMD4_ALIGN float color[4] = { opt.fill, opt.fill, opt.fill,
+                                            opt.fill };
+        OIIO_SIMD4_ALIGN float zero[4]  = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int c = 0; c < actualchannels; ++c)
+            color[c] = subinfo.average_color[c + opt.firstchannel];
+        if (fill_gray)
+            fill_gray_channels(spec, nchannels, color, dresultds ? zero : NULL,
+                               dresultds ? zero : NULL);
+        for (int c = 0; c < nchannels; ++c) {
+            Tex::FloatWide(color[c]).store_mask(int(mask),
+                                           result + c * Tex::BatchWidth);
+            if (dresultds) {
+                // Derivs are always 0 from a constant texture lookup
+                Tex::FloatWide::Zero().store_mask(int(mask),
+                                             dresultds + c * Tex::BatchWidth);
+                Tex::FloatWide::Zero().store_mask(int(mask),
+                                             dresultdt + c * Tex::BatchWidth);
+            }
+        }
+        return true;
+    }
+
+    // Apply the t flip and the overscan/crop remapping of the texture
+    // coordinates to all lanes at once.
+    Tex::FloatWide ss(s), tt(t);
+    Tex::FloatWide dsdxw(dsdx), dtdxw(dtdx), dsdyw(dsdy), dtdyw(dtdy);
+    if (m_flip_t) {
+        tt    = 1.0f - tt;
+        dtdxw = -dtdxw;
+        dtdyw = -dtdyw;
+    }
+    if (!subinfo.full_pixel_range) {  // remap st for overscan or crop
+        ss    = ss * subinfo.sscale + subinfo.soffset;
+        dsdxw = dsdxw * subinfo.sscale;
+        dsdyw = dsdyw * subinfo.sscale;
+        tt    = tt * subinfo.tscale + subinfo.toffset;
+        dtdxw = dtdxw * subinfo.tscale;
+        dtdyw = dtdyw * subinfo.tscale;
+    }
+    alignas(Tex::BatchAlign) float sval[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float tval[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float dsdxval[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float dtdxval[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float dsdyval[Tex::BatchWidth];
+    alignas(Tex::BatchAlign) float dtdyval[Tex::BatchWidth];
+    ss.store(sval);
+    tt.store(tval);
+    dsdxw.store(dsdxval);
+    dtdxw.store(dtdxval);
+    dsdyw.store(dsdyval);
+    dtdyw.store(dtdyval);
+
+    // Scale the derivatives by the filter widths, and choose the MIP
+    // levels and their weights, for all lanes at once. Only the filter
+    // ellipse of an anisotropic lookup (which needs double precision) and
+    // its sampling along the major axis are figured one lane at a time.
+    const int BW = Tex::BatchWidth;
+    using Tex::FloatWide;
+    FloatWide sdx = dsdxw, tdx = dtdxw, sdy = dsdyw, tdy = dtdyw;
+    adjust_width(sdx, tdx, sdy, tdy, FloatWide(options.swidth),
+                 FloatWide(options.twidth));
+    bool aniso = (opt.mipmode == TextureOpt::MipModeDefault
+                  || opt.mipmode == TextureOpt::MipModeAniso);
+    alignas(Tex::BatchAlign) float majorlength[BW];
+    alignas(Tex::BatchAlign) float minorlength[BW];
+    alignas(Tex::BatchAlign) float theta[BW];
+    alignas(Tex::BatchAlign) float aspect[BW];
+    alignas(Tex::BatchAlign) float trueaspect[BW];
+    alignas(Tex::BatchAlign) int naturalsres[BW];
+    alignas(Tex::BatchAlign) int naturaltres[BW];
+    Tex::IntWide levw[2];
+    FloatWide weightw[2];
+    Tex::RunMask bit;
+    if (opt.mipmode == TextureOpt::MipModeNoMIP) {
+        levw[0] = levw[1] = Tex::IntWide(subinfo.min_mip_level);
+        weightw[0]        = FloatWide(1.0f);
+        weightw[1]        = FloatWide::Zero();
+    } else if (!aniso) {
+        FloatWide sfilt     = max(abs(sdx), abs(sdy));
+        FloatWide tfilt     = max(abs(tdx), abs(tdy));
+        FloatWide filtwidth = opt.conservative_filter ? max(sfilt, tfilt)
+                                                      : min(sfilt, tfilt);
+        // account for blur
+        filtwidth += max(FloatWide(options.sblur), FloatWide(options.tblur));
+        compute_miplevels_batch(*texturefile, opt, false, filtwidth,
+                                filtwidth, NULL, levw, weightw);
+        if (opt.mipmode == TextureOpt::MipModeOneLevel) {
+            levw[0]    = levw[1];
+            weightw[0] = FloatWide(1.0f);
+            weightw[1] = FloatWide::Zero();
+        }
+    } else {
+        // The natural resolution of the bare derivatives is the threshold
+        // for knowing we're magnifying (and want smart bicubic).
+        FloatWide eps(1e-8f);
+        FloatWide sfilt_noblur = max(max(abs(dsdxw), abs(dsdyw)), eps);
+        FloatWide tfilt_noblur = max(max(abs(dtdxw), abs(dtdyw)), eps);
+        Tex::IntWide(1.0f / sfilt_noblur).store(naturalsres);
+        Tex::IntWide(1.0f / tfilt_noblur).store(naturaltres);
+        alignas(Tex::BatchAlign) float sdxval[BW], tdxval[BW];
+        alignas(Tex::BatchAlign) float sdyval[BW], tdyval[BW];
+        sdx.store(sdxval);
+        tdx.store(tdxval);
+        sdy.store(sdyval);
+        tdy.store(tdyval);
+        bit = 1;
+        for (int i = 0; i < BW; ++i, bit <<= 1) {
+            if (!(mask & bit)) {
+                majorlength[i] = minorlength[i] = aspect[i] = 1.0f;
+                continue;
+            }
+            ellipse_axes(sdxval[i], tdxval[i], sdyval[i], tdyval[i],
+                         majorlength[i], minorlength[i], theta[i]);
+            adjust_blur(majorlength[i], minorlength[i], theta[i],
+                        options.sblur[i], options.tblur[i]);
+            aspect[i] = anisotropic_aspect(majorlength[i], minorlength[i], opt,
+                                           trueaspect[i]);
+        }
+        FloatWide aspectw(aspect);
+        compute_miplevels_batch(*texturefile, opt, false,
+                                FloatWide(majorlength), FloatWide(minorlength),
+                                &aspectw, levw, weightw);
+        aspectw.store(aspect);
+    }
+    alignas(Tex::BatchAlign) int miplevel[2][BW];
+    alignas(Tex::BatchAlign) float levelweight[2][BW];
+    for (int level = 0; level < 2; ++level) {
+        levw[level].store(miplevel[level]);
+        weightw[level].store(levelweight[level]);
+    }
+
+    // Lay out the samples of each lane along its major axis (or just the
+    // one sample at the lookup point), each lane's padded to a multiple
+    // of 4 as the samplers expect.
+    int nsamples[BW], firstsample[BW];
+    float smajor[BW], tmajor[BW], invsamples[BW];
+    int totalsamples = 0;
+    bit              = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        nsamples[i] = 1;
+        if (aniso)
+            nsamples[i] = compute_ellipse_sampling(aspect[i], theta[i],
+                                                   majorlength[i],
+                                                   minorlength[i], smajor[i],
+                                                   tmajor[i], invsamples[i]);
+        firstsample[i] = totalsamples;
+        totalsamples += round_to_multiple_of_pow2(nsamples[i], 4);
+    }
+    float* samplebuf = OIIO_ALLOCA(float, 3 * totalsamples);
+    bit              = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        float* ss = samplebuf + firstsample[i];
+        float* tt = ss + totalsamples;
+        float* ww = tt + totalsamples;
+        if (aniso) {
+            compute_ellipse_sampling(aspect[i], theta[i], majorlength[i],
+                                     minorlength[i], smajor[i], tmajor[i],
+                                     invsamples[i], ww);
+            // The derivatives are pixel-to-pixel, so scale the diametric
+            // axes by 1/2, as texture_lookup() does.
+            ellipse_sample_positions(sval[i], tval[i], 0.5f * smajor[i],
+                                     0.5f * tmajor[i], nsamples[i],
+                                     invsamples[i], ss, tt);
+        } else {
+            for (int j = 0; j < 4; ++j) {
+                ss[j] = j ? 0.0f : sval[i];
+                tt[j] = j ? 0.0f : tval[i];
+                ww[j] = j ? 0.0f : 1.0f;
+            }
+        }
+    }
+
+    // Sample each level of each lane. All the bilinear samples of the
+    // batch are gathered together, so that lanes whose footprints share a
+    // tile find it just once; closest and bicubic samples are done lane
+    // by lane.
+    bool ok = true;
+    BilinearJob jobs[2 * BW];
+    int njobs = 0;
+    vfloat4 r[BW][2], drds[BW][2], drdt[BW][2];
+    bit = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        const float* ss   = samplebuf + firstsample[i];
+        const float* tt   = ss + totalsamples;
+        const float* ww   = tt + totalsamples;
+        int npointson     = 0;
+        int closestprobes = 0, bilinearprobes = 0, bicubicprobes = 0;
+        for (int level = 0; level < 2; ++level) {
+            if (!levelweight[level][i])  // No contribution from this level
+                continue;
+            ++npointson;
+            int lev = miplevel[level][i];
+            vfloat4* drdsl = dresultds ? &drds[i][level] : NULL;
+            vfloat4* drdtl = dresultds ? &drdt[i][level] : NULL;
+            TextureOpt::InterpMode interp = opt.interpmode;
+            if (interp == TextureOpt::InterpSmartBicubic) {
+                const ImageSpec& levspec(texturefile->spec(opt.subimage, lev));
+                bool bicubic = aniso
+                               && (lev == 0
+                                   || levspec.width < naturalsres[i] / 2
+                                   || levspec.height < naturaltres[i] / 2);
+                interp = bicubic ? TextureOpt::InterpBicubic
+                                 : TextureOpt::InterpBilinear;
+            }
+            if (interp == TextureOpt::InterpBilinear) {
+                BilinearJob& job(jobs[njobs++]);
+                job.miplevel = lev;
+                job.nsamples = nsamples[i];
+                job.s        = ss;
+                job.t        = tt;
+                job.weight   = ww;
+                job.accum    = &r[i][level];
+                job.daccumds = drdsl;
+                job.daccumdt = drdtl;
+                ++bilinearprobes;
+            } else if (interp == TextureOpt::InterpClosest) {
+                ok &= sample_closest(nsamples[i], ss, tt, lev, *texturefile,
+                                     thread_info, opt, nchannels,
+                                     actualchannels, ww, &r[i][level], drdsl,
+                                     drdtl);
+                ++closestprobes;
+            } else {
+                ok &= sample_bicubic(nsamples[i], ss, tt, lev, *texturefile,
+                                     thread_info, opt, nchannels,
+                                     actualchannels, ww, &r[i][level], drdsl,
+                                     drdtl);
+                ++bicubicprobes;
+            }
+        }
+        stats.aniso_queries += npointson;
+        stats.aniso_probes += npointson * nsamples[i];
+        if (aniso && trueaspect[i] > stats.max_aniso)
+            stats.max_aniso = trueaspect[i];  // FIXME?
+        stats.closest_interps += closestprobes * nsamples[i];
+        stats.bilinear_interps += bilinearprobes * nsamples[i];
+        stats.cubic_interps += bicubicprobes * nsamples[i];
+    }
+    ok &= sample_bilinear_batch(jobs, njobs, *texturefile, thread_info, opt,
+                                nchannels, actualchannels);
+
+    // Blend the levels of each lane and scatter the results.
+    bit = 1;
+    for (int i = 0; i < BW; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        vfloat4 r_sum = vfloat4::Zero();
+        vfloat4 drds_sum = vfloat4::Zero(), drdt_sum = vfloat4::Zero();
+        for (int level = 0; level < 2; ++level) {
+            if (!levelweight[level][i])
+                continue;
+            vfloat4 lw = levelweight[level][i];
+            r_sum += lw * r[i][level];
+            if (dresultds) {
+                drds_sum += lw * drds[i][level];
+                drdt_sum += lw * drdt[i][level];
+            }
+        }
+        if (fill_gray)
+            fill_gray_channels(spec, nchannels, (float*)&r_sum,
+                               dresultds ? (float*)&drds_sum : NULL,
+                               dresultds ? (float*)&drdt_sum : NULL);
+        for (int c = 0; c < nchannels; ++c)
+            result[c * BW + i] = r_sum[c];
+        if (dresultds) {
+            if (m_flip_t)
+                drdt_sum = -drdt_sum;
+            for (int c = 0; c < nchannels; ++c) {
+                dresultds[c * BW + i] = drds_sum[c];
+                dresultdt[c * BW + i] = drdt_sum[c];
+            }
+        }
+    }
+    return ok;
+}
+
+
+
 const float*
 TextureSystemImpl::pole_color(TextureFile& texturefile,
                               PerThreadInfo* /*thread_info*/,
@@ -2160,32 +2733,8 @@ TextureSystemImpl::sample_bilinear(
             const unsigned char* p = tile->bytedata() + offset
                                      + channelsize
                                            * (firstchannel - id.chbegin());
-            if (pixeltype == TypeDesc::UINT8) {
-                texel_simd[0][0] = uchar2float4(p);
-                texel_simd[0][1] = uchar2float4(p + pixelsize);
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = uchar2float4(p);
-                texel_simd[1][1] = uchar2float4(p + pixelsize);
-            } else if (pixeltype == TypeDesc::UINT16) {
-                texel_simd[0][0] = ushort2float4((uint16_t*)p);
-                texel_simd[0][1] = ushort2float4((uint16_t*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = ushort2float4((uint16_t*)p);
-                texel_simd[1][1] = ushort2float4((uint16_t*)(p + pixelsize));
-            } else if (pixeltype == TypeDesc::HALF) {
-                texel_simd[0][0] = half2float4((half*)p);
-                texel_simd[0][1] = half2float4((half*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = half2float4((half*)p);
-                texel_simd[1][1] = half2float4((half*)(p + pixelsize));
-            } else {
-                OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                texel_simd[0][0].load((const float*)p);
-                texel_simd[0][1].load((const float*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0].load((const float*)p);
-                texel_simd[1][1].load((const float*)(p + pixelsize));
-            }
+            load_bilinear_texels(p, pixelsize, pixelsize * spec.tile_width,
+                                 pixeltype, texel_simd);
         } else {
             bool noreusetile      = (options.swrap == TextureOpt::WrapMirror);
             simd::vint4 tile_st   = (sttex - xy) % tilewh;
@@ -2298,6 +2847,238 @@ TextureSystemImpl::sample_bilinear(
 }
 
 
+bool
+TextureSystemImpl::gather_tile_probes(TextureFile& texturefile,
+                                      PerThreadInfo* thread_info,
+                                      TextureOpt& options, int actualchannels,
+                                      TileProbe* probes, int nprobes,
+                                      tile_gather_func gather)
+{
+    // Sort the probes so that all of those on any one tile are adjacent.
+    auto tile_order = [](const TileProbe& a, const TileProbe& b) {
+        if (a.level != b.level)
+            return a.level < b.level;
+        if (a.z != b.z)
+            return a.z < b.z;
+        if (a.y != b.y)
+            return a.y < b.y;
+        return a.x < b.x;
+    };
+    std::sort(probes, probes + nprobes, tile_order);
+
+    const ImageSpec& spec(texturefile.spec(options.subimage, 0));
+    int tile_chbegin = 0, tile_chend = spec.nchannels;
+    if (spec.nchannels > m_max_tile_channels) {
+        // For files with many channels, narrow the range we cache
+        tile_chbegin = options.firstchannel;
+        tile_chend   = options.firstchannel + actualchannels;
+    }
+    size_t chanoffset = texturefile.channelsize(options.subimage)
+                        * (options.firstchannel - tile_chbegin);
+    for (int first = 0, end = 0; first < nprobes; first = end) {
+        const TileProbe& probe(probes[first]);
+        for (end = first + 1;
+             end < nprobes && !tile_order(probe, probes[end]); ++end)
+            ;
+        TileID id(texturefile, options.subimage, probe.level, probe.x,
+                  probe.y, probe.z, tile_chbegin, tile_chend);
+        bool ok = find_tile(id, thread_info, true);
+        if (!ok)
+            errorf("%s", m_imagecache->geterror());
+        TileRef& tile(thread_info->tile);
+        if (!tile->valid())
+            return false;
+        int pixelsize             = tile->pixelsize();
+        const unsigned char* data = tile->bytedata() + chanoffset;
+        for (int i = first; i < end; ++i)
+            gather(probes[i], data + size_t(pixelsize) * probes[i].tilepel,
+                   pixelsize);
+    }
+    return true;
+}
+
+
+
+bool
+TextureSystemImpl::sample_bilinear_batch(BilinearJob* jobs, int njobs,
+                                         TextureFile& texturefile,
+                                         PerThreadInfo* thread_info,
+                                         TextureOpt& options,
+                                         int nchannels_result,
+                                         int actualchannels)
+{
+    // The samples of the jobs waiting to be gathered, each with the
+    // fractional position within its 2x2 footprint and, once gathered,
+    // the interpolated value and its differences in s and t.
+    enum { MaxSamples = 128 };
+    TileProbe probes[MaxSamples];
+    float sfrac[MaxSamples], tfrac[MaxSamples];
+    bool inrange[MaxSamples];  // false if all its texels are black wrap
+    vfloat4 value[MaxSamples], dvalueds[MaxSamples], dvaluedt[MaxSamples];
+    int pending[MaxSamples];
+    int npending = 0, nsamples = 0, nprobes = 0;
+
+    TypeDesc::BASETYPE pixeltype = texturefile.pixeltype(options.subimage);
+    wrap_impl swrap_func         = wrap_functions[(int)options.swrap];
+    wrap_impl twrap_func         = wrap_functions[(int)options.twrap];
+    wrap_impl_simd wrap_func     = (swrap_func == twrap_func)
+                                   ? wrap_functions_simd[(int)options.swrap]
+                                   : NULL;
+    bool derivs         = (njobs && jobs[0].daccumds);
+    bool use_fill       = (nchannels_result > actualchannels && options.fill);
+    vbool4 channel_mask = channel_masks[actualchannels];
+    enum { S0 = 0, S1 = 1, T0 = 2, T1 = 3 };
+
+    // Find the footprints of all of a job's samples, exactly as
+    // sample_bilinear() would. Only if every footprint lies within one
+    // tile and has all its texels in range (or none of them) is the job
+    // added to the pending ones.
+    auto add_job = [&](const BilinearJob& job) -> bool {
+        const ImageSpec& spec(texturefile.spec(options.subimage, job.miplevel));
+        const ImageCacheFile::LevelInfo& levelinfo(
+            texturefile.levelinfo(options.subimage, job.miplevel));
+        if (options.envlayout == LayoutLatLong && levelinfo.onetile)
+            return false;  // may need to fade to the pole color
+        vint4 xy(spec.x, spec.y);
+        vint4 widthheight(spec.width, spec.height);
+        vint4 tilewh(spec.tile_width, spec.tile_height);
+        vint4 tilewhmask = tilewh - 1;
+        bool tilepow2    = ispow2(spec.tile_width) && ispow2(spec.tile_height);
+        int slot = nsamples, probe = nprobes;
+        vfloat4 s_simd, t_simd;
+        vint4 sint_simd, tint_simd;
+        vfloat4 sfrac_simd, tfrac_simd;
+        for (int sample = 0; sample < job.nsamples; ++sample, ++slot) {
+            int sample4 = sample & 3;
+            if (sample4 == 0) {
+                s_simd.load(job.s + sample);
+                t_simd.load(job.t + sample);
+                st_to_texel_simd(s_simd, t_simd, texturefile, spec, sint_simd,
+                                 tint_simd, sfrac_simd, tfrac_simd);
+            }
+            int sint = sint_simd[sample4], tint = tint_simd[sample4];
+            vint4 sttex(sint, sint + 1, tint, tint + 1);
+            vbool4 stvalid;
+            if (wrap_func) {
+                stvalid = wrap_func(sttex, xy, widthheight);
+            } else {
+                stvalid.load(swrap_func(sttex[S0], spec.x, spec.width),
+                             swrap_func(sttex[S1], spec.x, spec.width),
+                             twrap_func(sttex[T0], spec.y, spec.height),
+                             twrap_func(sttex[T1], spec.y, spec.height));
+            }
+            if (!levelinfo.full_pixel_range)
+                stvalid &= (sttex >= xy) & (sttex < (xy + widthheight));
+            inrange[slot] = !none(stvalid);
+            if (!inrange[slot])
+                continue;
+            if (!all(stvalid))
+                return false;
+            vint4 tile_st = vint4(simd::shuffle<S0, S0, T0, T0>(sttex)) - xy;
+            if (tilepow2)
+                tile_st &= tilewhmask;
+            else
+                tile_st %= tilewh;
+            bool s_onetile = (tile_st[S0] != tilewhmask[S0])
+                             & (sttex[S0] + 1 == sttex[S1]);
+            bool t_onetile = (tile_st[T0] != tilewhmask[T0])
+                             & (sttex[T0] + 1 == sttex[T1]);
+            if (!(s_onetile & t_onetile))
+                return false;
+            TileProbe& p(probes[probe++]);
+            p.level     = job.miplevel;
+            p.x         = sttex[S0] - tile_st[S0];
+            p.y         = sttex[T0] - tile_st[T0];
+            p.z         = 0;
+            p.tilepel   = tile_st[T0] * spec.tile_width + tile_st[S0];
+            p.index     = slot;
+            sfrac[slot] = sfrac_simd[sample4];
+            tfrac[slot] = tfrac_simd[sample4];
+        }
+        nsamples = slot;
+        nprobes  = probe;
+        return true;
+    };
+
+    // Gather the footprints of all the pending jobs, finding each tile
+    // just once, then add up the samples of each job in order, as
+    // sample_bilinear() does.
+    auto gather = [&](const TileProbe& probe, const unsigned char* texel,
+                      int pixelsize) {
+        int i = probe.index;
+        int rowbytes
+            = pixelsize
+              * texturefile.spec(options.subimage, probe.level).tile_width;
+        vfloat4 t[2][2];
+        load_bilinear_texels(texel, pixelsize, rowbytes, pixeltype, t);
+        value[i] = bilerp(t[0][0], t[0][1], t[1][0], t[1][1], sfrac[i],
+                          tfrac[i]);
+        if (derivs) {
+            dvalueds[i] = lerp(t[0][1] - t[0][0], t[1][1] - t[1][0], tfrac[i]);
+            dvaluedt[i] = lerp(t[1][0] - t[0][0], t[1][1] - t[0][1], sfrac[i]);
+        }
+    };
+    bool ok    = true;
+    auto flush = [&]() {
+        bool gathered = gather_tile_probes(texturefile, thread_info, options,
+                                           actualchannels, probes, nprobes,
+                                           gather);
+        ok &= gathered;
+        for (int j = 0, slot = 0; j < npending; ++j) {
+            const BilinearJob& job(jobs[pending[j]]);
+            const ImageSpec& spec(
+                texturefile.spec(options.subimage, job.miplevel));
+            vfloat4 accum = vfloat4::Zero();
+            vfloat4 daccumds = vfloat4::Zero(), daccumdt = vfloat4::Zero();
+            float nonfill = 0.0f;
+            for (int sample = 0; sample < job.nsamples; ++sample, ++slot) {
+                float weight = job.weight[sample];
+                if (!inrange[slot] || !gathered) {
+                    nonfill += weight;
+                    continue;
+                }
+                vfloat4 weight_simd = weight;
+                accum += weight_simd * value[slot];
+                if (derivs) {
+                    vfloat4 scalex = weight_simd * float(spec.width);
+                    vfloat4 scaley = weight_simd * float(spec.height);
+                    daccumds += scalex * dvalueds[slot];
+                    daccumdt += scaley * dvaluedt[slot];
+                }
+            }
+            accum = blend0(accum, channel_mask);
+            if (use_fill)
+                accum += blend0not(vfloat4((1.0f - nonfill) * options.fill),
+                                   channel_mask);
+            *job.accum = accum;
+            if (derivs) {
+                *job.daccumds = blend0(daccumds, channel_mask);
+                *job.daccumdt = blend0(daccumdt, channel_mask);
+            }
+        }
+        npending = nsamples = nprobes = 0;
+    };
+
+    for (int j = 0; j < njobs; ++j) {
+        BilinearJob& job(jobs[j]);
+        if (npending && nsamples + job.nsamples > MaxSamples)
+            flush();
+        if (job.nsamples <= MaxSamples && add_job(job)) {
+            pending[npending++] = j;
+        } else {
+            ok &= sample_bilinear(job.nsamples, job.s, job.t, job.miplevel,
+                                  texturefile, thread_info, options,
+                                  nchannels_result, actualchannels,
+                                  job.weight, job.accum, job.daccumds,
+                                  job.daccumdt);
+        }
+    }
+    if (npending)
+        flush();
+    return ok;
+}
+
+
 namespace {
 
     // Evaluate Bspline weights for both value and derivatives (if dw is not
@@ -23,6 +23,9 @@
 #    include <io.h>
 #    include <shellapi.h>
 #else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
 #    include <unistd.h>
 #endif
 
@@ -1029,7 +1032,7 @@ Filesystem::IOFile::pwrite(const void* buf, size_t size, int64_t offset)
     size_t r = ::pwrite(fd, buf, size, offset);
 #endif
     offset += r;
-    if (m_pos > int64_t(m_size))
+    if (offset > int64_t(m_size))
         m_size = offset;
     return r;
 }
@@ -1093,6 +1096,8 @@ size_t
 Filesystem::IOMemReader::pread(void* buf, size_t size, int64_t offset)
 {
     // N.B. No lock necessary
+    if (offset < 0 || size_t(offset) >= size_t(m_buf.size()))
+        return 0;
     if (size + size_t(offset) > size_t(m_buf.size()))
         size = m_buf.size() - size_t(offset);
     memcpy(buf, m_buf.data() + offset, size);
@@ -1100,4 +1105,148 @@ Filesystem::IOMemReader::pread(void* buf, size_t size, int64_t offset)
 }
 
 
+
+Filesystem::IOMMap::IOMMap(string_view filename)
+    : IOMemReader(cspan<unsigned char>())
+{
+    m_filename       = filename;
+    const void* data = nullptr;
+    size_t size      = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Strutil::utf8_to_utf16(m_filename).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fsize;
+        if (GetFileSizeEx(file, &fsize) && fsize.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0,
+                                                0, NULL);
+            if (mapping) {
+                data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (data)
+                    size = size_t(fsize.QuadPart);
+                CloseHandle(mapping);  // the view keeps the mapping alive
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = ::open(m_filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED,
+                           fd, 0);
+            if (p != MAP_FAILED) {
+                data = p;
+                size = size_t(st.st_size);
+            }
+        }
+        ::close(fd);  // the mapping stays valid after the descriptor closes
+    }
+#endif
+    if (data) {
+        m_buf = cspan<unsigned char>((const unsigned char*)data, size);
+    } else {
+        m_mode = Closed;
+        error(Strutil::sprintf("Could not map \"%s\"", m_filename));
+    }
+}
+
+
+
+Filesystem::IOMMap::~IOMMap() { close(); }
+
+
+
+void
+Filesystem::IOMMap::close()
+{
+    if (m_buf.data()) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_buf.data());
+#else
+        munmap((void*)m_buf.data(), m_buf.size());
+#endif
+    }
+    m_buf  = cspan<unsigned char>();
+    m_mode = Closed;
+}
+
+
+
+Filesystem::IOProxyStreambuf::IOProxyStreambuf(IOProxy* io, size_t bufsize)
+    : m_io(io)
+{
+    auto mem = dynamic_cast<IOMemReader*>(io);
+    if (mem && mem->buffer().size()) {
+        // Everything is already in memory, so make the whole buffer our
+        // get area rather than copying blocks of it.
+        char* base  = (char*)mem->buffer().data();
+        size_t size = mem->buffer().size();
+        int64_t pos = std::min(std::max(mem->tell(), int64_t(0)),
+                               int64_t(size));
+        m_bufpos    = 0;
+        m_inmemory  = true;
+        setg(base, base + pos, base + size);
+        return;
+    }
+    m_buf.resize(bufsize);
+    m_bufpos = m_io ? m_io->tell() : 0;
+    setg(m_buf.data(), m_buf.data(), m_buf.data());
+}
+
+
+
+std::streambuf::int_type
+Filesystem::IOProxyStreambuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if (!m_io || m_inmemory)
+        return traits_type::eof();
+    m_bufpos += egptr() - eback();
+    size_t n = m_io->pread(m_buf.data(), m_buf.size(), m_bufpos);
+    setg(m_buf.data(), m_buf.data(), m_buf.data() + n);
+    if (!n)
+        return traits_type::eof();
+    return traits_type::to_int_type(*gptr());
+}
+
+
+
+std::streambuf::pos_type
+Filesystem::IOProxyStreambuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                      std::ios_base::openmode which)
+{
+    int64_t pos = off;
+    if (dir == std::ios_base::cur)
+        pos += m_bufpos + (gptr() - eback());
+    else if (dir == std::ios_base::end)
+        pos += m_io ? int64_t(m_io->size()) : 0;
+    return seekpos(pos_type(off_type(pos)), which);
+}
+
+
+
+std::streambuf::pos_type
+Filesystem::IOProxyStreambuf::seekpos(pos_type pos,
+                                      std::ios_base::openmode which)
+{
+    int64_t p = off_type(pos);
+    if (!(which & std::ios_base::in) || p < 0)
+        return pos_type(off_type(-1));
+    if (m_inmemory && p > egptr() - eback())
+        return pos_type(off_type(-1));  // can't seek past the end
+    if (p >= m_bufpos && p <= m_bufpos + (egptr() - eback())) {
+        // Within the current buffer, just move the get pointer
+        setg(eback(), eback() + (p - m_bufpos), egptr());
+    } else {
+        m_bufpos = p;
+        setg(m_buf.data(), m_buf.data(), m_buf.data());
+    }
+    return pos;
+}
+
+
 OIIO_NAMESPACE_END
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -509,6 +510,125 @@ test_mem_proxies()
 
 
 
+void
+test_mmap_proxy()
+{
+    std::cout << "Testing memory mapped file proxy:\n";
+    // Big enough to span several pages, and not a multiple of their size
+    std::vector<unsigned char> data(100003);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (unsigned char)(i * 7 + (i >> 8));
+    const std::string filename = "testfile_mmap";
+    {
+        Filesystem::IOFile f(filename, Filesystem::IOProxy::Mode::Write);
+        f.write(data.data(), data.size());
+    }
+
+    Filesystem::IOMMap m(filename);
+    OIIO_CHECK_ASSERT(m.mode() == Filesystem::IOProxy::Mode::Read);
+    OIIO_CHECK_EQUAL(m.size(), data.size());
+    OIIO_CHECK_EQUAL(m.buffer().size(), data.size());
+    OIIO_CHECK_ASSERT(m.buffer().data()
+                      && memcmp(m.buffer().data(), data.data(), data.size())
+                             == 0);
+    unsigned char b[16];
+    OIIO_CHECK_EQUAL(m.pread(b, 16, 4090), size_t(16));
+    OIIO_CHECK_ASSERT(memcmp(b, data.data() + 4090, 16) == 0);
+    m.seek(data.size() - 5);
+    OIIO_CHECK_EQUAL(m.read(b, 16), size_t(5));  // short read at the end
+    OIIO_CHECK_ASSERT(memcmp(b, data.data() + data.size() - 5, 5) == 0);
+    OIIO_CHECK_EQUAL(m.read(b, 16), size_t(0));
+    m.close();
+    OIIO_CHECK_ASSERT(m.mode() == Filesystem::IOProxy::Mode::Closed);
+    OIIO_CHECK_EQUAL(m.buffer().size(), size_t(0));
+
+    // Files that can't be mapped leave the proxy closed
+    {
+        Filesystem::IOFile f("testfile_mmap_empty",
+                             Filesystem::IOProxy::Mode::Write);
+    }
+    Filesystem::IOMMap empty("testfile_mmap_empty");
+    OIIO_CHECK_ASSERT(empty.mode() == Filesystem::IOProxy::Mode::Closed);
+    Filesystem::IOMMap missing("testfile_mmap_missing");
+    OIIO_CHECK_ASSERT(missing.mode() == Filesystem::IOProxy::Mode::Closed);
+
+    Filesystem::remove(filename);
+    Filesystem::remove("testfile_mmap_empty");
+}
+
+
+
+// Run the same reads and seeks through an istream on an IOProxyStreambuf,
+// whether it reads the proxy in blocks or an in-memory proxy in place.
+static void
+check_proxy_streambuf(Filesystem::IOProxy* io,
+                      const std::vector<unsigned char>& data, size_t bufsize)
+{
+    io->seek(100);  // the stream starts where the proxy is
+    Filesystem::IOProxyStreambuf sb(io, bufsize);
+    std::istream in(&sb);
+    OIIO_CHECK_EQUAL(in.get(), data[100]);
+
+    // Read across block boundaries
+    std::vector<char> b(bufsize * 3 + 5);
+    in.read(b.data(), b.size());
+    OIIO_CHECK_ASSERT(in.good());
+    OIIO_CHECK_ASSERT(memcmp(b.data(), data.data() + 101, b.size()) == 0);
+    OIIO_CHECK_EQUAL(in.tellg(), std::streampos(101 + b.size()));
+
+    // Seek backwards, forwards, relative, and from the end
+    in.seekg(7);
+    OIIO_CHECK_EQUAL(in.get(), data[7]);
+    in.seekg(data.size() / 2);
+    OIIO_CHECK_EQUAL(in.get(), data[data.size() / 2]);
+    in.seekg(-3, std::ios::cur);
+    OIIO_CHECK_EQUAL(in.get(), data[data.size() / 2 - 2]);
+    in.seekg(-10, std::ios::end);
+    in.read(b.data(), 10);
+    OIIO_CHECK_ASSERT(memcmp(b.data(), data.data() + data.size() - 10, 10)
+                      == 0);
+
+    // Reading off the end fails, and seeking back recovers
+    OIIO_CHECK_EQUAL(in.get(), std::istream::traits_type::eof());
+    OIIO_CHECK_ASSERT(in.eof());
+    in.clear();
+    in.seekg(0);
+    OIIO_CHECK_EQUAL(in.get(), data[0]);
+}
+
+
+
+void
+test_proxy_streambuf()
+{
+    std::cout << "Testing IOProxyStreambuf:\n";
+    std::vector<unsigned char> data(5000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (unsigned char)(i * 13 + 1);
+    const std::string filename = "testfile_streambuf";
+    {
+        Filesystem::IOFile f(filename, Filesystem::IOProxy::Mode::Write);
+        f.write(data.data(), data.size());
+    }
+
+    // Blocks read through the proxy
+    Filesystem::IOFile file(filename, Filesystem::IOProxy::Mode::Read);
+    check_proxy_streambuf(&file, data, 64);
+    // In place, over a memory buffer and over a mapped file
+    Filesystem::IOMemReader mem(data);
+    check_proxy_streambuf(&mem, data, 64);
+    Filesystem::IOMMap mapped(filename);
+    OIIO_CHECK_ASSERT(mapped.mode() == Filesystem::IOProxy::Mode::Read);
+    if (mapped.mode() == Filesystem::IOProxy::Mode::Read)
+        check_proxy_streambuf(&mapped, data, 64);
+    file.close();
+    mapped.close();
+
+    Filesystem::remove(filename);
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -518,6 +638,8 @@ main(int /*argc*/, char* /*argv*/[])
     test_frame_sequences();
     test_scan_sequences();
     test_mem_proxies();
+    test_mmap_proxy();
+    test_proxy_streambuf();
 
     return unit_test_failures;
 }
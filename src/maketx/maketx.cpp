@@ -164,6 +164,7 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     std::string compression = "zip";
     bool updatemode         = false;
     bool checknan           = false;
+    bool stream             = false;
     std::string fixnan;  // none, black, box3
     bool set_full_to_pixels        = false;
     bool do_highlight_compensation = false;
@@ -228,6 +229,7 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
                           "Compress HDR range before resize, expand after.",
                   "--sharpen %f", &sharpen, "Sharpen MIP levels (default = 0.0 = no)",
                   "--nomipmap", &nomipmap, "Do not make multiple MIP-map levels",
+                  "--stream", &stream, "Build the texture a tile row at a time, for images larger than memory",
                   "--checknan", &checknan, "Check for NaN/Inf values (abort if found)",
                   "--fixnan %s", &fixnan, "Attempt to fix NaN/Inf values in the image (options: none, black, box3)",
                   "--fullpixels", &set_full_to_pixels, "Set the 'full' image range to be the pixel data window",
@@ -360,6 +362,7 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     configspec.attribute("maketx:runstats", runstats);
     configspec.attribute("maketx:resize", doresize);
     configspec.attribute("maketx:nomipmap", nomipmap);
+    configspec.attribute("maketx:stream", stream);
     configspec.attribute("maketx:updatemode", updatemode);
     configspec.attribute("maketx:constant_color_detect", constant_color_detect);
     configspec.attribute("maketx:monochrome_detect", monochrome_detect);
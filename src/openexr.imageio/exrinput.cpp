@@ -176,6 +176,15 @@ public:
                                         int xend, int ybegin, int yend,
                                         int zbegin, int zend, int chbegin,
                                         int chend, DeepData& deepdata) override;
+    virtual bool read_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, int chbegin, int chend,
+                                TypeDesc format, void* data, stride_t xstride,
+                                stride_t ystride) override;
+    virtual bool read_tiles(int subimage, int miplevel, int xbegin, int xend,
+                            int ybegin, int yend, int zbegin, int zend,
+                            int chbegin, int chend, TypeDesc format, void* data,
+                            stride_t xstride, stride_t ystride,
+                            stride_t zstride) override;
 
     virtual bool set_ioproxy(Filesystem::IOProxy* ioproxy) override
     {
@@ -265,6 +274,22 @@ private:
                                         int chend, void* data, stride_t xstride,
                                         stride_t ystride);
 
+    // Can OpenEXR itself deliver channels [chbegin,chend) of the current
+    // subimage as the given format, into the caller's buffer and strides?
+    bool can_read_direct(int chbegin, int chend, TypeDesc format,
+                         stride_t xstride, stride_t ystride) const;
+
+    // Read scanlines, or a valid range of tiles, of the current subimage
+    // and MIP level straight into the caller's buffer, converting to
+    // format, which must have passed can_read_direct(). Must be called
+    // with m_mutex held.
+    bool read_scanlines_direct(int ybegin, int yend, int chbegin, int chend,
+                               TypeDesc format, void* data, stride_t xstride,
+                               stride_t ystride);
+    bool read_tiles_direct(int xbegin, int xend, int ybegin, int yend,
+                           int chbegin, int chend, TypeDesc format, void* data,
+                           stride_t xstride, stride_t ystride);
+
     // Fill in with 'missing' color/pattern.
     void fill_missing(int xbegin, int xend, int ybegin, int yend, int zbegin,
                       int zend, int chbegin, int chend, void* data,
@@ -1469,6 +1494,168 @@ OpenEXRInput::fill_missing(int xbegin, int xend, int ybegin, int yend,
 
 
 
+bool
+OpenEXRInput::can_read_direct(int chbegin, int chend, TypeDesc format,
+                              stride_t xstride, stride_t ystride) const
+{
+    // OpenEXR converts between half and float exactly as convert_image
+    // would, but its conversions to and from uint don't scale the way
+    // ours do, so only take this path for half and float on both sides.
+    // Also leave negative (flipped) strides to the general path.
+    if (format != TypeHalf && format != TypeFloat)
+        return false;
+    if (m_spec.deep || xstride <= 0 || ystride <= 0)
+        return false;
+    const PartInfo& part(m_parts[m_subimage]);
+    for (int c = chbegin; c < chend; ++c)
+        if (part.pixeltype[c] != Imf::HALF && part.pixeltype[c] != Imf::FLOAT)
+            return false;
+    return true;
+}
+
+
+
+bool
+OpenEXRInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
+                             int z, int chbegin, int chend, TypeDesc format,
+                             void* data, stride_t xstride, stride_t ystride)
+{
+    // The generic ImageInput::read_scanlines reads native data into a
+    // temporary buffer and then converts it into the caller's. For half
+    // and float results, hand the caller's buffer, type and strides
+    // straight to the OpenEXR FrameBuffer instead, saving an allocation
+    // and a full copy of the pixels.
+    {
+        lock_guard lock(m_mutex);
+        if (!seek_subimage(subimage, miplevel))
+            return false;
+        chend = clamp(chend, chbegin + 1, m_spec.nchannels);
+        stride_t xs = xstride, ys = ystride, zs = AutoStride;
+        m_spec.auto_stride(xs, ys, zs, format, chend - chbegin, m_spec.width,
+                           m_spec.height);
+        if ((m_input_scanline || m_scanline_input_part)
+            && can_read_direct(chbegin, chend, format, xs, ys))
+            return read_scanlines_direct(ybegin,
+                                         std::min(yend,
+                                                  m_spec.y + m_spec.height),
+                                         chbegin, chend, format, data, xs, ys);
+    }
+    return ImageInput::read_scanlines(subimage, miplevel, ybegin, yend, z,
+                                      chbegin, chend, format, data, xstride,
+                                      ystride);
+}
+
+
+
+bool
+OpenEXRInput::read_scanlines_direct(int ybegin, int yend, int chbegin,
+                                    int chend, TypeDesc format, void* data,
+                                    stride_t xstride, stride_t ystride)
+{
+    // As in read_native_scanlines, OpenEXR wants the address of pixel
+    // (0,0) of the "virtual framebuffer", not of the first pixel we read.
+    Imf::PixelType pixeltype = format == TypeHalf ? Imf::HALF : Imf::FLOAT;
+    char* buf = (char*)data - m_spec.x * xstride - ybegin * ystride;
+    try {
+        Imf::FrameBuffer frameBuffer;
+        for (int c = chbegin; c < chend; ++c)
+            frameBuffer.insert(m_spec.channelnames[c].c_str(),
+                               Imf::Slice(pixeltype,
+                                          buf + (c - chbegin) * format.size(),
+                                          xstride, ystride));
+        if (m_input_scanline) {
+            m_input_scanline->setFrameBuffer(frameBuffer);
+            m_input_scanline->readPixels(ybegin, yend - 1);
+        } else {
+            m_scanline_input_part->setFrameBuffer(frameBuffer);
+            m_scanline_input_part->readPixels(ybegin, yend - 1);
+        }
+    } catch (const std::exception& e) {
+        errorf("Failed OpenEXR read: %s", e.what());
+        return false;
+    } catch (...) {  // catch-all for edge cases or compiler bugs
+        errorf("Failed OpenEXR read: unknown exception");
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+OpenEXRInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
+                         int ybegin, int yend, int zbegin, int zend,
+                         int chbegin, int chend, TypeDesc format, void* data,
+                         stride_t xstride, stride_t ystride, stride_t zstride)
+{
+    // Like read_scanlines, read half or float results directly into the
+    // caller's buffer when we can. A valid tile range is a whole number
+    // of tiles, except that it may stop at the image edge, and OpenEXR
+    // only writes the pixels inside the data window, so it never writes
+    // outside the region the caller asked for.
+    {
+        lock_guard lock(m_mutex);
+        if (!seek_subimage(subimage, miplevel))
+            return false;
+        chend = clamp(chend, chbegin + 1, m_spec.nchannels);
+        stride_t xs = xstride, ys = ystride, zs = zstride;
+        m_spec.auto_stride(xs, ys, zs, format, chend - chbegin, xend - xbegin,
+                           yend - ybegin);
+        int xe = std::min(xend, m_spec.x + m_spec.width);
+        int ye = std::min(yend, m_spec.y + m_spec.height);
+        if ((m_input_tiled || m_tiled_input_part)
+            && m_spec.valid_tile_range(xbegin, xend, ybegin, yend, zbegin, zend)
+            && can_read_direct(chbegin, chend, format, xs, ys)
+            && read_tiles_direct(xbegin, xe, ybegin, ye, chbegin, chend,
+                                 format, data, xs, ys))
+            return true;
+        // If the direct read failed, the general path below will try again
+        // (filling in missing tiles if asked to) and report any errors.
+    }
+    return ImageInput::read_tiles(subimage, miplevel, xbegin, xend, ybegin,
+                                  yend, zbegin, zend, chbegin, chend, format,
+                                  data, xstride, ystride, zstride);
+}
+
+
+
+bool
+OpenEXRInput::read_tiles_direct(int xbegin, int xend, int ybegin, int yend,
+                                int chbegin, int chend, TypeDesc format,
+                                void* data, stride_t xstride, stride_t ystride)
+{
+    Imf::PixelType pixeltype = format == TypeHalf ? Imf::HALF : Imf::FLOAT;
+    int firstxtile = (xbegin - m_spec.x) / m_spec.tile_width;
+    int firstytile = (ybegin - m_spec.y) / m_spec.tile_height;
+    int nxtiles = (xend - xbegin + m_spec.tile_width - 1) / m_spec.tile_width;
+    int nytiles = (yend - ybegin + m_spec.tile_height - 1) / m_spec.tile_height;
+    char* buf   = (char*)data - xbegin * xstride - ybegin * ystride;
+    try {
+        Imf::FrameBuffer frameBuffer;
+        for (int c = chbegin; c < chend; ++c)
+            frameBuffer.insert(m_spec.channelnames[c].c_str(),
+                               Imf::Slice(pixeltype,
+                                          buf + (c - chbegin) * format.size(),
+                                          xstride, ystride));
+        if (m_input_tiled) {
+            m_input_tiled->setFrameBuffer(frameBuffer);
+            m_input_tiled->readTiles(firstxtile, firstxtile + nxtiles - 1,
+                                     firstytile, firstytile + nytiles - 1,
+                                     m_miplevel, m_miplevel);
+        } else {
+            m_tiled_input_part->setFrameBuffer(frameBuffer);
+            m_tiled_input_part->readTiles(firstxtile, firstxtile + nxtiles - 1,
+                                          firstytile, firstytile + nytiles - 1,
+                                          m_miplevel, m_miplevel);
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+
+
 bool
 OpenEXRInput::read_native_deep_scanlines(int subimage, int miplevel, int ybegin,
                                          int yend, int /*z*/, int chbegin,
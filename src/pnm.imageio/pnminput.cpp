@@ -3,7 +3,8 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 #include <cstdlib>
-#include <fstream>
+#include <istream>
+#include <memory>
 #include <string>
 
 #include <OpenImageIO/filesystem.h>
@@ -17,7 +18,13 @@ public:
     PNMInput() {}
     virtual ~PNMInput() { close(); }
     virtual const char* format_name(void) const override { return "pnm"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual int current_subimage(void) const override { return 0; }
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
@@ -26,7 +33,8 @@ public:
 private:
     enum PNMType { P1, P2, P3, P4, P5, P6, Pf, PF };
 
-    OIIO::ifstream m_file;
+    std::unique_ptr<Filesystem::IOProxyStreambuf> m_streambuf;
+    std::istream m_file { nullptr };  // reads through m_streambuf
     std::streampos m_header_end_pos;  // file position after the header
     std::string m_current_line;       ///< Buffer the image pixels
     const char* m_pos;
@@ -187,16 +195,17 @@ inline void
 unpack_floats(const unsigned char* read, float* write, imagesize_t numsamples,
               float scaling_factor)
 {
-    float* read_floats = (float*)read;
-
-    if ((scaling_factor < 0 && bigendian())
-        || (scaling_factor > 0 && littleendian())) {
-        swap_endian(read_floats, numsamples);
-    }
-
+    // N.B. read may point into read-only memory, so swap as we go rather
+    // than in place.
+    bool doswap = (scaling_factor < 0 && bigendian())
+                  || (scaling_factor > 0 && littleendian());
     float absfactor = fabs(scaling_factor);
     for (imagesize_t i = 0; i < numsamples; i++) {
-        write[i] = absfactor * read_floats[i];
+        float f;
+        memcpy(&f, read + i * sizeof(float), sizeof(float));
+        if (doswap)
+            swap_endian(&f);
+        write[i] = absfactor * f;
     }
 }
 
@@ -232,7 +241,8 @@ PNMInput::read_file_scanline(void* data, int y)
 {
     try {
         std::vector<unsigned char> buf;
-        bool good = true;
+        const unsigned char* raw = nullptr;  // the binary scanline's bytes
+        bool good                = true;
         if (!m_file)
             return false;
         int nsamples = m_spec.width * m_spec.nchannels;
@@ -253,8 +263,17 @@ PNMInput::read_file_scanline(void* data, int y)
                 numbytes = m_spec.nchannels * 4 * m_spec.width;
             else
                 numbytes = m_spec.scanline_bytes();
-            buf.resize(numbytes);
-            m_file.read((char*)&buf[0], numbytes);
+            // If the proxy has the whole file in memory, use the bytes
+            // where they are rather than copying them into buf.
+            std::streamoff pos = m_file.tellg();
+            raw = pos >= 0 ? iomapped(int64_t(pos), size_t(numbytes)) : nullptr;
+            if (raw) {
+                m_file.seekg(numbytes, std::ios_base::cur);
+            } else {
+                buf.resize(numbytes);
+                m_file.read((char*)&buf[0], numbytes);
+                raw = &buf[0];
+            }
             if (!m_file.good())
                 return false;
         }
@@ -279,23 +298,25 @@ PNMInput::read_file_scanline(void* data, int y)
                                      (unsigned char)m_max_val);
             break;
         //Raw
-        case P4: unpack(&buf[0], (unsigned char*)data, nsamples); break;
+        case P4: unpack(raw, (unsigned char*)data, nsamples); break;
         case P5:
         case P6:
             if (m_max_val > std::numeric_limits<unsigned char>::max()) {
+                // Byte swap in data, as raw may be read-only
+                unsigned short* sdata = (unsigned short*)data;
+                memcpy(sdata, raw, nsamples * sizeof(unsigned short));
                 if (littleendian())
-                    swap_endian((unsigned short*)&buf[0], nsamples);
-                raw_to_raw((unsigned short*)&buf[0], (unsigned short*)data,
-                           nsamples, (unsigned short)m_max_val);
+                    swap_endian(sdata, nsamples);
+                raw_to_raw(sdata, sdata, nsamples, (unsigned short)m_max_val);
             } else {
-                raw_to_raw((unsigned char*)&buf[0], (unsigned char*)data,
-                           nsamples, (unsigned char)m_max_val);
+                raw_to_raw(raw, (unsigned char*)data, nsamples,
+                           (unsigned char)m_max_val);
             }
             break;
         //Floating point
         case Pf:
         case PF:
-            unpack_floats(&buf[0], (float*)data, nsamples, m_scaling_factor);
+            unpack_floats(raw, (float*)data, nsamples, m_scaling_factor);
             break;
         default: return false;
         }
@@ -417,7 +438,10 @@ PNMInput::open(const std::string& name, ImageSpec& newspec)
 {
     close();  //close previously opened file
 
-    Filesystem::open(m_file, name, std::ios::in | std::ios::binary);
+    if (!ioproxy_use_or_open(name))
+        return false;
+    m_streambuf.reset(new Filesystem::IOProxyStreambuf(ioproxy()));
+    m_file.rdbuf(m_streambuf.get());
 
     m_current_line = "";
     m_pos          = m_current_line.c_str();
@@ -431,10 +455,24 @@ PNMInput::open(const std::string& name, ImageSpec& newspec)
 
 
 
+bool
+PNMInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
 bool
 PNMInput::close()
 {
-    m_file.close();
+    if (ioproxy_opened()) {
+        m_file.rdbuf(nullptr);
+        m_streambuf.reset();
+        ioproxy_clear();
+    }
     return true;
 }
 
@@ -2,7 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
-#include <fstream>
+#include <sstream>
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
@@ -14,6 +14,10 @@ class PNMOutput final : public ImageOutput {
 public:
     virtual ~PNMOutput();
     virtual const char* format_name(void) const override { return "pnm"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode = Create) override;
     virtual bool close() override;
@@ -25,7 +29,6 @@ public:
 
 private:
     std::string m_filename;  ///< Stash the filename
-    OIIO::ofstream m_file;
     unsigned int m_max_val, m_pnm_type;
     unsigned int m_dither;
     std::vector<unsigned char> m_scratch;
@@ -155,32 +158,26 @@ PNMOutput::open(const std::string& name, const ImageSpec& userspec,
         m_pnm_type = 5;
     else
         m_pnm_type = 6;
-    if (!m_spec.get_int_attribute("pnm:binary", 1)) {
+    if (!m_spec.get_int_attribute("pnm:binary", 1))
         m_pnm_type -= 3;
-        Filesystem::open(m_file, name);
-
-    } else {
-        Filesystem::open(m_file, name, std::ios::out | std::ios::binary);
-    }
 
-    if (!m_file) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     m_max_val = (1 << bits_per_sample) - 1;
     // Write header
-    m_file << "P" << m_pnm_type << std::endl;
-    m_file << m_spec.width << " " << m_spec.height << std::endl;
+    bool ok = iowritef("P%d\n%d %d\n", m_pnm_type, m_spec.width,
+                       m_spec.height);
     if (m_pnm_type != 1 && m_pnm_type != 4)  // only non-monochrome
-        m_file << m_max_val << std::endl;
+        ok &= iowritef("%d\n", m_max_val);
 
     // If user asked for tiles -- which this format doesn't support, emulate
     // it by buffering the whole image.
     if (m_spec.tile_width && m_spec.tile_height)
         m_tilebuffer.resize(m_spec.image_bytes());
 
-    return m_file.good();
+    return ok;
 }
 
 
@@ -188,7 +185,7 @@ PNMOutput::open(const std::string& name, const ImageSpec& userspec,
 bool
 PNMOutput::close()
 {
-    if (!m_file) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         return true;
     }
 
@@ -201,8 +198,8 @@ PNMOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    m_file.close();
-    return true;
+    ioproxy_clear();
+    return ok;
 }
 
 
@@ -211,7 +208,7 @@ bool
 PNMOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
                           stride_t xstride)
 {
-    if (!m_file)
+    if (!ioproxy_opened())
         return false;
     if (z)
         return false;
@@ -222,34 +219,35 @@ PNMOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
     if (data != origdata)  // a conversion happened...
         xstride = spec().nchannels;
 
+    // Format the scanline in memory, then hand it to the proxy in one go
+    std::ostringstream file;
     switch (m_pnm_type) {
     case 1:
-        write_ascii_binary(m_file, (unsigned char*)data, xstride, m_spec);
+        write_ascii_binary(file, (unsigned char*)data, xstride, m_spec);
         break;
     case 2:
     case 3:
         if (m_max_val > std::numeric_limits<unsigned char>::max())
-            write_ascii(m_file, (unsigned short*)data, xstride, m_spec,
+            write_ascii(file, (unsigned short*)data, xstride, m_spec,
                         m_max_val);
         else
-            write_ascii(m_file, (unsigned char*)data, xstride, m_spec,
-                        m_max_val);
+            write_ascii(file, (unsigned char*)data, xstride, m_spec, m_max_val);
         break;
     case 4:
-        write_raw_binary(m_file, (unsigned char*)data, xstride, m_spec);
+        write_raw_binary(file, (unsigned char*)data, xstride, m_spec);
         break;
     case 5:
     case 6:
         if (m_max_val > std::numeric_limits<unsigned char>::max())
-            write_raw(m_file, (unsigned short*)data, xstride, m_spec,
-                      m_max_val);
+            write_raw(file, (unsigned short*)data, xstride, m_spec, m_max_val);
         else
-            write_raw(m_file, (unsigned char*)data, xstride, m_spec, m_max_val);
+            write_raw(file, (unsigned char*)data, xstride, m_spec, m_max_val);
         break;
     default: return false;
     }
 
-    return m_file.good();
+    std::string buf = file.str();
+    return iowrite(buf.data(), buf.size());
 }
 
 
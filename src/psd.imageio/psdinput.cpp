@@ -10,7 +10,7 @@
 
 
 #include <csetjmp>
-#include <fstream>
+#include <istream>
 #include <functional>
 #include <map>
 #include <memory>
@@ -33,7 +33,8 @@ public:
     virtual const char* format_name(void) const override { return "psd"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "exif" || feature == "iptc");
+        return (feature == "exif" || feature == "iptc"
+                || feature == "ioproxy");
     }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
     virtual bool open(const std::string& name, ImageSpec& newspec,
@@ -174,7 +175,8 @@ private:
     };
 
     std::string m_filename;
-    OIIO::ifstream m_file;
+    std::unique_ptr<Filesystem::IOProxyStreambuf> m_streambuf;
+    std::istream m_file { nullptr };  // reads through m_streambuf
     //Current subimage
     int m_subimage;
     //Subimage count (1 + layer count)
@@ -524,12 +526,10 @@ PSDInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
 
-    Filesystem::open(m_file, name, std::ios::binary);
-
-    if (!m_file) {
-        errorf("\"%s\": failed to open file", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
+    m_streambuf.reset(new Filesystem::IOProxyStreambuf(ioproxy()));
+    m_file.rdbuf(m_streambuf.get());
 
     // File Header
     if (!load_header()) {
@@ -600,6 +600,7 @@ PSDInput::open(const std::string& name, ImageSpec& newspec,
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
 
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
@@ -609,6 +610,7 @@ bool
 PSDInput::close()
 {
     init();
+    ioproxy_clear();
     return true;
 }
 
@@ -829,7 +831,8 @@ void
 PSDInput::init()
 {
     m_filename.clear();
-    m_file.close();
+    m_file.rdbuf(nullptr);
+    m_streambuf.reset();
     m_subimage       = -1;
     m_subimage_count = 0;
     m_specs.clear();
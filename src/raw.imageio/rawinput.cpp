@@ -7,6 +7,7 @@
 #include <iostream>
 #include <memory>
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/platform.h>
@@ -49,7 +50,7 @@ public:
     virtual const char* format_name(void) const override { return "raw"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "exif"
+        return (feature == "exif" || feature == "ioproxy"
                 /* not yet? || feature == "iptc"*/);
     }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
@@ -68,8 +69,13 @@ private:
     std::string m_filename;
     ImageSpec m_config;  // save config requests
     std::string m_make;
+    // When the app supplies an IOProxy, LibRaw decodes from memory: either
+    // the proxy's own buffer, or a copy of its contents in m_rawbuffer.
+    cspan<unsigned char> m_rawdata;
+    std::vector<unsigned char> m_rawbuffer;
 
     bool do_unpack();
+    void close_raw();
 
     // Do the actual open. It expects m_filename and m_config to be set.
     bool open_raw(bool unpack, const std::string& name,
@@ -328,6 +334,28 @@ RawInput::open(const std::string& name, ImageSpec& newspec,
     m_filename = name;
     m_config   = config;
 
+    // LibRaw reads files itself, but an IOProxy supplied by the app is
+    // handed to it as a memory buffer, which it can't read incrementally.
+    m_rawdata = {};
+    std::vector<unsigned char>().swap(m_rawbuffer);
+    ioproxy_retrieve_from_config(config);
+    if (ioproxy()) {
+        if (!ioproxy_use_or_open(name))
+            return false;
+        size_t size = ioproxy()->size();
+        if (const unsigned char* mapped = iomapped(0, size)) {
+            m_rawdata = cspan<unsigned char>(mapped, size);
+        } else {
+            m_rawbuffer.resize(size);
+            if (!ioread(m_rawbuffer.data(), 1, size)) {
+                ioproxy_clear();
+                return false;
+            }
+            m_rawdata = m_rawbuffer;
+        }
+        ioproxy_clear();
+    }
+
     // For a fresh open, we are concerned with just reading all the
     // meatadata quickly, because maybe that's all that will be needed. So
     // call open_raw passing unpack=false. This will not read the pixels! We
@@ -356,7 +384,12 @@ RawInput::open_raw(bool unpack, const std::string& name,
 #endif
 
     int ret;
-    if ((ret = m_processor->open_file(name.c_str())) != LIBRAW_SUCCESS) {
+    if (m_rawdata.size())
+        ret = m_processor->open_buffer((void*)m_rawdata.data(),
+                                       m_rawdata.size());
+    else
+        ret = m_processor->open_file(name.c_str());
+    if (ret != LIBRAW_SUCCESS) {
         errorf("Could not open file \"%s\", %s", m_filename,
                libraw_strerror(ret));
         return false;
@@ -1153,6 +1186,17 @@ RawInput::get_shootinginfo()
 
 bool
 RawInput::close()
+{
+    close_raw();
+    m_rawdata = {};
+    std::vector<unsigned char>().swap(m_rawbuffer);
+    return true;
+}
+
+
+
+void
+RawInput::close_raw()
 {
     if (m_image) {
         LibRaw::dcraw_clear_mem(m_image);
@@ -1161,7 +1205,6 @@ RawInput::close()
     m_processor.reset();
     m_unpacked = false;
     m_process  = true;
-    return true;
 }
 
 
@@ -1173,8 +1216,8 @@ RawInput::do_unpack()
         return true;
 
     // We need to unpack but we didn't when we opened the file. Close and
-    // re-open with unpack.
-    close();
+    // re-open with unpack, keeping any buffer the file was read into.
+    close_raw();
     bool ok    = open_raw(true, m_filename, m_config);
     m_unpacked = true;
     return ok;
@@ -25,7 +25,13 @@ public:
     RLAInput() { init(); }
     virtual ~RLAInput() { close(); }
     virtual const char* format_name(void) const override { return "rla"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual int current_subimage(void) const override
     {
         lock_guard lock(m_mutex);
@@ -38,7 +44,6 @@ public:
 
 private:
     std::string m_filename;            ///< Stash the filename
-    FILE* m_file;                      ///< Open image handle
     RLAHeader m_rla;                   ///< Wavefront RLA header
     std::vector<unsigned char> m_buf;  ///< Buffer the image pixels
     int m_subimage;                    ///< Current subimage index
@@ -47,21 +52,13 @@ private:
 
     /// Reset everything to initial state
     ///
-    void init()
-    {
-        m_file = NULL;
-        m_buf.clear();
-    }
+    void init() { m_buf.clear(); }
 
     /// Helper: raw read, with error detection
     ///
     bool fread(void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Read error: read %d records but %d expected %s", (int)n,
-                   (int)nitems, feof(m_file) ? " (hit EOF)" : "");
-        return n == nitems;
+        return ioread(buf, itemsize, nitems);
     }
 
     /// Helper: read buf[0..nitems-1], swap endianness if necessary
@@ -103,8 +100,7 @@ private:
     // debugging aid
     void preview(std::ostream& out)
     {
-        OIIO_DASSERT(!feof(m_file));
-        long pos = ftell(m_file);
+        int64_t pos = iotell();
         out << "@" << pos << ", next 4 bytes are ";
         union {  // trickery to avoid punned pointer warnings
             unsigned char c[4];
@@ -122,7 +118,7 @@ private:
                                 u.c[0], ((char*)u.c)[0], u.c[1],
                                 ((char*)u.c)[1], u.c[2], ((char*)u.c)[2],
                                 u.c[3], ((char*)u.c)[3], s[0], s[1], i);
-        fseek(m_file, pos, SEEK_SET);
+        ioseek(pos);
     }
 };
 
@@ -156,11 +152,8 @@ RLAInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
 
-    m_file = Filesystem::fopen(name, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // set a bogus subimage index so that seek_subimage actually seeks
     m_subimage = 1;
@@ -222,14 +215,14 @@ RLAInput::seek_subimage(int subimage, int miplevel)
     if (subimage - current_subimage() < 0) {
         // If we are requesting an image earlier than the current one,
         // reset to the first subimage.
-        fseek(m_file, 0, SEEK_SET);
+        ioseek(0);
         if (!read_header())
             return false;  // read_header always calls error()
         diff = subimage;
     }
     // forward scrolling -- skip subimages until we're at the right place
     while (diff > 0 && m_rla.NextOffset != 0) {
-        fseek(m_file, m_rla.NextOffset, SEEK_SET);
+        ioseek(m_rla.NextOffset);
         if (!read_header())
             return false;  // read_header always calls error()
         --diff;
@@ -439,13 +432,19 @@ RLAInput::seek_subimage(int subimage, int miplevel)
 
 
 bool
-RLAInput::close()
+RLAInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
 
+
+bool
+RLAInput::close()
+{
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
@@ -619,7 +618,8 @@ RLAInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     y = m_spec.height - (y - m_spec.y) - 1;
 
     // Seek to scanline start, based on the scanline offset table
-    fseek(m_file, m_sot[y], SEEK_SET);
+    if (!ioseek(m_sot[y]))
+        return false;
 
     // Now decode and interleave the channels.
     // The channels are non-interleaved (i.e. rrrrrgggggbbbbb...).
@@ -41,7 +41,6 @@ public:
 
 private:
     std::string m_filename;  ///< Stash the filename
-    FILE* m_file;            ///< Open image handle
     std::vector<unsigned char> m_scratch;
     RLAHeader m_rla;                   ///< Wavefront RLA header
     std::vector<uint32_t> m_sot;       ///< Scanline offset table
@@ -50,11 +49,7 @@ private:
     unsigned int m_dither;
 
     // Initialize private members to pre-opened state
-    void init(void)
-    {
-        m_file = NULL;
-        m_sot.clear();
-    }
+    void init(void) { m_sot.clear(); }
 
     /// Helper - sets a chromaticity from attribute
     inline void set_chromaticity(const ParamValue* p, char* dst,
@@ -69,10 +64,7 @@ private:
     /// Helper - write, with error detection
     bool fwrite(const void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fwrite(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Write error: wrote %d records of %d", (int)n, (int)nitems);
-        return n == nitems;
+        return iowrite(buf, itemsize, nitems);
     }
 
     /// Helper: write buf[0..nitems-1], swap endianness if necessary
@@ -137,6 +129,8 @@ RLAOutput::supports(string_view feature) const
         return true;
     if (feature == "channelformats")
         return true;
+    if (feature == "ioproxy")
+        return true;
     // Support nothing else nonstandard
     return false;
 }
@@ -161,11 +155,9 @@ RLAOutput::open(const std::string& name, const ImageSpec& userspec,
     if (m_spec.format == TypeDesc::UNKNOWN)
         m_spec.format = TypeDesc::UINT8;  // Default to uint8 if unknown
 
-    m_file = Filesystem::fopen(name, "wb");
-    if (!m_file) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // Check for things this format doesn't support
     if (m_spec.width < 1 || m_spec.height < 1) {
@@ -407,7 +399,7 @@ RLAOutput::set_chromaticity(const ParamValue* p, char* dst, size_t field_size,
 bool
 RLAOutput::close()
 {
-    if (!m_file) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -423,10 +415,9 @@ RLAOutput::close()
 
     // Now that all scanlines have been output, return to write the
     // correct scanline offset table to file and close the stream.
-    fseek(m_file, sizeof(RLAHeader), SEEK_SET);
-    write(&m_sot[0], m_sot.size());
-    fclose(m_file);
-    m_file = NULL;
+    ok &= ioseek(sizeof(RLAHeader));
+    ok &= write(&m_sot[0], m_sot.size());
+    ioproxy_clear();
 
     init();  // re-initialize
     return ok;
@@ -554,7 +545,7 @@ RLAOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
 
     // store the offset to the scanline.  We'll swap_endian if necessary
     // when we go to actually write it.
-    m_sot[m_spec.height - 1 - (y - m_spec.y)] = (uint32_t)ftell(m_file);
+    m_sot[m_spec.height - 1 - (y - m_spec.y)] = (uint32_t)iotell();
 
     size_t pixelsize = m_spec.pixel_bytes(true /*native*/);
     int offset       = 0;
@@ -67,24 +67,25 @@ public:
     SgiInput() { init(); }
     virtual ~SgiInput() { close(); }
     virtual const char* format_name(void) const override { return "sgi"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool close(void) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
 
 private:
-    FILE* m_fd = nullptr;
     std::string m_filename;
     sgi_pvt::SgiHeader m_sgi_header;
     std::vector<uint32_t> start_tab;
     std::vector<uint32_t> length_tab;
 
-    void init()
-    {
-        m_fd = nullptr;
-        memset(&m_sgi_header, 0, sizeof(m_sgi_header));
-    }
+    void init() { memset(&m_sgi_header, 0, sizeof(m_sgi_header)); }
 
     // reads SGI file header (512 bytes) into m_sgi_header
     // Return true if ok, false if there was a read error.
@@ -106,10 +107,7 @@ private:
     ///
     bool fread(void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_fd);
-        if (n != nitems)
-            errorf("Read error");
-        return n == nitems;
+        return ioread(buf, itemsize, nitems);
     }
 };
 
@@ -131,25 +129,18 @@ public:
                             stride_t ystride, stride_t zstride) override;
 
 private:
-    FILE* m_fd = nullptr;
     std::string m_filename;
     std::vector<unsigned char> m_scratch;
     unsigned int m_dither;
     std::vector<unsigned char> m_tilebuffer;
 
-    void init() { m_fd = NULL; }
-
     bool create_and_write_header();
 
     /// Helper - write, with error detection
     template<class T>
     bool fwrite(const T* buf, size_t itemsize = sizeof(T), size_t nitems = 1)
     {
-        size_t n = std::fwrite(buf, itemsize, nitems, m_fd);
-        if (n != nitems)
-            errorf("Error writing \"%s\" (wrote %d/%d records)", m_filename,
-                   (int)n, (int)nitems);
-        return n == nitems;
+        return iowrite(buf, itemsize, nitems);
     }
 };
 
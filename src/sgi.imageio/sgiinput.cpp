@@ -33,14 +33,20 @@ OIIO_PLUGIN_EXPORTS_END
 bool
 SgiInput::valid_file(const std::string& filename) const
 {
-    FILE* fd = Filesystem::fopen(filename, "rb");
-    if (!fd)
-        return false;
+    Filesystem::IOFile file(filename, Filesystem::IOProxy::Read);
     int16_t magic;
-    bool ok = (::fread(&magic, sizeof(magic), 1, fd) == 1)
-              && (magic == sgi_pvt::SGI_MAGIC);
-    fclose(fd);
-    return ok;
+    return file.read(&magic, sizeof(magic)) == sizeof(magic)
+           && magic == sgi_pvt::SGI_MAGIC;
+}
+
+
+
+bool
+SgiInput::open(const std::string& name, ImageSpec& spec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
 }
 
 
@@ -51,11 +57,8 @@ SgiInput::open(const std::string& name, ImageSpec& spec)
     // saving name for later use
     m_filename = name;
 
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     if (!read_header())
         return false;
@@ -128,6 +131,7 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
     ptrdiff_t bpc = m_sgi_header.bpc;
     std::vector<std::vector<unsigned char>> channeldata(m_spec.nchannels);
+    std::vector<const unsigned char*> channelptr(m_spec.nchannels);
     if (m_sgi_header.storage == sgi_pvt::RLE) {
         // reading and uncompressing first channel (red in RGBA images)
         for (int c = 0; c < m_spec.nchannels; ++c) {
@@ -136,33 +140,40 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
             ptrdiff_t scanline_offset = start_tab[off];
             ptrdiff_t scanline_length = length_tab[off];
             channeldata[c].resize(m_spec.width * bpc);
-            uncompress_rle_channel(scanline_offset, scanline_length,
-                                   &(channeldata[c][0]));
+            if (!uncompress_rle_channel(scanline_offset, scanline_length,
+                                        &(channeldata[c][0])))
+                return false;
+            channelptr[c] = &(channeldata[c][0]);
         }
     } else {
-        // non-RLE case -- just read directly into our channel data
+        // non-RLE case -- use the channel data where it is if the proxy
+        // has the file in memory, else read it into our channel data
         for (int c = 0; c < m_spec.nchannels; ++c) {
             // offset for this scanline/channel
             ptrdiff_t off             = y + c * m_spec.height;
             ptrdiff_t scanline_offset = sgi_pvt::SGI_HEADER_LEN
                                         + off * m_spec.width * bpc;
-            Filesystem::fseek(m_fd, scanline_offset, SEEK_SET);
+            channelptr[c] = iomapped(scanline_offset, m_spec.width * bpc);
+            if (channelptr[c])
+                continue;
+            ioseek(scanline_offset);
             channeldata[c].resize(m_spec.width * bpc);
             if (!fread(&(channeldata[c][0]), 1, m_spec.width * bpc))
                 return false;
+            channelptr[c] = &(channeldata[c][0]);
         }
     }
 
     if (m_spec.nchannels == 1) {
         // If just one channel, no interleaving is necessary, just memcpy
-        memcpy(data, &(channeldata[0][0]), channeldata[0].size());
+        memcpy(data, channelptr[0], m_spec.width * bpc);
     } else {
         unsigned char* cdata = (unsigned char*)data;
         for (int x = 0; x < m_spec.width; ++x) {
             for (int c = 0; c < m_spec.nchannels; ++c) {
-                *cdata++ = channeldata[c][x * bpc];
+                *cdata++ = channelptr[c][x * bpc];
                 if (bpc == 2)
-                    *cdata++ = channeldata[c][x * bpc + 1];
+                    *cdata++ = channelptr[c][x * bpc + 1];
             }
         }
     }
@@ -181,11 +192,17 @@ SgiInput::uncompress_rle_channel(int scanline_off, int scanline_len,
                                  unsigned char* out)
 {
     int bpc = m_sgi_header.bpc;
-    std::unique_ptr<unsigned char[]> rle_scanline(
-        new unsigned char[scanline_len]);
-    Filesystem::fseek(m_fd, scanline_off, SEEK_SET);
-    if (!fread(&rle_scanline[0], 1, scanline_len))
-        return false;
+    // Decode from the proxy's memory if it has the file, else read the
+    // compressed scanline first.
+    const unsigned char* rle_scanline = iomapped(scanline_off, scanline_len);
+    std::unique_ptr<unsigned char[]> rle_buf;
+    if (!rle_scanline) {
+        rle_buf.reset(new unsigned char[scanline_len]);
+        ioseek(scanline_off);
+        if (!fread(&rle_buf[0], 1, scanline_len))
+            return false;
+        rle_scanline = rle_buf.get();
+    }
     int limit = m_spec.width;
     int i     = 0;
     if (bpc == 1) {
@@ -262,8 +279,7 @@ SgiInput::uncompress_rle_channel(int scanline_off, int scanline_len,
 bool
 SgiInput::close()
 {
-    if (m_fd)
-        fclose(m_fd);
+    ioproxy_clear();
     init();
     return true;
 }
@@ -291,7 +307,7 @@ SgiInput::read_header()
         return false;
 
     //don't read dummy bytes
-    Filesystem::fseek(m_fd, 404, SEEK_CUR);
+    ioseek(404, SEEK_CUR);
 
     if (littleendian()) {
         swap_endian(&m_sgi_header.magic);
@@ -23,7 +23,8 @@ OIIO_PLUGIN_EXPORTS_END
 int
 SgiOutput::supports(string_view feature) const
 {
-    return (feature == "alpha" || feature == "nchannels");
+    return (feature == "alpha" || feature == "nchannels"
+            || feature == "ioproxy");
 }
 
 
@@ -46,11 +47,9 @@ SgiOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
         return false;
     }
 
-    m_fd = Filesystem::fopen(m_filename, "wb");
-    if (!m_fd) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // SGI image files only supports UINT8 and UINT16.  If something
     // else was requested, revert to the one most likely to be readable
@@ -104,7 +103,7 @@ SgiOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
         ptrdiff_t scanline_offset = sgi_pvt::SGI_HEADER_LEN
                                     + ptrdiff_t(c * m_spec.height + y)
                                           * m_spec.width * bpc;
-        Filesystem::fseek(m_fd, scanline_offset, SEEK_SET);
+        ioseek(scanline_offset);
         if (!fwrite(&channeldata[0], 1, m_spec.width * bpc)) {
             return false;
         }
@@ -129,10 +128,8 @@ SgiOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 SgiOutput::close()
 {
-    if (!m_fd) {  // already closed
-        init();
+    if (!ioproxy_opened())  // already closed
         return true;
-    }
 
     bool ok = true;
     if (m_spec.tile_width) {
@@ -143,8 +140,7 @@ SgiOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    fclose(m_fd);
-    init();
+    ioproxy_clear();
     return ok;
 }
 
@@ -38,10 +38,10 @@ PicFileHeader::swap_endian()
 
 
 bool
-PicFileHeader::read_header(FILE* fd)
+PicFileHeader::read_header(Filesystem::IOProxy* fd)
 {
     int byte_count = 0;
-    byte_count += fread(this, 1, sizeof(PicFileHeader), fd);
+    byte_count += fd->read(this, sizeof(PicFileHeader));
 
     // Check if we're running on a little endian processor
     if (littleendian())
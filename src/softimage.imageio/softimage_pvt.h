@@ -17,7 +17,7 @@ namespace softimage_pvt {
 class PicFileHeader {
 public:
     // Read pic header from file
-    bool read_header(FILE* fd);
+    bool read_header(Filesystem::IOProxy* fd);
 
     // PIC header
     uint32_t magic;    // Softimage magic number
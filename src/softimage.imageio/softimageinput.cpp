@@ -15,7 +15,13 @@ public:
     SoftimageInput() { init(); }
     virtual ~SoftimageInput() { close(); }
     virtual const char* format_name(void) const override { return "softimage"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
@@ -24,10 +30,10 @@ private:
     /// Resets the core data members to defaults.
     ///
     void init();
-    /// Read a scanline from m_fd.
+    /// Read a scanline from the file.
     ///
     bool read_next_scanline(void* data);
-    /// Read uncompressed pixel data from m_fd.
+    /// Read uncompressed pixel data from the file.
     ///
     bool read_pixels_uncompressed(const softimage_pvt::ChannelPacket& curPacket,
                                   void* data);
@@ -42,11 +48,22 @@ private:
     read_pixels_mixed_run_length(const softimage_pvt::ChannelPacket& curPacket,
                                  void* data);
 
-    FILE* m_fd;
+    /// Helpers: stdio-alikes that go through the IOProxy.
+    ///
+    size_t fread(void* buf, size_t itemsize, size_t nitems)
+    {
+        return itemsize ? ioproxy()->read(buf, itemsize * nitems) / itemsize
+                        : 0;
+    }
+    int fseek(int64_t offset, int origin)
+    {
+        return ioproxy()->seek(offset, origin) ? 0 : -1;
+    }
+
     softimage_pvt::PicFileHeader m_pic_header;
     std::vector<softimage_pvt::ChannelPacket> m_channel_packets;
     std::string m_filename;
-    std::vector<fpos_t> m_scanline_markers;
+    std::vector<int64_t> m_scanline_markers;
 };
 
 
@@ -69,7 +86,6 @@ OIIO_PLUGIN_EXPORTS_END
 void
 SoftimageInput::init()
 {
-    m_fd = NULL;
     m_filename.clear();
     m_channel_packets.clear();
     m_scanline_markers.clear();
@@ -83,14 +99,11 @@ SoftimageInput::open(const std::string& name, ImageSpec& spec)
     // Remember the filename
     m_filename = name;
 
-    m_fd = Filesystem::fopen(m_filename, "rb");
-    if (!m_fd) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     // Try read the header
-    if (!m_pic_header.read_header(m_fd)) {
+    if (!m_pic_header.read_header(ioproxy())) {
         errorf("\"%s\": failed to read header", m_filename);
         close();
         return false;
@@ -110,7 +123,7 @@ SoftimageInput::open(const std::string& name, ImageSpec& spec)
     int nchannels = 0;
     do {
         // Read the next packet into curPacket and store it off
-        if (fread(&curPacket, 1, sizeof(ChannelPacket), m_fd)
+        if (fread(&curPacket, 1, sizeof(ChannelPacket))
             != sizeof(ChannelPacket)) {
             errorf("Unexpected end of file \"%s\".", m_filename);
             close();
@@ -140,9 +153,7 @@ SoftimageInput::open(const std::string& name, ImageSpec& spec)
     }
 
     // Build the scanline index
-    fpos_t curPos;
-    fgetpos(m_fd, &curPos);
-    m_scanline_markers.push_back(curPos);
+    m_scanline_markers.push_back(iotell());
 
     spec = m_spec;
     return true;
@@ -165,30 +176,25 @@ SoftimageInput::read_native_scanline(int subimage, int miplevel, int y,
 
         // save the marker for the next scanline if we haven't got the who images
         if (m_scanline_markers.size() < m_pic_header.height) {
-            fpos_t curPos;
-            fgetpos(m_fd, &curPos);
-            m_scanline_markers.push_back(curPos);
+            m_scanline_markers.push_back(iotell());
         }
     } else if (y >= (int)m_scanline_markers.size()) {
         // we haven't yet read this far
-        fpos_t curPos;
         // Store the ones before this without pulling the pixels
         do {
             if (!read_next_scanline(NULL))
                 return false;
 
-            fgetpos(m_fd, &curPos);
-            m_scanline_markers.push_back(curPos);
+            m_scanline_markers.push_back(iotell());
         } while ((int)m_scanline_markers.size() <= y);
 
         result = read_next_scanline(data);
-        fgetpos(m_fd, &curPos);
-        m_scanline_markers.push_back(curPos);
+        m_scanline_markers.push_back(iotell());
     } else {
         // We've already got the index for this scanline and moved past
 
         // Let's seek to the scanline's data
-        if (fsetpos(m_fd, &m_scanline_markers[y])) {
+        if (!ioproxy()->seek(m_scanline_markers[y])) {
             errorf("Failed to seek to scanline %d in \"%s\"", y, m_filename);
             close();
             return false;
@@ -198,8 +204,7 @@ SoftimageInput::read_native_scanline(int subimage, int miplevel, int y,
 
         // If the index isn't complete let's shift the file pointer back to the latest readline
         if (m_scanline_markers.size() < m_pic_header.height) {
-            if (fsetpos(m_fd,
-                        &m_scanline_markers[m_scanline_markers.size() - 1])) {
+            if (!ioproxy()->seek(m_scanline_markers.back())) {
                 errorf("Failed to restore to scanline %llu in \"%s\"",
                        (long long unsigned int)m_scanline_markers.size() - 1,
                        m_filename);
@@ -214,13 +219,20 @@ SoftimageInput::read_native_scanline(int subimage, int miplevel, int y,
 
 
 
+bool
+SoftimageInput::open(const std::string& name, ImageSpec& spec,
+                     const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
+}
+
+
+
 bool
 SoftimageInput::close()
 {
-    if (m_fd) {
-        fclose(m_fd);
-        m_fd = NULL;
-    }
+    ioproxy_clear();
     init();
     return true;
 }
@@ -288,7 +300,7 @@ SoftimageInput::read_pixels_uncompressed(
                                              * m_spec.nchannels)
                                             + (channel * pixelChannelSize)
                                             + curByte],
-                              1, 1, m_fd)
+                              1, 1)
                         != 1)
                         return false;
                 }
@@ -297,7 +309,7 @@ SoftimageInput::read_pixels_uncompressed(
     } else {
         // data pointer is null so we should just seek to the next scanline
         // If the seek fails return false
-        if (fseek(m_fd, m_pic_header.width * pixelChannelSize * channels.size(),
+        if (fseek(m_pic_header.width * pixelChannelSize * channels.size(),
                   SEEK_CUR))
             return false;
     }
@@ -321,14 +333,14 @@ SoftimageInput::read_pixels_pure_run_length(
     // Read the pixels until we've read them all
     while (linePixelCount < m_pic_header.width) {
         // Read the repeats for the run length - return false if read fails
-        if (fread(&curCount, 1, 1, m_fd) != 1)
+        if (fread(&curCount, 1, 1) != 1)
             return false;
 
         if (data) {
             // data pointer is set so we're supposed to write data there
             size_t pixelSize   = pixelChannelSize * channels.size();
             uint8_t* pixelData = new uint8_t[pixelSize];
-            if (fread(pixelData, pixelSize, 1, m_fd) != pixelSize)
+            if (fread(pixelData, pixelSize, 1) != pixelSize)
                 return false;
 
             // Now we've got the pixel value we need to push it into the data
@@ -355,7 +367,7 @@ SoftimageInput::read_pixels_pure_run_length(
         } else {
             // data pointer is null so we should just seek to the next scanline
             // If the seek fails return false
-            if (fseek(m_fd, pixelChannelSize * channels.size(), SEEK_CUR))
+            if (fseek(pixelChannelSize * channels.size(), SEEK_CUR))
                 return false;
         }
 
@@ -382,7 +394,7 @@ SoftimageInput::read_pixels_mixed_run_length(
     // Read the pixels until we've read them all
     while (linePixelCount < m_pic_header.width) {
         // Read the repeats for the run length - return false if read fails
-        if (fread(&curCount, 1, 1, m_fd) != 1)
+        if (fread(&curCount, 1, 1) != 1)
             return false;
 
         if (curCount < 128) {
@@ -412,7 +424,7 @@ SoftimageInput::read_pixels_mixed_run_length(
                                                    * m_spec.nchannels)
                                                   + (channel * pixelChannelSize)
                                                   + curByte],
-                                    1, 1, m_fd)
+                                    1, 1)
                                 != 1)
                                 return false;
                         }
@@ -421,7 +433,7 @@ SoftimageInput::read_pixels_mixed_run_length(
             } else {
                 // data pointer is null so we should just seek to the
                 // next scanline If the seek fails return false.
-                if (fseek(m_fd, curCount * pixelChannelSize * channels.size(),
+                if (fseek(curCount * pixelChannelSize * channels.size(),
                           SEEK_CUR))
                     return false;
             }
@@ -436,7 +448,7 @@ SoftimageInput::read_pixels_mixed_run_length(
                 // This is a long count so the next 16bits of the file
                 // are an unsigned int containing the count.  If the
                 // read fails we should return false.
-                if (fread(&longCount, 1, 2, m_fd) != 2)
+                if (fread(&longCount, 1, 2) != 2)
                     return false;
 
                 // longCount is in big endian format - if we're not
@@ -451,7 +463,7 @@ SoftimageInput::read_pixels_mixed_run_length(
                 // data pointer is set so we're supposed to write data there
                 size_t pixelSize   = pixelChannelSize * channels.size();
                 uint8_t* pixelData = new uint8_t[pixelSize];
-                if (fread(pixelData, 1, pixelSize, m_fd) != pixelSize)
+                if (fread(pixelData, 1, pixelSize) != pixelSize)
                     return false;
 
                 // Now we've got the pixel value we need to push it into
@@ -482,7 +494,7 @@ SoftimageInput::read_pixels_mixed_run_length(
             } else {
                 // data pointer is null so we should just seek to the
                 // next scanline.  If the seek fails return false.
-                if (fseek(m_fd, pixelChannelSize * channels.size(), SEEK_CUR))
+                if (fseek(pixelChannelSize * channels.size(), SEEK_CUR))
                     return false;
             }
 
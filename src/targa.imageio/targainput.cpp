@@ -25,6 +25,10 @@ public:
     TGAInput() { init(); }
     virtual ~TGAInput() { close(); }
     virtual const char* format_name(void) const override { return "targa"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
     virtual bool open(const std::string& name, ImageSpec& newspec,
                       const ImageSpec& config) override;
@@ -34,7 +38,6 @@ public:
 
 private:
     std::string m_filename;            ///< Stash the filename
-    FILE* m_file;                      ///< Open image handle
     tga_header m_tga;                  ///< Targa header
     tga_footer m_foot;                 ///< Targa 2.0 footer
     unsigned int m_ofs_colcorr_tbl;    ///< Offset to colour correction table
@@ -46,7 +49,6 @@ private:
     ///
     void init()
     {
-        m_file = NULL;
         m_buf.clear();
         m_ofs_colcorr_tbl         = 0;
         m_alpha                   = TGA_ALPHA_NONE;
@@ -58,7 +60,7 @@ private:
     bool readimg();
 
     /// Helper function: decode a pixel.
-    inline void decode_pixel(unsigned char* in, unsigned char* out,
+    inline void decode_pixel(const unsigned char* in, unsigned char* out,
                              unsigned char* palette, int bytespp,
                              int palbytespp);
 
@@ -66,10 +68,7 @@ private:
     ///
     bool fread(void* buf, size_t itemsize, size_t nitems)
     {
-        size_t n = ::fread(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Read error");
-        return n == nitems;
+        return ioread(buf, itemsize, nitems);
     }
 };
 
@@ -103,11 +102,8 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
 
-    m_file = Filesystem::fopen(name, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // due to struct packing, we may get a corrupt header if we just load the
     // struct from file; to adress that, read every member individually
@@ -223,10 +219,10 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
         m_spec.attribute("targa:ImageID", id);
     }
 
-    int64_t ofs = Filesystem::ftell(m_file);
+    int64_t ofs = iotell();
     // now try and see if it's a TGA 2.0 image
     // TGA 2.0 files are identified by a nifty "TRUEVISION-XFILE.\0" signature
-    fseek(m_file, -26, SEEK_END);
+    ioproxy()->seek(-26, SEEK_END);
     if (fread(&m_foot.ofs_ext, sizeof(m_foot.ofs_ext), 1)
         && fread(&m_foot.ofs_dev, sizeof(m_foot.ofs_dev), 1)
         && fread(&m_foot.signature, sizeof(m_foot.signature), 1)
@@ -238,7 +234,7 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
         }
 
         // read the extension area
-        Filesystem::fseek(m_file, m_foot.ofs_ext, SEEK_SET);
+        ioseek(m_foot.ofs_ext);
         // check if this is a TGA 2.0 extension area
         // according to the 2.0 spec, the size for valid 2.0 files is exactly
         // 495 bytes, and the reader should only read as much as it understands
@@ -397,7 +393,7 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
 
             // now load the thumbnail
             if (ofs_thumb) {
-                Filesystem::fseek(m_file, ofs_thumb, SEEK_SET);
+                ioseek(ofs_thumb);
 
                 // most of this code is a dupe of readimg(); according to the
                 // spec, the thumbnail is in the same format as the main image
@@ -423,12 +419,12 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
                 // read palette, if there is any
                 std::unique_ptr<unsigned char[]> palette;
                 if (m_tga.cmap_type) {
-                    fseek(m_file, ofs, SEEK_SET);
+                    ioseek(ofs);
                     palette.reset(
                         new unsigned char[palbytespp * m_tga.cmap_length]);
                     if (!fread(palette.get(), palbytespp, m_tga.cmap_length))
                         return false;
-                    fseek(m_file, ofs_thumb + 2, SEEK_SET);
+                    ioseek(ofs_thumb + 2);
                 }
                 unsigned char pixel[4];
                 unsigned char in[4];
@@ -461,7 +457,7 @@ TGAInput::open(const std::string& name, ImageSpec& newspec)
         if (m_keep_unassociated_alpha)
             m_spec.attribute("oiio:UnassociatedAlpha", 1);
 
-    fseek(m_file, ofs, SEEK_SET);
+    ioseek(ofs);
 
     newspec = spec();
     return true;
@@ -476,13 +472,14 @@ TGAInput::open(const std::string& name, ImageSpec& newspec,
     // Check 'config' for any special requests
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
 
 
 inline void
-TGAInput::decode_pixel(unsigned char* in, unsigned char* out,
+TGAInput::decode_pixel(const unsigned char* in, unsigned char* out,
                        unsigned char* palette, int bytespp, int palbytespp)
 {
     unsigned int k = 0;
@@ -635,12 +632,25 @@ TGAInput::readimg()
 
     unsigned char pixel[4];
     if (m_tga.type < TYPE_PALETTED_RLE) {
-        // uncompressed image data
-        unsigned char in[4];
+        // uncompressed image data -- decode it straight from the proxy's
+        // memory if it has it all, else read it a scanline at a time
+        size_t npixelbytes = size_t(m_spec.image_pixels()) * bytespp;
+        size_t nlinebytes  = size_t(m_spec.width) * bytespp;
+        const unsigned char* in = iomapped(iotell(), npixelbytes);
+        std::unique_ptr<unsigned char[]> inbuf;
+        if (in)
+            ioseek(npixelbytes, SEEK_CUR);
+        else
+            inbuf.reset(new unsigned char[nlinebytes]);
         for (int64_t y = m_spec.height - 1; y >= 0; y--) {
-            for (int64_t x = 0; x < m_spec.width; x++) {
-                if (!fread(in, bytespp, 1))
+            if (inbuf) {
+                if (!fread(inbuf.get(), nlinebytes, 1)) {
+                    delete[] palette;
                     return false;
+                }
+                in = inbuf.get();
+            }
+            for (int64_t x = 0; x < m_spec.width; x++, in += bytespp) {
                 decode_pixel(in, pixel, palette, bytespp, palbytespp);
                 memcpy(&m_buf[y * m_spec.width * m_spec.nchannels
                               + x * m_spec.nchannels],
@@ -760,11 +770,7 @@ TGAInput::readimg()
 bool
 TGAInput::close()
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
-
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
@@ -27,7 +27,7 @@ public:
     virtual const char* format_name(void) const override { return "targa"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "alpha");
+        return (feature == "alpha" || feature == "ioproxy");
     }
     virtual bool open(const std::string& name, const ImageSpec& spec,
                       OpenMode mode = Create) override;
@@ -40,7 +40,6 @@ public:
 
 private:
     std::string m_filename;  ///< Stash the filename
-    FILE* m_file;            ///< Open image handle
     bool m_want_rle;         ///< Whether the client asked for RLE
     bool m_convert_alpha;    ///< Do we deassociate alpha?
     float m_gamma;           ///< Gamma to use for alpha conversion
@@ -52,7 +51,6 @@ private:
     // Initialize private members to pre-opened state
     void init(void)
     {
-        m_file          = NULL;
         m_convert_alpha = true;
         m_gamma         = 1.0;
     }
@@ -74,10 +72,7 @@ private:
     {
         if (itemsize * nitems == 0)
             return true;
-        size_t n = std::fwrite(buf, itemsize, nitems, m_file);
-        if (n != nitems)
-            errorf("Write error: wrote %d records of %d", (int)n, (int)nitems);
-        return n == nitems;
+        return iowrite(buf, itemsize, nitems);
     }
 
     /// Helper -- write a 'short' with byte swapping if necessary
@@ -97,10 +92,11 @@ private:
     /// Helper -- pad with zeroes
     bool pad(size_t n = 1)
     {
-        while (n--)
-            if (fputc(0, m_file))
+        static const char zeroes[64] = { 0 };
+        for (; n > sizeof(zeroes); n -= sizeof(zeroes))
+            if (!iowrite(zeroes, sizeof(zeroes)))
                 return false;
-        return true;
+        return iowrite(zeroes, n);
     }
 
     /// Helper -- write string, with padding and/or truncation
@@ -186,11 +182,9 @@ TGAOutput::open(const std::string& name, const ImageSpec& userspec,
         return false;
     }
 
-    m_file = Filesystem::fopen(name, "wb");
-    if (!m_file) {
-        errorf("Could not open \"%s\"", name);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     // Force 8 bit integers
     m_spec.set_format(TypeDesc::UINT8);
@@ -262,16 +256,14 @@ TGAOutput::open(const std::string& name, const ImageSpec& userspec,
         || !fwrite(&tga.cmap_size) || !fwrite(&tga.x_origin)
         || !fwrite(&tga.y_origin) || !fwrite(&tga.width) || !fwrite(&tga.height)
         || !fwrite(&tga.bpp) || !fwrite(&tga.attr)) {
-        fclose(m_file);
-        m_file = NULL;
+        ioproxy_clear();
         return false;
     }
 
     // dump comment to file, don't bother about null termination
     if (tga.idlen) {
         if (!fwrite(id.c_str(), tga.idlen)) {
-            fclose(m_file);
-            m_file = NULL;
+            ioproxy_clear();
             return false;
         }
     }
@@ -289,14 +281,14 @@ TGAOutput::open(const std::string& name, const ImageSpec& userspec,
 bool
 TGAOutput::write_tga20_data_fields()
 {
-    if (m_file) {
+    if (ioproxy_opened()) {
         // write out the TGA 2.0 data fields
 
         // FIXME: write out the developer area; according to Larry,
         // it's probably safe to ignore it altogether until someone complains
         // that it's missing :)
 
-        Filesystem::fseek(m_file, 0, SEEK_END);
+        ioseek(0, SEEK_END);
 
         // write out the thumbnail, if there is one
         uint32_t ofs_thumb = 0;
@@ -306,7 +298,7 @@ TGAOutput::write_tga20_data_fields()
         if (tw && th && tc == m_spec.nchannels) {
             ParamValue* p = m_spec.find_attribute("thumbnail_image");
             if (p) {
-                ofs_thumb = (uint32_t)ftell(m_file);
+                ofs_thumb = (uint32_t)iotell();
                 // dump thumbnail size
                 if (!fwrite(&tw) || !fwrite(&th)
                     || !fwrite(p->data(), p->datasize())) {
@@ -316,7 +308,7 @@ TGAOutput::write_tga20_data_fields()
         }
 
         // prepare the footer
-        tga_footer foot = { (uint32_t)ftell(m_file), 0, "TRUEVISION-XFILE." };
+        tga_footer foot = { (uint32_t)iotell(), 0, "TRUEVISION-XFILE." };
 
         // write out the extension area
 
@@ -441,7 +433,7 @@ TGAOutput::write_tga20_data_fields()
 bool
 TGAOutput::close()
 {
-    if (!m_file) {  // already closed
+    if (!ioproxy_opened()) {  // already closed
         init();
         return true;
     }
@@ -456,8 +448,7 @@ TGAOutput::close()
     }
 
     ok &= write_tga20_data_fields();
-    fclose(m_file);  // close the stream
-    m_file = NULL;
+    ioproxy_clear();  // close the stream
 
     init();  // re-initialize
     return ok;
@@ -684,9 +675,7 @@ TGAOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
         // seek to the correct scanline
         int n     = m_spec.nchannels;
         int64_t w = m_spec.width;
-        Filesystem::fseek(m_file,
-                          18 + m_idlen + int64_t(m_spec.height - y - 1) * w * n,
-                          SEEK_SET);
+        ioseek(18 + m_idlen + int64_t(m_spec.height - y - 1) * w * n);
         if (n <= 2) {
             // 1- and 2-channels can write directly
             if (!fwrite(bdata, n, w)) {
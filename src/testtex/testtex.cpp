@@ -3,6 +3,7 @@
 // https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
 
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -60,6 +61,7 @@ static bool filtertest        = false;
 static TextureSystem* texsys  = NULL;
 static std::string searchpath;
 static bool batch        = false;
+static bool verify_batch = false;
 static bool nowarp       = false;
 static bool tube         = false;
 static bool use_handle   = false;
@@ -153,6 +155,8 @@ getargs(int argc, const char* argv[])
                   "--automip", &automip, "Set auto-MIPmap for the image cache",
                   "--batch", &batch,
                         Strutil::sprintf("Use batched shading, batch size = %d", Tex::BatchWidth).c_str(),
+                  "--verifybatch", &verify_batch,
+                        "Check --batch results against single point lookups",
                   "--handle", &use_handle, "Use texture handle rather than name lookup",
                   "--searchpath %s:PATHLIST", &searchpath, "Search path for files (colon-separated directory list)",
                   "--filtertest", &filtertest, "Test the filter sizes",
@@ -224,6 +228,28 @@ initialize_opt(TextureOpt& opt)
 
 
 
+// For --verifybatch: count the results of batched lookups that differ
+// from the single point lookups of the same points.
+static std::atomic<int> batch_mismatches(0);
+
+static void
+verify_batch_lane(const char* what, int x, int y, int nchannels,
+                  const float* single, const Tex::FloatWide* batched, int lane)
+{
+    for (int c = 0; c < nchannels; ++c) {
+        float a = single[c], b = batched[c][lane];
+        if (a == b || fabsf(a - b) <= 1.0e-6f * std::max(1.0f, fabsf(a)))
+            continue;
+        if (batch_mismatches++ < 10)
+            Strutil::fprintf(std::cerr,
+                             "Batch mismatch in %s at (%d, %d) channel %d: "
+                             "single %g, batched %g\n",
+                             what, x, y, c, a, b);
+    }
+}
+
+
+
 static void
 initialize_opt(TextureOptBatch& opt)
 {
@@ -498,6 +524,59 @@ map_default_3D(const Int& x, const Int& y, Imath::Vec3<Float>& P,
 
 
 
+// Map pixels to directions for environment lookups: x sweeps longitude
+// (0 to 2pi) and y sweeps latitude (pole to pole), so the output image is
+// a latlong view of the environment.
+static void
+map_env_dir(const float& s, const float& t, Imath::V3f& R)
+{
+    float phi   = float(2.0 * M_PI) * s;
+    float theta = float(M_PI) * t;
+    float sinphi, cosphi, sintheta, costheta;
+    sincos(phi, &sinphi, &cosphi);
+    sincos(theta, &sintheta, &costheta);
+    R.setValue(sintheta * cosphi, sintheta * sinphi, costheta);
+}
+
+
+
+static void
+map_env(const int& x, const int& y, Imath::V3f& R, Imath::V3f& dRdx,
+        Imath::V3f& dRdy, Imath::V3f& dRdz)
+{
+    float s = (float(x) + 0.5f) / output_xres * sscale + texoffset[0];
+    float t = (float(y) + 0.5f) / output_yres * tscale + texoffset[1];
+    Imath::V3f Rx, Ry;
+    map_env_dir(s, t, R);
+    map_env_dir(s + sscale / output_xres, t, Rx);
+    map_env_dir(s, t + tscale / output_yres, Ry);
+    dRdx = Rx - R;
+    dRdy = Ry - R;
+    dRdz.setValue(0, 0, 0);
+}
+
+
+
+// FIXME -- templatize map_env. For now, just loop over scalar version.
+static void
+map_env(const Tex::IntWide& x, const Tex::IntWide& y,
+        Imath::Vec3<Tex::FloatWide>& R, Imath::Vec3<Tex::FloatWide>& dRdx,
+        Imath::Vec3<Tex::FloatWide>& dRdy, Imath::Vec3<Tex::FloatWide>& dRdz)
+{
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        Imath::V3f r, rx, ry, rz;
+        map_env(x[i], y[i], r, rx, ry, rz);
+        for (int c = 0; c < 3; ++c) {
+            R[c][i]    = r[c];
+            dRdx[c][i] = rx[c];
+            dRdy[c][i] = ry[c];
+            dRdz[c][i] = rz[c];
+        }
+    }
+}
+
+
+
 template<typename Float = float, typename Int = int>
 void
 map_warp_3D(const Int& x, const Int& y, Imath::Vec3<Float>& P,
@@ -661,6 +740,12 @@ plain_tex_region_batch(ImageBuf& image, ustring filename, Mapping2DWide mapping,
     FloatWide* result    = OIIO_ALLOCA(FloatWide, nc);
     FloatWide* dresultds = test_derivs ? OIIO_ALLOCA(FloatWide, nc) : nullptr;
     FloatWide* dresultdt = test_derivs ? OIIO_ALLOCA(FloatWide, nc) : nullptr;
+    // Single point lookups for --verifybatch
+    TextureOpt sopt;
+    initialize_opt(sopt);
+    float* sresult    = OIIO_ALLOCA(float, nc);
+    float* sdresultds = test_derivs ? OIIO_ALLOCA(float, nc) : nullptr;
+    float* sdresultdt = test_derivs ? OIIO_ALLOCA(float, nc) : nullptr;
     for (int y = roi.ybegin; y < roi.yend; ++y) {
         for (int x = roi.xbegin; x < roi.xend; x += BatchWidth) {
             FloatWide s, t, dsdx, dtdx, dsdy, dtdy;
@@ -685,6 +770,23 @@ plain_tex_region_batch(ImageBuf& image, ustring filename, Mapping2DWide mapping,
                 if (!e.empty())
                     Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
             }
+            if (verify_batch) {
+                for (int i = 0; i < npoints; ++i) {
+                    texsys->texture(texture_handle, perthread_info, sopt, s[i],
+                                    t[i], dsdx[i], dtdx[i], dsdy[i], dtdy[i],
+                                    nchannels, sresult, sdresultds,
+                                    sdresultdt);
+                    verify_batch_lane("texture", x + i, y, nchannels, sresult,
+                                      result, i);
+                    if (test_derivs) {
+                        verify_batch_lane("texture ds", x + i, y, nchannels,
+                                          sdresultds, dresultds, i);
+                        verify_batch_lane("texture dt", x + i, y, nchannels,
+                                          sdresultdt, dresultdt, i);
+                    }
+                }
+                (void)texsys->geterror();
+            }
             // Save filtered pixels back to the image.
             for (int c = 0; c < nchannels; ++c)
                 result[c] *= scalefactor;
@@ -833,6 +935,14 @@ tex3d_region_batch(ImageBuf& image, ustring filename, Mapping3DWide mapping,
                                        : NULL;
     FloatWide* dresultdr = test_derivs ? OIIO_ALLOCA(FloatWide, nchannels)
                                        : NULL;
+    // Single point lookups for --verifybatch
+    TextureOpt sopt;
+    initialize_opt(sopt);
+    sopt.fill         = opt.fill;
+    float* sresult    = OIIO_ALLOCA(float, nchannels);
+    float* sdresultds = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    float* sdresultdt = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    float* sdresultdr = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
     for (int y = roi.ybegin; y < roi.yend; ++y) {
         for (int x = roi.xbegin; x < roi.xend; x += BatchWidth) {
             Imath::Vec3<FloatWide> P, dPdx, dPdy, dPdz;
@@ -853,6 +963,28 @@ tex3d_region_batch(ImageBuf& image, ustring filename, Mapping3DWide mapping,
                 if (!e.empty())
                     Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
             }
+            if (verify_batch) {
+                for (int i = 0; i < npoints; ++i) {
+                    Imath::V3f p(P[0][i], P[1][i], P[2][i]);
+                    Imath::V3f px(dPdx[0][i], dPdx[1][i], dPdx[2][i]);
+                    Imath::V3f py(dPdy[0][i], dPdy[1][i], dPdy[2][i]);
+                    Imath::V3f pz(dPdz[0][i], dPdz[1][i], dPdz[2][i]);
+                    texsys->texture3d(texture_handle, perthread_info, sopt, p,
+                                      px, py, pz, nchannels, sresult,
+                                      sdresultds, sdresultdt, sdresultdr);
+                    verify_batch_lane("texture3d", x + i, y, nchannels,
+                                      sresult, result, i);
+                    if (test_derivs) {
+                        verify_batch_lane("texture3d ds", x + i, y, nchannels,
+                                          sdresultds, dresultds, i);
+                        verify_batch_lane("texture3d dt", x + i, y, nchannels,
+                                          sdresultdt, dresultdt, i);
+                        verify_batch_lane("texture3d dr", x + i, y, nchannels,
+                                          sdresultdr, dresultdr, i);
+                    }
+                }
+                (void)texsys->geterror();
+            }
 
             // Save filtered pixels back to the image.
             for (int c = 0; c < nchannels; ++c)
@@ -934,7 +1066,181 @@ static void test_shadow(ustring /*filename*/) {}
 
 
 
-static void test_environment(ustring /*filename*/) {}
+void
+env_region(ImageBuf& image, ustring filename, Mapping3D mapping, ROI roi)
+{
+    TextureSystem::Perthread* perthread_info     = texsys->get_perthread_info();
+    TextureSystem::TextureHandle* texture_handle = texsys->get_texture_handle(
+        filename);
+    int nchannels = nchannels_override ? nchannels_override : image.nchannels();
+
+    TextureOpt opt;
+    initialize_opt(opt);
+
+    float* result    = OIIO_ALLOCA(float, std::max(3, nchannels));
+    float* dresultds = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    float* dresultdt = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    for (ImageBuf::Iterator<float> p(image, roi); !p.done(); ++p) {
+        Imath::V3f R, dRdx, dRdy, dRdz;
+        mapping(p.x(), p.y(), R, dRdx, dRdy, dRdz);
+
+        // Call the texture system to do the filtering.
+        bool ok = texsys->environment(texture_handle, perthread_info, opt, R,
+                                      dRdx, dRdy, nchannels, result, dresultds,
+                                      dresultdt);
+        if (!ok) {
+            std::string e = texsys->geterror();
+            if (!e.empty())
+                Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
+        }
+
+        // Save filtered pixels back to the image.
+        for (int i = 0; i < nchannels; ++i)
+            result[i] *= scalefactor;
+        image.setpixel(p.x(), p.y(), result);
+    }
+}
+
+
+
+void
+env_region_batch(ImageBuf& image, ustring filename, Mapping3DWide mapping,
+                 ROI roi)
+{
+    using namespace Tex;
+    TextureSystem::Perthread* perthread_info     = texsys->get_perthread_info();
+    TextureSystem::TextureHandle* texture_handle = texsys->get_texture_handle(
+        filename);
+    int nchannels_img = image.nchannels();
+    int nchannels = nchannels_override ? nchannels_override : image.nchannels();
+
+    TextureOptBatch opt;
+    initialize_opt(opt);
+
+    FloatWide* result    = OIIO_ALLOCA(FloatWide, std::max(3, nchannels));
+    FloatWide* dresultds = test_derivs ? OIIO_ALLOCA(FloatWide, nchannels)
+                                       : NULL;
+    FloatWide* dresultdt = test_derivs ? OIIO_ALLOCA(FloatWide, nchannels)
+                                       : NULL;
+    // Single point lookups for --verifybatch
+    TextureOpt sopt;
+    initialize_opt(sopt);
+    float* sresult    = OIIO_ALLOCA(float, std::max(3, nchannels));
+    float* sdresultds = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    float* sdresultdt = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    for (int y = roi.ybegin; y < roi.yend; ++y) {
+        for (int x = roi.xbegin; x < roi.xend; x += BatchWidth) {
+            Imath::Vec3<FloatWide> R, dRdx, dRdy, dRdz;
+            mapping(IntWide::Iota(x), y, R, dRdx, dRdy, dRdz);
+            int npoints  = std::min(BatchWidth, roi.xend - x);
+            RunMask mask = RunMaskOn >> (BatchWidth - npoints);
+
+            // Call the texture system to do the filtering.
+            bool ok = texsys->environment(texture_handle, perthread_info, opt,
+                                          mask, (float*)&R, (float*)&dRdx,
+                                          (float*)&dRdy, nchannels,
+                                          (float*)result, (float*)dresultds,
+                                          (float*)dresultdt);
+            if (!ok) {
+                std::string e = texsys->geterror();
+                if (!e.empty())
+                    Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
+            }
+            if (verify_batch) {
+                for (int i = 0; i < npoints; ++i) {
+                    Imath::V3f r(R[0][i], R[1][i], R[2][i]);
+                    Imath::V3f rx(dRdx[0][i], dRdx[1][i], dRdx[2][i]);
+                    Imath::V3f ry(dRdy[0][i], dRdy[1][i], dRdy[2][i]);
+                    texsys->environment(texture_handle, perthread_info, sopt,
+                                        r, rx, ry, nchannels, sresult,
+                                        sdresultds, sdresultdt);
+                    verify_batch_lane("environment", x + i, y, nchannels,
+                                      sresult, result, i);
+                    if (test_derivs) {
+                        verify_batch_lane("environment ds", x + i, y,
+                                          nchannels, sdresultds, dresultds, i);
+                        verify_batch_lane("environment dt", x + i, y,
+                                          nchannels, sdresultdt, dresultdt, i);
+                    }
+                }
+                (void)texsys->geterror();
+            }
+
+            // Save filtered pixels back to the image.
+            for (int c = 0; c < nchannels; ++c)
+                result[c] *= scalefactor;
+            float* resultptr = (float*)image.pixeladdr(x, y);
+            // FIXME: simplify by using SIMD scatter
+            for (int c = 0; c < nchannels; ++c)
+                for (int i = 0; i < npoints; ++i)
+                    resultptr[c + i * nchannels_img] = result[c][i];
+        }
+    }
+}
+
+
+
+static void
+test_environment(ustring filename, Mapping3D mapping)
+{
+    std::cout << "Testing environment " << filename
+              << ", output = " << output_filename << "\n";
+    int nchannels = nchannels_override ? nchannels_override : 4;
+    ImageSpec outspec(output_xres, output_yres, nchannels, TypeDesc::FLOAT);
+    ImageBuf image(outspec);
+    TypeDesc fmt(dataformatname);
+    image.set_write_format(fmt);
+    OIIO::ImageBufAlgo::zero(image);
+
+    for (int iter = 0; iter < iters; ++iter) {
+        if (close_before_iter)
+            texsys->close_all();
+        ImageBufAlgo::parallel_image(get_roi(image.spec()), nthreads,
+                                     std::bind(env_region, std::ref(image),
+                                               filename, mapping, _1));
+        if (resetstats) {
+            std::cout << texsys->getstats(2) << "\n";
+            texsys->reset_stats();
+        }
+    }
+
+    if (!image.write(output_filename))
+        Strutil::fprintf(std::cerr, "Error writing %s : %s\n", output_filename,
+                         image.geterror());
+}
+
+
+
+static void
+test_environment_batch(ustring filename, Mapping3DWide mapping)
+{
+    std::cout << "Testing BATCHED environment " << filename
+              << ", output = " << output_filename << "\n";
+    int nchannels = nchannels_override ? nchannels_override : 4;
+    ImageSpec outspec(output_xres, output_yres, nchannels, TypeDesc::FLOAT);
+    ImageBuf image(outspec);
+    TypeDesc fmt(dataformatname);
+    image.set_write_format(fmt);
+    OIIO::ImageBufAlgo::zero(image);
+
+    for (int iter = 0; iter < iters; ++iter) {
+        if (close_before_iter)
+            texsys->close_all();
+        ImageBufAlgo::parallel_image(get_roi(image.spec()), nthreads,
+                                     [&](ROI roi) {
+                                         env_region_batch(image, filename,
+                                                          mapping, roi);
+                                     });
+        if (resetstats) {
+            std::cout << texsys->getstats(2) << "\n";
+            texsys->reset_stats();
+        }
+    }
+
+    if (!image.write(output_filename))
+        Strutil::fprintf(std::cerr, "Error writing %s : %s\n", output_filename,
+                         image.geterror());
+}
 
 
 
@@ -1566,7 +1872,10 @@ main(int argc, const char* argv[])
             test_shadow(filename);
         }
         if (!strcmp(texturetype, "Environment")) {
-            test_environment(filename);
+            if (batch)
+                test_environment_batch(filename, map_env);
+            else
+                test_environment(filename, map_env);
         }
         test_getimagespec_gettexels(filename);
         std::cout << "Time: " << Strutil::timeintervalformat(timer()) << "\n";
@@ -1622,5 +1931,11 @@ main(int argc, const char* argv[])
 
     if (verbose)
         std::cout << "\nustrings: " << ustring::getstats(false) << "\n\n";
+    if (verify_batch) {
+        std::cout << "Batch verification: " << batch_mismatches
+                  << " mismatches\n";
+        if (batch_mismatches)
+            return EXIT_FAILURE;
+    }
     return 0;
 }
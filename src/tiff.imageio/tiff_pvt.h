@@ -0,0 +1,113 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio/blob/master/LICENSE.md
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include <tiffio.h>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imageio.h>
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+
+namespace tiff_pvt {
+
+// libtiff client procedures that do the I/O through an IOProxy, which is
+// passed as the thandle_t. The proxy is owned by the caller, so closing
+// the TIFF doesn't close it.
+
+inline Filesystem::IOProxy*
+proxy(thandle_t handle)
+{
+    return reinterpret_cast<Filesystem::IOProxy*>(handle);
+}
+
+
+inline tsize_t
+readproc(thandle_t handle, tdata_t data, tsize_t size)
+{
+    auto io = proxy(handle);
+    if (io->mode() == Filesystem::IOProxy::Write) {
+        // libtiff reads back directory links and headers it has already
+        // written when it appends a directory. We can serve that from a
+        // vector output, but a write-only file can't be read.
+        if (strcmp(io->proxytype(), "vecoutput"))
+            return 0;
+        auto& buf   = static_cast<Filesystem::IOVecOutput*>(io)->buffer();
+        int64_t pos = io->tell();
+        if (pos < 0 || pos >= int64_t(buf.size()))
+            return 0;
+        size_t n = std::min(size_t(size), buf.size() - size_t(pos));
+        memcpy(data, buf.data() + pos, n);
+        io->seek(pos + int64_t(n));
+        return tsize_t(n);
+    }
+    return tsize_t(io->read(data, size_t(size)));
+}
+
+
+inline tsize_t
+writeproc(thandle_t handle, tdata_t data, tsize_t size)
+{
+    return tsize_t(proxy(handle)->write(data, size_t(size)));
+}
+
+
+inline toff_t
+seekproc(thandle_t handle, toff_t offset, int origin)
+{
+    auto io = proxy(handle);
+    // N.B. for SEEK_CUR and SEEK_END, the unsigned offset may really be a
+    // negative number, so reinterpret it as signed.
+    if (!io->seek(int64_t(offset), origin))
+        return toff_t(-1);
+    return toff_t(io->tell());
+}
+
+
+inline int
+closeproc(thandle_t /*handle*/)
+{
+    return 0;  // The proxy belongs to the caller
+}
+
+
+inline toff_t
+sizeproc(thandle_t handle)
+{
+    return toff_t(proxy(handle)->size());
+}
+
+
+inline int
+mapproc(thandle_t /*handle*/, tdata_t* /*base*/, toff_t* /*size*/)
+{
+    return 0;  // No memory mapping, libtiff will use readproc
+}
+
+
+inline void
+unmapproc(thandle_t /*handle*/, tdata_t /*base*/, toff_t /*size*/)
+{
+}
+
+
+// Open a TIFF that reads from or writes to io. The mode is as for
+// TIFFOpen.
+inline TIFF*
+open_proxy(const std::string& name, const char* mode, Filesystem::IOProxy* io)
+{
+    return TIFFClientOpen(name.c_str(), mode, (thandle_t)io, readproc,
+                          writeproc, seekproc, closeproc, sizeproc, mapproc,
+                          unmapproc);
+}
+
+}  // namespace tiff_pvt
+
+
+OIIO_PLUGIN_NAMESPACE_END
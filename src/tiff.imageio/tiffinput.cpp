@@ -22,6 +22,7 @@
 #include <OpenImageIO/typedesc.h>
 
 #include "imageio_pvt.h"
+#include "tiff_pvt.h"
 
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -49,6 +50,102 @@ struct TIFF_tag_info {
 
 
 
+// Decode TIFF LZW data (the "new style" variant written by every TIFF
+// writer since 1991: MSB-first codes of 9 to 12 bits, with the "early
+// change" of code width) into exactly outsize bytes. Unlike libtiff's
+// decoder, this has no state beyond the call, so raw strips or tiles may
+// be decoded in parallel. Return true if the data decoded to exactly the
+// expected size.
+static bool
+tiff_lzw_decode(const unsigned char* in, size_t insize, unsigned char* out,
+                size_t outsize)
+{
+    enum { Clear = 256, EOI = 257, FirstFree = 258, MaxCodes = 4096 };
+    // Each table entry is its prefix code, its last byte, and its length.
+    // A string is written by walking the prefixes backwards from its end.
+    uint16_t prefix[MaxCodes];
+    unsigned char suffix[MaxCodes];
+    uint16_t length[MaxCodes];
+    for (int i = 0; i < 256; ++i) {
+        prefix[i] = 0;
+        suffix[i] = (unsigned char)i;
+        length[i] = 1;
+    }
+
+    const unsigned char* inend = in + insize;
+    size_t pos                 = 0;
+    uint32_t bitbuf            = 0;
+    int bitsinbuf              = 0;
+    int nbits                  = 9;
+    int freecode               = FirstFree;
+    int oldcode                = -1;
+    while (pos < outsize) {
+        while (bitsinbuf < nbits && in < inend) {
+            bitbuf = (bitbuf << 8) | *in++;
+            bitsinbuf += 8;
+        }
+        if (bitsinbuf < nbits)
+            break;  // ran out of input
+        int code = int(bitbuf >> (bitsinbuf - nbits)) & ((1 << nbits) - 1);
+        bitsinbuf -= nbits;
+        if (code == EOI)
+            break;
+        if (code == Clear) {
+            nbits    = 9;
+            freecode = FirstFree;
+            oldcode  = -1;
+            continue;
+        }
+        if (oldcode < 0) {
+            // First code after a clear must be a literal
+            if (code >= 256)
+                return false;
+            out[pos++] = (unsigned char)code;
+            oldcode    = code;
+            continue;
+        }
+        if (code > freecode || (code == freecode && freecode >= MaxCodes))
+            return false;  // corrupt
+        int len = length[code == freecode ? oldcode : code]
+                  + (code == freecode ? 1 : 0);
+        // Add the new table entry: oldcode's string plus the first byte
+        // of this code's string.
+        if (freecode < MaxCodes) {
+            prefix[freecode] = (uint16_t)oldcode;
+            length[freecode] = length[oldcode] + 1;
+        }
+        // Write the string for code, back to front. If code is the entry
+        // being added (the KwKwK case), it's oldcode's string plus its own
+        // first byte, and that last byte is filled in afterwards.
+        size_t n = std::min(size_t(len), outsize - pos);
+        size_t i = size_t(len);
+        int c    = code;
+        if (code == freecode) {
+            --i;
+            c = oldcode;
+        }
+        while (i-- > 0) {
+            if (i < n)
+                out[pos + i] = suffix[c];
+            c = prefix[c];
+        }
+        unsigned char first = out[pos];
+        if (freecode < MaxCodes)
+            suffix[freecode] = first;
+        if (code == freecode && size_t(len - 1) < n)
+            out[pos + len - 1] = first;
+        pos += n;
+        oldcode = code;
+        if (freecode < MaxCodes)
+            ++freecode;
+        if (freecode >= (1 << nbits) - 1 && nbits < 12)
+            ++nbits;
+    }
+    return pos == outsize;
+}
+
+
+
 // Note about MIP-maps versus subimages:
 //
 // TIFF files support subimages, but do not explicitly support
@@ -76,7 +173,8 @@ public:
     virtual bool valid_file(const std::string& filename) const override;
     virtual int supports(string_view feature) const override
     {
-        return (feature == "exif" || feature == "iptc");
+        return (feature == "exif" || feature == "iptc"
+                || feature == "ioproxy");
         // N.B. No support for arbitrary metadata.
     }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
@@ -139,6 +237,7 @@ private:
     bool m_convert_alpha;            ///< Do we need to associate alpha?
     bool m_separate;                 ///< Separate planarconfig?
     bool m_testopenconfig;           ///< Debug aid to test open-with-config
+    bool m_want_tile_offsets;        ///< Add "tiff:tile_offsets" to specs
     bool m_use_rgba_interface;       ///< Sometimes we punt
     bool m_is_byte_swapped;          ///< Is the file opposite our endian?
     int m_rowsperstrip;              ///< For scanline imgs, rows per strip
@@ -164,11 +263,34 @@ private:
         m_separate                = false;
         m_inputchannels           = 0;
         m_testopenconfig          = false;
+        m_want_tile_offsets       = false;
         m_colormap.clear();
         m_use_rgba_interface = false;
         m_subimage_specs.clear();
     }
 
+    // Open m_tif, through the app's IOProxy if we were given one, or else
+    // from the named file. Return true if m_tif is open.
+    bool open_tif()
+    {
+        if (ioproxy()) {
+            // The proxy may have been left anywhere by a previous reader
+            // (or by our own earlier use of it), but libtiff expects to
+            // find the header at its start.
+            m_tif = ioproxy()->seek(0)
+                        ? tiff_pvt::open_proxy(m_filename, "rm", ioproxy())
+                        : NULL;
+        } else {
+#ifdef _WIN32
+            std::wstring wfilename = Strutil::utf8_to_utf16(m_filename);
+            m_tif                  = TIFFOpenW(wfilename.c_str(), "rm");
+#else
+            m_tif = TIFFOpen(m_filename.c_str(), "rm");
+#endif
+        }
+        return m_tif != NULL;
+    }
+
     // Just close the TIFF file handle, but don't forget anything we
     // learned about the contents of the file or any configuration hints.
     void close_tif()
@@ -183,8 +305,13 @@ private:
 
     // Read tags from the current directory of m_tif and fill out spec.
     // If read_meta is false, assume that m_spec already contains valid
-    // metadata and should not be cleared or rewritten.
-    void readspec(bool read_meta = true);
+    // metadata and should not be cleared or rewritten. Return false (with
+    // an error issued, and m_tif closed) if the file could not be reread.
+    bool readspec(bool read_meta = true);
+
+    // Add the "tiff:tile_offsets" attribute to m_spec if the tiles of the
+    // current subimage may be used in place, or remove it if not.
+    void readspec_tile_offsets();
 
     // Figure out all the photometric-related aspects of the header
     void readspec_photometric();
@@ -353,40 +480,69 @@ private:
             }
     }
 
+    // Decode one raw strip or tile that was read with TIFFReadRawStrip or
+    // TIFFReadRawTile: decompress (deflate, LZW, or none), byte swap, and
+    // undo the horizontal predictor, just as libtiff would have done. This
+    // is safe to call from multiple threads at once, since it doesn't
+    // touch libtiff's state. Failure stashes false in *ok.
     void uncompress_one_strip(void* compressed_buf, unsigned long csize,
                               void* uncompressed_buf, size_t strip_bytes,
                               int channels, int width, int height,
                               int compression, bool* ok)
     {
-        OIIO_DASSERT (compression == COMPRESSION_ADOBE_DEFLATE /*||
-                      compression == COMPRESSION_NONE*/);
+        OIIO_DASSERT(compression == COMPRESSION_ADOBE_DEFLATE
+                     || compression == COMPRESSION_LZW
+                     || compression == COMPRESSION_NONE);
         if (compression == COMPRESSION_NONE) {
             // just copy if there's no compression
-            memcpy(uncompressed_buf, compressed_buf, csize);
-            if (m_is_byte_swapped && m_spec.format == TypeUInt16)
-                TIFFSwabArrayOfShort((unsigned short*)uncompressed_buf,
-                                     width * height * channels);
-            return;
+            if (csize < strip_bytes) {
+                *ok = false;
+                return;
+            }
+            memcpy(uncompressed_buf, compressed_buf, strip_bytes);
+        } else if (compression == COMPRESSION_LZW) {
+            if (!tiff_lzw_decode((const unsigned char*)compressed_buf, csize,
+                                 (unsigned char*)uncompressed_buf,
+                                 strip_bytes)) {
+                *ok = false;
+                return;
+            }
+        } else {
+            uLong uncompressed_size = (uLong)strip_bytes;
+            auto zok = uncompress((Bytef*)uncompressed_buf, &uncompressed_size,
+                                  (const Bytef*)compressed_buf, csize);
+            if (zok != Z_OK || uncompressed_size != strip_bytes) {
+                *ok = false;
+                return;
+            }
         }
-        uLong uncompressed_size = (uLong)strip_bytes;
-        auto zok = uncompress((Bytef*)uncompressed_buf, &uncompressed_size,
-                              (const Bytef*)compressed_buf, csize);
-        if (zok != Z_OK || uncompressed_size != strip_bytes) {
-            *ok = false;
-            return;
+        size_t nvals = size_t(width) * size_t(height) * size_t(channels);
+        if (m_is_byte_swapped) {
+            if (m_spec.format.size() == 2)
+                TIFFSwabArrayOfShort((unsigned short*)uncompressed_buf,
+                                     tmsize_t(nvals));
+            else if (m_spec.format.size() == 4)
+                TIFFSwabArrayOfLong((uint32_t*)uncompressed_buf,
+                                    tmsize_t(nvals));
+            else if (m_spec.format.size() == 8)
+                TIFFSwabArrayOfDouble((double*)uncompressed_buf,
+                                      tmsize_t(nvals));
         }
-        if (m_is_byte_swapped && m_spec.format == TypeUInt16)
-            TIFFSwabArrayOfShort((unsigned short*)uncompressed_buf,
-                                 width * height * channels);
-        if (m_predictor == PREDICTOR_HORIZONTAL) {
-            if (m_spec.format == TypeUInt8)
+        // libtiff only applies the predictor for compressed data
+        if (m_predictor == PREDICTOR_HORIZONTAL
+            && compression != COMPRESSION_NONE) {
+            if (m_spec.format.size() == 1)
                 undo_horizontal_predictor((unsigned char*)uncompressed_buf,
                                           (unsigned char*)uncompressed_buf,
                                           channels, width, height);
-            else if (m_spec.format == TypeUInt16)
+            else if (m_spec.format.size() == 2)
                 undo_horizontal_predictor((unsigned short*)uncompressed_buf,
                                           (unsigned short*)uncompressed_buf,
                                           channels, width, height);
+            else if (m_spec.format.size() == 4)
+                undo_horizontal_predictor((uint32_t*)uncompressed_buf,
+                                          (uint32_t*)uncompressed_buf,
+                                          channels, width, height);
         }
     }
 
@@ -583,6 +739,9 @@ TIFFInput::open(const std::string& name, ImageSpec& newspec,
     // OIIO components.
     if (config.get_int_attribute("oiio:DebugOpenConfig!", 0))
         m_testopenconfig = true;
+    if (config.get_int_attribute("tiff:tile_offsets", 0))
+        m_want_tile_offsets = true;
+    ioproxy_retrieve_from_config(config);
     return open(name, newspec);
 }
 
@@ -615,13 +774,9 @@ TIFFInput::seek_subimage(int subimage, int miplevel)
     bool read_meta = !(m_emulate_mipmap && m_tif && m_subimage >= 0);
 
     if (!m_tif) {
-#ifdef _WIN32
-        std::wstring wfilename = Strutil::utf8_to_utf16(m_filename);
-        m_tif                  = TIFFOpenW(wfilename.c_str(), "rm");
-#else
-        m_tif = TIFFOpen(m_filename.c_str(), "rm");
-#endif
-        if (m_tif == NULL) {
+        if (ioproxy() && !ioproxy_opened() && !ioproxy_use_or_open(m_filename))
+            return false;
+        if (!open_tif()) {
             std::string e = oiio_tiff_last_error();
             errorf("Could not open file: %s", e.length() ? e : m_filename);
             return false;
@@ -633,7 +788,10 @@ TIFFInput::seek_subimage(int subimage, int miplevel)
     m_next_scanline = 0;  // next scanline we'll read
     if (subimage == m_subimage || TIFFSetDirectory(m_tif, subimage)) {
         m_subimage = subimage;
-        readspec(read_meta);
+        if (!readspec(read_meta)) {
+            m_subimage = -1;
+            return false;
+        }
         // OK, some edge cases we just don't handle. For those, fall back on
         // the TIFFRGBA interface.
         bool is_jpeg        = (m_compression == COMPRESSION_JPEG
@@ -657,6 +815,7 @@ TIFFInput::seek_subimage(int subimage, int miplevel)
             m_spec.channelformats.clear();
             m_photometric = PHOTOMETRIC_RGB;
         }
+        readspec_tile_offsets();
         if (size_t(subimage) >= m_subimage_specs.size())  // make room
             m_subimage_specs.resize(
                 subimage > 0 ? round_to_multiple(subimage + 1, 4) : 1);
@@ -719,7 +878,7 @@ TIFFInput::spec_dimensions(int subimage, int miplevel)
 #define ICC_PROFILE_ATTR "ICCProfile"
 
 
-void
+bool
 TIFFInput::readspec(bool read_meta)
 {
     uint32 width = 0, height = 0, depth = 0;
@@ -976,7 +1135,7 @@ TIFFInput::readspec(bool read_meta)
     // assumed to be identical to what we already have in m_spec,
     // skip everything following.
     if (!read_meta)
-        return;
+        return true;
 
     short resunit = -1;
     TIFFGetField(m_tif, TIFFTAG_RESOLUTIONUNIT, &resunit);
@@ -1034,14 +1193,13 @@ TIFFInput::readspec(bool read_meta)
         // I'm not sure what state TIFFReadEXIFDirectory leaves us.
         // So to be safe, close and re-seek.
         TIFFClose(m_tif);
-#    ifdef _WIN32
-        std::wstring wfilename = Strutil::utf8_to_utf16(m_filename);
-        m_tif                  = TIFFOpenW(wfilename.c_str(), "rm");
-#    else
-        m_tif = TIFFOpen(m_filename.c_str(), "rm");
-#    endif
-        if (m_subimage)
-            TIFFSetDirectory(m_tif, m_subimage);
+        if (!open_tif()
+            || (m_subimage && !TIFFSetDirectory(m_tif, m_subimage))) {
+            std::string e = oiio_tiff_last_error();
+            errorf("Could not reopen file: %s", e.length() ? e : m_filename);
+            close_tif();
+            return false;
+        }
 
         // A few tidbits to look for
         ParamValue* p;
@@ -1138,6 +1296,51 @@ TIFFInput::readspec(bool read_meta)
 
     if (m_testopenconfig)  // open-with-config debugging
         m_spec.attribute("oiio:DebugOpenConfig!", 42);
+    return true;
+}
+
+
+
+void
+TIFFInput::readspec_tile_offsets()
+{
+    m_spec.erase_attribute("tiff:tile_offsets");
+    if (!m_want_tile_offsets || !m_spec.tile_width)
+        return;
+    // Only when the bytes in the file are exactly what read_native_tile
+    // would give back, with no decoding or conversion of any kind.
+    if (m_compression != COMPRESSION_NONE || m_separate || m_is_byte_swapped
+        || m_use_rgba_interface || m_convert_alpha
+        || m_photometric == PHOTOMETRIC_PALETTE
+        || m_photometric == PHOTOMETRIC_MINISWHITE
+        || m_photometric == PHOTOMETRIC_SEPARATED
+        || m_inputchannels != m_spec.nchannels
+        || m_bitspersample != m_spec.format.size() * 8
+        || m_spec.channelformats.size())
+        return;
+#if TIFFLIB_VERSION >= 20120922
+    uint64* offsets    = nullptr;
+    uint64* bytecounts = nullptr;
+#else
+    uint32* offsets    = nullptr;
+    uint32* bytecounts = nullptr;
+#endif
+    if (!TIFFGetField(m_tif, TIFFTAG_TILEOFFSETS, &offsets)
+        || !TIFFGetField(m_tif, TIFFTAG_TILEBYTECOUNTS, &bytecounts)
+        || !offsets || !bytecounts)
+        return;
+    // libtiff numbers the tiles in the same x, then y, then z order.
+    int ntiles = int(TIFFNumberOfTiles(m_tif));
+    if (ntiles < 1)
+        return;
+    std::vector<uint64_t> tileoffsets(ntiles);
+    for (int t = 0; t < ntiles; ++t) {
+        if (imagesize_t(bytecounts[t]) < m_spec.tile_bytes(true))
+            return;  // truncated or otherwise odd file
+        tileoffsets[t] = uint64_t(offsets[t]);
+    }
+    m_spec.attribute("tiff:tile_offsets", TypeDesc(TypeDesc::UINT64, ntiles),
+                     tileoffsets.data());
 }
 
 
@@ -1252,6 +1455,8 @@ TIFFInput::close()
 {
     close_tif();
     init();  // Reset to initial state
+    if (ioproxy_opened())
+        ioproxy_clear();
     return true;
 }
 
@@ -1854,11 +2059,11 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
 
     // If the stars all align properly, use the thread pool to parallelize
     // the decompression. This can give a large speedup (5x or more!)
-    // because the zip decompression dwarfs the actual raw I/O. But libtiff
-    // is totally serialized, so we can only parallelize by making calls to
-    // zlib ourselves and then writing "raw" (compressed) strips. Don't
-    // bother trying to handle any of the uncommon cases with strips. This
-    // covers most real-world cases.
+    // because the zip or LZW decompression dwarfs the actual raw I/O. But
+    // libtiff is totally serialized, so we can only parallelize by reading
+    // "raw" (compressed) tiles and decoding them ourselves. Don't bother
+    // trying to handle any of the uncommon cases with tiles. This covers
+    // most real-world cases.
     thread_pool* pool = default_thread_pool();
     OIIO_DASSERT(m_spec.tile_depth >= 1);
     size_t ntiles = size_t(
@@ -1875,11 +2080,16 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
         && (spec().format.size() * 8 == m_bitspersample)
         // contig planarconfig only (for now?)
         && !m_separate
-        // only deflate/zip compression with horizontal predictor
-        && m_compression == COMPRESSION_ADOBE_DEFLATE
-        && m_predictor == PREDICTOR_HORIZONTAL
-        // only uint8, uint16
-        && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
+        // only compression we can decode ourselves: deflate/zip, LZW, none
+        && (m_compression == COMPRESSION_ADOBE_DEFLATE
+            || m_compression == COMPRESSION_LZW
+            || m_compression == COMPRESSION_NONE)
+        // only no predictor, or horizontal predictor on samples up to
+        // 32 bits (libtiff ignores the predictor for uncompressed data)
+        && (m_predictor == PREDICTOR_NONE
+            || m_compression == COMPRESSION_NONE
+            || (m_predictor == PREDICTOR_HORIZONTAL
+                && m_spec.format.size() <= 4))
         // No other unusual cases
         && !m_use_rgba_interface
         // only if we're threading and don't enter the thread pool recursively!
@@ -1907,7 +2117,14 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
     stride_t zstride       = (yend - ybegin) * ystride;
     imagesize_t tile_bytes = m_spec.tile_bytes(true);
     int tilevals           = m_spec.tile_pixels() * m_spec.nchannels;
-    size_t cbound          = compressBound((uLong)tile_bytes);
+    // Worst case raw tile size. LZW codes are at most 12 bits for each
+    // byte, plus a clear code every 4094 codes.
+    size_t cbound = m_compression == COMPRESSION_ADOBE_DEFLATE
+                        ? size_t(compressBound((uLong)tile_bytes))
+                        : m_compression == COMPRESSION_LZW
+                              ? size_t(tile_bytes + tile_bytes / 2
+                                       + tile_bytes / 1024 + 64)
+                              : size_t(tile_bytes);
     std::unique_ptr<char[]> compressed_scratch(new char[cbound * ntiles]);
     std::unique_ptr<char[]> scratch(new char[tile_bytes * ntiles]);
     task_set tasks(pool);
@@ -1928,16 +2145,36 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                     errorf(
                         "TIFFReadRawTile failed reading tile x=%d,y=%d,z=%d: %s",
                         x, y, z, err.size() ? err.c_str() : "unknown error");
+                    tasks.wait();
                     return false;
                 }
+                // Old-style (pre-TIFF 6) LZW is bit-reversed and rare
+                // enough that we just let libtiff decode it, serially.
+                bool decoded = false;
+                if (m_compression == COMPRESSION_LZW && csize >= 2
+                    && cbuf[0] == 0 && (cbuf[1] & 0x1)) {
+                    if (TIFFReadEncodedTile(m_tif, tile_index(x, y, z), ubuf,
+                                            tmsize_t(tile_bytes))
+                        < 0) {
+                        std::string err = oiio_tiff_last_error();
+                        errorf(
+                            "TIFFReadEncodedTile failed reading tile x=%d,y=%d,z=%d: %s",
+                            x, y, z, err.size() ? err.c_str() : "unknown error");
+                        tasks.wait();
+                        return false;
+                    }
+                    decoded = true;
+                }
                 // Push the rest of the work onto the thread pool queue
                 tasks.push(pool->push([=, &ok](int /*id*/) {
-                    uncompress_one_strip(cbuf, (unsigned long)csize, ubuf,
-                                         tile_bytes, this->m_spec.nchannels,
-                                         this->m_spec.tile_width,
-                                         this->m_spec.tile_height
-                                             * this->m_spec.tile_depth,
-                                         m_compression, &ok);
+                    if (!decoded)
+                        uncompress_one_strip(cbuf, (unsigned long)csize, ubuf,
+                                             tile_bytes,
+                                             this->m_spec.nchannels,
+                                             this->m_spec.tile_width,
+                                             this->m_spec.tile_height
+                                                 * this->m_spec.tile_depth,
+                                             m_compression, &ok);
                     if (m_photometric == PHOTOMETRIC_MINISWHITE)
                         invert_photometric(tilevals, ubuf);
                     copy_image(this->m_spec.nchannels, this->m_spec.tile_width,
@@ -1953,6 +2190,11 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
             }
         }
     }
+    // Wait for all the decodes before looking at whether they succeeded
+    tasks.wait();
+    if (!ok)
+        errorf("Could not decompress tiles in range x=[%d,%d) y=[%d,%d)",
+               xbegin, xend, ybegin, yend);
     return ok;
 }
 
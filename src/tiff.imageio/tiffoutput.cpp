@@ -23,6 +23,8 @@
 #include <OpenImageIO/tiffutils.h>
 #include <OpenImageIO/timer.h>
 
+#include "tiff_pvt.h"
+
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
 
@@ -295,6 +297,8 @@ TIFFOutput::supports(string_view feature) const
         return true;
     if (feature == "iptc")
         return true;
+    if (feature == "ioproxy")
+        return true;
     // N.B. TIFF doesn't support arbitrary metadata.
 
     // FIXME: we could support "volumes" and "empty"
@@ -326,8 +330,15 @@ TIFFOutput::open(const std::string& name, const ImageSpec& userspec,
         return false;
     }
 
+    // Appending a subimage re-opens the file we were writing, so if that
+    // was the app's proxy, hang onto it across the close().
+    Filesystem::IOProxy* io = (mode == AppendSubimage && !ioproxy_owned())
+                                  ? ioproxy()
+                                  : nullptr;
     close();            // Close any already-opened file
     m_spec = userspec;  // Stash the spec
+    if (io)
+        set_ioproxy(io);
 
     // Check for things this format doesn't support
     if (m_spec.width < 1 || m_spec.height < 1) {
@@ -355,15 +366,25 @@ TIFFOutput::open(const std::string& name, const ImageSpec& userspec,
         }
     }
 
-    // Open the file
+    // Open the file, or write through the app's proxy if we were given one
+    ioproxy_retrieve_from_config(m_spec);
+    if (ioproxy()) {
+        if (!ioproxy_use_or_open(name))
+            return false;
+        m_tif = tiff_pvt::open_proxy(name, mode == AppendSubimage ? "a" : "w",
+                                     ioproxy());
+    } else {
 #ifdef _WIN32
-    std::wstring wname = Strutil::utf8_to_utf16(name);
-    m_tif = TIFFOpenW(wname.c_str(), mode == AppendSubimage ? "a" : "w");
+        std::wstring wname = Strutil::utf8_to_utf16(name);
+        m_tif = TIFFOpenW(wname.c_str(), mode == AppendSubimage ? "a" : "w");
 #else
-    m_tif = TIFFOpen(name.c_str(), mode == AppendSubimage ? "a" : "w");
+        m_tif = TIFFOpen(name.c_str(), mode == AppendSubimage ? "a" : "w");
 #endif
+    }
     if (!m_tif) {
         errorf("Could not open \"%s\"", name);
+        if (ioproxy_opened())
+            ioproxy_clear();
         return false;
     }
 
@@ -929,6 +950,8 @@ TIFFOutput::close()
         write_exif_data();
         TIFFClose(m_tif);  // N.B. TIFFClose doesn't return a status code
     }
+    if (ioproxy_opened())
+        ioproxy_clear();
     init();       // re-initialize
     return true;  // How can we fail?
 }
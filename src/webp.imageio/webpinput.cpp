@@ -21,7 +21,13 @@ public:
     WebpInput() { init(); }
     virtual ~WebpInput() { close(); }
     virtual const char* format_name() const override { return "webp"; }
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& spec) override;
+    virtual bool open(const std::string& name, ImageSpec& spec,
+                      const ImageSpec& config) override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
     virtual bool close() override;
@@ -31,52 +37,53 @@ private:
     uint8_t* m_decoded_image;
     uint64_t m_image_size;
     long int m_scanline_size;
-    FILE* m_file;
 
     void init()
     {
         m_image_size    = 0;
         m_scanline_size = 0;
         m_decoded_image = NULL;
-        m_file          = NULL;
     }
 };
 
 
+bool
+WebpInput::open(const std::string& name, ImageSpec& spec,
+                const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, spec);
+}
+
+
 bool
 WebpInput::open(const std::string& name, ImageSpec& spec)
 {
     m_filename = name;
 
     // Perform preliminary test on file type.
-    if (!Filesystem::is_regular(m_filename)) {
+    if (!ioproxy() && !Filesystem::is_regular(m_filename)) {
         errorf("Not a regular file \"%s\"", m_filename);
         return false;
     }
 
-    // Get file size and check we've got enough data to decode WebP.
-    m_image_size = Filesystem::file_size(name);
-    if (m_image_size == uint64_t(-1)) {
-        errorf("Failed to get size for \"%s\"", m_filename);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
+
+    // Get file size and check we've got enough data to decode WebP.
+    m_image_size = ioproxy()->size();
     if (m_image_size < 12) {
         errorf("File size is less than WebP header for file \"%s\"",
                m_filename);
-        return false;
-    }
-
-    m_file = Filesystem::fopen(m_filename, "rb");
-    if (!m_file) {
-        errorf("Could not open file \"%s\"", m_filename);
+        close();
         return false;
     }
 
     // Read header and verify we've got WebP image.
     std::vector<uint8_t> image_header;
     image_header.resize(std::min(m_image_size, (uint64_t)64), 0);
-    size_t numRead = fread(&image_header[0], sizeof(uint8_t),
-                           image_header.size(), m_file);
+    size_t numRead = ioproxy()->pread(&image_header[0], image_header.size(),
+                                      0);
     if (numRead != image_header.size()) {
         errorf("Read failure for header of \"%s\" (expected %d bytes, read %d)",
                m_filename, image_header.size(), numRead);
@@ -94,9 +101,7 @@ WebpInput::open(const std::string& name, ImageSpec& spec)
     // Read actual data and decode.
     std::vector<uint8_t> encoded_image;
     encoded_image.resize(m_image_size, 0);
-    fseek(m_file, 0, SEEK_SET);
-    numRead = fread(&encoded_image[0], sizeof(uint8_t), encoded_image.size(),
-                    m_file);
+    numRead = ioproxy()->pread(&encoded_image[0], encoded_image.size(), 0);
     if (numRead != encoded_image.size()) {
         errorf("Read failure for \"%s\" (expected %d bytes, read %d)",
                m_filename, encoded_image.size(), numRead);
@@ -153,10 +158,7 @@ WebpInput::read_native_scanline(int /*subimage*/, int /*miplevel*/, int y,
 bool
 WebpInput::close()
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = NULL;
-    }
+    ioproxy_clear();
     if (m_decoded_image) {
         free(m_decoded_image);
         m_decoded_image = NULL;
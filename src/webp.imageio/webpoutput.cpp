@@ -34,16 +34,11 @@ private:
     WebPPicture m_webp_picture;
     WebPConfig m_webp_config;
     std::string m_filename;
-    FILE* m_file;
     int m_scanline_size;
     unsigned int m_dither;
     std::vector<uint8_t> m_uncompressed_image;
 
-    void init()
-    {
-        m_scanline_size = 0;
-        m_file          = NULL;
-    }
+    void init() { m_scanline_size = 0; }
 };
 
 
@@ -52,7 +47,8 @@ int
 WebpOutput::supports(string_view feature) const
 {
     return feature == "tiles" || feature == "alpha"
-           || feature == "random_access" || feature == "rewrite";
+           || feature == "random_access" || feature == "rewrite"
+           || feature == "ioproxy";
 }
 
 
@@ -61,13 +57,9 @@ static int
 WebpImageWriter(const uint8_t* img_data, size_t data_size,
                 const WebPPicture* const webp_img)
 {
-    FILE* out_file = (FILE*)webp_img->custom_ptr;
-    size_t wb      = fwrite(img_data, data_size, sizeof(uint8_t), out_file);
-    if (wb != sizeof(uint8_t)) {
-        //FIXME Bad write occurred
-    }
-
-    return 1;
+    auto io = (Filesystem::IOProxy*)webp_img->custom_ptr;
+    // Returning 0 makes WebPEncode stop and report the failure.
+    return io->write(img_data, data_size) == data_size;
 }
 
 
@@ -90,11 +82,9 @@ WebpOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
         return false;
     }
 
-    m_file = Filesystem::fopen(m_filename, "wb");
-    if (!m_file) {
-        errorf("Could not open \"%s\"", m_filename);
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(m_filename))
         return false;
-    }
 
     if (!WebPPictureInit(&m_webp_picture)) {
         errorf("Couldn't initialize WebPPicture\n");
@@ -105,7 +95,7 @@ WebpOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
     m_webp_picture.width      = m_spec.width;
     m_webp_picture.height     = m_spec.height;
     m_webp_picture.writer     = WebpImageWriter;
-    m_webp_picture.custom_ptr = (void*)m_file;
+    m_webp_picture.custom_ptr = (void*)ioproxy();
 
     if (!WebPConfigInit(&m_webp_config)) {
         errorf("Couldn't initialize WebPPicture\n");
@@ -189,7 +179,7 @@ WebpOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
 bool
 WebpOutput::close()
 {
-    if (!m_file)
+    if (!ioproxy_opened())
         return true;  // already closed
 
     bool ok = true;
@@ -202,9 +192,8 @@ WebpOutput::close()
     }
 
     WebPPictureFree(&m_webp_picture);
-    fclose(m_file);
-    m_file = NULL;
-    return true;
+    ioproxy_clear();
+    return ok;
 }
 
 
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 #include <zlib.h>
 
@@ -32,21 +33,13 @@ struct ZfileHeader {
 static const int zfile_magic        = 0x2f0867ab;
 static const int zfile_magic_endian = 0xab67082f;  // other endianness
 
+// Zfiles may be gzip-compressed, and we do the compression ourselves
+// with zlib, through our IOProxy. These are the zlib window bits that ask
+// for a gzip header and trailer rather than a zlib one.
+static const int gzip_window_bits = 15 + 16;
 
-
-// Open the named file (setting m_filename), return either open gz
-// handle or 0 (if it failed).
-gzFile
-open_gz(const std::string& filename, const char* mode)
-{
-#ifdef _WIN32
-    std::wstring wpath = Strutil::utf8_to_utf16(filename);
-    gzFile gz          = gzopen_w(wpath.c_str(), mode);
-#else
-    gzFile gz = gzopen(filename.c_str(), mode);
-#endif
-    return gz;
-}
+// Size of the buffer of compressed data on its way to or from the proxy.
+static const size_t zbuffer_size = 64 * 1024;
 
 }  // namespace
 
@@ -57,26 +50,40 @@ public:
     ZfileInput() { init(); }
     virtual ~ZfileInput() { close(); }
     virtual const char* format_name(void) const override { return "zfile"; }
-    virtual bool valid_file(const std::string& filename) const override;
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
+    virtual bool open(const std::string& name, ImageSpec& newspec,
+                      const ImageSpec& config) override;
     virtual bool close() override;
     virtual bool read_native_scanline(int subimage, int miplevel, int y, int z,
                                       void* data) override;
 
 private:
     std::string m_filename;  ///< Stash the filename
-    gzFile m_gz;             ///< Handle for compressed files
+    bool m_gzip;             ///< Is the file gzip-compressed?
+    z_stream m_stream;       ///< Inflate state for compressed files
     bool m_swab;             ///< swap bytes for other endianness?
     int m_next_scanline;     ///< Which scanline is the next to be read?
+    std::vector<unsigned char> m_zbuffer;  ///< Compressed data read
 
     // Reset everything to initial state
     void init()
     {
         m_filename.clear();
-        m_gz            = 0;
+        m_gzip          = false;
         m_swab          = false;
         m_next_scanline = 0;
+        std::vector<unsigned char>().swap(m_zbuffer);
     }
+
+    // Go to the start of the file, figure out whether it's compressed, and
+    // read its header.
+    bool read_header(ZfileHeader& header);
+    // Read size bytes of the image, uncompressing them if need be.
+    bool zread(void* data, size_t size);
 };
 
 
@@ -95,19 +102,31 @@ public:
                             const void* data, stride_t xstride,
                             stride_t ystride, stride_t zstride) override;
 
+    virtual int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
+
 private:
     std::string m_filename;  ///< Stash the filename
-    FILE* m_file;            ///< Open image handle for not compressed
-    gzFile m_gz;             ///< Handle for compressed files
+    bool m_gzip;             ///< Are we compressing what we write?
+    z_stream m_stream;       ///< Deflate state when compressing
+    std::vector<unsigned char> m_zbuffer;  ///< Compressed data to write
     std::vector<unsigned char> m_scratch;
     std::vector<unsigned char> m_tilebuffer;
 
     // Initialize private members to pre-opened state
     void init(void)
     {
-        m_file = nullptr;
-        m_gz   = 0;
+        m_gzip = false;
+        std::vector<unsigned char>().swap(m_zbuffer);
     }
+
+    // Write size bytes of the image, compressing them if need be.
+    bool zwrite(const void* data, size_t size);
+    // Compress and write size bytes, or with flush == Z_FINISH, whatever
+    // the compressor still holds.
+    bool deflate_and_write(const void* data, size_t size, int flush);
 };
 
 
@@ -144,18 +163,11 @@ OIIO_PLUGIN_EXPORTS_END
 
 
 bool
-ZfileInput::valid_file(const std::string& filename) const
+ZfileInput::open(const std::string& name, ImageSpec& newspec,
+                 const ImageSpec& config)
 {
-    gzFile gz = open_gz(filename, "rb");
-    if (!gz)
-        return false;
-
-    ZfileHeader header;
-    gzread(gz, &header, sizeof(header));
-    bool ok = (header.magic == zfile_magic
-               || header.magic == zfile_magic_endian);
-    gzclose(gz);
-    return ok;
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
 }
 
 
@@ -164,18 +176,19 @@ bool
 ZfileInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
-    m_gz       = open_gz(name, "rb");
-    if (!m_gz) {
-        errorf("Could not open \"%s\"", name);
+    if (!ioproxy_use_or_open(name))
         return false;
-    }
 
     ZfileHeader header;
     static_assert(sizeof(header) == 136, "header size does not match");
-    gzread(m_gz, &header, sizeof(header));
+    if (!read_header(header)) {
+        close();
+        return false;
+    }
 
     if (header.magic != zfile_magic && header.magic != zfile_magic_endian) {
         errorf("Not a valid Zfile");
+        close();
         return false;
     }
 
@@ -206,13 +219,72 @@ ZfileInput::open(const std::string& name, ImageSpec& newspec)
 
 
 bool
-ZfileInput::close()
+ZfileInput::read_header(ZfileHeader& header)
 {
-    if (m_gz) {
-        gzclose(m_gz);
-        m_gz = 0;
+    if (m_gzip)
+        inflateEnd(&m_stream);
+    m_gzip                 = false;
+    m_next_scanline        = 0;
+    unsigned char magic[2] = { 0, 0 };
+    if (!ioseek(0) || ioproxy()->read(magic, 2) != 2 || !ioseek(0)) {
+        errorf("Could not read \"%s\"", m_filename);
+        return false;
+    }
+    if (magic[0] == 0x1f && magic[1] == 0x8b) {
+        // gzip-compressed
+        m_stream          = z_stream();
+        m_stream.next_in  = Z_NULL;
+        m_stream.avail_in = 0;
+        if (inflateInit2(&m_stream, gzip_window_bits) != Z_OK) {
+            errorf("Could not initialize zlib");
+            return false;
+        }
+        m_gzip = true;
+        m_zbuffer.resize(zbuffer_size);
+    }
+    return zread(&header, sizeof(header));
+}
+
+
+
+bool
+ZfileInput::zread(void* data, size_t size)
+{
+    if (!m_gzip)
+        return ioread(data, size);
+    m_stream.next_out  = (Bytef*)data;
+    m_stream.avail_out = (uInt)size;
+    while (m_stream.avail_out) {
+        if (!m_stream.avail_in) {
+            size_t n = ioproxy()->read(m_zbuffer.data(), m_zbuffer.size());
+            if (!n) {
+                errorf("Read error: hit end of file in zfile reader");
+                return false;
+            }
+            m_stream.next_in  = m_zbuffer.data();
+            m_stream.avail_in = (uInt)n;
+        }
+        int r = inflate(&m_stream, Z_NO_FLUSH);
+        if (r == Z_STREAM_END && m_stream.avail_out) {
+            errorf("Read error: hit end of file in zfile reader");
+            return false;
+        }
+        if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+            errorf("zlib error: %s", m_stream.msg ? m_stream.msg : "unknown");
+            return false;
+        }
     }
+    return true;
+}
+
 
+
+bool
+ZfileInput::close()
+{
+    if (m_gzip)
+        inflateEnd(&m_stream);
+    ioproxy_clear();
     init();  // Reset to initial state
     return true;
 }
@@ -229,17 +301,16 @@ ZfileInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
     if (m_next_scanline > y) {
         // User is trying to read an earlier scanline than the one we're
-        // up to.  Easy fix: close the file and re-open.
-        ImageSpec dummyspec;
-        int subimage = current_subimage();
-        if (!close() || !open(m_filename, dummyspec)
-            || !seek_subimage(subimage, miplevel))
-            return false;  // Somehow, the re-open failed
-        OIIO_DASSERT(m_next_scanline == 0 && current_subimage() == subimage);
+        // up to.  Easy fix: start over from the beginning of the file.
+        ZfileHeader header;
+        if (!read_header(header))
+            return false;  // Somehow, the rewind failed
+        OIIO_DASSERT(m_next_scanline == 0);
     }
     while (m_next_scanline <= y) {
         // Keep reading until we're read the scanline we really need
-        gzread(m_gz, data, m_spec.width * sizeof(float));
+        if (!zread(data, m_spec.width * sizeof(float)))
+            return false;
         ++m_next_scanline;
     }
     if (m_swab)
@@ -259,9 +330,8 @@ ZfileOutput::open(const std::string& name, const ImageSpec& userspec,
     }
 
     close();  // Close any already-opened file
-    m_gz   = 0;
-    m_file = NULL;
-    m_spec = userspec;  // Stash the spec
+    m_filename = name;
+    m_spec     = userspec;  // Stash the spec
 
     // Check for things this format doesn't support
     if (m_spec.width < 1 || m_spec.height < 1) {
@@ -305,25 +375,26 @@ ZfileOutput::open(const std::string& name, const ImageSpec& userspec,
     else
         memcpy(header.worldtoscreen, ident, 16 * sizeof(float));
 
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
+        return false;
+
     if (m_spec.get_string_attribute("compression", "none")
         != std::string("none")) {
-        m_gz = open_gz(name, "wb");
-    } else {
-        m_file = Filesystem::fopen(name, "wb");
-    }
-    if (!m_file && !m_gz) {
-        errorf("Could not open \"%s\"", name);
-        return false;
+        m_stream = z_stream();
+        if (deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         gzip_window_bits, 8, Z_DEFAULT_STRATEGY)
+            != Z_OK) {
+            errorf("Could not initialize zlib");
+            ioproxy_clear();
+            return false;
+        }
+        m_gzip = true;
+        m_zbuffer.resize(zbuffer_size);
     }
 
-    bool b = 0;
-    if (m_gz) {
-        b = gzwrite(m_gz, &header, sizeof(header));
-    } else {
-        b = fwrite(&header, sizeof(header), 1, m_file);
-    }
-    if (!b) {
-        errorf("Failed write zfile::open (err: %d)", b);
+    if (!zwrite(&header, sizeof(header))) {
+        close();
         return false;
     }
 
@@ -340,6 +411,11 @@ ZfileOutput::open(const std::string& name, const ImageSpec& userspec,
 bool
 ZfileOutput::close()
 {
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
+
     bool ok = true;
     if (m_spec.tile_width) {
         // We've been emulating tiles; now dump as scanlines.
@@ -349,14 +425,11 @@ ZfileOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    if (m_gz) {
-        gzclose(m_gz);
-        m_gz = 0;
-    }
-    if (m_file) {
-        fclose(m_file);
-        m_file = nullptr;
+    if (m_gzip) {
+        ok &= deflate_and_write(nullptr, 0, Z_FINISH);
+        deflateEnd(&m_stream);
     }
+    ioproxy_clear();
 
     init();  // re-initialize
     return ok;
@@ -378,16 +451,42 @@ ZfileOutput::write_scanline(int y, int /*z*/, TypeDesc format, const void* data,
         data = &m_scratch[0];
     }
 
-    if (m_gz)
-        gzwrite(m_gz, data, m_spec.width * sizeof(float));
-    else {
-        size_t b = fwrite(data, sizeof(float), m_spec.width, m_file);
-        if (b != (size_t)m_spec.width) {
-            errorf("Failed write zfile::open (err: %d)", b);
+    return zwrite(data, m_spec.width * sizeof(float));
+}
+
+
+
+bool
+ZfileOutput::zwrite(const void* data, size_t size)
+{
+    if (!m_gzip)
+        return iowrite(data, size);
+    return deflate_and_write(data, size, Z_NO_FLUSH);
+}
+
+
+
+bool
+ZfileOutput::deflate_and_write(const void* data, size_t size, int flush)
+{
+    m_stream.next_in  = (Bytef*)data;
+    m_stream.avail_in = (uInt)size;
+    int r             = Z_OK;
+    do {
+        m_stream.next_out  = m_zbuffer.data();
+        m_stream.avail_out = (uInt)m_zbuffer.size();
+        r                  = deflate(&m_stream, flush);
+        if (r == Z_STREAM_ERROR) {
+            errorf("zlib error: %s", m_stream.msg ? m_stream.msg : "unknown");
             return false;
         }
-    }
-
+        size_t n = m_zbuffer.size() - m_stream.avail_out;
+        if (n && !iowrite(m_zbuffer.data(), n))
+            return false;
+        // Keep going while the output buffer fills up, or until the
+        // stream is finished when flushing.
+    } while (m_stream.avail_out == 0
+             || (flush == Z_FINISH && r != Z_STREAM_END));
     return true;
 }
 
@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+
+# Check that maketx --stream, which builds the texture a strip at a time,
+# makes the same texture as the usual in-memory path. The two only differ
+# in the order of float operations when resampling the MIP levels.
+
+failthresh = 0.00001
+hardfail = 0.00001
+failpercent = 0
+
+# Odd sized, non-square sources, with 4 channels (the SIMD path of the
+# resampler) and 3 channels (the scalar path).
+command += oiiotool ("--pattern noise 301x203 4 -d float -o src4.exr")
+command += oiiotool ("--pattern noise 203x301 3 -d float -o src3.exr")
+
+for src in [ "src4", "src3" ] :
+    for filt in [ "box", "lanczos3", "gaussian", "blackman-harris" ] :
+        opts = "-d float --filter " + filt
+        full = src + "-" + filt + ".exr"
+        strm = src + "-" + filt + "-stream.exr"
+        command += maketx_command (src + ".exr", full, opts)
+        command += maketx_command (src + ".exr", strm, opts + " --stream")
+        command += diff_command (full, strm)
+
+# Smaller tiles than the streaming strip, and TIFF output
+command += maketx_command ("src4.exr", "tile16.tif",
+                           "-d float --tile 16 16")
+command += maketx_command ("src4.exr", "tile16-stream.tif",
+                           "-d float --tile 16 16 --stream")
+command += diff_command ("tile16.tif", "tile16-stream.tif")
+
+outputs = [ ]
@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+
+# Check that batched texture lookups give the same results as single point
+# lookups of the same points. testtex --verifybatch fails if any differ.
+
+grid = "../common/textures/grid.tx"
+verify = "--batch --verifybatch -res 64 64 -d uint8 -o out.tif"
+
+command = testtex_command (grid, verify)
+command += testtex_command (grid, verify + " -derivs")
+command += testtex_command (grid, verify + " -derivs -flipt -nowarp")
+command += testtex_command (grid, verify + " -tube -blur 0.02")
+command += testtex_command (grid, verify + " -filtertest")
+command += testtex_command (grid, verify + " -interpmode 0")
+command += testtex_command (grid, verify + " -interpmode 1 -mipmode 2")
+command += testtex_command (grid, verify + " -mipmode 1 -wrap black")
+command += testtex_command ("missing.tx", verify + " --missing 1 0 0")
+
+# UDIM: neighboring lanes of a batch land in different tiles
+command += oiiotool ("-pattern constant:color=.5,.1,.1 64x64 3 -d uint8 -otex file.1001.tx")
+command += oiiotool ("-pattern constant:color=.1,.5,.1 64x64 3 -d uint8 -otex file.1002.tx")
+command += oiiotool ("-pattern checker 64x64 3 -d uint8 -otex file.1011.tx")
+command += testtex_command ("\"file.<UDIM>.tx\"",
+                            verify + " -nowarp -scalest 2 2 -derivs")
+
+# Latlong environment map
+command += oiiotool ("-pattern fill:top=1,0.5,0:bottom=0,0.5,1 64x32 3 -d half -oenv env.tx")
+command += testtex_command ("env.tx", verify)
+command += testtex_command ("env.tx", verify + " -derivs -blur 0.05")
+
+outputs = [ ]
@@ -2,3 +2,7 @@
 
 command = oiio_app("testtex") + " --nowarp --offset -1 -1 -1 --scalest 2 2 src/sparse_half.f3d"
 outputs = [ "out.exr" ]
+
+# Batched lookups must match the single point lookups
+command += ";\n" + testtex_command ("src/sparse_half.f3d",
+                                    "--batch --verifybatch --nowarp --offset -1 -1 -1 --scalest 2 2 -derivs -o batch.exr")